@@ -13,5 +13,6 @@
 #include "rc.h"
 #define CHASSIS_TASK_STACK (configMINIMAL_STACK_SIZE * 3)
 #define CHASSIS_TASK_PRIORITY (configMAX_PRIORITIES - 3) /* 当前优先级为2 */
+#define CHASSIS_RC_TIMEOUT_US 50000 /* 遥控器快照超过该年龄视为过期,SBUS帧间隔为7ms或14ms */
 void chassis_task(void *pvParameters);
 #endif //!__CHASSIS__H__
@@ -2,18 +2,20 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-20 14:01:26
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-20 14:10:50
+ * @LastEditTime: 2025-01-29 17:21:45
  * @Description: chassis.c
  *               该文件用于chassis任务,涉及的底层文件包括:rc.c/......
  *               当前任务执行频率为200Hz:周期5ms,可以尝试将周期调整到10ms
  *
  * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
  */
+#define LOG_MODULE CHASSIS /* 日志模块,必须在包含头文件之前定义,见rtt.h */
 #include "FreeRTOS.h"
 #include "task.h"
 #include "portable.h"
 #include "chassis.h"
 #include "rtt.h"
+#include "rtt_format.h"
 TaskHandle_t chassis_task_handle;
 RemoteCR_InstanceHandle remote_control_instance_handle;
 /**
@@ -34,12 +36,33 @@ void chassis_task(void *pvParameters)
         }
     }
     remote_control_instance_handle->enable_flag = 1; /* 使能遥控器 */
+#ifdef __SBUS_BENCHMARK
+    /* SBUS解码测试 */
+    sbus_benchmark();
+#endif //__SBUS_BENCHMARK
+#ifdef __RTT_LOG_BENCHMARK
+    /* 文本日志与延迟日志耗时测试 */
+    rtt_log_benchmark();
+#endif //__RTT_LOG_BENCHMARK
+#ifdef __RTT_FORMAT_BENCHMARK
+    /* 十六进制转储与浮点数格式化测试 */
+    rtt_format_benchmark();
+#endif //__RTT_FORMAT_BENCHMARK
+    SBUS_FrameDef rc_frame;    /* 遥控器通道值的完整副本 */
+    uint32_t rc_timestamp = 0; /* 副本发布时的DWT节拍数 */
+    uint8_t rc_valid = 0;      /* 副本有效:读取成功、未过期且不处于失控保护 */
     TickType_t xLastWakeTime = 0;
     /* 创建1ms的tick计数值 */
     const TickType_t xDelay1ms = pdMS_TO_TICKS(1);
     xLastWakeTime = xTaskGetTickCount();
     while (1)
     {
+        /* 读取遥控器快照,读取时间有上限,不会阻塞控制周期 */
+        rc_valid = snapshot_read(remote_control_instance_handle->rc_snapshot, &rc_frame, &rc_timestamp) &&
+                   (snapshot_age_us(rc_timestamp) < CHASSIS_RC_TIMEOUT_US) &&
+                   !rc_frame.failsafe;
+        /* 底盘控制使用rc_frame,rc_valid为0时应停车 */
+        (void)rc_valid;
         xTaskDelayUntil(&xLastWakeTime, xDelay1ms * 5);
     }
 }
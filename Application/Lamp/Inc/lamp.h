@@ -0,0 +1,27 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-03 09:20:17
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-06 16:24:08
+ * @Description: lamp.h
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __LAMP__H__
+#define __LAMP__H__
+#include "stdint.h"
+#include "led.h"
+#include "lamp_effect.h"
+#define LAMP_TASK_STACK (configMINIMAL_STACK_SIZE * 3)
+#define LAMP_TASK_PRIORITY (configMAX_PRIORITIES - 4) /* 当前优先级为1,灯效不影响其他任务 */
+#define LAMP_PERIOD_MS 50                             /* 帧周期:每50ms渲染一帧(20帧/秒),呼吸灯每帧更新一次色值 */
+#define LAMP_SEGMENT_NUM 4                            /* 灯带最多划分的分段数 */
+/* 默认分段布局(LAMP_NUM为58):状态指示 | 剂量率电平表 | 渐变 | 报警,可以通过lamp_set_segment修改 */
+#define LAMP_SEGMENT_STATUS 0
+#define LAMP_SEGMENT_DOSE 1
+#define LAMP_SEGMENT_GRADIENT 2
+#define LAMP_SEGMENT_ALARM 3
+void lamp_task(void *pvParameters);
+uint8_t lamp_set_segment(uint8_t idx, const Lamp_SegmentDef *segment);
+void lamp_set_level(uint8_t idx, uint16_t level);
+#endif //!__LAMP__H__
@@ -0,0 +1,47 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-06 10:37:45
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-06 16:24:08
+ * @Description: lamp_effect.h
+ *               灯带按分段显示不同的灯效,每一帧由lamp任务依次渲染所有分段,分段之间不应重叠;
+ *               该文件不依赖HAL与RTOS,可以在上位机测试
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __LAMP_EFFECT__H__
+#define __LAMP_EFFECT__H__
+#include "stdint.h"
+#include "ws2812b_fb.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* 灯效类型 */
+#define LAMP_EFFECT_OFF 0      /* 熄灭 */
+#define LAMP_EFFECT_SOLID 1    /* 常亮:状态指示,颜色为color */
+#define LAMP_EFFECT_BLINK 2    /* 闪烁:状态报警,每period帧亮灭一次 */
+#define LAMP_EFFECT_GRADIENT 3 /* 渐变:从color过渡到color_end,period不为0时每period帧滚动一周 */
+#define LAMP_EFFECT_METER 4    /* 柱状电平表:按level点亮,颜色从color(低)过渡到color_end(高),用于剂量率显示 */
+
+#define LAMP_METER_FULL 1000 /* 电平表满量程 */
+
+typedef struct
+{
+    /* data */
+    uint8_t effect;          /* 灯效类型 */
+    uint16_t begin;          /* 起始灯珠 */
+    uint16_t length;         /* 灯珠数量 */
+    uint32_t color;          /* 颜色0xRRGGBB */
+    uint32_t color_end;      /* 渐变与电平表的终点颜色 */
+    uint16_t period;         /* 闪烁与渐变滚动的周期,单位帧 */
+    volatile uint16_t level; /* 电平表的当前值:0 ~ LAMP_METER_FULL */
+} Lamp_SegmentDef;
+
+void lamp_effect_render(WS2812B_FramebufferDef *fb, const Lamp_SegmentDef *segment, uint32_t frame);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //!__LAMP_EFFECT__H__
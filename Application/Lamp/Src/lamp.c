@@ -0,0 +1,106 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-03 09:20:05
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-08 15:52:30
+ * @Description: lamp.c
+ *               该文件用于lamp任务,涉及的底层文件包括:led.c
+ *               WS2812B灯带的渲染在低优先级任务中完成,渲染结果通过交换帧指针交给DMA发送,不再占用临界区
+ *               当前任务以固定帧率运行,帧周期为LAMP_PERIOD_MS
+ *               定义TEST_WS2812B_LAMP时整条灯带显示呼吸灯,否则按分段渲染灯效(见lamp_effect.h)
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#define LOG_MODULE LED /* 日志模块,必须在包含头文件之前定义,见rtt.h */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "lamp.h"
+#include "rtt.h"
+#include "string.h"
+TaskHandle_t lamp_task_handle;
+/* 分段配置,由lamp_set_segment修改,lamp任务每一帧拷贝一份后渲染 */
+static Lamp_SegmentDef lamp_segment[LAMP_SEGMENT_NUM] = {
+    [LAMP_SEGMENT_STATUS] = {.effect = LAMP_EFFECT_SOLID, .begin = 0, .length = 8, .color = DarkGreen},
+    [LAMP_SEGMENT_DOSE] = {.effect = LAMP_EFFECT_METER, .begin = 8, .length = 36, .color = DarkGreen, .color_end = Firebrick, .level = 0},
+    [LAMP_SEGMENT_GRADIENT] = {.effect = LAMP_EFFECT_GRADIENT, .begin = 44, .length = 8, .color = Turquoise1, .color_end = MediumPurple1, .period = 40},
+    [LAMP_SEGMENT_ALARM] = {.effect = LAMP_EFFECT_OFF, .begin = 52, .length = 6, .color = DarkGoldenrod1, .period = 10},
+};
+/**
+ * @description: 修改一个分段的灯效,可以在任意任务中调用
+ * @param {uint8_t} idx
+ * @param {Lamp_SegmentDef} *segment
+ * @return {*} 0:参数不合法
+ */
+uint8_t lamp_set_segment(uint8_t idx, const Lamp_SegmentDef *segment)
+{
+    if ((idx >= LAMP_SEGMENT_NUM) || (segment == NULL))
+    {
+        LOGWARNING("[lamp_segment]Segment %d Is Illegal!\r\n", idx);
+        return 0;
+    }
+    taskENTER_CRITICAL();
+    memcpy(&lamp_segment[idx], segment, sizeof(Lamp_SegmentDef));
+    taskEXIT_CRITICAL();
+    return 1;
+}
+/**
+ * @description: 修改电平表分段的当前值,16位写入是原子操作,不需要进入临界区
+ * @param {uint8_t} idx
+ * @param {uint16_t} level 0 ~ LAMP_METER_FULL
+ * @return {*}
+ */
+void lamp_set_level(uint8_t idx, uint16_t level)
+{
+    if (idx < LAMP_SEGMENT_NUM)
+    {
+        lamp_segment[idx].level = level;
+    }
+}
+/**
+ * @description: 渲染一帧:拷贝分段配置后在帧缓冲区中依次渲染,只发送发生变化的帧
+ * @param {uint32_t} frame 帧计数
+ * @return {*}
+ */
+static void lamp_render(uint32_t frame)
+{
+    Lamp_SegmentDef segment[LAMP_SEGMENT_NUM];
+    WS2812B_FramebufferDef *fb = ws2812b_get_framebuffer();
+    taskENTER_CRITICAL();
+    memcpy(segment, lamp_segment, sizeof(segment));
+    taskEXIT_CRITICAL();
+    for (uint8_t i = 0; i < LAMP_SEGMENT_NUM; i++)
+    {
+        lamp_effect_render(fb, &segment[i], frame);
+    }
+    ws2812b_show();
+}
+/**
+ * @description: 灯效任务
+ * @param {void} *pvParameters
+ * @return {*}
+ */
+void lamp_task(void *pvParameters)
+{
+#ifdef __WS2812B_BENCHMARK
+    /* 关中断时间测试 */
+    ws2812b_benchmark();
+#endif //__WS2812B_BENCHMARK
+#ifdef __WS2812B_COLOR_BENCHMARK
+    /* 呼吸灯亮度计算测试 */
+    ws2812b_color_benchmark();
+#endif //__WS2812B_COLOR_BENCHMARK
+    uint32_t frame = 0; /* 帧计数 */
+    TickType_t xLastWakeTime = 0;
+    xLastWakeTime = xTaskGetTickCount();
+    while (1)
+    {
+#ifdef TEST_WS2812B_LAMP
+        /* 调用该函数前需要使用ws2812b_config_color函数配置RGB灯带,见main.c */
+        ws2812b_breath();
+#else
+        lamp_render(frame);
+#endif // TEST_WS2812B_LAMP
+        frame++;
+        xTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(LAMP_PERIOD_MS));
+    }
+}
@@ -0,0 +1,150 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-06 10:37:31
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-06 16:24:08
+ * @Description: lamp_effect.c
+ *               所有灯效都使用整数运算,颜色插值的权重为0 ~ 256(8位小数)
+ *               渲染结果写入帧缓冲区,颜色没有变化的灯珠不计入脏区间,静止的画面不会触发发送
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include "lamp_effect.h"
+/**
+ * @description: 颜色插值:weight为0时返回from,为256时返回to
+ * @param {uint32_t} from
+ * @param {uint32_t} to
+ * @param {uint16_t} weight 0 ~ 256
+ * @return {*}
+ */
+static uint32_t lamp_color_blend(uint32_t from, uint32_t to, uint16_t weight)
+{
+    uint32_t color = 0;
+    int32_t a, b;
+    for (uint8_t shift = 0; shift < 24; shift += 8)
+    {
+        a = (from >> shift) & 0xFF;
+        b = (to >> shift) & 0xFF;
+        color |= (uint32_t)(a + (((b - a) * weight) >> 8)) << shift;
+    }
+    return color;
+}
+/**
+ * @description: 颜色按比例调暗
+ * @param {uint32_t} color
+ * @param {uint16_t} scale 0 ~ 256
+ * @return {*}
+ */
+static uint32_t lamp_color_scale(uint32_t color, uint16_t scale)
+{
+    return lamp_color_blend(0x000000, color, scale);
+}
+/**
+ * @description: 分段内第i颗灯珠的线性位置,0 ~ 256
+ * @param {uint16_t} i
+ * @param {uint16_t} length
+ * @return {*}
+ */
+static uint16_t lamp_effect_position(uint16_t i, uint16_t length)
+{
+    return (length > 1) ? (uint16_t)(((uint32_t)i << 8) / (length - 1)) : 0;
+}
+/**
+ * @description: 渐变:不滚动时从首到尾线性过渡;滚动时按三角波往返过渡,首尾颜色相同,滚动时没有跳变
+ * @param {WS2812B_FramebufferDef} *fb
+ * @param {Lamp_SegmentDef} *segment
+ * @param {uint16_t} length
+ * @param {uint32_t} frame
+ * @return {*}
+ */
+static void lamp_effect_gradient(WS2812B_FramebufferDef *fb, const Lamp_SegmentDef *segment, uint16_t length, uint32_t frame)
+{
+    uint32_t phase;
+    uint32_t position;
+    uint16_t weight;
+    if (segment->period == 0)
+    {
+        for (uint16_t i = 0; i < length; i++)
+        {
+            ws2812b_fb_set(fb, segment->begin + i, lamp_color_blend(segment->color, segment->color_end, lamp_effect_position(i, length)));
+        }
+        return;
+    }
+    phase = (frame % segment->period) * 512 / segment->period;
+    for (uint16_t i = 0; i < length; i++)
+    {
+        position = (((uint32_t)i << 9) / length + phase) & 511;
+        weight = (position <= 256) ? position : (512 - position);
+        ws2812b_fb_set(fb, segment->begin + i, lamp_color_blend(segment->color, segment->color_end, weight));
+    }
+}
+/**
+ * @description: 柱状电平表:点亮的长度按level计算,保留8位小数,最后一颗灯珠按小数部分调暗,使电平变化连续
+ * @param {WS2812B_FramebufferDef} *fb
+ * @param {Lamp_SegmentDef} *segment
+ * @param {uint16_t} length
+ * @return {*}
+ */
+static void lamp_effect_meter(WS2812B_FramebufferDef *fb, const Lamp_SegmentDef *segment, uint16_t length)
+{
+    uint32_t level = segment->level;
+    uint32_t lit;
+    uint32_t color;
+    if (level > LAMP_METER_FULL)
+    {
+        level = LAMP_METER_FULL;
+    }
+    lit = level * length * 256 / LAMP_METER_FULL;
+    for (uint16_t i = 0; i < length; i++)
+    {
+        color = 0x000000;
+        if (i < (lit >> 8))
+        {
+            color = lamp_color_blend(segment->color, segment->color_end, lamp_effect_position(i, length));
+        }
+        else if (i == (lit >> 8))
+        {
+            color = lamp_color_scale(lamp_color_blend(segment->color, segment->color_end, lamp_effect_position(i, length)), lit & 0xFF);
+        }
+        ws2812b_fb_set(fb, segment->begin + i, color);
+    }
+}
+/**
+ * @description: 渲染一个分段,超出帧缓冲区的部分被截掉
+ * @param {WS2812B_FramebufferDef} *fb
+ * @param {Lamp_SegmentDef} *segment
+ * @param {uint32_t} frame 帧计数,用于闪烁与滚动
+ * @return {*}
+ */
+void lamp_effect_render(WS2812B_FramebufferDef *fb, const Lamp_SegmentDef *segment, uint32_t frame)
+{
+    uint16_t length = segment->length;
+    if (segment->begin >= fb->lamp_num)
+    {
+        return;
+    }
+    if (length > fb->lamp_num - segment->begin)
+    {
+        length = fb->lamp_num - segment->begin;
+    }
+    switch (segment->effect)
+    {
+    case LAMP_EFFECT_SOLID:
+        ws2812b_fb_fill(fb, segment->begin, length, segment->color);
+        break;
+    case LAMP_EFFECT_BLINK:
+        /* 前半个周期点亮,后半个周期熄灭 */
+        ws2812b_fb_fill(fb, segment->begin, length,
+                        ((segment->period == 0) || ((frame % segment->period) < segment->period / 2)) ? segment->color : 0x000000);
+        break;
+    case LAMP_EFFECT_GRADIENT:
+        lamp_effect_gradient(fb, segment, length, frame);
+        break;
+    case LAMP_EFFECT_METER:
+        lamp_effect_meter(fb, segment, length);
+        break;
+    default:
+        ws2812b_fb_fill(fb, segment->begin, length, 0x000000);
+        break;
+    }
+}
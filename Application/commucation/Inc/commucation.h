@@ -2,7 +2,7 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-13 14:38:32
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-17 22:11:59
+ * @LastEditTime: 2025-02-10 15:04:37
  * @Description: commucation.h
  *
  * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
@@ -11,9 +11,26 @@
 #define __COMMUCATION__H__
 #include "FreeRTOSConfig.h"
 #include "uart.h"
+#include "commucation_parser.h"
 /* commucation任务配置宏 */
 #define COMMUCATION_TASK_STACK (configMINIMAL_STACK_SIZE * 2)
 #define COMMUCATION_TASK_PRIORITY (configMAX_PRIORITIES - 2) /* 当前优先级为3 */
+/* 上位机串口的分帧方式:PARSER_FRAMING_SOF或PARSER_FRAMING_COBS,收发双方必须一致 */
+#define COMMUCATION_FRAMING PARSER_FRAMING_SOF
+/* 可靠传输宏定义:开启后上位机必须回复确认帧,见commucation_reliable.h */
+// #define __COMMUCATION_RELIABLE
+#define COMMUCATION_RELIABLE_WINDOW 8 /* 可靠传输窗口大小 */
+/* 分帧方式测试宏定义:注入比特错误,比较两种分帧方式的开销与重新同步能力 */
+// #define __COMMUCATION_FRAMING_BENCHMARK
+#define COMMUCATION_FRAMING_BENCHMARK_FRAMES 64    /* 测试数据帧数量 */
+#define COMMUCATION_FRAMING_BENCHMARK_FLOATS 4     /* 每个测试数据帧的float个数 */
+#define COMMUCATION_FRAMING_BENCHMARK_ERRORS 8     /* 注入的比特错误数量 */
+#define COMMUCATION_FRAMING_BENCHMARK_CHUNK 32     /* 每次输入解析器的字节数,模拟DMA数据块 */
+/* 批量数据帧测试宏定义:持续写入记录直到发送队列饱和,实测记录速率与串口吞吐量,上位机用telemetry_benchmark tty接收 */
+// #define __COMMUCATION_BATCH_BENCHMARK
+#define COMMUCATION_BATCH_BENCHMARK_FIELDS 4         /* 每条记录的float个数 */
+#define COMMUCATION_BATCH_BENCHMARK_DEADLINE_MS 10   /* 截止时间 */
+#define COMMUCATION_BATCH_BENCHMARK_DURATION_MS 2000 /* 测试时长 */
 
 /* 串口通信协议封装方式 */
 /**
@@ -33,10 +50,8 @@
 
 3. cmd_id 命令码 ID 说明 **(字节偏移 4，字节大小 2)**
 
-   | 命令码         | 数据段长度      | 功能说明 |
-   | -------------- | --------------- | -------- |
-   | 0x0001(可修改) | 2 byte (16-bit) | 视觉数据 |
-   | .......        |                 |          |
+   各命令码的字段、类型与数据段长度统一在commucation_schema.h中描述,
+   编解码函数由commucation_codec.h生成,不再手写
 
 4.  数据段data (n-byte)
 
@@ -48,13 +63,7 @@
 5. frame_tail(CRC16，整包校验)
 */
 
-#define PROTOCOL_HEAD_CMD 0xA5
-#define OFFSET_BYTE 0x08                 /* 串口通信协议中,除了数据段外,其他部分所占字节数 */
-#define PROTOCOL_FRAME_LENGTH_MAX (256u) /* 数据帧最大字节数 */
-#define PROTOCOL_DATA_LENGTH_MAX (128u)  /* 数据最大字节数 */
-/* 用于通信检验的宏定义 */
-#define TRUE 0x01
-#define FALSE 0x00
+/* 协议相关宏定义(PROTOCOL_HEAD_CMD,OFFSET_BYTE等)见commucation_parser.h */
 /* 生成测试数据 */
 /* 两个测试宏定义 */
 // #define __EASY_PRINT_TEST
@@ -65,36 +74,44 @@ void generate_test_data(uint16_t cmd_id,          /* 命令码 */
                         uint16_t flags_register); /* 16位寄存器 */
 #endif
 #endif //!__EASY_PRINT_TEST
-/* 串口通信协议结构体 */
-#if defined(__CC_ARM)
-#pragma anon_unions /*支持匿名结构体和联合体 */
-#endif              //(__CC_ARM)
+/* 接收到的数据帧通过Commucation_FrameViewDef只读视图访问,见commucation_parser.h */
 
+/* 命令码处理函数注册表:按cmd_id低位直接寻址,分发耗时与已注册命令数量无关 */
+#define COMMUCATION_CMD_TABLE_SIZE 16 /* 注册表大小,必须为2的幂 */
+#define COMMUCATION_CMD_INDEX(cmd_id) ((cmd_id) & (COMMUCATION_CMD_TABLE_SIZE - 1))
+#define COMMUCATION_CMD_BIT(cmd_id) (1u << COMMUCATION_CMD_INDEX(cmd_id)) /* 命令码在注册表中占用的位,用于编译期检查下标冲突 */
+/* 命令码处理函数,view只在调用期间有效 */
+typedef void (*commucation_cmd_handler)(const Commucation_FrameViewDef *view);
 typedef struct
 {
    /* data */
-   struct Frame_Head
-   {
-      /* data */
-      uint8_t sof;          /* 0xA5 */
-      uint16_t data_length; /* 数据段长度 */
-      uint8_t crc_check;    /* 帧头CRC校验 */
-   }; /* 帧头 */
-   uint16_t cmd_id; /* 功能码 */
-   struct Fream_Data
-   {
-      /* data */
-      uint16_t flags_register;                      /* 16位标志位寄存器 */
-      uint8_t float_data[PROTOCOL_DATA_LENGTH_MAX]; /* 数据 */
-   }; /* 数据帧 */
-   uint16_t frame_tail; /* 帧尾CRC校验 */
-} Commucation_ProtocolDef;
-typedef Commucation_ProtocolDef *Commucation_ProtocolHandle;
+   uint16_t cmd_id;                 /* 命令码 */
+   uint16_t max_len;                /* float数据段的最大字节数,超出的数据帧不会交给处理函数 */
+   commucation_cmd_handler handler; /* 处理函数,NULL表示该表项未注册 */
+   /* 统计信息 */
+   uint32_t frame_count;         /* 已处理的数据帧数 */
+   uint32_t byte_count;          /* 已处理的数据帧字节数 */
+   uint32_t crc_error_count;     /* 整包crc16校验失败次数 */
+   uint32_t length_error_count;  /* 数据段超出max_len的次数 */
+   uint32_t handler_cycle_total; /* 处理函数累计执行节拍数 */
+   uint32_t handler_cycle_max;   /* 处理函数单次最大执行节拍数 */
+} Commucation_CmdEntryDef;
+typedef Commucation_CmdEntryDef *Commucation_CmdEntryHandle;
 
-/* 将数据帧长度设置为buffer的大小,实际上要求一帧数据长度小于buffer大小,这样做是为了避免DMA传输错位 */
-/* 同时利用IDLE中断实现不定长数据的传输 */
-#define COMMUCATION_PROTOCOL_FRAME_SIZE UART_RECEIVE_BUFFER_SIZE /* 串口通信过程中,一个数据帧的大小 */
+/* 接收采用环形DMA,数据帧可以跨越IDLE/HT/TC事件,由流式解析器重新拼帧 */
+/* 环形缓冲区的一半需要容纳解码任务一次调度延迟内到达的数据 */
+#define COMMUCATION_PROTOCOL_FRAME_SIZE UART_RECEIVE_BUFFER_SIZE /* 串口接收环形缓冲区大小 */
 void commucation_task(void *pvParameters);
+uint16_t commucation_frame_pack(uint8_t *tx_buffer, uint16_t cmd_id, uint16_t flags_register, const float *tx_data, uint8_t float_length);
+uint8_t register_cmd_handler(uint16_t cmd_id, commucation_cmd_handler handler, uint16_t max_len);
+void commucation_cmd_report(void);
+#ifdef __COMMUCATION_FRAMING_BENCHMARK
+void commucation_framing_benchmark(void);
+#endif //__COMMUCATION_FRAMING_BENCHMARK
+#ifdef __COMMUCATION_BATCH_BENCHMARK
+void commucation_batch_benchmark(void);
+#endif //__COMMUCATION_BATCH_BENCHMARK
+uint8_t commucation_message_send(uint16_t cmd_id, uint16_t flags_register, const float *tx_data, uint8_t float_length, TickType_t timeout);
 
 /* 用于LED检验的宏定义 */
 #define TEST_LED_RGB
@@ -0,0 +1,65 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-13 09:41:27
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-11 10:26:03
+ * @Description: commucation_batch.h 批量遥测数据帧
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __COMMUCATION_BATCH__H__
+#define __COMMUCATION_BATCH__H__
+#include "FreeRTOS.h"
+#include "timers.h"
+#include "uart.h"
+#include "commucation_parser.h"
+/* 批量数据帧格式 */
+/**
+   批量数据帧沿用通信协议的帧头、cmd_id与帧尾,数据段按如下方式组织:
+
+   | 数据           | 偏移位置 | 字节大小                   | 内容                                       |
+   | -------------- | -------- | -------------------------- | ------------------------------------------ |
+   | flags_register | 6        | 2                          | 低8位:记录条数;高8位:每条记录的float个数    |
+   | records        | 8        | record_size * 记录条数      | 记录依次排列                               |
+
+   每条记录:timestamp(4-byte,uint32,由调用者给出) + field_num个float(4 * field_num-byte),均为先发低字节
+*/
+#define COMMUCATION_CMD_BATCH PROTOCOL_CMD_BATCH                                       /* 批量数据帧的默认命令码,见commucation_parser.h */
+#define COMMUCATION_BATCH_FIELD_MAX 16                                                 /* 每条记录的最大float个数 */
+#define COMMUCATION_BATCH_DATA_MAX PROTOCOL_DATA_LENGTH_MAX                            /* 一帧可以容纳的记录字节数:与普通数据帧相同,接收端的帧视图不需要区分命令码 */
+#define COMMUCATION_BATCH_RECORD_SIZE(field_num) (4 + 4 * (field_num))                /* 每条记录的字节数 */
+#define COMMUCATION_BATCH_POOL_SIZE 2                                                  /* 批量发送端对象池容量 */
+
+typedef struct
+{
+    /* data */
+    UART_InstanceHandle uart_instance_handle;   /* 发送使用的串口实例,必须已创建发送队列 */
+    uint16_t cmd_id;                            /* 命令码 */
+    uint8_t framing;                            /* 分帧方式:PARSER_FRAMING_SOF或PARSER_FRAMING_COBS */
+    uint8_t frame_offset;                       /* 原始数据帧在帧槽中的偏移,COBS分帧时为PROTOCOL_COBS_OFFSET */
+    uint8_t field_num;                          /* 每条记录的float个数 */
+    uint8_t record_size;                        /* 每条记录的字节数 */
+    uint8_t record_max;                         /* 一帧最多容纳的记录条数,写满后立即发送 */
+    uint8_t record_count;                       /* 私有缓冲区中已写入的记录条数 */
+    uint8_t record[COMMUCATION_BATCH_DATA_MAX]; /* 私有缓冲区:记录依次排列,发送时才分配帧槽并拷入 */
+    TimerHandle_t deadline_timer;               /* 截止时间定时器:第一条记录写入时启动,超时后发送未写满的帧 */
+    /* 统计信息 */
+    uint32_t record_total;        /* 已发送的记录条数 */
+    uint32_t frame_total;         /* 已发送的帧数 */
+    uint32_t deadline_flush;      /* 因截止时间到达而发送的帧数 */
+    uint32_t payload_bytes;       /* 已发送的记录字节数 */
+    uint32_t wire_bytes;          /* 已发送的数据帧字节数 */
+    uint32_t report_records;      /* 上一次统计时的记录条数 */
+    uint32_t report_wire_bytes;   /* 上一次统计时的数据帧字节数 */
+    TickType_t report_tick;       /* 上一次统计时的tick */
+} Commucation_BatchDef;
+typedef Commucation_BatchDef *Commucation_BatchHandle;
+/* 编译期检查:写满的批量数据帧经过COBS编码后仍然能放进一个帧槽 */
+typedef char commucation_batch_slot_check[(PROTOCOL_COBS_OFFSET + OFFSET_BYTE + 2 + COMMUCATION_BATCH_DATA_MAX + 1 <= UART_TRANSMIT_BUFFER_SIZE) ? 1 : -1];
+
+Commucation_BatchHandle Y_commucation_create_batch(UART_InstanceHandle uart_instance_handle, uint8_t framing, uint16_t cmd_id, uint8_t field_num, uint16_t deadline_ms);
+uint8_t commucation_batch_append(Commucation_BatchHandle batch, uint32_t timestamp, const float *fields);
+void commucation_batch_flush(Commucation_BatchHandle batch);
+void commucation_batch_report(Commucation_BatchHandle batch);
+
+#endif //!__COMMUCATION_BATCH__H__
@@ -0,0 +1,113 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-20 10:06:47
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-11 11:52:08
+ * @Description: commucation_codec.h 由commucation_schema.h展开生成的消息编解码函数
+ *               每条消息生成:结构体Schema_nameDef,常量SCHEMA_NAME_CMD/PAYLOAD_SIZE/FRAME_SIZE,
+ *               编码函数schema_name_encode与解码函数schema_name_decode
+ *               帧长在编译期确定,不申请内存,字段按定长逐个拷贝,不存在分支
+ *               该文件不依赖HAL与FreeRTOS,C++上位机可以直接包含,另外提供按类型重载的encode/decode
+ *               注意该文件不是只有头文件的库:编码调用commucation_frame_seal,解码使用解析器给出的帧视图,
+ *               上位机需要一起编译链接commucation_parser.c、crc8.c、crc16.c与cobs.c(解析器的COBS分帧),
+ *               编译命令见Host/Src/uart_ring_replay_test.cpp
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __COMMUCATION_CODEC__H__
+#define __COMMUCATION_CODEC__H__
+#include "stdint.h"
+#include "string.h"
+#include "commucation_parser.h"
+#include "commucation_schema.h"
+/* 字段按小端序直接拷贝,下位机(Cortex-M4)与上位机(x86/ARM Linux)均为小端平台 */
+
+/* 字段展开宏 */
+#define SCHEMA_FIELD_MEMBER(type, name) type name;
+#define SCHEMA_FIELD_SIZE(type, name) +sizeof(type)
+#define SCHEMA_FIELD_ENCODE(type, name)      \
+    memcpy(field, &msg->name, sizeof(type)); \
+    field += sizeof(type);
+#define SCHEMA_FIELD_DECODE(type, name)      \
+    memcpy(&msg->name, field, sizeof(type)); \
+    field += sizeof(type);
+
+/* 结构体:flags_register + 描述中的字段,结构体内存布局与数据帧无关 */
+#define SCHEMA_MSG_STRUCT(name, NAME, cmd, FIELDS) \
+    typedef struct                                 \
+    {                                              \
+        uint16_t flags_register;                   \
+        FIELDS(SCHEMA_FIELD_MEMBER)                \
+    } Schema_##name##Def;
+/* 编译期常量:命令码、flags_register之后的字节数、完整数据帧字节数 */
+#define SCHEMA_MSG_CONST(name, NAME, cmd, FIELDS)                                      \
+    enum                                                                               \
+    {                                                                                  \
+        SCHEMA_##NAME##_CMD = (cmd),                                                   \
+        SCHEMA_##NAME##_PAYLOAD_SIZE = (0 FIELDS(SCHEMA_FIELD_SIZE)),                  \
+        SCHEMA_##NAME##_FRAME_SIZE = (OFFSET_BYTE + 2 + (0 FIELDS(SCHEMA_FIELD_SIZE))) \
+    };                                                                                 \
+    /* 数据段超出协议上限时编译报错 */                                                               \
+    typedef char schema_##name##_size_check[((0 FIELDS(SCHEMA_FIELD_SIZE)) <= PROTOCOL_DATA_LENGTH_MAX) ? 1 : -1];
+/* 编码:frame大小不小于SCHEMA_NAME_FRAME_SIZE,返回数据帧字节数 */
+/* 解码:命令码与数据段长度必须与描述完全一致,否则返回FALSE且不修改msg */
+#define SCHEMA_MSG_CODEC(name, NAME, cmd, FIELDS)                                                               \
+    static inline uint16_t schema_##name##_encode(uint8_t *frame, const Schema_##name##Def *msg)                \
+    {                                                                                                           \
+        uint8_t *field = frame + OFFSET_BYTE;                                                                   \
+        frame[6] = (uint8_t)msg->flags_register;        /* 先发低字节 */                                             \
+        frame[7] = (uint8_t)(msg->flags_register >> 8); /* 后发高字节 */                                             \
+        FIELDS(SCHEMA_FIELD_ENCODE)                                                                             \
+        return commucation_frame_seal(frame, SCHEMA_##NAME##_CMD, 2 + SCHEMA_##NAME##_PAYLOAD_SIZE);            \
+    }                                                                                                           \
+    static inline uint8_t schema_##name##_decode(const Commucation_FrameViewDef *view, Schema_##name##Def *msg) \
+    {                                                                                                           \
+        const uint8_t *field = view->payload;                                                                   \
+        if ((view->cmd_id != SCHEMA_##NAME##_CMD) || (view->payload_length != SCHEMA_##NAME##_PAYLOAD_SIZE))    \
+        {                                                                                                       \
+            return FALSE;                                                                                       \
+        }                                                                                                       \
+        msg->flags_register = view->flags_register;                                                             \
+        FIELDS(SCHEMA_FIELD_DECODE)                                                                             \
+        return TRUE;                                                                                            \
+    }
+
+COMMUCATION_SCHEMA(SCHEMA_MSG_STRUCT)
+COMMUCATION_SCHEMA(SCHEMA_MSG_CONST)
+COMMUCATION_SCHEMA(SCHEMA_MSG_CODEC)
+
+#ifdef __cplusplus
+/* C++上位机:按消息类型重载,commucation_codec::traits<T>给出编译期常量;链接的源文件见文件头 */
+namespace commucation_codec
+{
+    template <typename T>
+    struct traits;
+#define SCHEMA_MSG_CPP(name, NAME, cmd, FIELDS)                                       \
+    template <>                                                                       \
+    struct traits<Schema_##name##Def>                                                 \
+    {                                                                                 \
+        static const uint16_t cmd_id = SCHEMA_##NAME##_CMD;                           \
+        static const uint16_t payload_size = SCHEMA_##NAME##_PAYLOAD_SIZE;            \
+        static const uint16_t frame_size = SCHEMA_##NAME##_FRAME_SIZE;                \
+    };                                                                                \
+    inline uint16_t encode(uint8_t *frame, const Schema_##name##Def &msg)             \
+    {                                                                                 \
+        return schema_##name##_encode(frame, &msg);                                   \
+    }                                                                                 \
+    inline bool decode(const Commucation_FrameViewDef &view, Schema_##name##Def &msg) \
+    {                                                                                 \
+        return schema_##name##_decode(&view, &msg) == TRUE;                           \
+    }
+    COMMUCATION_SCHEMA(SCHEMA_MSG_CPP)
+#undef SCHEMA_MSG_CPP
+} // namespace commucation_codec
+#endif //__cplusplus
+
+/* 编解码自测与吞吐量测试宏定义 */
+// #define __COMMUCATION_CODEC_TEST
+#define COMMUCATION_CODEC_TEST_ROUNDS 1000 /* 每条消息的编解码次数 */
+#ifdef __COMMUCATION_CODEC_TEST
+void commucation_codec_test(void);
+#endif //__COMMUCATION_CODEC_TEST
+
+#endif //!__COMMUCATION_CODEC__H__
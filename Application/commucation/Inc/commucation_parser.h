@@ -0,0 +1,116 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-06 10:12:40
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 15:04:37
+ * @Description: commucation_parser.h 串口通信协议流式解析器
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __COMMUCATION_PARSER__H__
+#define __COMMUCATION_PARSER__H__
+#include "stdint.h"
+#include "crc8.h"
+#include "crc16.h"
+#include "cobs.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/* 该文件不依赖HAL与FreeRTOS,上位机可以直接复用 */
+/* 通信协议格式见commucation.h */
+#define PROTOCOL_HEAD_CMD 0xA5
+#define PROTOCOL_HEAD_SIZE 0x04          /* 帧头字节数:sof + data_length + crc_check */
+#define OFFSET_BYTE 0x08                 /* 串口通信协议中,除了数据段外,其他部分所占字节数 */
+#define PROTOCOL_FRAME_LENGTH_MAX (256u) /* 数据帧最大字节数 */
+#define PROTOCOL_DATA_LENGTH_MAX (128u)  /* 数据最大字节数 */
+/* 用于通信检验的宏定义 */
+#define TRUE 0x01
+#define FALSE 0x00
+
+/* 分帧方式 */
+#define PARSER_FRAMING_SOF 0  /* 以0xA5作为帧起始字节,数据段中的0xA5可能被误认为帧头,需要逐字节重新同步 */
+#define PARSER_FRAMING_COBS 1 /* 整个数据帧经过COBS编码,以0x00作为帧分隔符,在下一个分隔符处立即重新同步 */
+/* 解析器缓存大小:COBS编码后的数据帧比原始数据帧多COBS_MAX_OVERHEAD字节 */
+#define PARSER_BUFFER_SIZE (PROTOCOL_FRAME_LENGTH_MAX + COBS_MAX_OVERHEAD(PROTOCOL_FRAME_LENGTH_MAX))
+/* COBS分帧发送时,原始数据帧在缓存中的偏移:预留编码开销,以便原地编码 */
+#define PROTOCOL_COBS_OFFSET COBS_MAX_OVERHEAD(PROTOCOL_FRAME_LENGTH_MAX)
+
+/* 解析状态 */
+#define PARSER_STATE_WAIT_SOF 0     /* 等待帧起始字节 */
+#define PARSER_STATE_HEAD 1         /* 接收帧头 */
+#define PARSER_STATE_BODY 2         /* 接收cmd_id,数据段以及帧尾 */
+#define PARSER_STATE_COBS_COLLECT 3 /* COBS分帧:缓存分隔符之前的数据 */
+#define PARSER_STATE_COBS_DISCARD 4 /* COBS分帧:数据超出缓存大小,丢弃到下一个分隔符 */
+
+/* 数据帧回调,frame指向解析器内部缓存,仅在回调期间有效 */
+typedef void (*commucation_frame_callback)(uint8_t *frame, uint16_t frame_length);
+
+typedef struct
+{
+   /* data */
+   uint8_t framing;                            /* 分帧方式:PARSER_FRAMING_SOF或PARSER_FRAMING_COBS */
+   uint8_t state;                              /* 解析状态 */
+   uint8_t resync;                             /* 当前缓存的数据帧校验失败,需要从下一个字节开始重新同步 */
+   uint16_t frame_pos;                         /* 数据帧已缓存的字节数 */
+   uint16_t frame_length;                      /* 当前数据帧的总字节数,由帧头得出 */
+   uint8_t frame[PARSER_BUFFER_SIZE];          /* 数据帧缓存 */
+   CRC8_ContextDef head_crc;                   /* 帧头crc8,随字节到达逐块累加 */
+   CRC16_ContextDef frame_crc;                 /* 整包crc16,随字节到达逐块累加 */
+   commucation_frame_callback frame_callback;  /* 完整数据帧回调 */
+   commucation_frame_callback crc_error_callback; /* 整包crc16校验失败回调,可以为NULL,帧头已通过crc8校验 */
+   /* 统计信息 */
+   uint32_t frame_count;       /* 通过校验的数据帧数 */
+   uint32_t head_error_count;  /* 帧头校验失败次数 */
+   uint32_t crc_error_count;   /* 整包crc16校验失败次数 */
+   uint32_t skip_bytes;        /* 同步过程中丢弃的字节数 */
+} Commucation_ParserDef;
+typedef Commucation_ParserDef *Commucation_ParserHandle;
+
+/* 数据帧只读视图:直接指向解析器的数据帧缓存,不拷贝数据段,仅在完整数据帧回调期间有效 */
+typedef struct
+{
+   /* data */
+   uint16_t cmd_id;         /* 功能码 */
+   uint16_t flags_register; /* 16位标志位寄存器 */
+   const uint8_t *payload;  /* float数据段起始地址,不保证4字节对齐 */
+   uint16_t payload_length; /* float数据段字节数,不超过PROTOCOL_DATA_LENGTH_MAX */
+} Commucation_FrameViewDef;
+typedef Commucation_FrameViewDef *Commucation_FrameViewHandle;
+
+/* 可靠传输的接收端状态,发送端见commucation_reliable.h */
+/* 可靠数据帧的数据段:flags_register低8位为8位序号,随后是原始cmd_id(2-byte)、原始flags_register(2-byte)与float数据 */
+/* 确认帧的数据段:flags_register低8位为累计确认序号(期望接收的下一个序号),随后是32位选择确认位图(4-byte) */
+/* 批量数据帧的数据段:flags_register低8位为记录条数,高8位为每条记录的float个数,随后是记录,见commucation_batch.h */
+/* 协议保留的命令码占用0x000D ~ 0x000F,位于命令码注册表的末尾,commucation_schema.h中的消息从0x0001开始依次编号 */
+#define PROTOCOL_CMD_BATCH 0x000D         /* 批量数据帧命令码 */
+#define PROTOCOL_CMD_RELIABLE_DATA 0x000E /* 可靠数据帧命令码 */
+#define PROTOCOL_CMD_RELIABLE_ACK 0x000F  /* 确认帧命令码 */
+#define RELIABLE_DATA_HEAD_SIZE 6 /* 可靠数据帧数据段中float数据之前的字节数 */
+#define RELIABLE_SACK_BITS 32     /* 选择确认位图的位数:第i位表示序号ack + 1 + i已收到 */
+typedef struct
+{
+   /* data */
+   uint8_t expected;         /* 期望接收的下一个序号,之前的序号均已收到 */
+   uint32_t sack_bitmap;     /* 第i位表示序号expected + 1 + i已收到 */
+   uint32_t duplicate_count; /* 重复收到的数据帧数 */
+} Commucation_ReliableRxDef;
+typedef Commucation_ReliableRxDef *Commucation_ReliableRxHandle;
+
+void commucation_parser_init(Commucation_ParserHandle parser, uint8_t framing, commucation_frame_callback frame_callback);
+void commucation_parser_feed(Commucation_ParserHandle parser, const uint8_t *data, uint16_t length);
+uint8_t commucation_frame_view(const uint8_t *frame, uint16_t frame_length, Commucation_FrameViewHandle view);
+uint16_t commucation_frame_seal(uint8_t *frame, uint16_t cmd_id, uint16_t data_length);
+uint16_t commucation_frame_cobs_wrap(uint8_t *buffer, uint16_t frame_length);
+void commucation_reliable_rx_init(Commucation_ReliableRxHandle rx);
+uint8_t commucation_reliable_rx_accept(Commucation_ReliableRxHandle rx, uint8_t seq);
+uint16_t commucation_reliable_ack_pack(const Commucation_ReliableRxDef *rx, uint8_t *frame);
+uint16_t commucation_frame_view_float_num(const Commucation_FrameViewDef *view);
+uint8_t commucation_frame_view_get_float(const Commucation_FrameViewDef *view, uint16_t index, float *value);
+uint8_t crc8_check(uint8_t *message, uint16_t size);
+uint8_t crc16_check(uint8_t *message, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //!__COMMUCATION_PARSER__H__
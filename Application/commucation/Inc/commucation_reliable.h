@@ -0,0 +1,73 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-17 09:26:48
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 15:41:09
+ * @Description: commucation_reliable.h 滑动窗口可靠传输(发送端)
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __COMMUCATION_RELIABLE__H__
+#define __COMMUCATION_RELIABLE__H__
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "timers.h"
+#include "uart.h"
+#include "commucation_parser.h"
+/* 可靠传输配置宏 */
+/* 帧格式与接收端状态见commucation_parser.h */
+#define COMMUCATION_RELIABLE_POOL_SIZE 16                                                                  /* 重传缓存帧数,必须为2的幂,窗口大小不能超过该值 */
+#define COMMUCATION_RELIABLE_FRAME_SIZE 96                                                                 /* 重传缓存中每帧的最大字节数 */
+#define COMMUCATION_RELIABLE_FLOAT_MAX ((COMMUCATION_RELIABLE_FRAME_SIZE - OFFSET_BYTE - RELIABLE_DATA_HEAD_SIZE) / 4) /* 每帧最多携带的float个数 */
+#define COMMUCATION_RELIABLE_RTO_MIN_MS 20                                                                 /* 重传超时的最小值,单位ms */
+#define COMMUCATION_RELIABLE_TIMER_MS 5                                                                    /* 重传检查周期,单位ms */
+#define COMMUCATION_RELIABLE_INSTANCE_POOL_SIZE 1                                                          /* 发送端对象池容量:确认帧处理函数没有上下文参数,每条链路只支持一个发送端 */
+
+/* 重传缓存帧状态 */
+#define RELIABLE_ENTRY_FREE 0     /* 空闲 */
+#define RELIABLE_ENTRY_INFLIGHT 1 /* 已发送,等待确认 */
+#define RELIABLE_ENTRY_SACKED 2   /* 已被选择确认,等待累计确认释放,不再重传 */
+/* 重传缓存帧的锁定状态:发送时在临界区内锁定,在临界区外拷贝与编码,完成后解锁 */
+#define RELIABLE_PIN_NONE 0    /* 未锁定 */
+#define RELIABLE_PIN_COPY 1    /* 正在拷贝到发送队列,重传检查跳过该帧 */
+#define RELIABLE_PIN_RELEASE 2 /* 拷贝期间已被累计确认,解锁时再释放窗口 */
+
+typedef struct
+{
+    /* data */
+    uint8_t frame[COMMUCATION_RELIABLE_FRAME_SIZE]; /* 完整数据帧(未经COBS编码) */
+    uint16_t frame_length;                          /* 数据帧字节数 */
+    uint8_t state;                                  /* 状态:RELIABLE_ENTRY_xxx */
+    uint8_t retransmit;                             /* 该帧的重传次数 */
+    uint8_t pin;                                    /* 锁定状态:RELIABLE_PIN_xxx,锁定期间帧内容不会被新的数据帧覆盖 */
+    TickType_t sent_tick;                           /* 最近一次发送的tick */
+} Commucation_ReliableEntryDef;
+
+typedef struct
+{
+    /* data */
+    UART_InstanceHandle uart_instance_handle;                         /* 发送使用的串口实例,必须已创建发送队列 */
+    uint8_t framing;                                                  /* 分帧方式:PARSER_FRAMING_SOF或PARSER_FRAMING_COBS */
+    uint8_t window;                                                   /* 窗口大小:未确认的数据帧数上限 */
+    uint8_t base_seq;                                                 /* 最早的未确认序号 */
+    uint8_t next_seq;                                                 /* 下一个待分配的序号 */
+    Commucation_ReliableEntryDef pool[COMMUCATION_RELIABLE_POOL_SIZE]; /* 重传缓存,按序号低位寻址 */
+    SemaphoreHandle_t window_semaphore;                               /* 计数信号量:窗口中剩余的可发送帧数 */
+    TimerHandle_t retransmit_timer;                                   /* 周期性检查重传超时 */
+    TickType_t srtt;                                                  /* 平滑往返时间,单位tick,0表示尚无采样 */
+    TickType_t rto;                                                   /* 重传超时,单位tick */
+    /* 统计信息 */
+    uint32_t tx_frames;       /* 首次发送的数据帧数 */
+    uint32_t acked_frames;    /* 已被累计确认的数据帧数 */
+    uint32_t retransmit_count; /* 重传次数 */
+    uint32_t ack_count;       /* 收到的确认帧数 */
+    uint32_t report_acked;    /* 上一次统计时已确认的数据帧数 */
+    TickType_t report_tick;   /* 上一次统计时的tick */
+} Commucation_ReliableDef;
+typedef Commucation_ReliableDef *Commucation_ReliableHandle;
+
+Commucation_ReliableHandle Y_commucation_create_reliable(UART_InstanceHandle uart_instance_handle, uint8_t framing, uint8_t window);
+uint8_t commucation_reliable_send(Commucation_ReliableHandle reliable, uint16_t cmd_id, uint16_t flags_register, const float *tx_data, uint8_t float_length, TickType_t timeout);
+void commucation_reliable_report(Commucation_ReliableHandle reliable);
+
+#endif //!__COMMUCATION_RELIABLE__H__
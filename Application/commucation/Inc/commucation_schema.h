@@ -0,0 +1,73 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-20 10:05:12
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 15:04:37
+ * @Description: commucation_schema.h 上位机通信协议描述(消息、字段、类型与命令码)
+ *               该文件只包含描述,编解码函数由commucation_codec.h根据描述展开生成
+ *               修改协议时只需要修改该文件,下位机与上位机重新编译即可保持一致
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __COMMUCATION_SCHEMA__H__
+#define __COMMUCATION_SCHEMA__H__
+/* 协议描述规则 */
+/**
+1. 消息描述:MSG(name, NAME, cmd_id, FIELDS)
+
+   | 参数   | 内容                                                              |
+   | ------ | ----------------------------------------------------------------- |
+   | name   | 小写消息名,生成Schema_nameDef、schema_name_encode/decode           |
+   | NAME   | 大写消息名,生成SCHEMA_NAME_CMD、SCHEMA_NAME_PAYLOAD_SIZE等常量      |
+   | cmd_id | 命令码,不能与PROTOCOL_CMD_xxx(0x000D ~ 0x000F)重复,低4位互不相同 |
+   | FIELDS | 字段描述宏                                                        |
+
+2. 字段描述:F(type, name),按描述顺序紧密排列在数据段flags_register之后,先发低字节
+
+   type只能是定长类型:uint8_t/int8_t/uint16_t/int16_t/uint32_t/int32_t/float
+   每条消息都隐含16位寄存器flags_register,不需要描述
+
+3. 命令码注册表按cmd_id低4位直接寻址,低4位相同的命令码无法同时注册,commucation.c中有编译期检查
+*/
+
+/* 视觉数据:云台目标角度与距离 */
+#define SCHEMA_VISION_FIELDS(F) \
+    F(float, yaw)               \
+    F(float, pitch)             \
+    F(float, distance)
+
+/* 底盘速度指令 */
+#define SCHEMA_CHASSIS_SPEED_FIELDS(F) \
+    F(float, vx)                       \
+    F(float, vy)                       \
+    F(float, wz)
+
+/* 辐射剂量遥测:探测器编号、采样时间戳、计数与剂量率 */
+#define SCHEMA_RADIATION_FIELDS(F) \
+    F(uint8_t, detector)           \
+    F(uint8_t, gain)               \
+    F(uint32_t, timestamp)         \
+    F(uint32_t, counts)            \
+    F(float, dose_rate)
+
+/* 日志等级设置:模块编号(见rtt.h中的RTT_LOG_MODULES,0xFF表示全部模块)与日志等级(0:INFO ~ 3:OFF) */
+#define SCHEMA_LOG_LEVEL_FIELDS(F) \
+    F(uint8_t, module)             \
+    F(uint8_t, level)
+
+/* 测试数据:generate_test_data使用的4个float */
+#define SCHEMA_TEST_DATA_FIELDS(F) \
+    F(float, data0)                \
+    F(float, data1)                \
+    F(float, data2)                \
+    F(float, data3)
+
+/* 消息列表 */
+#define COMMUCATION_SCHEMA(MSG)                                            \
+    MSG(vision, VISION, 0x0001, SCHEMA_VISION_FIELDS)                      \
+    MSG(chassis_speed, CHASSIS_SPEED, 0x0002, SCHEMA_CHASSIS_SPEED_FIELDS) \
+    MSG(radiation, RADIATION, 0x0003, SCHEMA_RADIATION_FIELDS)             \
+    MSG(log_level, LOG_LEVEL, 0x0004, SCHEMA_LOG_LEVEL_FIELDS)             \
+    MSG(test_data, TEST_DATA, 0x0010, SCHEMA_TEST_DATA_FIELDS)
+
+#endif //!__COMMUCATION_SCHEMA__H__
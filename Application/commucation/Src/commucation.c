@@ -2,12 +2,13 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-13 14:38:45
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-20 12:55:38
+ * @LastEditTime: 2025-02-11 10:26:03
  * @Description: commucation.c 上位机通信文件
  *
  * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
  */
 
+#define LOG_MODULE COMMUCATION /* 日志模块,必须在包含头文件之前定义,见rtt.h */
 #include "commucation.h"
 #include "FreeRTOS.h"
 #include "task.h"
@@ -16,12 +17,37 @@
 #include "crc8.h"
 #include "crc16.h"
 #include "string.h"
+#include "dwt.h"
+#include "pool.h"
+#include "cobs.h"
+#include "commucation_codec.h"
+#ifdef __COMMUCATION_RELIABLE
+#include "commucation_reliable.h"
+#endif //__COMMUCATION_RELIABLE
+#ifdef __COMMUCATION_BATCH_BENCHMARK
+#include "commucation_batch.h"
+#endif //__COMMUCATION_BATCH_BENCHMARK
 #ifdef TEST_LED_RGB
 #include "led.h"
 #endif // TEST_LED_RGB
+/* 编译期检查:所有命令码在注册表中的下标互不相同
+   每个命令码占用下标对应的一位,没有两个命令码占用同一位时,各位的累加和才等于按位或 */
+#define COMMUCATION_SCHEMA_CMD_SUM(name, NAME, cmd_id, FIELDS) +COMMUCATION_CMD_BIT(cmd_id)
+#define COMMUCATION_SCHEMA_CMD_OR(name, NAME, cmd_id, FIELDS) | COMMUCATION_CMD_BIT(cmd_id)
+#define COMMUCATION_CMD_RESERVED_SUM (COMMUCATION_CMD_BIT(PROTOCOL_CMD_BATCH) + COMMUCATION_CMD_BIT(PROTOCOL_CMD_RELIABLE_DATA) + COMMUCATION_CMD_BIT(PROTOCOL_CMD_RELIABLE_ACK))
+#define COMMUCATION_CMD_RESERVED_OR (COMMUCATION_CMD_BIT(PROTOCOL_CMD_BATCH) | COMMUCATION_CMD_BIT(PROTOCOL_CMD_RELIABLE_DATA) | COMMUCATION_CMD_BIT(PROTOCOL_CMD_RELIABLE_ACK))
+typedef char commucation_cmd_index_check[((COMMUCATION_CMD_RESERVED_SUM COMMUCATION_SCHEMA(COMMUCATION_SCHEMA_CMD_SUM)) ==
+                                          (COMMUCATION_CMD_RESERVED_OR COMMUCATION_SCHEMA(COMMUCATION_SCHEMA_CMD_OR)))
+                                             ? 1
+                                             : -1];
 TaskHandle_t commucation_task_handle;
 UART_InstanceHandle commucation_uart_handle;
-Commucation_ProtocolHandle message_handle; /* 用于装载通信协议解码后的数据,只创建一次 */
+#ifdef __COMMUCATION_RELIABLE
+Commucation_ReliableHandle commucation_reliable_handle; /* 上位机可靠传输发送端 */
+#endif //__COMMUCATION_RELIABLE
+Commucation_ParserDef commucation_parser;  /* 上位机数据流解析器 */
+static Commucation_CmdEntryDef commucation_cmd_table[COMMUCATION_CMD_TABLE_SIZE]; /* 命令码处理函数注册表 */
+static uint32_t commucation_cmd_unknown_count = 0;                                /* 未注册命令码的数据帧数 */
 #ifdef TEST_LED_RGB
 LED_InstanceHandle commucation_led_instance_handle;
 #endif // TEST_LED_RGB
@@ -36,138 +62,206 @@ uint8_t get_crc8_check_code(uint8_t *message, uint16_t size)
     return crc_8(message, size);
 }
 /**
- * @description: 检验crc8数据段
+ * @description: 获取crc16校验码
  * @param {uint8_t} *message:输入字符串
- * @param {uint16_t} size:字符串字节数
+ * @param {uint32_t} size:字符串字节数
  * @return {*}
  */
-uint8_t crc8_check(uint8_t *message, uint16_t size)
+uint8_t get_crc16_check_code(uint8_t *message, uint32_t size)
+{
+    return crc_16(message, size);
+}
+/**
+ * @description: 注册命令码处理函数,注册表按cmd_id低位直接寻址
+ *               低位相同的两个命令码无法同时注册,后注册的会被拒绝,此时需要调整命令码或者增大COMMUCATION_CMD_TABLE_SIZE
+ * @param {uint16_t} cmd_id 命令码
+ * @param {commucation_cmd_handler} handler 处理函数
+ * @param {uint16_t} max_len float数据段的最大字节数,不超过PROTOCOL_DATA_LENGTH_MAX
+ * @return {*} TRUE:注册成功;FALSE:参数非法或者与已注册的命令码冲突
+ */
+uint8_t register_cmd_handler(uint16_t cmd_id, commucation_cmd_handler handler, uint16_t max_len)
 {
-    uint8_t ucExpected = 0; /* 期望值 */
-    /* 问题:为什么需要<=2,,不能计算一个字节数据的crc吗? */
-    if ((message == NULL) || (size <= 2))
+    Commucation_CmdEntryHandle entry = &commucation_cmd_table[COMMUCATION_CMD_INDEX(cmd_id)];
+    if ((handler == NULL) || (max_len > PROTOCOL_DATA_LENGTH_MAX))
+    {
+        LOGERROR("[commucation]cmd 0x%04x register param error.\r\n", cmd_id);
+        return FALSE;
+    }
+    taskENTER_CRITICAL();
+    if ((entry->handler != NULL) && (entry->cmd_id != cmd_id))
     {
-        return FALSE; /* false */
+        taskEXIT_CRITICAL();
+        LOGERROR("[commucation]cmd 0x%04x conflicts with cmd 0x%04x.\r\n", cmd_id, entry->cmd_id);
+        return FALSE;
     }
-    ucExpected = crc_8(message, size - 1);
-    return (ucExpected == message[size - 1]); /* true or false */
+    memset(entry, 0, sizeof(Commucation_CmdEntryDef));
+    entry->cmd_id = cmd_id;
+    entry->max_len = max_len;
+    entry->handler = handler;
+    taskEXIT_CRITICAL();
+    return TRUE;
 }
 /**
- * @description: 获取crc16校验码
- * @param {uint8_t} *message:输入字符串
- * @param {uint32_t} size:字符串字节数
+ * @description: 查找命令码对应的注册表项
+ * @param {uint16_t} cmd_id 命令码
+ * @return {*} 注册表项,未注册时返回NULL
+ */
+static Commucation_CmdEntryHandle commucation_cmd_lookup(uint16_t cmd_id)
+{
+    Commucation_CmdEntryHandle entry = &commucation_cmd_table[COMMUCATION_CMD_INDEX(cmd_id)];
+    return ((entry->handler != NULL) && (entry->cmd_id == cmd_id)) ? entry : NULL;
+}
+/**
+ * @description: 打印每个已注册命令码的统计信息
  * @return {*}
  */
-uint8_t get_crc16_check_code(uint8_t *message, uint32_t size)
+void commucation_cmd_report(void)
 {
-    return crc_16(message, size);
+    Commucation_CmdEntryHandle entry;
+    for (uint8_t idx = 0; idx < COMMUCATION_CMD_TABLE_SIZE; idx++)
+    {
+        entry = &commucation_cmd_table[idx];
+        if (entry->handler == NULL)
+        {
+            continue;
+        }
+        LOGINFO("[commucation]cmd 0x%04x frames [%d] bytes [%d] crc error [%d] length error [%d] handler avg [%d] max [%d] cycles.\r\n",
+                entry->cmd_id, entry->frame_count, entry->byte_count, entry->crc_error_count, entry->length_error_count,
+                (entry->frame_count != 0) ? entry->handler_cycle_total / entry->frame_count : 0, entry->handler_cycle_max);
+    }
+    LOGINFO("[commucation]unknown cmd frames [%d].\r\n", commucation_cmd_unknown_count);
 }
 /**
- * @description: 检验crc16数据段
- * @param {uint8_t} *message:输入字符串
- * @param {uint32_t} size:字符串字节数
+ * @description: 整包crc16校验失败回调,帧头已通过crc8校验,按帧中的cmd_id统计
+ *               cmd_id本身也可能损坏,统计结果仅作参考
+ * @param {uint8_t} *frame 数据帧
+ * @param {uint16_t} frame_length 数据帧字节数
  * @return {*}
  */
-uint8_t crc16_check(uint8_t *message, uint32_t size)
+static void commucation_frame_crc_error_callback(uint8_t *frame, uint16_t frame_length)
 {
-    /* 注意,期望值是16字节 */
-    uint16_t ucExpected = 0; /* 期望值 */
-    if ((message == NULL) || (size <= 2))
+    Commucation_CmdEntryHandle entry = commucation_cmd_lookup((frame[5] << 8) | frame[4]);
+    if (entry != NULL)
     {
-        return FALSE; /* false */
+        entry->crc_error_count++;
     }
-    /* 计算除了帧尾字节外的其他字节的crc16 */
-    ucExpected = crc_16(message, size - 2);
-    return (((ucExpected & 0xff) == message[size - 2]) && (((ucExpected >> 8) & 0xff) == message[size - 1])); /* true or false */
 }
 /**
- * @description: 检验数据帧头
- * @param {Commucation_ProtocolHandle} message:数据帧句柄
- * @param {uint8_t*} rx_buffer:接收buffer
+ * @description: 完整数据帧回调,数据帧已经通过帧头crc8与整包crc16校验
+ *               通过只读视图直接访问解析器中的数据帧,不拷贝数据段,视图只在回调期间有效
+ *               随后按cmd_id查表分发给已注册的处理函数
+ * @param {uint8_t} *frame 数据帧
+ * @param {uint16_t} frame_length 数据帧字节数
  * @return {*}
  */
-uint8_t protocol_head_check(Commucation_ProtocolHandle message, uint8_t *rx_buffer)
+static void commucation_frame_decode_callback(uint8_t *frame, uint16_t frame_length)
 {
-    /* Commucation_ProtocolDef结构体只需要申请一次空间 */
-    /* 如果检验通过,将rx_buffer的数据装载到message句柄对应的结构体 */
-    if (rx_buffer[0] == PROTOCOL_HEAD_CMD)
+    Commucation_FrameViewDef view;
+    Commucation_CmdEntryHandle entry;
+    uint32_t cycle_start;
+    uint32_t cycle;
+    if (!commucation_frame_view(frame, frame_length, &view))
     {
-#if !defined __EASY_PRINT_TEST && defined __COMMUCATION_PROTOCOL_TEST_DATA
-        LOGWARNING("TEST Pass Protocol Head CMD.\r\n");
-#endif //!__EASY_PRINT_TEST && __COMMUCATION_PROTOCOL_TEST_DATA
-        message->sof = PROTOCOL_HEAD_CMD;
-        /* 检验帧头crc8 */
-        /* 帧头4字节 */
-        if (crc8_check(rx_buffer, 4))
-        {
-#if !defined __EASY_PRINT_TEST && defined __COMMUCATION_PROTOCOL_TEST_DATA
-            LOGWARNING("TEST Pass crc8 Check.\r\n");
-#endif                                                                 //!__EASY_PRINT_TEST && __COMMUCATION_PROTOCOL_TEST_DATA
-            message->data_length = (rx_buffer[2] << 8) | rx_buffer[1]; /* 先发低字节,后发高字节 */
-            message->crc_check = rx_buffer[3];
-            message->cmd_id = (rx_buffer[5] << 8) | rx_buffer[4]; /* 先发低字节,后发高字节 */
-            /* 不需要装载数据以及帧尾crc,因为数据是不定长的 */
-            return TRUE;
-        }
+        LOGWARNING("Frame length [%d] invalid.\r\n", frame_length);
+        return;
     }
-    return FALSE;
+#ifdef __COMMUCATION_PROTOCOL_TEST_DATA
+    /* cmd_id解码测试 */
+    // 正确编码:00 10
+    uint8_t cmd_id_high = view.cmd_id >> 8;
+    uint8_t cmd_id_low = view.cmd_id;
+    rtt_str_to_hex(&cmd_id_high, 1);
+    rtt_str_to_hex(&cmd_id_low, 1);
+    /* float数据解码测试 */
+    // 正确编码:EB 56 B7 3F AE 6E 67 43 A4 70 15 41 2A E9 F6 42
+    rtt_str_to_hex(view.payload, view.payload_length);
+    /* 测试数据由函数generate_test_data生成 */
+    // A5 12 00 74 10 00 55 FE EB 56 B7 3F AE 6E 67 43 A4 70 15 41 2A E9 F6 42 75 71
+    // 浮点数据:1.43234/231.43234/9.34/123.4554
+#endif //__COMMUCATION_PROTOCOL_TEST_DATA
+    /* 按命令码分发 */
+    entry = commucation_cmd_lookup(view.cmd_id);
+    if (entry == NULL)
+    {
+        commucation_cmd_unknown_count++;
+        return;
+    }
+    if (view.payload_length > entry->max_len)
+    {
+        entry->length_error_count++;
+        return;
+    }
+    cycle_start = dwt_get_cycle();
+    entry->handler(&view);
+    cycle = dwt_get_cycle() - cycle_start;
+    entry->frame_count++;
+    entry->byte_count += frame_length;
+    entry->handler_cycle_total += cycle;
+    if (cycle > entry->handler_cycle_max)
+    {
+        entry->handler_cycle_max = cycle;
+    }
+}
+/**
+ * @description: 日志等级设置命令处理函数:调整模块的运行时日志等级,并打印各模块的日志统计
+ * @param {Commucation_FrameViewDef} *view 数据帧视图
+ * @return {*}
+ */
+static void commucation_log_level_handler(const Commucation_FrameViewDef *view)
+{
+    Schema_log_levelDef msg;
+    if (!schema_log_level_decode(view, &msg) || !rtt_log_set_level(msg.module, msg.level))
+    {
+        LOGWARNING("[commucation]log level param error.\r\n");
+        return;
+    }
+    rtt_log_report();
 }
 /**
- * @description: 接收解码函数
+ * @description: 接收解码函数,接收到的数据块可能只包含半帧,也可能包含多帧,统一交给流式解析器处理
  * @param {uint8_t} *buffer
  * @param {uint16_t} pack_num
  * @return {*}
  */
-static void commucation_message_decode_callback(uint8_t *rx_buffer, uint16_t frame_length)
+static void commucation_message_decode_callback(uint8_t *rx_buffer, uint16_t length)
 {
 #ifdef __EASY_PRINT_TEST
-    rtt_str_to_hex(rx_buffer, frame_length);
+    rtt_str_to_hex(rx_buffer, length);
 #else
     /* 申请在静态区,只创建一次,避免反复申请 */
-    static uint16_t frame_error_count = 0; /* 错误帧计数 */
+    static uint32_t frame_error_count = 0; /* 错误帧计数 */
 
-    if (protocol_head_check(message_handle, rx_buffer))
-    {
-        /* 通过帧头校验 */
-        if (crc16_check(rx_buffer, frame_length))
-        {
-            /* 通过crc16校验 */
-#if !defined __EASY_PRINT_TEST && defined __COMMUCATION_PROTOCOL_TEST_DATA
-            LOGWARNING("Pass crc16 Check.\r\n");
-#endif //!__EASY_PRINT_TEST && __COMMUCATION_PROTOCOL_TEST_DATA
-            /* 整帧数据通过crc16检验 */
-            /* 获取16位寄存器的值 */
-            message_handle->flags_register = (rx_buffer[7] << 8) | rx_buffer[6];
-            memcpy(message_handle->float_data, rx_buffer + 8, message_handle->data_length - 2);
-#ifdef __COMMUCATION_PROTOCOL_TEST_DATA
-            /* cmd_id解码测试 */
-            // 正确编码:00 10
-            uint8_t cmd_id_high = message_handle->cmd_id >> 8;
-            uint8_t cmd_id_low = message_handle->cmd_id;
-            rtt_str_to_hex(&cmd_id_high, 1);
-            rtt_str_to_hex(&cmd_id_low, 1);
-            /* float数据解码测试 */
-            // 正确编码:EB 56 B7 3F AE 6E 67 43 A4 70 15 41 2A E9 F6 42
-            rtt_str_to_hex(message_handle->float_data, message_handle->data_length - 2);
-            /* 测试数据由函数generate_test_data生成 */
-            // A5 12 00 74 10 00 55 FE EB 56 B7 3F AE 6E 67 43 A4 70 15 41 2A E9 F6 42 75 71
-            // 浮点数据:1.43234/231.43234/9.34/123.4554
-#endif //__COMMUCATION_PROTOCOL_TEST_DATA
-        }
-#if !defined __EASY_PRINT_TEST && defined __COMMUCATION_PROTOCOL_TEST_DATA
-        else
-        {
-            LOGWARNING("Can not Pass crc16 Check.\r\n");
-        }
-#endif //!__EASY_PRINT_TEST && __COMMUCATION_PROTOCOL_TEST_DATA
-    }
-    else
+    commucation_parser_feed(&commucation_parser, rx_buffer, length);
+    if (commucation_parser.head_error_count + commucation_parser.crc_error_count != frame_error_count)
     {
-        frame_error_count++;
+        frame_error_count = commucation_parser.head_error_count + commucation_parser.crc_error_count;
         LOGWARNING("Receive Error Frame, accumulate [%d] times.\r\n", frame_error_count);
     }
 #endif //__EASY_PRINT_TEST
 }
+/**
+ * @description: 按照通信协议将数据打包成一帧
+ * @param {uint8_t} *tx_buffer 数据帧缓存,大小不小于PROTOCOL_FRAME_LENGTH_MAX
+ * @param {uint16_t} cmd_id 命令码
+ * @param {uint16_t} flags_register 16位寄存器
+ * @param {float} *tx_data 待发送的float数据
+ * @param {uint8_t} float_length float数据的个数
+ * @return {*} 数据帧长度
+ */
+uint16_t commucation_frame_pack(uint8_t *tx_buffer, uint16_t cmd_id, uint16_t flags_register, const float *tx_data, uint8_t float_length)
+{
+    uint16_t data_length = float_length * 4 + 2; /* 数据段长度:寄存器值 + float数据,一个float数据是4字节 */
+
+    /* 数据段部分 */
+    /* flags_register */
+    tx_buffer[6] = flags_register;      /* 先发低字节 */
+    tx_buffer[7] = flags_register >> 8; /* 后发高字节 */
+    /* data:小端平台,float的内存布局即为先发低字节的顺序 */
+    memcpy(tx_buffer + 8, tx_data, 4 * float_length);
+
+    /* 帧头、命令码与帧尾,返回数据帧长度 */
+    return commucation_frame_seal(tx_buffer, cmd_id, data_length);
+}
 #ifndef __EASY_PRINT_TEST
 #ifdef __COMMUCATION_PROTOCOL_TEST_DATA
 /**
@@ -177,52 +271,21 @@ static void commucation_message_decode_callback(uint8_t *rx_buffer, uint16_t fra
 void generate_test_data(uint16_t cmd_id,         /* 命令码 */
                         uint16_t flags_register) /* 16位寄存器 */
 {
-    uint8_t *tx_buffer = (uint8_t *)malloc(sizeof(uint8_t) * PROTOCOL_FRAME_LENGTH_MAX); /* 待发送的数据帧 */
-    uint8_t float_length = 4;                                                            /* 发送4个float数据 */
-    float *float_data = (float *)malloc(sizeof(float) * float_length);                   /* 待发送的float数据 */
-    float_data[0] = 1.43234;
-    float_data[1] = 231.43234;
-    float_data[2] = 9.34;
-    float_data[3] = 123.4554;
-    uint16_t frame_tail;
-    uint16_t data_length;  /* 数据段长度:寄存器值 + float数据 */
-    uint16_t frame_length; /* 数据帧长度,用于打印 */
+    static uint8_t tx_buffer[SCHEMA_TEST_DATA_FRAME_SIZE]; /* 待发送的数据帧,帧长在编译期确定 */
+    Schema_test_dataDef test_data;                         /* 待发送的4个float数据 */
+    uint16_t frame_length;                                 /* 数据帧长度,用于打印 */
+    test_data.flags_register = flags_register;
+    test_data.data0 = 1.43234f;
+    test_data.data1 = 231.43234f;
+    test_data.data2 = 9.34f;
+    test_data.data3 = 123.4554f;
 
-    data_length = float_length * 4 + 2; /* 一个float数据是4字节,转换成uint8_t类型需要乘4 */
-    /* 帧头部分 */
-    /* sof */
-    tx_buffer[0] = PROTOCOL_HEAD_CMD;
-    /* data_length */
-    tx_buffer[1] = data_length;      /* 先发低字节 */
-    tx_buffer[2] = data_length >> 8; /* 后发高字节 */
-    /* crc_check */
-    tx_buffer[3] = crc_8(tx_buffer, 3); /* 生成帧头的8位宽crc */
-    /* 命令码部分 */
-    /* cmd_id */
-    tx_buffer[4] = cmd_id;      /* 先发低字节 */
-    tx_buffer[5] = cmd_id >> 8; /* 后发高字节 */
-    /* 数据段部分 */
-    /* flags_register */
-    tx_buffer[6] = flags_register;      /* 先发低字节 */
-    tx_buffer[7] = flags_register >> 8; /* 后发高字节 */
-    /* data */
-    for (uint8_t i = 0; i < 4 * float_length; i++)
+    frame_length = schema_test_data_encode(tx_buffer, &test_data);
+    if (cmd_id != SCHEMA_TEST_DATA_CMD)
     {
-        /* 从第9字节开始发送数据 */
-        /* 一个float需要执行4次循环才能发送完毕 */
-        /* (uint8_t *)(&float_data[i / 4])表示将第i / 4个float类型的指针强制转换成uint8_t类型的指针 */
-        /* [i % 4]表示转换之后按照1字节的大小将float数据取出,每个float取4次 */
-        tx_buffer[i + 8] = ((uint8_t *)(&float_data[i / 4]))[i % 4];
+        /* 使用其他命令码时重新封装帧头与帧尾 */
+        frame_length = commucation_frame_seal(tx_buffer, cmd_id, 2 + SCHEMA_TEST_DATA_PAYLOAD_SIZE);
     }
-
-    /* 整包校验部分 */
-    /* frame_tail */
-    frame_tail = crc_16(tx_buffer, data_length + 6);
-    tx_buffer[data_length + 6] = frame_tail;      /* 先发低字节 */
-    tx_buffer[data_length + 7] = frame_tail >> 8; /* 后发高字节 */
-
-    /* 计算数据帧长度 */
-    frame_length = data_length + 8;
     /* 循环打印四次 */
     for (uint8_t i = 0; i < 4; i++)
     {
@@ -232,18 +295,181 @@ void generate_test_data(uint16_t cmd_id,         /* 命令码 */
 #endif //__COMMUCATION_PROTOCOL_TEST_DATA
 #endif //!__EASY_PRINT_TEST
 /**
- * @description: 将数据打包成一帧,随后通过待选串口进行发送
+ * @description: 将数据打包成一帧,随后通过上位机串口的发送队列进行发送
+ *               直接在发送队列的帧槽中组帧,发送由DMA完成,函数不会忙等
+ * @param {uint16_t} cmd_id 命令码
+ * @param {uint16_t} flags_register 16位寄存器
+ * @param {float} *tx_data 待发送的float数据
+ * @param {uint8_t} float_length float数据的个数,不超过PROTOCOL_DATA_LENGTH_MAX / 4
+ * @param {TickType_t} timeout 发送队列满时的最长等待时间,0表示队列满时直接丢弃
+ * @return {*} TRUE:已进入发送队列;FALSE:参数非法或队列满
+ */
+uint8_t commucation_message_send(uint16_t cmd_id, uint16_t flags_register, const float *tx_data, uint8_t float_length, TickType_t timeout)
+{
+    uint8_t *tx_buffer;
+    uint16_t frame_length;
+    if ((commucation_uart_handle == NULL) || (float_length * 4 > PROTOCOL_DATA_LENGTH_MAX))
+    {
+        return FALSE;
+    }
+    tx_buffer = uart_tx_frame_alloc(commucation_uart_handle, timeout);
+    if (tx_buffer == NULL)
+    {
+        return FALSE;
+    }
+#if COMMUCATION_FRAMING == PARSER_FRAMING_COBS
+    /* 在预留编码开销的位置组帧,随后原地编码 */
+    frame_length = commucation_frame_pack(tx_buffer + PROTOCOL_COBS_OFFSET, cmd_id, flags_register, tx_data, float_length);
+    frame_length = commucation_frame_cobs_wrap(tx_buffer, frame_length);
+#else
+    frame_length = commucation_frame_pack(tx_buffer, cmd_id, flags_register, tx_data, float_length);
+#endif //COMMUCATION_FRAMING == PARSER_FRAMING_COBS
+    uart_tx_frame_commit(commucation_uart_handle, tx_buffer, frame_length);
+    return TRUE;
+}
+#ifdef __COMMUCATION_FRAMING_BENCHMARK
+static uint8_t framing_bench_recovered[COMMUCATION_FRAMING_BENCHMARK_FRAMES]; /* 每个测试数据帧是否被正确解析 */
+/**
+ * @description: 分帧方式测试的数据帧回调,测试数据帧的cmd_id即为其编号
+ * @param {uint8_t} *frame 数据帧
+ * @param {uint16_t} frame_length 数据帧字节数
+ * @return {*}
+ */
+static void framing_bench_callback(uint8_t *frame, uint16_t frame_length)
+{
+    uint16_t idx = (frame[5] << 8) | frame[4];
+    if (idx < COMMUCATION_FRAMING_BENCHMARK_FRAMES)
+    {
+        framing_bench_recovered[idx] = 1;
+    }
+}
+/**
+ * @description: 分帧方式测试函数:分别以SOF与COBS方式生成同一组数据帧,注入相同位置的比特错误后交给解析器
+ *               float数据中刻意包含0xA5与0x00,统计编码开销、丢失帧数、重新同步延迟与解析耗时
+ *               重新同步延迟:从出错字节到其后第一个被正确解析的数据帧起始位置之间的字节数
+ * @return {*}
+ */
+void commucation_framing_benchmark(void)
+{
+    static Commucation_ParserDef bench_parser;
+    static uint8_t stream[COMMUCATION_FRAMING_BENCHMARK_FRAMES * (PROTOCOL_COBS_OFFSET + OFFSET_BYTE + 2 + 4 * COMMUCATION_FRAMING_BENCHMARK_FLOATS + 1)];
+    static uint16_t frame_start[COMMUCATION_FRAMING_BENCHMARK_FRAMES];
+    static const char *const framing_name[2] = {"SOF", "COBS"};
+    uint16_t error_pos[COMMUCATION_FRAMING_BENCHMARK_ERRORS];
+    uint8_t frame[PROTOCOL_COBS_OFFSET + PROTOCOL_FRAME_LENGTH_MAX + 1];
+    float tx_data[COMMUCATION_FRAMING_BENCHMARK_FLOATS];
+    uint32_t seed;
+    uint32_t cycle_start;
+    uint32_t cycle;
+    uint32_t latency;
+    uint16_t stream_length;
+    uint16_t frame_length;
+    uint16_t lost;
+    for (uint8_t framing = PARSER_FRAMING_SOF; framing <= PARSER_FRAMING_COBS; framing++)
+    {
+        /* 两种分帧方式使用相同的数据与相同的出错位置 */
+        seed = 0x1234567;
+        stream_length = 0;
+        for (uint16_t idx = 0; idx < COMMUCATION_FRAMING_BENCHMARK_FRAMES; idx++)
+        {
+            for (uint8_t i = 0; i < COMMUCATION_FRAMING_BENCHMARK_FLOATS * 4; i++)
+            {
+                seed = seed * 1103515245 + 12345;
+                ((uint8_t *)tx_data)[i] = (seed >> 24) & 0x03 ? (uint8_t)(seed >> 16) : ((seed >> 16) & 0x01 ? PROTOCOL_HEAD_CMD : 0x00);
+            }
+            frame_length = commucation_frame_pack(frame + PROTOCOL_COBS_OFFSET, idx, 0, tx_data, COMMUCATION_FRAMING_BENCHMARK_FLOATS);
+            if (framing == PARSER_FRAMING_COBS)
+            {
+                frame_length = commucation_frame_cobs_wrap(frame, frame_length);
+                memcpy(stream + stream_length, frame, frame_length);
+            }
+            else
+            {
+                memcpy(stream + stream_length, frame + PROTOCOL_COBS_OFFSET, frame_length);
+            }
+            frame_start[idx] = stream_length;
+            stream_length += frame_length;
+        }
+        for (uint8_t i = 0; i < COMMUCATION_FRAMING_BENCHMARK_ERRORS; i++)
+        {
+            /* 出错位置均匀分布在整个数据流中,每个区间内随机 */
+            seed = seed * 1103515245 + 12345;
+            error_pos[i] = stream_length * i / COMMUCATION_FRAMING_BENCHMARK_ERRORS + (seed >> 16) % (stream_length / COMMUCATION_FRAMING_BENCHMARK_ERRORS);
+            stream[error_pos[i]] ^= 1 << ((seed >> 8) & 0x07);
+        }
+        memset(framing_bench_recovered, 0, sizeof(framing_bench_recovered));
+        commucation_parser_init(&bench_parser, framing, framing_bench_callback);
+        cycle_start = dwt_get_cycle();
+        for (uint16_t pos = 0; pos < stream_length; pos += COMMUCATION_FRAMING_BENCHMARK_CHUNK)
+        {
+            commucation_parser_feed(&bench_parser, stream + pos, (stream_length - pos < COMMUCATION_FRAMING_BENCHMARK_CHUNK) ? (stream_length - pos) : COMMUCATION_FRAMING_BENCHMARK_CHUNK);
+        }
+        cycle = dwt_get_cycle() - cycle_start;
+        lost = 0;
+        for (uint16_t idx = 0; idx < COMMUCATION_FRAMING_BENCHMARK_FRAMES; idx++)
+        {
+            lost += !framing_bench_recovered[idx];
+        }
+        latency = 0;
+        for (uint8_t i = 0; i < COMMUCATION_FRAMING_BENCHMARK_ERRORS; i++)
+        {
+            uint16_t idx = 0;
+            while ((idx < COMMUCATION_FRAMING_BENCHMARK_FRAMES) && ((frame_start[idx] <= error_pos[i]) || !framing_bench_recovered[idx]))
+            {
+                idx++;
+            }
+            latency += ((idx < COMMUCATION_FRAMING_BENCHMARK_FRAMES) ? frame_start[idx] : stream_length) - error_pos[i];
+        }
+        LOGINFO("[framing]%s: [%d] bytes for [%d] payload bytes, lost [%d]/[%d] frames with [%d] bit errors, resync avg [%d] bytes, [%d] cycles/kB.\r\n",
+                framing_name[framing],
+                stream_length,
+                COMMUCATION_FRAMING_BENCHMARK_FRAMES * (2 + 4 * COMMUCATION_FRAMING_BENCHMARK_FLOATS),
+                lost,
+                COMMUCATION_FRAMING_BENCHMARK_FRAMES,
+                COMMUCATION_FRAMING_BENCHMARK_ERRORS,
+                latency / COMMUCATION_FRAMING_BENCHMARK_ERRORS,
+                cycle * 1024 / stream_length);
+    }
+}
+#endif //__COMMUCATION_FRAMING_BENCHMARK
+#ifdef __COMMUCATION_BATCH_BENCHMARK
+/**
+ * @description: 批量数据帧测试函数:在测试时长内持续写入记录,发送队列满时让出1个tick等待DMA发送,
+ *               测试结束后打印实测的记录速率、串口吞吐量与占用率;发送队列满时被丢弃的帧见发送队列的drop
  * @return {*}
  */
-// static void commucation_message_send(uint8_t idx,               /* 执行发送操作的串口实例的id */
-//                                      uint16_t flags_register,   /* 16bit的寄存器 */
-//                                      float *tx_data,            /* 待发送的float数据 */
-//                                      uint8_t float_length,      /* float数据的长度 */
-//                                      uint8_t *tx_buffer,        /* 待发送数据缓存buffer */
-//                                      uint16_t *tx_frame_length) /* 待发送的数据帧长度 */
-// {
-//     /* 待补充 */
-// }
+void commucation_batch_benchmark(void)
+{
+    Commucation_BatchHandle batch;
+    float fields[COMMUCATION_BATCH_BENCHMARK_FIELDS];
+    TickType_t start;
+    uint32_t idx = 0;
+    batch = Y_commucation_create_batch(commucation_uart_handle, COMMUCATION_FRAMING, COMMUCATION_CMD_BATCH,
+                                       COMMUCATION_BATCH_BENCHMARK_FIELDS, COMMUCATION_BATCH_BENCHMARK_DEADLINE_MS);
+    if (batch == NULL)
+    {
+        return;
+    }
+    start = xTaskGetTickCount();
+    batch->report_tick = start;
+    while (xTaskGetTickCount() - start < pdMS_TO_TICKS(COMMUCATION_BATCH_BENCHMARK_DURATION_MS))
+    {
+        for (uint8_t i = 0; i < COMMUCATION_BATCH_BENCHMARK_FIELDS; i++)
+        {
+            fields[i] = idx + 0.25f * i;
+        }
+        if (!commucation_batch_append(batch, idx, fields))
+        {
+            /* 发送队列满,写满的帧被丢弃,等待DMA发送 */
+            vTaskDelay(1);
+        }
+        idx++;
+    }
+    commucation_batch_flush(batch);
+    commucation_batch_report(batch);
+    uart_tx_report(commucation_uart_handle);
+}
+#endif //__COMMUCATION_BATCH_BENCHMARK
 /**
  * @description: 上位机通信任务
  * @param {void} *pvParameters
@@ -252,12 +478,40 @@ void generate_test_data(uint16_t cmd_id,         /* 命令码 */
 void commucation_task(void *pvParameters)
 {
     /* 任务配置区 */
-    /* 创建通信协议解码结构体 */
-    /* 注意,增大该任务的栈空间 */
-    message_handle = (Commucation_ProtocolHandle)pvPortMalloc(sizeof(Commucation_ProtocolDef));
+    /* 初始化数据流解析器,必须在创建串口实例之前完成 */
+    commucation_parser_init(&commucation_parser, COMMUCATION_FRAMING, commucation_frame_decode_callback);
+    commucation_parser.crc_error_callback = commucation_frame_crc_error_callback;
+    /* 注册日志等级设置命令 */
+    register_cmd_handler(SCHEMA_LOG_LEVEL_CMD, commucation_log_level_handler, SCHEMA_LOG_LEVEL_PAYLOAD_SIZE);
     /* 创建串口实例,负责接受上位机的消息 */
     /* 串口实例本质上靠DMA中断处理,因此不属于任务体系,可以考虑作为硬件系统任务处理 */
-    commucation_uart_handle = Y_uart_create_instance(IDX_OF_UART_DEVICE_3, COMMUCATION_PROTOCOL_FRAME_SIZE, &huart3, commucation_message_decode_callback);
+    commucation_uart_handle = Y_uart_create_instance(IDX_OF_UART_DEVICE_3, COMMUCATION_PROTOCOL_FRAME_SIZE, UART_RECV_MODE_RING, &huart3, commucation_message_decode_callback);
+    /* 创建发送队列,用于向上位机发送数据 */
+    Y_uart_create_tx_queue(commucation_uart_handle);
+#ifdef __COMMUCATION_RELIABLE
+    /* 创建可靠传输发送端,确认帧由命令码注册表分发 */
+    commucation_reliable_handle = Y_commucation_create_reliable(commucation_uart_handle, COMMUCATION_FRAMING, COMMUCATION_RELIABLE_WINDOW);
+#endif //__COMMUCATION_RELIABLE
+#ifdef __UART_DISPATCH_BENCHMARK
+    /* 串口中断分发测试 */
+    uart_dispatch_benchmark();
+#endif //__UART_DISPATCH_BENCHMARK
+#ifdef __CRC_BENCHMARK
+    /* crc吞吐量测试 */
+    crc_benchmark();
+#endif //__CRC_BENCHMARK
+#ifdef __COMMUCATION_FRAMING_BENCHMARK
+    /* 分帧方式测试 */
+    commucation_framing_benchmark();
+#endif //__COMMUCATION_FRAMING_BENCHMARK
+#ifdef __COMMUCATION_BATCH_BENCHMARK
+    /* 批量数据帧实测吞吐量测试 */
+    commucation_batch_benchmark();
+#endif //__COMMUCATION_BATCH_BENCHMARK
+#ifdef __COMMUCATION_CODEC_TEST
+    /* 协议编解码自测与吞吐量测试 */
+    commucation_codec_test();
+#endif //__COMMUCATION_CODEC_TEST
 #ifdef TEST_LED_RGB
     /* LED测试 */
     commucation_led_instance_handle = Y_led_creat_instance(0, Firebrick);
@@ -271,6 +525,17 @@ void commucation_task(void *pvParameters)
     {
         /* 每隔1s打印一次心跳包 */
         LOGINFO("Heart %d\n\r", heart_count++);
+        /* 每隔10s打印一次串口接收中断的最坏执行时间 */
+        if (heart_count % 10 == 0)
+        {
+            uart_isr_report();
+            uart_tx_report(commucation_uart_handle);
+            commucation_cmd_report();
+            pool_report();
+#ifdef __COMMUCATION_RELIABLE
+            commucation_reliable_report(commucation_reliable_handle);
+#endif //__COMMUCATION_RELIABLE
+        }
 #ifdef TEST_LED_RGB
         /* 每隔1s闪烁3次,表征通信正常 */
         led_start(commucation_led_instance_handle, 3);
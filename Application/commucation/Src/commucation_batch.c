@@ -0,0 +1,233 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-13 09:41:40
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-11 10:26:03
+ * @Description: commucation_batch.c 批量遥测数据帧
+ *               将多条带时间戳的记录打包进同一个数据帧,写满或者截止时间到达时发送
+ *               记录先写入发送端的私有缓冲区,发送时才分配帧槽:发送队列按分配顺序发送,
+ *               提前占用帧槽会让后面分配的数据帧一直等到这一帧写满或截止时间到达
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#define LOG_MODULE COMMUCATION /* 日志模块,必须在包含头文件之前定义,见rtt.h */
+#include "commucation_batch.h"
+#include "task.h"
+#include "rtt.h"
+#include "string.h"
+#include "pool.h"
+POOL_DEFINE(batch_instance_pool, Commucation_BatchDef, COMMUCATION_BATCH_POOL_SIZE); /* 批量发送端对象池 */
+/**
+ * @description: 取出私有缓冲区中的全部记录,必须在临界区内调用
+ *               记录拷贝到调用者的缓冲区后立即清空,临界区内不分配帧槽,也不会阻塞
+ * @param {Commucation_BatchHandle} batch 批量数据帧句柄
+ * @param {uint8_t} *record 输出的记录,大小不小于COMMUCATION_BATCH_DATA_MAX
+ * @return {*} 取出的记录条数,0表示没有记录
+ */
+static uint8_t batch_detach(Commucation_BatchHandle batch, uint8_t *record)
+{
+    uint8_t record_count = batch->record_count;
+    memcpy(record, batch->record, record_count * batch->record_size);
+    batch->record_count = 0;
+    return record_count;
+}
+/**
+ * @description: 分配帧槽,拷入记录并补齐帧头、命令码与帧尾后提交到发送队列,不能在临界区内调用
+ *               COBS分帧时随后将数据帧原地编码到帧槽起始位置
+ *               发送队列满时不等待,这一帧被丢弃,由发送队列的drop_count计数
+ * @param {Commucation_BatchHandle} batch 批量数据帧句柄
+ * @param {uint8_t} *record batch_detach取出的记录
+ * @param {uint8_t} record_count 记录条数
+ * @param {uint8_t} deadline 1:因截止时间到达而发送
+ * @return {*} TRUE:已提交;FALSE:发送队列满,这一帧被丢弃
+ */
+static uint8_t batch_commit(Commucation_BatchHandle batch, const uint8_t *record, uint8_t record_count, uint8_t deadline)
+{
+    uint8_t *slot = uart_tx_frame_alloc(batch->uart_instance_handle, 0);
+    uint8_t *frame;
+    uint16_t data_length = 2 + record_count * batch->record_size;
+    uint16_t frame_length = data_length + OFFSET_BYTE;
+    if (slot == NULL)
+    {
+        return FALSE;
+    }
+    frame = slot + batch->frame_offset;
+    /* flags_register:低8位为记录条数,高8位为每条记录的float个数 */
+    frame[6] = record_count;
+    frame[7] = batch->field_num;
+    memcpy(frame + OFFSET_BYTE, record, record_count * batch->record_size);
+    commucation_frame_seal(frame, batch->cmd_id, data_length);
+    if (batch->framing == PARSER_FRAMING_COBS)
+    {
+        frame_length = commucation_frame_cobs_wrap(slot, frame_length);
+    }
+    uart_tx_frame_commit(batch->uart_instance_handle, slot, frame_length);
+    /* 统计信息可能被定时器任务与调用者同时修改 */
+    taskENTER_CRITICAL();
+    batch->record_total += record_count;
+    batch->payload_bytes += record_count * batch->record_size;
+    batch->wire_bytes += data_length + OFFSET_BYTE;
+    batch->frame_total++;
+    batch->deadline_flush += deadline;
+    taskEXIT_CRITICAL();
+    return TRUE;
+}
+/**
+ * @description: 截止时间定时器回调:发送未写满的帧,在定时器任务中执行
+ * @param {TimerHandle_t} xTimer
+ * @return {*}
+ */
+static void batch_deadline_callback(TimerHandle_t xTimer)
+{
+    Commucation_BatchHandle batch = (Commucation_BatchHandle)pvTimerGetTimerID(xTimer);
+    uint8_t record[COMMUCATION_BATCH_DATA_MAX];
+    uint8_t record_count;
+    taskENTER_CRITICAL();
+    record_count = batch_detach(batch, record);
+    taskEXIT_CRITICAL();
+    if (record_count != 0)
+    {
+        batch_commit(batch, record, record_count, 1);
+    }
+}
+/**
+ * @description: 创建批量数据帧实例
+ * @param {UART_InstanceHandle} uart_instance_handle 发送使用的串口实例,必须已创建发送队列
+ * @param {uint8_t} framing 分帧方式:PARSER_FRAMING_SOF或PARSER_FRAMING_COBS,与该串口的接收端一致
+ * @param {uint16_t} cmd_id 命令码
+ * @param {uint8_t} field_num 每条记录的float个数,范围1 ~ COMMUCATION_BATCH_FIELD_MAX
+ * @param {uint16_t} deadline_ms 截止时间:第一条记录写入后最多等待的时间,单位ms
+ * @return {*}
+ */
+Commucation_BatchHandle Y_commucation_create_batch(UART_InstanceHandle uart_instance_handle, uint8_t framing, uint16_t cmd_id, uint8_t field_num, uint16_t deadline_ms)
+{
+    /* 检测参数是否合法 */
+    if ((uart_instance_handle == NULL) || (uart_instance_handle->tx_queue == NULL) ||
+        (field_num == 0) || (field_num > COMMUCATION_BATCH_FIELD_MAX) || (deadline_ms == 0))
+    {
+        while (1)
+        {
+            LOGERROR("[batch_create]Batch Param Error!");
+        }
+    }
+    /* 从对象池中申请,常数时间,不使用FreeRTOS堆 */
+    Commucation_BatchHandle batch = (Commucation_BatchHandle)pool_alloc(&batch_instance_pool);
+    if (batch == NULL)
+    {
+        LOGERROR("[batch_create]Batch Pool Is Full!\r\n");
+        return NULL;
+    }
+    memset(batch, 0, sizeof(Commucation_BatchDef));
+    batch->uart_instance_handle = uart_instance_handle;
+    batch->framing = framing;
+    batch->frame_offset = (framing == PARSER_FRAMING_COBS) ? PROTOCOL_COBS_OFFSET : 0;
+    batch->cmd_id = cmd_id;
+    batch->field_num = field_num;
+    batch->record_size = COMMUCATION_BATCH_RECORD_SIZE(field_num);
+    batch->record_max = COMMUCATION_BATCH_DATA_MAX / batch->record_size;
+    /* 定时器由FreeRTOS堆分配,在临界区之外创建;发送端在返回句柄之前不会被其他任务访问 */
+    batch->deadline_timer = xTimerCreate("batch_deadline", pdMS_TO_TICKS(deadline_ms), pdFALSE, batch, batch_deadline_callback);
+    if (batch->deadline_timer == NULL)
+    {
+        LOGERROR("[batch_create]Batch Timer Create Failed!\r\n");
+        pool_free(&batch_instance_pool, batch);
+        return NULL;
+    }
+    batch->report_tick = xTaskGetTickCount();
+    return batch;
+}
+/**
+ * @description: 追加一条记录,帧写满时立即发送,不能在中断中调用
+ *               记录写入私有缓冲区,发送前不占用帧槽:未写满的帧不会挡住发送队列中后面的数据帧
+ * @param {Commucation_BatchHandle} batch 批量数据帧句柄
+ * @param {uint32_t} timestamp 记录时间戳,单位由调用者约定
+ * @param {float} *fields field_num个float数据
+ * @return {*} TRUE:记录已写入;FALSE:写满的帧因发送队列满被丢弃,包括这条记录
+ */
+uint8_t commucation_batch_append(Commucation_BatchHandle batch, uint32_t timestamp, const float *fields)
+{
+    uint8_t record[COMMUCATION_BATCH_DATA_MAX];
+    uint8_t *dest;
+    uint8_t first_record;
+    uint8_t record_count = 0;
+    taskENTER_CRITICAL();
+    first_record = (batch->record_count == 0);
+    /* 小端平台:内存布局即为先发低字节的顺序 */
+    dest = batch->record + batch->record_count * batch->record_size;
+    memcpy(dest, &timestamp, 4);
+    memcpy(dest + 4, fields, 4 * batch->field_num);
+    batch->record_count++;
+    /* 写满时在同一个临界区内取出,其他任务不会写入已满的缓冲区 */
+    if (batch->record_count >= batch->record_max)
+    {
+        record_count = batch_detach(batch, record);
+    }
+    taskEXIT_CRITICAL();
+    if (record_count != 0)
+    {
+        /* 写满发送,停止截止时间定时器 */
+        xTimerStop(batch->deadline_timer, 0);
+        return batch_commit(batch, record, record_count, 0);
+    }
+    if (first_record)
+    {
+        /* 第一条记录写入,启动截止时间定时器 */
+        xTimerReset(batch->deadline_timer, 0);
+    }
+    return TRUE;
+}
+/**
+ * @description: 立即发送未写满的帧
+ * @param {Commucation_BatchHandle} batch 批量数据帧句柄
+ * @return {*}
+ */
+void commucation_batch_flush(Commucation_BatchHandle batch)
+{
+    uint8_t record[COMMUCATION_BATCH_DATA_MAX];
+    uint8_t record_count;
+    taskENTER_CRITICAL();
+    record_count = batch_detach(batch, record);
+    taskEXIT_CRITICAL();
+    if (record_count != 0)
+    {
+        xTimerStop(batch->deadline_timer, 0);
+        batch_commit(batch, record, record_count, 0);
+    }
+}
+/**
+ * @description: 打印批量数据帧的统计信息:两次调用之间实测的记录速率与串口吞吐量
+ *               有效载荷效率 = 记录字节数 / 数据帧字节数
+ *               串口占用率按每字节10 bit(起始位 + 8位数据 + 停止位)与串口实际配置的波特率计算
+ *               发送队列满而丢弃的帧由发送队列计数,见uart_tx_report
+ * @param {Commucation_BatchHandle} batch 批量数据帧句柄
+ * @return {*}
+ */
+void commucation_batch_report(Commucation_BatchHandle batch)
+{
+    TickType_t tick = xTaskGetTickCount();
+    uint32_t records = batch->record_total;
+    uint32_t wire_bytes = batch->wire_bytes;
+    uint32_t baud_rate = batch->uart_instance_handle->uartHandle->Init.BaudRate;
+    uint32_t records_per_second = 0;
+    uint32_t bytes_per_second = 0;
+    if (tick != batch->report_tick)
+    {
+        records_per_second = (records - batch->report_records) * configTICK_RATE_HZ / (tick - batch->report_tick);
+        bytes_per_second = (wire_bytes - batch->report_wire_bytes) * configTICK_RATE_HZ / (tick - batch->report_tick);
+    }
+    batch->report_records = records;
+    batch->report_wire_bytes = wire_bytes;
+    batch->report_tick = tick;
+    LOGINFO("[batch]cmd 0x%04x [%d] records/s, [%d] bytes/s, uart [%d]%% of [%d] baud, [%d] records/frame.\r\n",
+            batch->cmd_id,
+            records_per_second,
+            bytes_per_second,
+            bytes_per_second * 10 / (baud_rate / 100),
+            baud_rate,
+            batch->record_max);
+    LOGINFO("[batch]cmd 0x%04x [%d] frames, deadline flush [%d], efficiency [%d]%%.\r\n",
+            batch->cmd_id,
+            batch->frame_total,
+            batch->deadline_flush,
+            (batch->wire_bytes != 0) ? batch->payload_bytes * 100 / batch->wire_bytes : 0);
+}
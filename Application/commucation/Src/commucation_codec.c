@@ -0,0 +1,115 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-20 10:07:22
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-01-28 15:37:20
+ * @Description: commucation_codec.c 由commucation_schema.h展开生成的编解码自测与吞吐量测试
+ *               编解码函数本身在commucation_codec.h中,该文件只包含测试代码
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#define LOG_MODULE COMMUCATION /* 日志模块,必须在包含头文件之前定义,见rtt.h */
+#include "commucation_codec.h"
+#ifdef __COMMUCATION_CODEC_TEST
+#include "FreeRTOS.h"
+#include "task.h"
+#include "commucation.h"
+#include "dwt.h"
+#include "rtt.h"
+/**
+ * @description: 用伪随机数填充一个字段
+ * @param {void} *field 字段地址
+ * @param {uint8_t} size 字段字节数
+ * @param {uint32_t} *seed 随机数种子
+ * @return {*}
+ */
+static void codec_test_fill(void *field, uint8_t size, uint32_t *seed)
+{
+    for (uint8_t i = 0; i < size; i++)
+    {
+        *seed = *seed * 1103515245 + 12345;
+        ((uint8_t *)field)[i] = *seed >> 16;
+    }
+}
+/* 每条消息:随机填充 -> 编码 -> 校验帧长与crc16 -> 建立视图 -> 解码 -> 逐字段比较,并统计编解码节拍数 */
+#define CODEC_FIELD_FILL(type, name) codec_test_fill(&msg_in.name, sizeof(type), &seed);
+#define CODEC_FIELD_CHECK(type, name) pass &= (memcmp(&msg_in.name, &msg_out.name, sizeof(type)) == 0);
+#define CODEC_MSG_TEST(name, NAME, cmd, FIELDS)                                                                       \
+    {                                                                                                                 \
+        Schema_##name##Def msg_in;                                                                                    \
+        Schema_##name##Def msg_out;                                                                                   \
+        memset(&msg_out, 0, sizeof(msg_out));                                                                         \
+        codec_test_fill(&msg_in.flags_register, 2, &seed);                                                            \
+        FIELDS(CODEC_FIELD_FILL)                                                                                      \
+        taskENTER_CRITICAL();                                                                                         \
+        cycle_start = dwt_get_cycle();                                                                                \
+        for (uint16_t i = 0; i < COMMUCATION_CODEC_TEST_ROUNDS; i++)                                                  \
+        {                                                                                                             \
+            frame_length = schema_##name##_encode(frame, &msg_in);                                                    \
+        }                                                                                                             \
+        cycle_encode = dwt_get_cycle() - cycle_start;                                                                 \
+        taskEXIT_CRITICAL();                                                                                          \
+        pass = (frame_length == SCHEMA_##NAME##_FRAME_SIZE) && crc16_check(frame, frame_length) &&                    \
+               commucation_frame_view(frame, frame_length, &view);                                                    \
+        decode_count = 0;                                                                                             \
+        taskENTER_CRITICAL();                                                                                         \
+        cycle_start = dwt_get_cycle();                                                                                \
+        for (uint16_t i = 0; i < COMMUCATION_CODEC_TEST_ROUNDS; i++)                                                  \
+        {                                                                                                             \
+            decode_count += schema_##name##_decode(&view, &msg_out);                                                  \
+        }                                                                                                             \
+        cycle_decode = dwt_get_cycle() - cycle_start;                                                                 \
+        taskEXIT_CRITICAL();                                                                                          \
+        pass &= (decode_count == COMMUCATION_CODEC_TEST_ROUNDS) && (msg_in.flags_register == msg_out.flags_register); \
+        FIELDS(CODEC_FIELD_CHECK)                                                                                     \
+        /* 数据段长度不一致的数据帧必须被拒绝 */                                                                                       \
+        view.payload_length--;                                                                                        \
+        pass &= !schema_##name##_decode(&view, &msg_out);                                                             \
+        LOGINFO("[codec]%s cmd 0x%04x frame [%d] bytes: %s, encode [%d] cycles, decode [%d] cycles.\r\n",             \
+                #name, SCHEMA_##NAME##_CMD, SCHEMA_##NAME##_FRAME_SIZE, pass ? "pass" : "FAIL",                       \
+                cycle_encode / COMMUCATION_CODEC_TEST_ROUNDS, cycle_decode / COMMUCATION_CODEC_TEST_ROUNDS);          \
+    }
+/**
+ * @description: 编解码自测与吞吐量测试,逐条测试协议描述中的所有消息
+ *               测试数据消息与手写的commucation_frame_pack生成的数据帧逐字节比较,并对比耗时
+ * @return {*}
+ */
+void commucation_codec_test(void)
+{
+    uint8_t frame[PROTOCOL_FRAME_LENGTH_MAX];
+    uint8_t frame_reference[PROTOCOL_FRAME_LENGTH_MAX];
+    Commucation_FrameViewDef view;
+    Schema_test_dataDef test_data;
+    float reference_data[4];
+    uint32_t seed = 0x1234567;
+    uint32_t cycle_start;
+    uint32_t cycle_encode;
+    uint32_t cycle_decode;
+    uint32_t decode_count;
+    uint16_t frame_length = 0;
+    uint8_t pass;
+    COMMUCATION_SCHEMA(CODEC_MSG_TEST)
+    /* 与手写组帧函数比较:字段均为float时两者的数据帧应完全一致 */
+    test_data.flags_register = 0xFE55;
+    test_data.data0 = 1.43234f;
+    test_data.data1 = 231.43234f;
+    test_data.data2 = 9.34f;
+    test_data.data3 = 123.4554f;
+    reference_data[0] = test_data.data0;
+    reference_data[1] = test_data.data1;
+    reference_data[2] = test_data.data2;
+    reference_data[3] = test_data.data3;
+    frame_length = schema_test_data_encode(frame, &test_data);
+    taskENTER_CRITICAL();
+    cycle_start = dwt_get_cycle();
+    for (uint16_t i = 0; i < COMMUCATION_CODEC_TEST_ROUNDS; i++)
+    {
+        commucation_frame_pack(frame_reference, SCHEMA_TEST_DATA_CMD, test_data.flags_register, reference_data, 4);
+    }
+    cycle_encode = dwt_get_cycle() - cycle_start;
+    taskEXIT_CRITICAL();
+    LOGINFO("[codec]frame_pack reference: %s, [%d] cycles.\r\n",
+            (memcmp(frame, frame_reference, frame_length) == 0) ? "match" : "MISMATCH",
+            cycle_encode / COMMUCATION_CODEC_TEST_ROUNDS);
+}
+#endif //__COMMUCATION_CODEC_TEST
@@ -0,0 +1,464 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-06 10:12:52
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 10:31:05
+ * @Description: commucation_parser.c 串口通信协议流式解析器
+ *               按字节流增量解析,数据块可以在任意位置被截断或者包含多个数据帧
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include "commucation_parser.h"
+#include "string.h"
+/**
+ * @description: 检验crc8数据段
+ * @param {uint8_t} *message:输入字符串
+ * @param {uint16_t} size:字符串字节数
+ * @return {*}
+ */
+uint8_t crc8_check(uint8_t *message, uint16_t size)
+{
+    uint8_t ucExpected = 0; /* 期望值 */
+    /* 问题:为什么需要<=2,,不能计算一个字节数据的crc吗? */
+    if ((message == NULL) || (size <= 2))
+    {
+        return FALSE; /* false */
+    }
+    ucExpected = crc_8(message, size - 1);
+    return (ucExpected == message[size - 1]); /* true or false */
+}
+/**
+ * @description: 检验crc16数据段
+ * @param {uint8_t} *message:输入字符串
+ * @param {uint32_t} size:字符串字节数
+ * @return {*}
+ */
+uint8_t crc16_check(uint8_t *message, uint32_t size)
+{
+    /* 注意,期望值是16字节 */
+    uint16_t ucExpected = 0; /* 期望值 */
+    if ((message == NULL) || (size <= 2))
+    {
+        return FALSE; /* false */
+    }
+    /* 计算除了帧尾字节外的其他字节的crc16 */
+    ucExpected = crc_16(message, size - 2);
+    return (((ucExpected & 0xff) == message[size - 2]) && (((ucExpected >> 8) & 0xff) == message[size - 1])); /* true or false */
+}
+/**
+ * @description: 初始化解析器
+ * @param {Commucation_ParserHandle} parser 解析器句柄
+ * @param {uint8_t} framing 分帧方式:PARSER_FRAMING_SOF或PARSER_FRAMING_COBS
+ * @param {commucation_frame_callback} frame_callback 完整数据帧回调
+ * @return {*}
+ */
+void commucation_parser_init(Commucation_ParserHandle parser, uint8_t framing, commucation_frame_callback frame_callback)
+{
+    memset(parser, 0, sizeof(Commucation_ParserDef));
+    parser->framing = framing;
+    parser->state = (framing == PARSER_FRAMING_COBS) ? PARSER_STATE_COBS_COLLECT : PARSER_STATE_WAIT_SOF;
+    parser->frame_callback = frame_callback;
+}
+/**
+ * @description: 将新写入数据帧缓存的字节累加到crc上下文
+ *               crc8只覆盖帧头的前3个字节,crc16覆盖除帧尾2字节之外的所有字节
+ * @param {Commucation_ParserHandle} parser 解析器句柄
+ * @param {uint16_t} start 新写入字节在数据帧中的起始位置
+ * @param {uint16_t} n 新写入的字节数
+ * @param {uint16_t} crc16_end crc16覆盖范围的结束位置,帧头阶段数据帧长度未知,取帧头长度
+ * @return {*}
+ */
+static void parser_crc_update(Commucation_ParserHandle parser, uint16_t start, uint16_t n, uint16_t crc16_end)
+{
+    if (start < PROTOCOL_HEAD_SIZE - 1)
+    {
+        crc8_update(&parser->head_crc, parser->frame + start, ((start + n) < (PROTOCOL_HEAD_SIZE - 1)) ? n : (PROTOCOL_HEAD_SIZE - 1 - start));
+    }
+    if (start < crc16_end)
+    {
+        crc16_update(&parser->frame_crc, parser->frame + start, ((start + n) < crc16_end) ? n : (crc16_end - start));
+    }
+}
+/**
+ * @description: COBS分帧:解码分隔符之前缓存的数据,并按照通信协议检验
+ *               COBS分帧时帧边界由分隔符确定,校验失败不需要回放,直接等待下一个分隔符
+ * @param {Commucation_ParserHandle} parser 解析器句柄
+ * @return {*}
+ */
+static void parser_cobs_frame(Commucation_ParserHandle parser)
+{
+    uint16_t frame_length = cobs_decode(parser->frame, parser->frame_pos, parser->frame);
+    uint16_t data_length;
+    if ((frame_length < OFFSET_BYTE) || (frame_length > PROTOCOL_FRAME_LENGTH_MAX) ||
+        (parser->frame[0] != PROTOCOL_HEAD_CMD) || !crc8_check(parser->frame, PROTOCOL_HEAD_SIZE))
+    {
+        parser->head_error_count++;
+        return;
+    }
+    data_length = (parser->frame[2] << 8) | parser->frame[1]; /* 先发低字节,后发高字节 */
+    if ((data_length < 2) || (data_length + OFFSET_BYTE != frame_length))
+    {
+        parser->head_error_count++;
+        return;
+    }
+    if (!crc16_check(parser->frame, frame_length))
+    {
+        parser->crc_error_count++;
+        if (parser->crc_error_callback != NULL)
+        {
+            parser->crc_error_callback(parser->frame, frame_length);
+        }
+        return;
+    }
+    parser->frame_count++;
+    if (parser->frame_callback != NULL)
+    {
+        parser->frame_callback(parser->frame, frame_length);
+    }
+}
+/**
+ * @description: COBS分帧:消耗一段输入数据,直到输入耗尽或者遇到一个分隔符
+ * @param {Commucation_ParserHandle} parser 解析器句柄
+ * @param {uint8_t} *data 输入数据
+ * @param {uint16_t} length 输入数据字节数
+ * @return {*} 本次消耗的字节数
+ */
+static uint16_t parser_cobs_step(Commucation_ParserHandle parser, const uint8_t *data, uint16_t length)
+{
+    const uint8_t *delimiter = (const uint8_t *)memchr(data, COBS_DELIMITER, length);
+    uint16_t n = (delimiter != NULL) ? (delimiter - data) : length;
+    if (parser->state == PARSER_STATE_COBS_COLLECT)
+    {
+        if (parser->frame_pos + n > PARSER_BUFFER_SIZE)
+        {
+            /* 超出缓存大小,不可能是合法的数据帧,丢弃到下一个分隔符 */
+            parser->skip_bytes += parser->frame_pos;
+            parser->frame_pos = 0;
+            parser->state = PARSER_STATE_COBS_DISCARD;
+        }
+        else
+        {
+            memcpy(parser->frame + parser->frame_pos, data, n);
+            parser->frame_pos += n;
+        }
+    }
+    if (parser->state == PARSER_STATE_COBS_DISCARD)
+    {
+        parser->skip_bytes += n;
+    }
+    if (delimiter == NULL)
+    {
+        return n;
+    }
+    /* 遇到分隔符:解码并检验缓存的数据,随后从分隔符之后重新开始 */
+    if ((parser->state == PARSER_STATE_COBS_COLLECT) && (parser->frame_pos > 0))
+    {
+        parser_cobs_frame(parser);
+    }
+    parser->frame_pos = 0;
+    parser->state = PARSER_STATE_COBS_COLLECT;
+    return n + 1;
+}
+/**
+ * @description: 消耗一段输入数据,直到输入耗尽、得到一个完整数据帧或者校验失败
+ *               data允许指向parser->frame中尚未写到的位置(重新同步时原地回放),因此拷贝统一使用memmove
+ * @param {Commucation_ParserHandle} parser 解析器句柄
+ * @param {uint8_t} *data 输入数据
+ * @param {uint16_t} length 输入数据字节数
+ * @return {*} 本次消耗的字节数
+ */
+static uint16_t parser_step(Commucation_ParserHandle parser, const uint8_t *data, uint16_t length)
+{
+    const uint8_t *sof;
+    uint16_t data_length;
+    uint16_t crc;
+    uint16_t n;
+
+    if (parser->framing == PARSER_FRAMING_COBS)
+    {
+        return parser_cobs_step(parser, data, length);
+    }
+    switch (parser->state)
+    {
+    case PARSER_STATE_WAIT_SOF:
+        sof = (const uint8_t *)memchr(data, PROTOCOL_HEAD_CMD, length);
+        if (sof == NULL)
+        {
+            parser->skip_bytes += length;
+            return length;
+        }
+        parser->skip_bytes += sof - data;
+        parser->frame[0] = PROTOCOL_HEAD_CMD;
+        parser->frame_pos = 1;
+        crc8_init(&parser->head_crc);
+        crc16_init(&parser->frame_crc);
+        parser_crc_update(parser, 0, 1, PROTOCOL_HEAD_SIZE);
+        parser->state = PARSER_STATE_HEAD;
+        return (sof - data) + 1;
+    case PARSER_STATE_HEAD:
+        n = PROTOCOL_HEAD_SIZE - parser->frame_pos;
+        n = (n < length) ? n : length;
+        memmove(parser->frame + parser->frame_pos, data, n);
+        parser_crc_update(parser, parser->frame_pos, n, PROTOCOL_HEAD_SIZE);
+        parser->frame_pos += n;
+        if (parser->frame_pos < PROTOCOL_HEAD_SIZE)
+        {
+            return n;
+        }
+        /* 帧头接收完成:crc8已随字节到达累加完成,只需比较,并限制数据段长度,避免越界 */
+        data_length = (parser->frame[2] << 8) | parser->frame[1]; /* 先发低字节,后发高字节 */
+        if ((crc8_final(&parser->head_crc) != parser->frame[PROTOCOL_HEAD_SIZE - 1]) || (data_length < 2) || (data_length > PROTOCOL_FRAME_LENGTH_MAX - OFFSET_BYTE))
+        {
+            parser->head_error_count++;
+            parser->resync = TRUE;
+            return n;
+        }
+        parser->frame_length = data_length + OFFSET_BYTE;
+        parser->state = PARSER_STATE_BODY;
+        return n;
+    case PARSER_STATE_BODY:
+        n = parser->frame_length - parser->frame_pos;
+        n = (n < length) ? n : length;
+        memmove(parser->frame + parser->frame_pos, data, n);
+        parser_crc_update(parser, parser->frame_pos, n, parser->frame_length - 2);
+        parser->frame_pos += n;
+        if (parser->frame_pos < parser->frame_length)
+        {
+            return n;
+        }
+        /* 最后一个字节到达时crc16已经累加完成,只需与帧尾比较 */
+        crc = crc16_final(&parser->frame_crc);
+        if (((crc & 0xff) != parser->frame[parser->frame_length - 2]) || (((crc >> 8) & 0xff) != parser->frame[parser->frame_length - 1]))
+        {
+            parser->crc_error_count++;
+            if (parser->crc_error_callback != NULL)
+            {
+                parser->crc_error_callback(parser->frame, parser->frame_length);
+            }
+            parser->resync = TRUE;
+            return n;
+        }
+        parser->frame_count++;
+        if (parser->frame_callback != NULL)
+        {
+            parser->frame_callback(parser->frame, parser->frame_length);
+        }
+        parser->frame_pos = 0;
+        parser->state = PARSER_STATE_WAIT_SOF;
+        return n;
+    default:
+        parser->frame_pos = 0;
+        parser->state = PARSER_STATE_WAIT_SOF;
+        return 0;
+    }
+}
+/**
+ * @description: 重新同步:缓存中的数据帧校验失败,丢弃其起始字节,将其余已缓存字节作为新的输入原地回放
+ *               回放从失败帧的第二个字节开始,已经越过的字节不会被重复扫描
+ * @param {Commucation_ParserHandle} parser 解析器句柄
+ * @return {*}
+ */
+static void parser_resync(Commucation_ParserHandle parser)
+{
+    uint16_t replay_length = parser->frame_pos; /* 待回放数据位于frame[replay_pos, replay_length) */
+    uint16_t replay_pos = 1;                    /* 跳过失败帧的sof */
+
+    parser->resync = FALSE;
+    parser->skip_bytes++;
+    parser->frame_pos = 0;
+    parser->state = PARSER_STATE_WAIT_SOF;
+    while (replay_pos < replay_length)
+    {
+        /* 写入位置frame_pos始终不超过读取位置replay_pos,原地回放不会覆盖未读数据 */
+        replay_pos += parser_step(parser, parser->frame + replay_pos, replay_length - replay_pos);
+        if (parser->resync)
+        {
+            /* 回放过程中再次校验失败:将剩余待回放数据接到已缓存数据之后,再次从第二个字节开始回放 */
+            memmove(parser->frame + parser->frame_pos, parser->frame + replay_pos, replay_length - replay_pos);
+            replay_length = parser->frame_pos + (replay_length - replay_pos);
+            replay_pos = 1;
+            parser->resync = FALSE;
+            parser->skip_bytes++;
+            parser->frame_pos = 0;
+            parser->state = PARSER_STATE_WAIT_SOF;
+        }
+    }
+}
+/**
+ * @description: 向解析器输入任意长度的数据块,数据块内的每一个完整数据帧都会通过回调输出
+ * @param {Commucation_ParserHandle} parser 解析器句柄
+ * @param {uint8_t} *data 输入数据
+ * @param {uint16_t} length 输入数据字节数
+ * @return {*}
+ */
+void commucation_parser_feed(Commucation_ParserHandle parser, const uint8_t *data, uint16_t length)
+{
+    uint16_t pos = 0;
+    while (pos < length)
+    {
+        pos += parser_step(parser, data + pos, length - pos);
+        if (parser->resync)
+        {
+            parser_resync(parser);
+        }
+    }
+}
+/**
+ * @description: 数据段已写入frame + 6之后,补齐帧头、命令码与帧尾
+ * @param {uint8_t} *frame 数据帧缓存,大小不小于data_length + OFFSET_BYTE
+ * @param {uint16_t} cmd_id 命令码
+ * @param {uint16_t} data_length 数据段字节数,包含flags_register
+ * @return {*} 数据帧字节数
+ */
+uint16_t commucation_frame_seal(uint8_t *frame, uint16_t cmd_id, uint16_t data_length)
+{
+    uint16_t frame_tail;
+    /* 帧头部分 */
+    frame[0] = PROTOCOL_HEAD_CMD;
+    frame[1] = data_length;      /* 先发低字节 */
+    frame[2] = data_length >> 8; /* 后发高字节 */
+    frame[3] = crc_8(frame, 3);  /* 生成帧头的8位宽crc */
+    /* 命令码部分 */
+    frame[4] = cmd_id;      /* 先发低字节 */
+    frame[5] = cmd_id >> 8; /* 后发高字节 */
+    /* 整包校验部分 */
+    frame_tail = crc_16(frame, data_length + 6);
+    frame[data_length + 6] = frame_tail;      /* 先发低字节 */
+    frame[data_length + 7] = frame_tail >> 8; /* 后发高字节 */
+    return data_length + OFFSET_BYTE;
+}
+/**
+ * @description: COBS分帧发送:将位于buffer + PROTOCOL_COBS_OFFSET的原始数据帧原地编码到buffer起始位置,并追加分隔符
+ * @param {uint8_t} *buffer 发送缓存,大小不小于PROTOCOL_COBS_OFFSET + frame_length + 1
+ * @param {uint16_t} frame_length 原始数据帧字节数
+ * @return {*} 编码后包含分隔符的字节数
+ */
+uint16_t commucation_frame_cobs_wrap(uint8_t *buffer, uint16_t frame_length)
+{
+    uint16_t length = cobs_encode(buffer + PROTOCOL_COBS_OFFSET, frame_length, buffer);
+    buffer[length++] = COBS_DELIMITER;
+    return length;
+}
+/**
+ * @description: 在数据帧上建立只读视图,不拷贝数据段
+ *               数据帧的crc已由解析器检验,这里只检验长度字段与数据帧长度是否一致,以及数据段是否越界
+ * @param {uint8_t} *frame 完整数据帧
+ * @param {uint16_t} frame_length 数据帧字节数
+ * @param {Commucation_FrameViewHandle} view 输出的数据帧视图
+ * @return {*} TRUE:视图有效;FALSE:数据帧长度非法
+ */
+uint8_t commucation_frame_view(const uint8_t *frame, uint16_t frame_length, Commucation_FrameViewHandle view)
+{
+    uint16_t data_length;
+    if ((frame == NULL) || (view == NULL) || (frame_length < OFFSET_BYTE))
+    {
+        return FALSE;
+    }
+    data_length = (frame[2] << 8) | frame[1]; /* 先发低字节,后发高字节 */
+    /* 数据段至少包含16位寄存器,float数据部分不能超过PROTOCOL_DATA_LENGTH_MAX */
+    if ((data_length < 2) || (data_length + OFFSET_BYTE != frame_length) || (data_length > PROTOCOL_DATA_LENGTH_MAX + 2))
+    {
+        return FALSE;
+    }
+    view->cmd_id = (frame[5] << 8) | frame[4];         /* 先发低字节,后发高字节 */
+    view->flags_register = (frame[7] << 8) | frame[6]; /* 先发低字节,后发高字节 */
+    view->payload = frame + 8;
+    view->payload_length = data_length - 2;
+    return TRUE;
+}
+/**
+ * @description: 获取数据帧视图中float数据的个数
+ * @param {Commucation_FrameViewDef} *view 数据帧视图
+ * @return {*}
+ */
+uint16_t commucation_frame_view_float_num(const Commucation_FrameViewDef *view)
+{
+    return view->payload_length / 4;
+}
+/**
+ * @description: 读取数据帧视图中的第index个float数据
+ *               数据段不保证4字节对齐,按小端字节序逐字节组装,不能直接解引用float指针
+ * @param {Commucation_FrameViewDef} *view 数据帧视图
+ * @param {uint16_t} index float数据下标
+ * @param {float} *value 输出的float数据
+ * @return {*} TRUE:读取成功;FALSE:下标越界
+ */
+uint8_t commucation_frame_view_get_float(const Commucation_FrameViewDef *view, uint16_t index, float *value)
+{
+    const uint8_t *ptr;
+    uint32_t word;
+    if (index >= commucation_frame_view_float_num(view))
+    {
+        return FALSE;
+    }
+    ptr = view->payload + index * 4;
+    word = ((uint32_t)ptr[3] << 24) | ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[1] << 8) | ptr[0];
+    memcpy(value, &word, sizeof(float));
+    return TRUE;
+}
+/**
+ * @description: 初始化可靠传输接收端
+ * @param {Commucation_ReliableRxHandle} rx 接收端句柄
+ * @return {*}
+ */
+void commucation_reliable_rx_init(Commucation_ReliableRxHandle rx)
+{
+    memset(rx, 0, sizeof(Commucation_ReliableRxDef));
+}
+/**
+ * @description: 接收端收到一个可靠数据帧后更新确认状态
+ * @param {Commucation_ReliableRxHandle} rx 接收端句柄
+ * @param {uint8_t} seq 数据帧序号
+ * @return {*} TRUE:新的数据帧,需要交付;FALSE:重复或超出选择确认范围,丢弃(发送端会重传)
+ */
+uint8_t commucation_reliable_rx_accept(Commucation_ReliableRxHandle rx, uint8_t seq)
+{
+    uint8_t distance = seq - rx->expected;
+    if (distance >= 0x80)
+    {
+        /* 早于expected的序号:已经收到过 */
+        rx->duplicate_count++;
+        return FALSE;
+    }
+    if (distance == 0)
+    {
+        /* 按序到达:推进expected,并越过此前乱序到达的序号 */
+        /* 推进一次后位图第i位对应expected + i */
+        rx->expected++;
+        while (rx->sack_bitmap & 0x01)
+        {
+            rx->sack_bitmap >>= 1;
+            rx->expected++;
+        }
+        /* 恢复为第i位对应expected + 1 + i */
+        rx->sack_bitmap >>= 1;
+        return TRUE;
+    }
+    if (distance > RELIABLE_SACK_BITS)
+    {
+        return FALSE;
+    }
+    if (rx->sack_bitmap & (1ul << (distance - 1)))
+    {
+        rx->duplicate_count++;
+        return FALSE;
+    }
+    rx->sack_bitmap |= 1ul << (distance - 1);
+    return TRUE;
+}
+/**
+ * @description: 根据接收端状态生成确认帧
+ * @param {Commucation_ReliableRxDef} *rx 接收端句柄
+ * @param {uint8_t} *frame 数据帧缓存,大小不小于OFFSET_BYTE + 6
+ * @return {*} 数据帧字节数
+ */
+uint16_t commucation_reliable_ack_pack(const Commucation_ReliableRxDef *rx, uint8_t *frame)
+{
+    frame[6] = rx->expected; /* flags_register低8位:累计确认序号 */
+    frame[7] = 0;
+    frame[8] = rx->sack_bitmap; /* 选择确认位图,先发低字节 */
+    frame[9] = rx->sack_bitmap >> 8;
+    frame[10] = rx->sack_bitmap >> 16;
+    frame[11] = rx->sack_bitmap >> 24;
+    return commucation_frame_seal(frame, PROTOCOL_CMD_RELIABLE_ACK, 6);
+}
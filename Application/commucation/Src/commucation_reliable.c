@@ -0,0 +1,325 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-17 09:27:03
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 15:41:09
+ * @Description: commucation_reliable.c 滑动窗口可靠传输(发送端)
+ *               数据帧带8位序号,发送后保存在固定大小的重传缓存中,直到被上位机累计确认
+ *               窗口内的数据帧连续发送,不需要等待确认;超时未确认且未被选择确认的数据帧会被重传
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#define LOG_MODULE COMMUCATION /* 日志模块,必须在包含头文件之前定义,见rtt.h */
+#include "commucation_reliable.h"
+#include "commucation.h"
+#include "task.h"
+#include "rtt.h"
+#include "string.h"
+#include "pool.h"
+/* 确认帧由命令码处理函数接收,处理函数没有上下文参数,因此每条链路只支持一个发送端 */
+static Commucation_ReliableHandle reliable_instance = NULL;
+#ifdef __COMMUCATION_RELIABLE
+POOL_DEFINE(reliable_instance_pool, Commucation_ReliableDef, COMMUCATION_RELIABLE_INSTANCE_POOL_SIZE); /* 发送端对象池 */
+#else
+/* 未启用可靠传输时对象池容量为0,不占用静态内存,创建总是失败 */
+POOL_DEFINE_EMPTY(reliable_instance_pool);
+#endif //__COMMUCATION_RELIABLE
+/**
+ * @description: 将重传缓存中的数据帧写入串口发送队列,在临界区外调用,调用前该帧必须已锁定
+ * @param {Commucation_ReliableHandle} reliable 发送端句柄
+ * @param {Commucation_ReliableEntryDef} *entry 重传缓存帧
+ * @return {*} TRUE:已进入发送队列;FALSE:发送队列满,等待下一次重传检查
+ */
+static uint8_t reliable_transmit(Commucation_ReliableHandle reliable, Commucation_ReliableEntryDef *entry)
+{
+    uint16_t frame_length = entry->frame_length;
+    /* 超时时间为0,发送队列满时不等待 */
+    uint8_t *slot = uart_tx_frame_alloc(reliable->uart_instance_handle, 0);
+    if (slot == NULL)
+    {
+        return FALSE;
+    }
+    if (reliable->framing == PARSER_FRAMING_COBS)
+    {
+        memcpy(slot + PROTOCOL_COBS_OFFSET, entry->frame, frame_length);
+        frame_length = commucation_frame_cobs_wrap(slot, frame_length);
+    }
+    else
+    {
+        memcpy(slot, entry->frame, frame_length);
+    }
+    uart_tx_frame_commit(reliable->uart_instance_handle, slot, frame_length);
+    return TRUE;
+}
+/**
+ * @description: 解锁重传缓存帧,必须在临界区内调用
+ * @param {Commucation_ReliableEntryDef} *entry 重传缓存帧
+ * @return {*} TRUE:拷贝期间该帧已被累计确认,调用者需要在临界区外释放一个窗口
+ */
+static uint8_t reliable_unpin(Commucation_ReliableEntryDef *entry)
+{
+    uint8_t release = (entry->pin == RELIABLE_PIN_RELEASE);
+    entry->pin = RELIABLE_PIN_NONE;
+    return release;
+}
+/**
+ * @description: 确认帧处理函数,在串口解析任务中执行
+ *               累计确认之前的数据帧全部释放;选择确认位图中的数据帧不再重传
+ * @param {Commucation_FrameViewDef} *view 确认帧视图
+ * @return {*}
+ */
+static void reliable_ack_handler(const Commucation_FrameViewDef *view)
+{
+    Commucation_ReliableHandle reliable = reliable_instance;
+    Commucation_ReliableEntryDef *entry;
+    uint8_t ack = view->flags_register & 0xFF;
+    uint32_t sack_bitmap = 0;
+    uint8_t freed = 0;
+    uint8_t seq;
+    TickType_t tick = xTaskGetTickCount();
+    TickType_t rtt;
+    if (reliable == NULL)
+    {
+        return;
+    }
+    if (view->payload_length >= 4)
+    {
+        sack_bitmap = ((uint32_t)view->payload[3] << 24) | ((uint32_t)view->payload[2] << 16) | ((uint32_t)view->payload[1] << 8) | view->payload[0];
+    }
+    taskENTER_CRITICAL();
+    reliable->ack_count++;
+    /* 累计确认序号必须落在[base_seq, next_seq]之间,否则是过期的确认帧 */
+    if ((uint8_t)(ack - reliable->base_seq) > (uint8_t)(reliable->next_seq - reliable->base_seq))
+    {
+        taskEXIT_CRITICAL();
+        return;
+    }
+    while (reliable->base_seq != ack)
+    {
+        entry = &reliable->pool[reliable->base_seq & (COMMUCATION_RELIABLE_POOL_SIZE - 1)];
+        if ((entry->state == RELIABLE_ENTRY_INFLIGHT) && (entry->retransmit == 0))
+        {
+            /* 只用未重传过的数据帧采样往返时间,避免确认对应哪一次发送的歧义 */
+            rtt = tick - entry->sent_tick;
+            reliable->srtt = (reliable->srtt == 0) ? rtt : (reliable->srtt * 7 + rtt) / 8;
+            reliable->rto = (reliable->srtt * 2 > pdMS_TO_TICKS(COMMUCATION_RELIABLE_RTO_MIN_MS)) ? reliable->srtt * 2 : pdMS_TO_TICKS(COMMUCATION_RELIABLE_RTO_MIN_MS);
+        }
+        entry->state = RELIABLE_ENTRY_FREE;
+        reliable->acked_frames++;
+        reliable->base_seq++;
+        if (entry->pin != RELIABLE_PIN_NONE)
+        {
+            /* 该帧正在被拷贝,解锁之前不能分配给新的数据帧,窗口由解锁方释放 */
+            entry->pin = RELIABLE_PIN_RELEASE;
+            continue;
+        }
+        freed++;
+    }
+    for (uint8_t i = 0; (i < RELIABLE_SACK_BITS) && (sack_bitmap != 0); i++, sack_bitmap >>= 1)
+    {
+        seq = ack + 1 + i;
+        if ((sack_bitmap & 0x01) && ((uint8_t)(seq - reliable->base_seq) < (uint8_t)(reliable->next_seq - reliable->base_seq)))
+        {
+            reliable->pool[seq & (COMMUCATION_RELIABLE_POOL_SIZE - 1)].state = RELIABLE_ENTRY_SACKED;
+        }
+    }
+    taskEXIT_CRITICAL();
+    /* 释放窗口 */
+    while (freed--)
+    {
+        xSemaphoreGive(reliable->window_semaphore);
+    }
+}
+/**
+ * @description: 重传检查定时器回调,在定时器任务中执行
+ *               临界区内只记录超时的序号并锁定对应的帧,拷贝与COBS编码在临界区外完成
+ * @param {TimerHandle_t} xTimer
+ * @return {*}
+ */
+static void reliable_retransmit_callback(TimerHandle_t xTimer)
+{
+    Commucation_ReliableHandle reliable = (Commucation_ReliableHandle)pvTimerGetTimerID(xTimer);
+    Commucation_ReliableEntryDef *entry;
+    uint8_t expired[COMMUCATION_RELIABLE_POOL_SIZE];
+    uint8_t expired_num = 0;
+    uint8_t sent = 0;
+    uint8_t release = 0;
+    TickType_t tick = xTaskGetTickCount();
+    taskENTER_CRITICAL();
+    for (uint8_t seq = reliable->base_seq; seq != reliable->next_seq; seq++)
+    {
+        entry = &reliable->pool[seq & (COMMUCATION_RELIABLE_POOL_SIZE - 1)];
+        if ((entry->state != RELIABLE_ENTRY_INFLIGHT) || (entry->pin != RELIABLE_PIN_NONE) || (tick - entry->sent_tick < reliable->rto))
+        {
+            continue;
+        }
+        /* 先增加重传次数,拷贝期间到达的确认帧不会用该帧采样往返时间 */
+        entry->pin = RELIABLE_PIN_COPY;
+        entry->retransmit++;
+        expired[expired_num++] = seq;
+    }
+    taskEXIT_CRITICAL();
+    for (uint8_t i = 0; i < expired_num; i++)
+    {
+        entry = &reliable->pool[expired[i] & (COMMUCATION_RELIABLE_POOL_SIZE - 1)];
+        /* 发送队列满后剩余的数据帧留到下一次检查,只解锁 */
+        if ((sent == i) && reliable_transmit(reliable, entry))
+        {
+            sent++;
+        }
+        taskENTER_CRITICAL();
+        if (sent > i)
+        {
+            entry->sent_tick = tick;
+            reliable->retransmit_count++;
+        }
+        else
+        {
+            entry->retransmit--;
+        }
+        release += reliable_unpin(entry);
+        taskEXIT_CRITICAL();
+    }
+    /* 释放拷贝期间被确认的窗口 */
+    while (release--)
+    {
+        xSemaphoreGive(reliable->window_semaphore);
+    }
+}
+/**
+ * @description: 创建可靠传输发送端,并注册确认帧处理函数
+ * @param {UART_InstanceHandle} uart_instance_handle 发送使用的串口实例,必须已创建发送队列
+ * @param {uint8_t} framing 分帧方式:PARSER_FRAMING_SOF或PARSER_FRAMING_COBS,与该串口的接收端一致
+ * @param {uint8_t} window 窗口大小,范围1 ~ COMMUCATION_RELIABLE_POOL_SIZE
+ *                         窗口应不小于往返时间内链路可以发送的数据帧数,否则链路会在等待确认时空闲
+ * @return {*}
+ */
+Commucation_ReliableHandle Y_commucation_create_reliable(UART_InstanceHandle uart_instance_handle, uint8_t framing, uint8_t window)
+{
+    /* 检测参数是否合法 */
+    if ((uart_instance_handle == NULL) || (uart_instance_handle->tx_queue == NULL) ||
+        (window == 0) || (window > COMMUCATION_RELIABLE_POOL_SIZE) || (reliable_instance != NULL))
+    {
+        while (1)
+        {
+            LOGERROR("[reliable_create]Reliable Param Error!");
+        }
+    }
+    /* 从对象池中申请,常数时间,不使用FreeRTOS堆 */
+    Commucation_ReliableHandle reliable = (Commucation_ReliableHandle)pool_alloc(&reliable_instance_pool);
+    if (reliable == NULL)
+    {
+        LOGERROR("[reliable_create]Reliable Pool Is Full!\r\n");
+        return NULL;
+    }
+    memset(reliable, 0, sizeof(Commucation_ReliableDef));
+    reliable->uart_instance_handle = uart_instance_handle;
+    reliable->framing = framing;
+    reliable->window = window;
+    reliable->rto = pdMS_TO_TICKS(COMMUCATION_RELIABLE_RTO_MIN_MS);
+    /* 信号量与定时器由FreeRTOS堆分配,在临界区之外创建 */
+    reliable->window_semaphore = xSemaphoreCreateCounting(window, window);
+    reliable->retransmit_timer = xTimerCreate("reliable_rto", pdMS_TO_TICKS(COMMUCATION_RELIABLE_TIMER_MS), pdTRUE, reliable, reliable_retransmit_callback);
+    if ((reliable->window_semaphore == NULL) || (reliable->retransmit_timer == NULL))
+    {
+        LOGERROR("[reliable_create]Reliable Semaphore/Timer Create Failed!\r\n");
+        pool_free(&reliable_instance_pool, reliable);
+        return NULL;
+    }
+    reliable->report_tick = xTaskGetTickCount();
+    /* 进入临界区,挂载发送端 */
+    taskENTER_CRITICAL();
+    reliable_instance = reliable;
+    /* 退出临界区 */
+    taskEXIT_CRITICAL();
+    register_cmd_handler(PROTOCOL_CMD_RELIABLE_ACK, reliable_ack_handler, 4);
+    xTimerStart(reliable->retransmit_timer, 0);
+    return reliable;
+}
+/**
+ * @description: 通过可靠传输发送一帧数据,窗口已满时最多等待timeout
+ * @param {Commucation_ReliableHandle} reliable 发送端句柄
+ * @param {uint16_t} cmd_id 原始命令码
+ * @param {uint16_t} flags_register 原始16位寄存器
+ * @param {float} *tx_data 待发送的float数据
+ * @param {uint8_t} float_length float数据的个数,不超过COMMUCATION_RELIABLE_FLOAT_MAX
+ * @param {TickType_t} timeout 窗口满时的最长等待时间
+ * @return {*} TRUE:已进入窗口,保证送达;FALSE:参数非法或窗口满
+ */
+uint8_t commucation_reliable_send(Commucation_ReliableHandle reliable, uint16_t cmd_id, uint16_t flags_register, const float *tx_data, uint8_t float_length, TickType_t timeout)
+{
+    Commucation_ReliableEntryDef *entry;
+    uint8_t seq;
+    uint8_t transmitted;
+    uint8_t release;
+    if ((reliable == NULL) || (float_length > COMMUCATION_RELIABLE_FLOAT_MAX))
+    {
+        return FALSE;
+    }
+    if (xSemaphoreTake(reliable->window_semaphore, timeout) != pdTRUE)
+    {
+        return FALSE;
+    }
+    /* 分配序号:窗口信号量保证该序号对应的重传缓存帧空闲 */
+    taskENTER_CRITICAL();
+    seq = reliable->next_seq++;
+    taskEXIT_CRITICAL();
+    entry = &reliable->pool[seq & (COMMUCATION_RELIABLE_POOL_SIZE - 1)];
+    /* 在临界区外组帧,此时该帧仍为空闲状态,重传检查会跳过它 */
+    /* 数据段:序号、原始命令码、原始寄存器与float数据 */
+    entry->frame[6] = seq;
+    entry->frame[7] = 0;
+    entry->frame[8] = cmd_id;               /* 先发低字节 */
+    entry->frame[9] = cmd_id >> 8;          /* 后发高字节 */
+    entry->frame[10] = flags_register;      /* 先发低字节 */
+    entry->frame[11] = flags_register >> 8; /* 后发高字节 */
+    memcpy(entry->frame + 6 + RELIABLE_DATA_HEAD_SIZE, tx_data, 4 * float_length);
+    entry->frame_length = commucation_frame_seal(entry->frame, PROTOCOL_CMD_RELIABLE_DATA, RELIABLE_DATA_HEAD_SIZE + 4 * float_length);
+    entry->retransmit = 0;
+    /* 先锁定再进入窗口:发送后确认帧可能在解锁之前到达 */
+    taskENTER_CRITICAL();
+    entry->state = RELIABLE_ENTRY_INFLIGHT;
+    entry->pin = RELIABLE_PIN_COPY;
+    entry->sent_tick = xTaskGetTickCount();
+    reliable->tx_frames++;
+    taskEXIT_CRITICAL();
+    transmitted = reliable_transmit(reliable, entry);
+    taskENTER_CRITICAL();
+    if (!transmitted)
+    {
+        /* 发送队列满:标记为已超时,由重传检查尽快发送 */
+        entry->sent_tick = xTaskGetTickCount() - reliable->rto;
+    }
+    release = reliable_unpin(entry);
+    taskEXIT_CRITICAL();
+    if (release)
+    {
+        xSemaphoreGive(reliable->window_semaphore);
+    }
+    return TRUE;
+}
+/**
+ * @description: 打印可靠传输的统计信息
+ * @param {Commucation_ReliableHandle} reliable 发送端句柄
+ * @return {*}
+ */
+void commucation_reliable_report(Commucation_ReliableHandle reliable)
+{
+    TickType_t tick = xTaskGetTickCount();
+    uint32_t acked = reliable->acked_frames;
+    uint32_t frames_per_second = 0;
+    if (tick != reliable->report_tick)
+    {
+        frames_per_second = (acked - reliable->report_acked) * configTICK_RATE_HZ / (tick - reliable->report_tick);
+    }
+    reliable->report_acked = acked;
+    reliable->report_tick = tick;
+    LOGINFO("[reliable]Window [%d], in flight [%d], acked [%d] frames/s, sent [%d], retransmit [%d], srtt [%d] ms, rto [%d] ms.\r\n",
+            reliable->window,
+            (uint8_t)(reliable->next_seq - reliable->base_seq),
+            frames_per_second,
+            reliable->tx_frames,
+            reliable->retransmit_count,
+            reliable->srtt * portTICK_PERIOD_MS,
+            reliable->rto * portTICK_PERIOD_MS);
+}
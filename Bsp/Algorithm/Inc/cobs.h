@@ -0,0 +1,26 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-15 10:05:13
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-01-15 18:37:45
+ * @Description: cobs.h
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __COBS__H__
+#define __COBS__H__
+#include "stdint.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+#define COBS_DELIMITER 0x00                          /* 帧分隔符,编码后的数据中不会出现 */
+#define COBS_MAX_OVERHEAD(num_bytes) ((num_bytes) / 254 + 1) /* 编码后最多增加的字节数 */
+
+uint16_t cobs_encode(const uint8_t *input_str, uint16_t num_bytes, uint8_t *output_str);
+uint16_t cobs_decode(const uint8_t *input_str, uint16_t num_bytes, uint8_t *output_str);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //!__COBS__H__
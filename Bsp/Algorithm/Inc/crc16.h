@@ -2,7 +2,7 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-16 14:40:03
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-16 16:58:05
+ * @LastEditTime: 2025-01-09 11:06:52
  * @Description: crc16.h
  * 
  * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved. 
@@ -10,13 +10,36 @@
 #ifndef __CRC16__H__
 #define __CRC16__H__
 #include "stdint.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
 #define CRC_START_16 0xFFFF
 #define CRC_START_MODBUS 0xFFFF
 #define CRC_POLY_16 0xA001
+#define CRC16_SLICE_NUM 4 /* slice-by-4:每次处理4字节,需要4张256项查找表 */
+/* crc测试宏定义:测量crc_8与crc_16在不同数据帧长度下的吞吐量 */
+// #define __CRC_BENCHMARK
+#define CRC_BENCHMARK_SIZE_MAX 256 /* 测试数据帧的最大长度,从8字节开始逐次翻倍 */
 
 uint16_t crc_16(const uint8_t *input_str, uint16_t num_bytes);
 uint16_t crc_modbus(const uint8_t *input_str, uint16_t num_bytes);
 uint16_t update_crc_16(uint16_t crc, uint8_t c);
 void init_crc16_tab(void);
+/* crc16流式计算上下文:数据分块到达时逐块累加,避免整帧到达后再遍历一次 */
+typedef struct
+{
+    uint16_t crc; /* 当前crc值 */
+} CRC16_ContextDef;
+typedef CRC16_ContextDef *CRC16_ContextHandle;
+void crc16_init(CRC16_ContextHandle ctx);
+void crc16_update(CRC16_ContextHandle ctx, const uint8_t *input_str, uint16_t num_bytes);
+uint16_t crc16_final(CRC16_ContextHandle ctx);
+#ifdef __CRC_BENCHMARK
+void crc_benchmark(void);
+#endif //__CRC_BENCHMARK
 
+#ifdef __cplusplus
+}
+#endif
 #endif  //!__CRC16__H__
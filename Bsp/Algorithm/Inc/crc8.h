@@ -2,7 +2,7 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-16 14:39:57
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-16 16:58:28
+ * @LastEditTime: 2025-01-09 11:06:52
  * @Description: crc8.h
  * 
  * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved. 
@@ -10,8 +10,25 @@
 #ifndef __CRC8__H__
 #define __CRC8__H__
 #define CRC_START_8 0x00
+#define CRC8_SLICE_NUM 4 /* slice-by-4:每次处理4字节,需要4张256项查找表 */
 #include "stdint.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
 uint8_t crc_8(const uint8_t *input_str, uint16_t num_bytes);
 uint8_t update_crc_8(uint8_t crc, uint8_t val);
+/* crc8流式计算上下文:数据分块到达时逐块累加,避免整帧到达后再遍历一次 */
+typedef struct
+{
+    uint8_t crc; /* 当前crc值 */
+} CRC8_ContextDef;
+typedef CRC8_ContextDef *CRC8_ContextHandle;
+void crc8_init(CRC8_ContextHandle ctx);
+void crc8_update(CRC8_ContextHandle ctx, const uint8_t *input_str, uint16_t num_bytes);
+uint8_t crc8_final(CRC8_ContextHandle ctx);
 
+#ifdef __cplusplus
+}
+#endif
 #endif  //!__CRC8__H__
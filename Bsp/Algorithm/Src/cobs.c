@@ -0,0 +1,85 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-15 10:05:26
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-01-15 18:37:45
+ * @Description: cobs.c
+ *               COBS(Consistent Overhead Byte Stuffing)编解码
+ *               编码后的数据不包含0x00,因此0x00可以作为帧分隔符,接收端在下一个分隔符处即可重新同步
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include "cobs.h"
+#include "stdlib.h"
+/**
+ * @description: COBS编码,单次遍历,不包含帧分隔符
+ *               支持原地编码:output_str可以等于input_str - COBS_MAX_OVERHEAD(num_bytes),
+ *               此时写入位置始终不超过读取位置,不会覆盖未读取的数据
+ * @param {uint8_t} *input_str:输入字符串
+ * @param {uint16_t} num_bytes:字符串字节数
+ * @param {uint8_t} *output_str:输出缓存,大小不小于num_bytes + COBS_MAX_OVERHEAD(num_bytes)
+ * @return {*} 编码后的字节数
+ */
+uint16_t cobs_encode(const uint8_t *input_str, uint16_t num_bytes, uint8_t *output_str)
+{
+    uint8_t *code_ptr = output_str; /* 当前分组的长度码位置 */
+    uint8_t *ptr = output_str + 1;
+    uint8_t code = 1;
+    uint8_t val;
+    if ((input_str == NULL) || (output_str == NULL))
+        return 0;
+    while (num_bytes--)
+    {
+        val = *input_str++;
+        if (val == COBS_DELIMITER)
+        {
+            *code_ptr = code;
+            code_ptr = ptr++;
+            code = 1;
+            continue;
+        }
+        *ptr++ = val;
+        if (++code == 0xFF)
+        {
+            /* 分组已满254个非零字节 */
+            *code_ptr = code;
+            code_ptr = ptr++;
+            code = 1;
+        }
+    }
+    *code_ptr = code;
+    return ptr - output_str;
+}
+/**
+ * @description: COBS解码,单次遍历,输入不包含帧分隔符
+ *               支持原地解码:output_str可以等于input_str,解码后的数据总是比输入短
+ * @param {uint8_t} *input_str:输入字符串
+ * @param {uint16_t} num_bytes:字符串字节数
+ * @param {uint8_t} *output_str:输出缓存,大小不小于num_bytes
+ * @return {*} 解码后的字节数,输入非法时返回0
+ */
+uint16_t cobs_decode(const uint8_t *input_str, uint16_t num_bytes, uint8_t *output_str)
+{
+    const uint8_t *end = input_str + num_bytes;
+    uint8_t *ptr = output_str;
+    uint8_t code;
+    if ((input_str == NULL) || (output_str == NULL))
+        return 0;
+    while (input_str < end)
+    {
+        code = *input_str++;
+        /* 长度码为0或者超出输入范围,说明数据损坏 */
+        if ((code == COBS_DELIMITER) || (input_str + code - 1 > end))
+            return 0;
+        for (uint8_t i = 1; i < code; i++)
+        {
+            if (*input_str == COBS_DELIMITER)
+                return 0;
+            *ptr++ = *input_str++;
+        }
+        /* 长度码小于0xFF且不是最后一个分组时,分组后面是一个被编码掉的0x00 */
+        if ((code != 0xFF) && (input_str < end))
+            *ptr++ = COBS_DELIMITER;
+    }
+    return ptr - output_str;
+}
@@ -2,7 +2,7 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-16 14:39:35
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-16 16:58:37
+ * @LastEditTime: 2025-02-11 11:05:21
  * @Description: crc8.c
  * 
  * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved. 
@@ -11,31 +11,128 @@
 
 #include "crc8.h"
 #include "stdlib.h"
+#include "string.h"
 /*
- * static uint8_t sht75_crc_table[];
+ * static const uint8_t sht75_crc_table[][];
  *
  * The SHT75 humidity sensor is capable of calculating an 8 bit CRC checksum to
  * ensure data integrity. The lookup table crc_table[] is used to recalculate
  * the CRC.
+ * sht75_crc_table[0]为多项式0x31的单字节查找表,sht75_crc_table[k][x] = sht75_crc_table[0][sht75_crc_table[k - 1][x]]
+ * 表示字节x之后再跟随k个0x00字节时的crc贡献,用于slice-by-4,const修饰,存放在flash中
  */
-static uint8_t sht75_crc_table[] =
+static const uint8_t sht75_crc_table[CRC8_SLICE_NUM][256] =
+{
+    {
+        0x00, 0x31, 0x62, 0x53, 0xC4, 0xF5, 0xA6, 0x97, 0xB9, 0x88, 0xDB, 0xEA, 0x7D, 0x4C, 0x1F, 0x2E,
+        0x43, 0x72, 0x21, 0x10, 0x87, 0xB6, 0xE5, 0xD4, 0xFA, 0xCB, 0x98, 0xA9, 0x3E, 0x0F, 0x5C, 0x6D,
+        0x86, 0xB7, 0xE4, 0xD5, 0x42, 0x73, 0x20, 0x11, 0x3F, 0x0E, 0x5D, 0x6C, 0xFB, 0xCA, 0x99, 0xA8,
+        0xC5, 0xF4, 0xA7, 0x96, 0x01, 0x30, 0x63, 0x52, 0x7C, 0x4D, 0x1E, 0x2F, 0xB8, 0x89, 0xDA, 0xEB,
+        0x3D, 0x0C, 0x5F, 0x6E, 0xF9, 0xC8, 0x9B, 0xAA, 0x84, 0xB5, 0xE6, 0xD7, 0x40, 0x71, 0x22, 0x13,
+        0x7E, 0x4F, 0x1C, 0x2D, 0xBA, 0x8B, 0xD8, 0xE9, 0xC7, 0xF6, 0xA5, 0x94, 0x03, 0x32, 0x61, 0x50,
+        0xBB, 0x8A, 0xD9, 0xE8, 0x7F, 0x4E, 0x1D, 0x2C, 0x02, 0x33, 0x60, 0x51, 0xC6, 0xF7, 0xA4, 0x95,
+        0xF8, 0xC9, 0x9A, 0xAB, 0x3C, 0x0D, 0x5E, 0x6F, 0x41, 0x70, 0x23, 0x12, 0x85, 0xB4, 0xE7, 0xD6,
+        0x7A, 0x4B, 0x18, 0x29, 0xBE, 0x8F, 0xDC, 0xED, 0xC3, 0xF2, 0xA1, 0x90, 0x07, 0x36, 0x65, 0x54,
+        0x39, 0x08, 0x5B, 0x6A, 0xFD, 0xCC, 0x9F, 0xAE, 0x80, 0xB1, 0xE2, 0xD3, 0x44, 0x75, 0x26, 0x17,
+        0xFC, 0xCD, 0x9E, 0xAF, 0x38, 0x09, 0x5A, 0x6B, 0x45, 0x74, 0x27, 0x16, 0x81, 0xB0, 0xE3, 0xD2,
+        0xBF, 0x8E, 0xDD, 0xEC, 0x7B, 0x4A, 0x19, 0x28, 0x06, 0x37, 0x64, 0x55, 0xC2, 0xF3, 0xA0, 0x91,
+        0x47, 0x76, 0x25, 0x14, 0x83, 0xB2, 0xE1, 0xD0, 0xFE, 0xCF, 0x9C, 0xAD, 0x3A, 0x0B, 0x58, 0x69,
+        0x04, 0x35, 0x66, 0x57, 0xC0, 0xF1, 0xA2, 0x93, 0xBD, 0x8C, 0xDF, 0xEE, 0x79, 0x48, 0x1B, 0x2A,
+        0xC1, 0xF0, 0xA3, 0x92, 0x05, 0x34, 0x67, 0x56, 0x78, 0x49, 0x1A, 0x2B, 0xBC, 0x8D, 0xDE, 0xEF,
+        0x82, 0xB3, 0xE0, 0xD1, 0x46, 0x77, 0x24, 0x15, 0x3B, 0x0A, 0x59, 0x68, 0xFF, 0xCE, 0x9D, 0xAC,
+    },
+    {
+        0x00, 0xF4, 0xD9, 0x2D, 0x83, 0x77, 0x5A, 0xAE, 0x37, 0xC3, 0xEE, 0x1A, 0xB4, 0x40, 0x6D, 0x99,
+        0x6E, 0x9A, 0xB7, 0x43, 0xED, 0x19, 0x34, 0xC0, 0x59, 0xAD, 0x80, 0x74, 0xDA, 0x2E, 0x03, 0xF7,
+        0xDC, 0x28, 0x05, 0xF1, 0x5F, 0xAB, 0x86, 0x72, 0xEB, 0x1F, 0x32, 0xC6, 0x68, 0x9C, 0xB1, 0x45,
+        0xB2, 0x46, 0x6B, 0x9F, 0x31, 0xC5, 0xE8, 0x1C, 0x85, 0x71, 0x5C, 0xA8, 0x06, 0xF2, 0xDF, 0x2B,
+        0x89, 0x7D, 0x50, 0xA4, 0x0A, 0xFE, 0xD3, 0x27, 0xBE, 0x4A, 0x67, 0x93, 0x3D, 0xC9, 0xE4, 0x10,
+        0xE7, 0x13, 0x3E, 0xCA, 0x64, 0x90, 0xBD, 0x49, 0xD0, 0x24, 0x09, 0xFD, 0x53, 0xA7, 0x8A, 0x7E,
+        0x55, 0xA1, 0x8C, 0x78, 0xD6, 0x22, 0x0F, 0xFB, 0x62, 0x96, 0xBB, 0x4F, 0xE1, 0x15, 0x38, 0xCC,
+        0x3B, 0xCF, 0xE2, 0x16, 0xB8, 0x4C, 0x61, 0x95, 0x0C, 0xF8, 0xD5, 0x21, 0x8F, 0x7B, 0x56, 0xA2,
+        0x23, 0xD7, 0xFA, 0x0E, 0xA0, 0x54, 0x79, 0x8D, 0x14, 0xE0, 0xCD, 0x39, 0x97, 0x63, 0x4E, 0xBA,
+        0x4D, 0xB9, 0x94, 0x60, 0xCE, 0x3A, 0x17, 0xE3, 0x7A, 0x8E, 0xA3, 0x57, 0xF9, 0x0D, 0x20, 0xD4,
+        0xFF, 0x0B, 0x26, 0xD2, 0x7C, 0x88, 0xA5, 0x51, 0xC8, 0x3C, 0x11, 0xE5, 0x4B, 0xBF, 0x92, 0x66,
+        0x91, 0x65, 0x48, 0xBC, 0x12, 0xE6, 0xCB, 0x3F, 0xA6, 0x52, 0x7F, 0x8B, 0x25, 0xD1, 0xFC, 0x08,
+        0xAA, 0x5E, 0x73, 0x87, 0x29, 0xDD, 0xF0, 0x04, 0x9D, 0x69, 0x44, 0xB0, 0x1E, 0xEA, 0xC7, 0x33,
+        0xC4, 0x30, 0x1D, 0xE9, 0x47, 0xB3, 0x9E, 0x6A, 0xF3, 0x07, 0x2A, 0xDE, 0x70, 0x84, 0xA9, 0x5D,
+        0x76, 0x82, 0xAF, 0x5B, 0xF5, 0x01, 0x2C, 0xD8, 0x41, 0xB5, 0x98, 0x6C, 0xC2, 0x36, 0x1B, 0xEF,
+        0x18, 0xEC, 0xC1, 0x35, 0x9B, 0x6F, 0x42, 0xB6, 0x2F, 0xDB, 0xF6, 0x02, 0xAC, 0x58, 0x75, 0x81,
+    },
+    {
+        0x00, 0x46, 0x8C, 0xCA, 0x29, 0x6F, 0xA5, 0xE3, 0x52, 0x14, 0xDE, 0x98, 0x7B, 0x3D, 0xF7, 0xB1,
+        0xA4, 0xE2, 0x28, 0x6E, 0x8D, 0xCB, 0x01, 0x47, 0xF6, 0xB0, 0x7A, 0x3C, 0xDF, 0x99, 0x53, 0x15,
+        0x79, 0x3F, 0xF5, 0xB3, 0x50, 0x16, 0xDC, 0x9A, 0x2B, 0x6D, 0xA7, 0xE1, 0x02, 0x44, 0x8E, 0xC8,
+        0xDD, 0x9B, 0x51, 0x17, 0xF4, 0xB2, 0x78, 0x3E, 0x8F, 0xC9, 0x03, 0x45, 0xA6, 0xE0, 0x2A, 0x6C,
+        0xF2, 0xB4, 0x7E, 0x38, 0xDB, 0x9D, 0x57, 0x11, 0xA0, 0xE6, 0x2C, 0x6A, 0x89, 0xCF, 0x05, 0x43,
+        0x56, 0x10, 0xDA, 0x9C, 0x7F, 0x39, 0xF3, 0xB5, 0x04, 0x42, 0x88, 0xCE, 0x2D, 0x6B, 0xA1, 0xE7,
+        0x8B, 0xCD, 0x07, 0x41, 0xA2, 0xE4, 0x2E, 0x68, 0xD9, 0x9F, 0x55, 0x13, 0xF0, 0xB6, 0x7C, 0x3A,
+        0x2F, 0x69, 0xA3, 0xE5, 0x06, 0x40, 0x8A, 0xCC, 0x7D, 0x3B, 0xF1, 0xB7, 0x54, 0x12, 0xD8, 0x9E,
+        0xD5, 0x93, 0x59, 0x1F, 0xFC, 0xBA, 0x70, 0x36, 0x87, 0xC1, 0x0B, 0x4D, 0xAE, 0xE8, 0x22, 0x64,
+        0x71, 0x37, 0xFD, 0xBB, 0x58, 0x1E, 0xD4, 0x92, 0x23, 0x65, 0xAF, 0xE9, 0x0A, 0x4C, 0x86, 0xC0,
+        0xAC, 0xEA, 0x20, 0x66, 0x85, 0xC3, 0x09, 0x4F, 0xFE, 0xB8, 0x72, 0x34, 0xD7, 0x91, 0x5B, 0x1D,
+        0x08, 0x4E, 0x84, 0xC2, 0x21, 0x67, 0xAD, 0xEB, 0x5A, 0x1C, 0xD6, 0x90, 0x73, 0x35, 0xFF, 0xB9,
+        0x27, 0x61, 0xAB, 0xED, 0x0E, 0x48, 0x82, 0xC4, 0x75, 0x33, 0xF9, 0xBF, 0x5C, 0x1A, 0xD0, 0x96,
+        0x83, 0xC5, 0x0F, 0x49, 0xAA, 0xEC, 0x26, 0x60, 0xD1, 0x97, 0x5D, 0x1B, 0xF8, 0xBE, 0x74, 0x32,
+        0x5E, 0x18, 0xD2, 0x94, 0x77, 0x31, 0xFB, 0xBD, 0x0C, 0x4A, 0x80, 0xC6, 0x25, 0x63, 0xA9, 0xEF,
+        0xFA, 0xBC, 0x76, 0x30, 0xD3, 0x95, 0x5F, 0x19, 0xA8, 0xEE, 0x24, 0x62, 0x81, 0xC7, 0x0D, 0x4B,
+    },
+    {
+        0x00, 0x9B, 0x07, 0x9C, 0x0E, 0x95, 0x09, 0x92, 0x1C, 0x87, 0x1B, 0x80, 0x12, 0x89, 0x15, 0x8E,
+        0x38, 0xA3, 0x3F, 0xA4, 0x36, 0xAD, 0x31, 0xAA, 0x24, 0xBF, 0x23, 0xB8, 0x2A, 0xB1, 0x2D, 0xB6,
+        0x70, 0xEB, 0x77, 0xEC, 0x7E, 0xE5, 0x79, 0xE2, 0x6C, 0xF7, 0x6B, 0xF0, 0x62, 0xF9, 0x65, 0xFE,
+        0x48, 0xD3, 0x4F, 0xD4, 0x46, 0xDD, 0x41, 0xDA, 0x54, 0xCF, 0x53, 0xC8, 0x5A, 0xC1, 0x5D, 0xC6,
+        0xE0, 0x7B, 0xE7, 0x7C, 0xEE, 0x75, 0xE9, 0x72, 0xFC, 0x67, 0xFB, 0x60, 0xF2, 0x69, 0xF5, 0x6E,
+        0xD8, 0x43, 0xDF, 0x44, 0xD6, 0x4D, 0xD1, 0x4A, 0xC4, 0x5F, 0xC3, 0x58, 0xCA, 0x51, 0xCD, 0x56,
+        0x90, 0x0B, 0x97, 0x0C, 0x9E, 0x05, 0x99, 0x02, 0x8C, 0x17, 0x8B, 0x10, 0x82, 0x19, 0x85, 0x1E,
+        0xA8, 0x33, 0xAF, 0x34, 0xA6, 0x3D, 0xA1, 0x3A, 0xB4, 0x2F, 0xB3, 0x28, 0xBA, 0x21, 0xBD, 0x26,
+        0xF1, 0x6A, 0xF6, 0x6D, 0xFF, 0x64, 0xF8, 0x63, 0xED, 0x76, 0xEA, 0x71, 0xE3, 0x78, 0xE4, 0x7F,
+        0xC9, 0x52, 0xCE, 0x55, 0xC7, 0x5C, 0xC0, 0x5B, 0xD5, 0x4E, 0xD2, 0x49, 0xDB, 0x40, 0xDC, 0x47,
+        0x81, 0x1A, 0x86, 0x1D, 0x8F, 0x14, 0x88, 0x13, 0x9D, 0x06, 0x9A, 0x01, 0x93, 0x08, 0x94, 0x0F,
+        0xB9, 0x22, 0xBE, 0x25, 0xB7, 0x2C, 0xB0, 0x2B, 0xA5, 0x3E, 0xA2, 0x39, 0xAB, 0x30, 0xAC, 0x37,
+        0x11, 0x8A, 0x16, 0x8D, 0x1F, 0x84, 0x18, 0x83, 0x0D, 0x96, 0x0A, 0x91, 0x03, 0x98, 0x04, 0x9F,
+        0x29, 0xB2, 0x2E, 0xB5, 0x27, 0xBC, 0x20, 0xBB, 0x35, 0xAE, 0x32, 0xA9, 0x3B, 0xA0, 0x3C, 0xA7,
+        0x61, 0xFA, 0x66, 0xFD, 0x6F, 0xF4, 0x68, 0xF3, 0x7D, 0xE6, 0x7A, 0xE1, 0x73, 0xE8, 0x74, 0xEF,
+        0x59, 0xC2, 0x5E, 0xC5, 0x57, 0xCC, 0x50, 0xCB, 0x45, 0xDE, 0x42, 0xD9, 0x4B, 0xD0, 0x4C, 0xD7,
+    }
+};
+/**
+ * @description: slice-by-4计算crc8,每次处理一个32位字
+ *               先逐字节处理到4字节对齐,再按字处理,最后逐字节处理剩余部分
+ * @param {uint8_t} crc:初始crc值
+ * @param {uint8_t} *ptr:输入字符串
+ * @param {uint16_t} num_bytes:字符串长度
+ * @return {*}
+ */
+static uint8_t crc8_slice4(uint8_t crc, const uint8_t *ptr, uint16_t num_bytes)
+{
+    uint32_t word;
+    /* 逐字节处理到4字节对齐 */
+    while ((num_bytes > 0) && (((uintptr_t)ptr & 0x03) != 0))
+    {
+        crc = sht75_crc_table[0][(*ptr++) ^ crc];
+        num_bytes--;
+    }
+    /* 按字处理,小端平台下第一个字节位于低8位 */
+    while (num_bytes >= 4)
+    {
+        /* 用memcpy读取,不违反严格别名规则,编译后仍是一次32位读取 */
+        memcpy(&word, ptr, sizeof(word));
+        crc = sht75_crc_table[3][(word & 0xFF) ^ crc] ^
+              sht75_crc_table[2][(word >> 8) & 0xFF] ^
+              sht75_crc_table[1][(word >> 16) & 0xFF] ^
+              sht75_crc_table[0][word >> 24];
+        ptr += 4;
+        num_bytes -= 4;
+    }
+    /* 逐字节处理剩余部分 */
+    while (num_bytes > 0)
     {
-        0, 49, 98, 83, 196, 245, 166, 151, 185, 136, 219, 234, 125, 76, 31, 46,
-        67, 114, 33, 16, 135, 182, 229, 212, 250, 203, 152, 169, 62, 15, 92, 109,
-        134, 183, 228, 213, 66, 115, 32, 17, 63, 14, 93, 108, 251, 202, 153, 168,
-        197, 244, 167, 150, 1, 48, 99, 82, 124, 77, 30, 47, 184, 137, 218, 235,
-        61, 12, 95, 110, 249, 200, 155, 170, 132, 181, 230, 215, 64, 113, 34, 19,
-        126, 79, 28, 45, 186, 139, 216, 233, 199, 246, 165, 148, 3, 50, 97, 80,
-        187, 138, 217, 232, 127, 78, 29, 44, 2, 51, 96, 81, 198, 247, 164, 149,
-        248, 201, 154, 171, 60, 13, 94, 111, 65, 112, 35, 18, 133, 180, 231, 214,
-        122, 75, 24, 41, 190, 143, 220, 237, 195, 242, 161, 144, 7, 54, 101, 84,
-        57, 8, 91, 106, 253, 204, 159, 174, 128, 177, 226, 211, 68, 117, 38, 23,
-        252, 205, 158, 175, 56, 9, 90, 107, 69, 116, 39, 22, 129, 176, 227, 210,
-        191, 142, 221, 236, 123, 74, 25, 40, 6, 55, 100, 85, 194, 243, 160, 145,
-        71, 118, 37, 20, 131, 178, 225, 208, 254, 207, 156, 173, 58, 11, 88, 105,
-        4, 53, 102, 87, 192, 241, 162, 147, 189, 140, 223, 238, 121, 72, 27, 42,
-        193, 240, 163, 146, 5, 52, 103, 86, 120, 73, 26, 43, 188, 141, 222, 239,
-        130, 179, 224, 209, 70, 119, 36, 21, 59, 10, 89, 104, 255, 206, 157, 172};
+        crc = sht75_crc_table[0][(*ptr++) ^ crc];
+        num_bytes--;
+    }
+    return crc;
+}
 /**
  * @description: 计算输入字符串的8位宽crc
  * @param {uint8_t} *input_str:输入字符串
@@ -44,18 +141,9 @@ static uint8_t sht75_crc_table[] =
  */
 uint8_t crc_8(const uint8_t *input_str, uint16_t num_bytes)
 {
-    uint16_t a;
-    uint8_t crc;
-    const uint8_t *ptr;
-
-    crc = CRC_START_8;
-    ptr = input_str;
-    if (ptr != NULL)
-        for (a = 0; a < num_bytes; a++)
-        {
-            crc = sht75_crc_table[(*ptr++) ^ crc];
-        }
-    return crc;
+    if (input_str == NULL)
+        return CRC_START_8;
+    return crc8_slice4(CRC_START_8, input_str, num_bytes);
 }
 /**
  * @description: 计算数据新的实际crc值
@@ -65,5 +153,37 @@ uint8_t crc_8(const uint8_t *input_str, uint16_t num_bytes)
  */
 uint8_t update_crc_8(uint8_t crc, uint8_t val)
 {
-    return sht75_crc_table[val ^ crc];
+    return sht75_crc_table[0][val ^ crc];
+}
+/**
+ * @description: 初始化crc8流式计算上下文
+ * @param {CRC8_ContextHandle} ctx 上下文句柄
+ * @return {*}
+ */
+void crc8_init(CRC8_ContextHandle ctx)
+{
+    ctx->crc = CRC_START_8;
+}
+/**
+ * @description: 将一段数据累加到crc8上下文,结果与逐字节调用update_crc_8一致
+ *               数据可以分多次输入,例如DMA每次半满/全满/IDLE事件到达的数据块
+ * @param {CRC8_ContextHandle} ctx 上下文句柄
+ * @param {uint8_t} *input_str 数据块
+ * @param {uint16_t} num_bytes 数据块字节数
+ * @return {*}
+ */
+void crc8_update(CRC8_ContextHandle ctx, const uint8_t *input_str, uint16_t num_bytes)
+{
+    if (input_str == NULL)
+        return;
+    ctx->crc = crc8_slice4(ctx->crc, input_str, num_bytes);
+}
+/**
+ * @description: 获取crc8上下文的最终结果
+ * @param {CRC8_ContextHandle} ctx 上下文句柄
+ * @return {*}
+ */
+uint8_t crc8_final(CRC8_ContextHandle ctx)
+{
+    return ctx->crc;
 }
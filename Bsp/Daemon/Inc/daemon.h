@@ -2,7 +2,7 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-18 10:40:04
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-18 15:10:10
+ * @LastEditTime: 2025-02-10 18:12:40
  * @Description: daemon.h
  *
  * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
@@ -13,27 +13,51 @@
 #include "task.h"
 #include "stdint.h"
 #include "timers.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
 #define INSTANCE_DAEMON_CNT 10   /* daemon实例最大数量 */
 #define DAEMON_OWNER_TYPE_LED 1  /* LED类型 */
 #define DAEMON_OWNER_TYPE_BEEP 2 /* BEEP类型 */
 #define DAEMON_OWNER_TYPE_RC 3   /* Remote Control类型 */
 
-/* 重载值选择 */
-#define DAEMON_RELOAD_LED   4 /* LED类型的守护实例重载值:守护进程每50ms执行一次,而LED的回调函数要求200ms调用一次 */
-#define DAEMON_RELOD_RC     3 /* RC的daemon回调函数150ms执行一次,判断遥控器是否在线 */
+/* 守护进程的调度方式 */
+/**
+ * 所有守护实例按到期时刻组成最小堆,守护进程是一个单次软件定时器,每次只在堆顶实例到期时唤醒,
+ * 依次处理已经到期的实例后,将定时器重新设置到下一个到期时刻,处理开销只与到期的实例数有关
+ * 实例到期:调用回调函数,之后每隔period_ms再次到期;
+ * 喂狗:daemon_feed将到期时刻推迟到timeout_ms之后,持续喂狗的实例不会到期(用于离线检测)
+ */
+#define DAEMON_IDLE_PERIOD_MS 1000 /* 没有守护实例时定时器的唤醒周期 */
+/* 周期与超时选择 */
+#define DAEMON_PERIOD_LED_MS 200    /* LED的回调函数要求200ms调用一次 */
+#define DAEMON_PERIOD_RC_MS 150     /* 遥控器离线后,每150ms调用一次离线回调函数 */
+#define DAEMON_TIMEOUT_RC_MS 150    /* 遥控器超过150ms没有收到正确的数据帧即视为离线 */
 typedef void (*daemon_timeout_callback)(void *);
 typedef struct
 {
     /* data */
     uint8_t owner_type;               /* 拥有者的类型 */
     uint8_t owner_idx;                /* 拥有者的编号 */
-    uint16_t reload_count;            /* daemon维护的计数重载值:计数值从重载值减到0会触发超时回调函数:重载值为0时表示跟随守护进程执行(进入守护进程任务就会执行一次) */
-    uint16_t count;                   /* 计数值:从上到下计数 */
+    TickType_t period;                /* 到期后再次到期的间隔,单位tick */
+    TickType_t timeout;               /* 喂狗后到期的间隔,单位tick */
+    TickType_t expiry;                /* 到期时刻 */
+    uint8_t heap_index;               /* 在最小堆中的位置 */
+    uint8_t delete_pending;           /* 回调函数执行期间被删除,回调结束后释放 */
+    uint32_t expire_count;            /* 到期次数 */
     daemon_timeout_callback callback; /* 守护超时回调函数 */
     void *owner_instance_handle;      /* 拥有者的实例句柄(需要强制转换成所需类型) */
 } Daemon_InstanceDef;
 typedef Daemon_InstanceDef *Daemon_InstanceHandle;
 
-Daemon_InstanceHandle Y_daemon_create_instance(void *owner_instance_handle, uint8_t owner_type, uint8_t owner_id, uint16_t reload_count, daemon_timeout_callback callback);
+void daemon_scheduler_start(void);
+Daemon_InstanceHandle Y_daemon_create_instance(void *owner_instance_handle, uint8_t owner_type, uint8_t owner_id, uint16_t period_ms, uint16_t timeout_ms, daemon_timeout_callback callback);
+void daemon_delete_instance(Daemon_InstanceHandle daemon_instance_handle);
+void daemon_feed(Daemon_InstanceHandle daemon_instance_handle);
+TickType_t daemon_next_expiry(void);
 void deamon_timer_callback(TimerHandle_t xTimer);
+#ifdef __cplusplus
+}
+#endif
 #endif //!__DAEMON__H__
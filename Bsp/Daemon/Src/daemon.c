@@ -2,11 +2,11 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-18 10:39:36
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-20 13:52:02
+ * @LastEditTime: 2025-02-10 18:12:40
  * @Description: daemon.c
- *               该文件实现守护实例的创建操作
- *               注意事项:通过实现一个软件定时器作为守护进程,守护进程维护这些守护实例
- *               守护进程对应的软件定时器的执行周期是50ms(测试中ing...)
+ *               该文件实现守护实例的创建、删除与喂狗操作
+ *               注意事项:守护进程是一个单次软件定时器,所有守护实例按到期时刻组成最小堆,
+ *               定时器只在最早到期的时刻唤醒,处理完到期的实例后重新设置到下一个到期时刻
  *
  * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
  */
@@ -14,77 +14,314 @@
 #include "daemon.h"
 #include "stdlib.h"
 #include "rtt.h"
-#include "led.h"
-#include "portable.h"
+#include "pool.h"
 
-/* 创建守护实例的挂载队列 */
-static Daemon_InstanceHandle daemon_instance_array[INSTANCE_DAEMON_CNT] = {NULL};
-static uint8_t daemon_instance_count = 0; /* 当前的daemon实例数量 */
+/* tick计数会溢出回绕,按差值比较先后:a早于b */
+#define DAEMON_TICK_BEFORE(a, b) ((TickType_t)((a) - (b)) > (portMAX_DELAY / 2))
+
+/* 守护实例的最小堆:堆顶为最早到期的实例 */
+static Daemon_InstanceHandle daemon_instance_heap[INSTANCE_DAEMON_CNT] = {NULL};
+static uint8_t daemon_instance_count = 0;          /* 当前的daemon实例数量 */
+static TimerHandle_t daemon_timer_handle = NULL;   /* 守护进程对应的单次软件定时器 */
+static TickType_t daemon_timer_expiry = 0;         /* 定时器下一次唤醒的时刻 */
+static Daemon_InstanceHandle daemon_running = NULL; /* 正在执行回调函数的实例 */
+POOL_DEFINE(daemon_instance_pool, Daemon_InstanceDef, INSTANCE_DAEMON_CNT); /* 守护实例对象池:容量与最小堆相同 */
+/**
+ * @description: 交换堆中的两个实例,同时更新实例记录的位置,调用时需要处于临界区
+ * @param {uint8_t} i
+ * @param {uint8_t} j
+ * @return {*}
+ */
+static void daemon_heap_swap(uint8_t i, uint8_t j)
+{
+    Daemon_InstanceHandle temp = daemon_instance_heap[i];
+    daemon_instance_heap[i] = daemon_instance_heap[j];
+    daemon_instance_heap[j] = temp;
+    daemon_instance_heap[i]->heap_index = i;
+    daemon_instance_heap[j]->heap_index = j;
+}
+/**
+ * @description: 到期时刻提前后向上调整,调用时需要处于临界区
+ * @param {uint8_t} i 实例在堆中的位置
+ * @return {*}
+ */
+static void daemon_heap_sift_up(uint8_t i)
+{
+    uint8_t parent;
+    while (i > 0)
+    {
+        parent = (i - 1) / 2;
+        if (!DAEMON_TICK_BEFORE(daemon_instance_heap[i]->expiry, daemon_instance_heap[parent]->expiry))
+        {
+            break;
+        }
+        daemon_heap_swap(i, parent);
+        i = parent;
+    }
+}
+/**
+ * @description: 到期时刻推迟后向下调整,调用时需要处于临界区
+ * @param {uint8_t} i 实例在堆中的位置
+ * @return {*}
+ */
+static void daemon_heap_sift_down(uint8_t i)
+{
+    uint8_t child;
+    while ((child = 2 * i + 1) < daemon_instance_count)
+    {
+        if ((child + 1 < daemon_instance_count) &&
+            DAEMON_TICK_BEFORE(daemon_instance_heap[child + 1]->expiry, daemon_instance_heap[child]->expiry))
+        {
+            child++;
+        }
+        if (!DAEMON_TICK_BEFORE(daemon_instance_heap[child]->expiry, daemon_instance_heap[i]->expiry))
+        {
+            break;
+        }
+        daemon_heap_swap(i, child);
+        i = child;
+    }
+}
 /**
- * @description: 创建守护实例进程
+ * @description: 实例的到期时刻早于定时器的唤醒时刻时需要重新设置定时器,调用时需要处于临界区
+ * @param {Daemon_InstanceHandle} daemon_instance_handle
+ * @return {*} 1:需要重新设置定时器
+ */
+static uint8_t daemon_timer_need_rearm(Daemon_InstanceHandle daemon_instance_handle)
+{
+    return (daemon_timer_handle != NULL) && (daemon_instance_handle->heap_index == 0) &&
+           DAEMON_TICK_BEFORE(daemon_instance_handle->expiry, daemon_timer_expiry);
+}
+/**
+ * @description: 将定时器设置到下一个到期时刻,不能在中断中调用
+ * @return {*}
+ */
+static void daemon_timer_rearm(void)
+{
+    TickType_t delay;
+    taskENTER_CRITICAL();
+    delay = daemon_next_expiry();
+    if (delay == portMAX_DELAY)
+    {
+        delay = pdMS_TO_TICKS(DAEMON_IDLE_PERIOD_MS);
+    }
+    if (delay == 0)
+    {
+        delay = 1;
+    }
+    daemon_timer_expiry = xTaskGetTickCount() + delay;
+    taskEXIT_CRITICAL();
+    /* 定时器命令队列已满时放弃本次设置,定时器仍会在原来的时刻唤醒并重新设置 */
+    xTimerChangePeriod(daemon_timer_handle, delay, 0);
+}
+/**
+ * @description: 创建守护进程对应的软件定时器
+ * @return {*}
+ */
+void daemon_scheduler_start(void)
+{
+    daemon_timer_handle = xTimerCreate("Daemon", pdMS_TO_TICKS(DAEMON_IDLE_PERIOD_MS), pdFALSE, (void *)1, deamon_timer_callback); /* 单次执行,每次唤醒后重新设置 */
+    if (daemon_timer_handle == NULL)
+    {
+        LOGERROR("[daemon_start]Daemon Timer Create Failed!\r\n");
+        return;
+    }
+    daemon_timer_rearm();
+}
+/**
+ * @description: 创建守护实例进程,可以在运行中创建
  * @param {void} *owner_instance_handle
  * @param {uint8_t} owner_type
  * @param {uint8_t} owner_id:从0开始
- * @param {uint16_t} reload_count
+ * @param {uint16_t} period_ms 到期后再次到期的间隔,单位ms
+ * @param {uint16_t} timeout_ms 创建或喂狗后到期的间隔,单位ms,为0时与period_ms相同
  * @param {daemon_timeout_callback} callback
  * @return {*}
  */
-Daemon_InstanceHandle Y_daemon_create_instance(void *owner_instance_handle, uint8_t owner_type, uint8_t owner_id, uint16_t reload_count, daemon_timeout_callback callback)
+Daemon_InstanceHandle Y_daemon_create_instance(void *owner_instance_handle, uint8_t owner_type, uint8_t owner_id, uint16_t period_ms, uint16_t timeout_ms, daemon_timeout_callback callback)
 {
-    /* 不需要对编号进行检测 */
-    /* 进入临界区,确保创建串口实例的过程是线程安全的,不要在检测串口是否合法之前进入临界区,这样会影响其他任务的调度,使整个系统卡死 */
+    uint8_t rearm;
+    /* 检测参数是否合法 */
+    if ((period_ms == 0) || (callback == NULL))
+    {
+        while (1)
+        {
+            LOGERROR("[daemon_create]Daemon Period Or Callback Is Illegal!");
+        }
+    }
+    /* 进入临界区,确保创建守护实例的过程是线程安全的 */
     taskENTER_CRITICAL();
-    Daemon_InstanceHandle daemon_instance_handle = (Daemon_InstanceHandle)pvPortMalloc(sizeof(Daemon_InstanceDef));
+    if (daemon_instance_count >= INSTANCE_DAEMON_CNT)
+    {
+        LOGERROR("[daemon_create]Daemon Instance Count Exceeds %d!\r\n", INSTANCE_DAEMON_CNT);
+        /* 退出临界区 */
+        taskEXIT_CRITICAL();
+        return NULL;
+    }
+    /* 从对象池中申请,常数时间,可以在临界区内调用 */
+    Daemon_InstanceHandle daemon_instance_handle = (Daemon_InstanceHandle)pool_alloc(&daemon_instance_pool);
     if (daemon_instance_handle == NULL)
     {
-        LOGERROR("[daemon_create]Daemon Instance Create Failed,Stack Overflow!\r\n");
+        LOGERROR("[daemon_create]Daemon Instance Pool Is Full!\r\n");
         /* 退出临界区 */
         taskEXIT_CRITICAL();
         return NULL;
     }
     daemon_instance_handle->owner_type = owner_type;
     daemon_instance_handle->owner_idx = owner_id;
-    daemon_instance_handle->reload_count = reload_count;
-    daemon_instance_handle->count = reload_count;
+    daemon_instance_handle->period = pdMS_TO_TICKS(period_ms) ? pdMS_TO_TICKS(period_ms) : 1;
+    daemon_instance_handle->timeout = timeout_ms ? pdMS_TO_TICKS(timeout_ms) : daemon_instance_handle->period;
+    daemon_instance_handle->expiry = xTaskGetTickCount() + daemon_instance_handle->timeout;
+    daemon_instance_handle->delete_pending = 0;
+    daemon_instance_handle->expire_count = 0;
     daemon_instance_handle->callback = callback;
     /* 使用的时候需要进行强制类型转换 */
     daemon_instance_handle->owner_instance_handle = owner_instance_handle;
 
-    /* 挂载到队列 */
-    daemon_instance_array[daemon_instance_count++] = daemon_instance_handle;
+    /* 插入最小堆 */
+    daemon_instance_handle->heap_index = daemon_instance_count;
+    daemon_instance_heap[daemon_instance_count++] = daemon_instance_handle;
+    daemon_heap_sift_up(daemon_instance_handle->heap_index);
+    rearm = daemon_timer_need_rearm(daemon_instance_handle);
 
     /* 退出临界区 */
     taskEXIT_CRITICAL();
 
+    if (rearm)
+    {
+        daemon_timer_rearm();
+    }
     return daemon_instance_handle;
 }
 /**
- * @description: 软件定时器Deamon的回调函数
- * @param {TimerHandle_t} xTimer
+ * @description: 删除守护实例,可以在运行中删除(包括在自身的回调函数中),不能在中断中调用
+ * @param {Daemon_InstanceHandle} daemon_instance_handle
  * @return {*}
  */
-void deamon_timer_callback(TimerHandle_t xTimer)
+void daemon_delete_instance(Daemon_InstanceHandle daemon_instance_handle)
+{
+    uint8_t i;
+    if (daemon_instance_handle == NULL)
+    {
+        return;
+    }
+    taskENTER_CRITICAL();
+    i = daemon_instance_handle->heap_index;
+    if ((i >= daemon_instance_count) || (daemon_instance_heap[i] != daemon_instance_handle))
+    {
+        /* 已经删除过 */
+        taskEXIT_CRITICAL();
+        return;
+    }
+    /* 用堆尾的实例填补空位,再按其到期时刻调整 */
+    daemon_instance_count--;
+    if (i != daemon_instance_count)
+    {
+        daemon_instance_heap[i] = daemon_instance_heap[daemon_instance_count];
+        daemon_instance_heap[i]->heap_index = i;
+        daemon_heap_sift_up(i);
+        daemon_heap_sift_down(daemon_instance_heap[i]->heap_index);
+    }
+    daemon_instance_heap[daemon_instance_count] = NULL;
+    daemon_instance_handle->heap_index = INSTANCE_DAEMON_CNT;
+    /* 回调函数执行期间删除的实例,由守护进程在回调结束后释放 */
+    if (daemon_instance_handle == daemon_running)
+    {
+        daemon_instance_handle->delete_pending = 1;
+    }
+    else
+    {
+        pool_free(&daemon_instance_pool, daemon_instance_handle);
+    }
+    taskEXIT_CRITICAL();
+}
+/**
+ * @description: 喂狗:将到期时刻设置为timeout之后,不能在中断中调用
+ *               timeout小于period时,到期后喂狗会使到期时刻提前,需要向上调整并可能重新设置定时器
+ * @param {Daemon_InstanceHandle} daemon_instance_handle
+ * @return {*}
+ */
+void daemon_feed(Daemon_InstanceHandle daemon_instance_handle)
+{
+    uint8_t rearm = 0;
+    if (daemon_instance_handle == NULL)
+    {
+        return;
+    }
+    taskENTER_CRITICAL();
+    if (daemon_instance_handle->heap_index < daemon_instance_count)
+    {
+        daemon_instance_handle->expiry = xTaskGetTickCount() + daemon_instance_handle->timeout;
+        daemon_heap_sift_up(daemon_instance_handle->heap_index);
+        daemon_heap_sift_down(daemon_instance_handle->heap_index);
+        rearm = daemon_timer_need_rearm(daemon_instance_handle);
+    }
+    taskEXIT_CRITICAL();
+
+    if (rearm)
+    {
+        daemon_timer_rearm();
+    }
+}
+/**
+ * @description: 查询距离下一个实例到期的tick数,系统可以据此休眠
+ * @return {*} 0:已有实例到期;portMAX_DELAY:没有守护实例
+ */
+TickType_t daemon_next_expiry(void)
 {
-    /* 遍历deamon队列,执行deamon实例的回调函数 */
+    TickType_t now;
+    TickType_t delay = portMAX_DELAY;
     taskENTER_CRITICAL();
-    /* 调用该函数前需要使用ws2812b_config_color函数配置RGB灯带 */
-    /* 最好将配置函数放到ws2812b初始化函数中 */
-    /* 后续可以设计运行中更改颜色的接口 */
-    ws2812b_breath();
+    if (daemon_instance_count != 0)
+    {
+        now = xTaskGetTickCount();
+        delay = DAEMON_TICK_BEFORE(now, daemon_instance_heap[0]->expiry) ? (daemon_instance_heap[0]->expiry - now) : 0;
+    }
     taskEXIT_CRITICAL();
-    for (uint8_t i = 0; i < daemon_instance_count; i++)
+    return delay;
+}
+/**
+ * @description: 软件定时器Deamon的回调函数:依次处理已经到期的实例,再设置到下一个到期时刻
+ * @param {TimerHandle_t} xTimer
+ * @return {*}
+ */
+void deamon_timer_callback(TimerHandle_t xTimer)
+{
+    Daemon_InstanceHandle daemon_instance_handle;
+    daemon_timeout_callback callback;
+    TickType_t now;
+    while (1)
     {
-        /* 判断是否计数到重载值:0触发 */
-        if (daemon_instance_array[i]->count == 0)
+        taskENTER_CRITICAL();
+        now = xTaskGetTickCount();
+        if ((daemon_instance_count == 0) || DAEMON_TICK_BEFORE(now, daemon_instance_heap[0]->expiry))
         {
-            /* 计数达到重载值 */
-            /* 是否需要进入临界区 */
-            daemon_instance_array[i]->callback((void *)daemon_instance_array[i]);
+            taskEXIT_CRITICAL();
+            break;
         }
-        else
+        /* 先设置下一次到期时刻再执行回调,回调函数中可以喂狗或删除自身 */
+        daemon_instance_handle = daemon_instance_heap[0];
+        daemon_instance_handle->expiry += daemon_instance_handle->period;
+        if (DAEMON_TICK_BEFORE(daemon_instance_handle->expiry, now))
         {
-            /* 递减计数值 */
-            daemon_instance_array[i]->count--;
+            /* 错过了多个周期,不补偿 */
+            daemon_instance_handle->expiry = now + daemon_instance_handle->period;
         }
+        daemon_instance_handle->expire_count++;
+        daemon_heap_sift_down(0);
+        callback = daemon_instance_handle->callback;
+        daemon_running = daemon_instance_handle;
+        taskEXIT_CRITICAL();
+
+        callback((void *)daemon_instance_handle);
+
+        taskENTER_CRITICAL();
+        daemon_running = NULL;
+        if (daemon_instance_handle->delete_pending)
+        {
+            pool_free(&daemon_instance_pool, daemon_instance_handle);
+        }
+        taskEXIT_CRITICAL();
     }
+    daemon_timer_rearm();
 }
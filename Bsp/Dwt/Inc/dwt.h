@@ -14,4 +14,6 @@
 #include "rtt.h"
 void dwt_init(uint32_t cpu_freq_hz);
 void dwt_delay_us(uint16_t _dwt_delay_time);
+uint32_t dwt_get_cycle(void);
+uint32_t dwt_cycle_to_us(uint32_t cycle);
 #endif //!__DWT__H__
@@ -63,3 +63,21 @@ void dwt_delay_us(uint16_t _dwt_delay_time)
         /* 严格要求CYCCNT只产生一次溢出,因此严格要求dwt的延时时间,尽量不要过度到毫秒级 */
     }
 }
+/**
+ * @description: 获取当前的CYCCNT计数值,用于测量代码段的执行节拍数
+ *               两次读数直接相减即可得到节拍数,无符号减法可以处理一次溢出
+ * @return {*}
+ */
+uint32_t dwt_get_cycle(void)
+{
+    return DWT->CYCCNT;
+}
+/**
+ * @description: 将节拍数换算成微秒,用于打印测量结果
+ * @param {uint32_t} cycle
+ * @return {*}
+ */
+uint32_t dwt_cycle_to_us(uint32_t cycle)
+{
+    return cycle / TIME_US_COUNT;
+}
@@ -2,7 +2,7 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-17 14:54:44
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-19 18:38:27
+ * @LastEditTime: 2025-02-11 11:21:37
  * @Description: led.h
  *               RGB颜色参考:https://tool.oschina.net/commons?type=3
  *
@@ -14,6 +14,9 @@
 #include "gpio.h"
 #include "tim.h"
 #include "daemon.h"
+#include "ws2812b_stream.h"
+#include "ws2812b_fb.h"
+#include "ws2812b_color.h"
 /* Color Define */
 #define Turquoise1 ((uint32_t)0x00F5FF)
 #define DarkGreen ((uint32_t)0x006400)
@@ -60,15 +63,23 @@ void led_start(LED_InstanceHandle led_instance_handle, uint16_t all_flash_cnt);
  * 发送顺序:按照GRB的顺序发送(G7->G6->G5->......B0)
  */
 
-#define WS_0 (uint16_t)0x46                                 /* WS2812B协议对应的0码:示波器高电平大约270ns */
-#define WS_1 (uint16_t)0x8C                                 /* WS2812B协议对应的1码:示波器高电平大约750ns */
-#define LAMP_NUM 58                                        /* 灯珠的数量 */
-#define WS2812B_DATA_LENGTH (uint16_t)(LAMP_NUM * 24 + 50) /* 50是复位脉冲数:可以继续调节小一点 */
+#define LAMP_NUM 58          /* 灯珠的数量:每颗灯珠占用帧缓冲区与两个发送缓冲区各3字节,流式编码的缓冲区大小与灯珠数量无关 */
+#define WS2812B_FRAME_NUM 2  /* 发送缓冲区数量:一帧发送,一帧拷贝 */
+
+/* 关中断时间测试:测量交换帧指针的最长关中断时间,打开后在lamp任务中调用ws2812b_benchmark */
+// #define __WS2812B_BENCHMARK
+#define WS2812B_BENCHMARK_ROUNDS 20      /* 测试轮数 */
+#define WS2812B_BENCHMARK_INTERVAL_MS 5  /* 每轮间隔,大于一帧的DMA发送时间(约1.8ms) */
 
 #define TEST_WS2812B_LAMP /* 测试WS2812B的宏定义 */
 void ws2812b_init(void);
 void ws2812b_close_lamp(void);
 void ws2812b_breath(void);
 void ws2812b_config_color(uint32_t color);
+WS2812B_FramebufferDef *ws2812b_get_framebuffer(void);
+void ws2812b_show(void);
+#ifdef __WS2812B_BENCHMARK
+void ws2812b_benchmark(void);
+#endif //__WS2812B_BENCHMARK
 
 #endif //!__LED__H__
@@ -0,0 +1,29 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-08 10:16:42
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-08 15:47:09
+ * @Description: ws2812b_color.h
+ *               呼吸灯亮度:按步数查亮度曲线得到感知亮度,再查gamma表得到Q16定点的比例系数,与存储的基础颜色相乘,
+ *               全程整数运算,不再经过RGB与HSV的浮点往返;该文件不依赖HAL,可以在上位机测试
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __WS2812B_COLOR__H__
+#define __WS2812B_COLOR__H__
+#include "stdint.h"
+
+#define WS2812B_BREATH_STEPS 50 /* 呼吸灯从熄灭到最亮的步数,每LAMP_PERIOD_MS(50ms)一步,呼吸周期为2 * 50 * 50ms = 5s */
+#define WS2812B_GAMMA_SHIFT 16  /* gamma表为Q16定点数 */
+
+/* 亮度测试宏定义:检验整数亮度与浮点计算的误差不超过1,并与原来的浮点HSV往返比较耗时,打开后在lamp任务中调用 */
+// #define __WS2812B_COLOR_BENCHMARK
+#define WS2812B_COLOR_BENCHMARK_ROUNDS 100 /* 耗时测试的颜色更新次数 */
+
+uint8_t ws2812b_breath_brightness(uint16_t step);
+uint32_t ws2812b_color_scale(uint32_t color, uint8_t brightness);
+#ifdef __WS2812B_COLOR_BENCHMARK
+void ws2812b_color_benchmark(void);
+#endif //__WS2812B_COLOR_BENCHMARK
+
+#endif //!__WS2812B_COLOR__H__
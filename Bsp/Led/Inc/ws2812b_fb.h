@@ -0,0 +1,47 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-06 09:51:33
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-06 16:24:08
+ * @Description: ws2812b_fb.h
+ *               WS2812B逐灯珠帧缓冲区:每颗灯珠按G/R/B顺序存放,写入时与原值比较,只有发生变化的灯珠计入脏区间,
+ *               显示时只拷贝脏区间,没有变化时不发送;该文件不依赖HAL,可以在上位机测试
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __WS2812B_FB__H__
+#define __WS2812B_FB__H__
+#include "stdint.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define WS2812B_GRB_SIZE 3 /* 一颗灯珠的颜色字节数 */
+
+/* 灯珠区间[begin, end),begin >= end表示空区间 */
+typedef struct
+{
+    /* data */
+    uint16_t begin;
+    uint16_t end;
+} WS2812B_RangeDef;
+
+typedef struct
+{
+    /* data */
+    uint8_t *grb;           /* 颜色数据,大小为lamp_num * WS2812B_GRB_SIZE */
+    uint16_t lamp_num;      /* 灯珠数量 */
+    WS2812B_RangeDef dirty; /* 上一次显示后发生变化的灯珠区间 */
+} WS2812B_FramebufferDef;
+
+void ws2812b_range_merge(WS2812B_RangeDef *range, uint16_t begin, uint16_t end);
+void ws2812b_fb_init(WS2812B_FramebufferDef *fb, uint8_t *grb, uint16_t lamp_num);
+void ws2812b_fb_set(WS2812B_FramebufferDef *fb, uint16_t idx, uint32_t color);
+void ws2812b_fb_fill(WS2812B_FramebufferDef *fb, uint16_t begin, uint16_t length, uint32_t color);
+uint8_t ws2812b_fb_take_dirty(WS2812B_FramebufferDef *fb, WS2812B_RangeDef *range);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //!__WS2812B_FB__H__
@@ -0,0 +1,47 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-04 14:08:51
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-04 17:36:20
+ * @Description: ws2812b_stream.h
+ *               WS2812B流式编码:DMA以循环模式发送一个很小的双缓冲区,每个半缓冲区对应一个时隙,
+ *               半传输/传输完成中断中把下一个时隙的脉冲编码到刚发送完的半缓冲区,
+ *               缓冲区大小与灯珠数量无关;该文件不依赖HAL,可以在上位机测试
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __WS2812B_STREAM__H__
+#define __WS2812B_STREAM__H__
+#include "stdint.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define WS_0 (uint16_t)0x46                                                /* WS2812B协议对应的0码:示波器高电平大约270ns */
+#define WS_1 (uint16_t)0x8C                                                /* WS2812B协议对应的1码:示波器高电平大约750ns */
+#define WS2812B_LAMP_PULSE 24                                             /* 一颗灯珠的脉冲数:G/R/B各8位 */
+#define WS2812B_RESET_PULSE 50                                            /* 复位脉冲数(全0):可以继续调节小一点 */
+#define WS2812B_STREAM_HALF_LAMP 1                                        /* 一个时隙(半缓冲区)对应的灯珠数 */
+#define WS2812B_STREAM_HALF_SIZE (WS2812B_LAMP_PULSE * WS2812B_STREAM_HALF_LAMP) /* 半缓冲区的脉冲数 */
+#define WS2812B_STREAM_BUFFER_SIZE (WS2812B_STREAM_HALF_SIZE * 2)          /* DMA循环缓冲区的脉冲数 */
+
+typedef struct
+{
+    /* data */
+    uint16_t buffer[WS2812B_STREAM_BUFFER_SIZE]; /* DMA循环缓冲区,前后两半交替发送与编码 */
+    const uint8_t *grb;                          /* 当前帧的颜色数据,每颗灯珠按G/R/B顺序存放 */
+    uint16_t grb_stride;                         /* 相邻灯珠颜色数据的间隔(字节),0表示所有灯珠同色 */
+    uint16_t lamp_num;                           /* 灯珠数量 */
+    uint16_t slot_num;                           /* 一帧的时隙数:灯珠与复位脉冲 */
+    uint16_t next_slot;                          /* 下一个需要编码的时隙 */
+} WS2812B_StreamDef;
+
+void ws2812b_encode_lamp(uint16_t *pulse, uint8_t g, uint8_t r, uint8_t b);
+void ws2812b_stream_start(WS2812B_StreamDef *stream, const uint8_t *grb, uint16_t grb_stride, uint16_t lamp_num);
+uint8_t ws2812b_stream_next(WS2812B_StreamDef *stream, uint8_t half);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //!__WS2812B_STREAM__H__
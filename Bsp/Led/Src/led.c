@@ -2,7 +2,7 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-17 14:54:59
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-20 13:31:42
+ * @LastEditTime: 2025-02-11 11:21:37
  * @Description: led.c
  *               板载一个RGB灯,无其他可配置LED灯,RGB配置有三个引脚R:PD14/G:PD13/B:PD15
  *               通过控制R/G/B产生不同的取值,进而控制最终显示的颜色
@@ -10,18 +10,30 @@
  *
  * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
  */
+#define LOG_MODULE LED /* 日志模块,必须在包含头文件之前定义,见rtt.h */
 #include "FreeRTOS.h" /* 这里并不需要FreeRTOS.h这个文件,但是task.h必须在FreeRTOS后面 */
 #include "task.h"
 #include "led.h"
 #include "string.h"
 #include "rtt.h"
 #include "stdlib.h"
-#include "portable.h"
+#include "pool.h"
+#include "dwt.h"
 static LED_InstanceHandle led_instance_array[INSTANCE_LED_NUM] = {NULL};
-static uint16_t WS2812B_LAMP_DATA[WS2812B_DATA_LENGTH] = {0};
-static uint16_t WS2812B_COLOR_CONFIG[24] = {0};
-static uint32_t WS2812B_COLOR = 0;      /* 用于存储配置的颜色 */
-static float WS2812B_V_RAW_VALUE = 0.0; /* 存储初始V值 */
+POOL_DEFINE(led_instance_pool, LED_InstanceDef, INSTANCE_LED_NUM); /* LED实例对象池 */
+static uint8_t WS2812B_PIXEL[LAMP_NUM * WS2812B_GRB_SIZE] = {0};                     /* 逐灯珠的帧缓冲区,由lamp任务渲染 */
+static WS2812B_FramebufferDef ws2812b_fb;                                            /* 帧缓冲区及其脏区间 */
+static uint8_t WS2812B_FRAME[WS2812B_FRAME_NUM][LAMP_NUM * WS2812B_GRB_SIZE] = {0}; /* 双缓冲:一帧由DMA发送时,另一帧用于拷贝帧缓冲区 */
+static WS2812B_RangeDef ws2812b_frame_stale[WS2812B_FRAME_NUM] = {0};                /* 每个发送缓冲区落后于帧缓冲区的灯珠区间 */
+static uint8_t *volatile ws2812b_frame_sending = NULL;        /* DMA正在发送的帧,DMA空闲时为NULL */
+static uint8_t *volatile ws2812b_frame_ready = NULL;          /* 渲染完成、等待DMA发送的帧 */
+static uint8_t ws2812b_frame_back = 0;                        /* 下一帧渲染使用的缓冲区编号,只由渲染方访问 */
+static uint32_t ws2812b_mask_cycle_max = 0;                   /* 提交帧时关中断的最大节拍数 */
+static uint32_t ws2812b_dma_error_count = 0;                  /* HAL启动/停止DMA失败的次数,失败的帧交还给lamp任务重试 */
+static void ws2812b_dma_abort_callback(DMA_HandleTypeDef *hdma);
+static WS2812B_StreamDef ws2812b_stream;                      /* 流式编码器:DMA循环发送的缓冲区只有两颗灯珠的脉冲 */
+static uint32_t WS2812B_COLOR = 0;                            /* 用于存储配置的颜色(呼吸灯的基础颜色) */
+static uint16_t ws2812b_breath_step = 0;                      /* 呼吸灯当前的步数 */
 /**
  * @description: 初始化led灯
  * @return {*}
@@ -73,8 +85,6 @@ void led_daemon_control_callback(void *daemon_instance_handle)
     Daemon_InstanceHandle h_daemon = (Daemon_InstanceHandle)daemon_instance_handle;
     /* 拿取对应的LED实例句柄 */
     LED_InstanceHandle h_led = (LED_InstanceHandle)(h_daemon->owner_instance_handle);
-    /* 执行"喂狗"操作 */
-    h_daemon->count = h_daemon->reload_count; /* 重新从重载值向下计数 */
     /* LED相关操作 */
     if (h_led->enable_flag == LED_ENABLE)
     {
@@ -119,15 +129,11 @@ LED_InstanceHandle Y_led_creat_instance(uint8_t idx, uint32_t color)
             LOGERROR("[led_create]LED Instance Already Created!");
         }
     }
-    /* 进入临界区,确保创建串口实例的过程是线程安全的,不要在检测串口是否合法之前进入临界区,这样会影响其他任务的调度,使整个系统卡死 */
-    taskENTER_CRITICAL();
-    /* 使用线程安全的内存分配函数 */
-    LED_InstanceHandle led_instance_handle = (LED_InstanceHandle)pvPortMalloc(sizeof(LED_InstanceDef));
+    /* 从对象池中申请LED实例,常数时间,不使用FreeRTOS堆 */
+    LED_InstanceHandle led_instance_handle = (LED_InstanceHandle)pool_alloc(&led_instance_pool);
     if (led_instance_handle == NULL)
     {
-        LOGERROR("[led_create]LED Instance Create Failed,Stack Overflow!\r\n");
-        /* 退出临界区 */
-        taskEXIT_CRITICAL();
+        LOGERROR("[led_create]LED Instance Pool Is Full!\r\n");
         return NULL;
     }
     led_instance_handle->idx = idx;
@@ -148,7 +154,10 @@ LED_InstanceHandle Y_led_creat_instance(uint8_t idx, uint32_t color)
     led_instance_handle->B_channel = B * 5;
 
     /* 注册守护对象:led的守护对象负责执行led的闪烁操作 */
-    led_instance_handle->led_daemon = Y_daemon_create_instance((void *)led_instance_handle, DAEMON_OWNER_TYPE_LED, idx, DAEMON_RELOAD_LED, led_daemon_control_callback);
+    led_instance_handle->led_daemon = Y_daemon_create_instance((void *)led_instance_handle, DAEMON_OWNER_TYPE_LED, idx, DAEMON_PERIOD_LED_MS, 0, led_daemon_control_callback);
+    /* 进入临界区,挂载LED实例 */
+    taskENTER_CRITICAL();
+    led_instance_array[idx] = led_instance_handle;
     /* 退出临界区 */
     taskEXIT_CRITICAL();
 
@@ -185,383 +194,285 @@ void led_start(LED_InstanceHandle led_instance_handle, uint16_t all_flash_cnt)
 void ws2812b_init(void)
 {
     LOGINFO("-------Use WS2812B-------.\r\n");
+    /* 流式编码:将DMA切换为循环模式,半传输与传输完成中断交替编码前后两半缓冲区 */
+    htim1.hdma[TIM_DMA_ID_CC4]->Init.Mode = DMA_CIRCULAR;
+    if (HAL_DMA_Init(htim1.hdma[TIM_DMA_ID_CC4]) != HAL_OK)
+    {
+        LOGERROR("[ws2812b_init]WS2812B DMA Init Failed!\r\n");
+        return;
+    }
+    /* 循环模式下停止DMA只是发出abort请求,下一帧在abort完成回调中启动 */
+    htim1.hdma[TIM_DMA_ID_CC4]->XferAbortCallback = ws2812b_dma_abort_callback;
+    ws2812b_fb_init(&ws2812b_fb, WS2812B_PIXEL, LAMP_NUM);
     ws2812b_close_lamp();
 }
 /**
- * @description: DMA向定时器传输数据完成回调函数(将所有数据传输完成后调用该函数,需要开启DMA对应通道的中断)
- * @param {TIM_HandleTypeDef} *htim
+ * @description: 开始发送一帧:编码前两颗灯珠后开启循环DMA,向定时器写入比较值,即将数据写入到ws2812b中
+ *               调用前ws2812b_frame_sending必须已经指向该帧;启动失败时把该帧交还给lamp任务,由ws2812b_show重试
+ * @param {uint8_t} *frame 需要发送的帧
  * @return {*}
  */
-void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim)
+static void ws2812b_load_data(uint8_t *frame)
 {
-    if (htim == &htim1)
+    uint32_t primask;
+    ws2812b_stream_start(&ws2812b_stream, frame, WS2812B_GRB_SIZE, LAMP_NUM);
+    __HAL_TIM_SET_COUNTER(&htim1, 0);
+    if (HAL_TIM_PWM_Start_DMA(&htim1, TIM_CHANNEL_4, (uint32_t *)ws2812b_stream.buffer, WS2812B_STREAM_BUFFER_SIZE) == HAL_OK)
     {
-        /* 完成一次整组数据的发送 */
-        HAL_TIM_PWM_Stop_DMA(&htim1, TIM_CHANNEL_4);
+        return;
+    }
+    ws2812b_dma_error_count++;
+    /* DMA启动失败时定时器通道可能停留在BUSY状态,停止一次使其恢复READY,否则之后的启动都会返回HAL_BUSY */
+    (void)HAL_TIM_PWM_Stop_DMA(&htim1, TIM_CHANNEL_4);
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (ws2812b_frame_sending == frame)
+    {
+        ws2812b_frame_sending = NULL;
+        /* 已有更新的帧在等待时丢弃该帧:更新的帧已经包含该帧的变化 */
+        if (ws2812b_frame_ready == NULL)
+        {
+            ws2812b_frame_ready = frame;
+        }
     }
+    __set_PRIMASK(primask);
 }
 /**
- * @description: 开启DMA,向定时器写入比较值,即将数据写入到ws2812b中
+ * @description: DMA abort完成回调函数,在DMA2_Stream4中断中调用:此时DMA句柄已经解锁,若已有渲染完成的帧,直接开始发送该帧
+ * @param {DMA_HandleTypeDef} *hdma
  * @return {*}
  */
-static void ws2812b_load_data(void)
+static void ws2812b_dma_abort_callback(DMA_HandleTypeDef *hdma)
 {
-    __HAL_TIM_SET_COUNTER(&htim1, 0);
-    HAL_TIM_PWM_Start_DMA(&htim1, TIM_CHANNEL_4, (uint32_t *)WS2812B_LAMP_DATA, WS2812B_DATA_LENGTH);
+    (void)hdma;
+    /* DMA2_Stream4的中断优先级为0,不会被渲染方提交帧的过程打断 */
+    ws2812b_frame_sending = ws2812b_frame_ready;
+    ws2812b_frame_ready = NULL;
+    if (ws2812b_frame_sending != NULL)
+    {
+        ws2812b_load_data(ws2812b_frame_sending);
+    }
 }
 /**
- * @description: 关闭所有的灯珠
+ * @description: 半缓冲区发送完成:编码下一颗灯珠,一帧结束后停止DMA
+ *               循环模式的DMA句柄在发送期间一直处于锁定状态,HAL_DMA_Abort_IT只设置ABORT状态并关闭数据流,
+ *               句柄要到下一次数据流中断才解锁,因此不能在这里启动下一帧,而是在abort完成回调中启动
+ * @param {uint8_t} half 0:前半区;1:后半区
  * @return {*}
  */
-void ws2812b_close_lamp(void)
+static void ws2812b_stream_half_done(uint8_t half)
 {
-    uint16_t i = 0;
-    /* 写入#000000(黑色) */
-    for (; i < LAMP_NUM * 24; i++)
+    if (ws2812b_stream_next(&ws2812b_stream, half))
     {
-        WS2812B_LAMP_DATA[i] = WS_0;
+        /* 完成一次整组数据的发送 */
+        if ((HAL_TIM_PWM_Stop_DMA(&htim1, TIM_CHANNEL_4) != HAL_OK) ||
+            (htim1.hdma[TIM_DMA_ID_CC4]->State != HAL_DMA_STATE_ABORT))
+        {
+            /* 没有发出abort请求,abort完成回调不会到来,直接处理 */
+            ws2812b_dma_error_count++;
+            ws2812b_dma_abort_callback(htim1.hdma[TIM_DMA_ID_CC4]);
+        }
     }
-
-    /* 写入复位脉冲 */
-    for (i = LAMP_NUM * 24; i < WS2812B_DATA_LENGTH; i++)
+}
+/**
+ * @description: DMA半传输完成回调函数:前半区发送完成
+ * @param {TIM_HandleTypeDef} *htim
+ * @return {*}
+ */
+void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef *htim)
+{
+    if (htim == &htim1)
     {
-        WS2812B_LAMP_DATA[i] = 0; /* 全0复位脉冲 */
+        ws2812b_stream_half_done(0);
     }
-
-    /* 写入ws2812b */
-    ws2812b_load_data();
 }
 /**
- * @description: 判断最小浮点值
- * @param {float} a
- * @param {float} b
- * @param {float} c
+ * @description: DMA传输完成回调函数:后半区发送完成,循环模式下DMA回到前半区继续发送
+ * @param {TIM_HandleTypeDef} *htim
  * @return {*}
  */
-static float ws2812b_min(float a, float b, float c)
+void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim)
 {
-    float m;
-    m = a < b ? a : b;
-    return (m < c ? m : c);
+    if (htim == &htim1)
+    {
+        ws2812b_stream_half_done(1);
+    }
 }
 /**
- * @description: 判断最大浮点值
- * @param {float} a
- * @param {float} b
- * @param {float} c
- * @return {*}
+ * @description: 获取用于拷贝帧缓冲区的发送缓冲区,只由渲染方(lamp任务或调度器启动前)调用
+ * @return {*} 缓冲区仍在发送时返回NULL,本次不显示
  */
-static float ws2812b_max(float a, float b, float c)
+static uint8_t *ws2812b_frame_back_buffer(void)
 {
-    float m;
-    m = a > b ? a : b;
-    return (m > c ? m : c);
+    uint8_t *frame = WS2812B_FRAME[ws2812b_frame_back];
+    if ((frame == ws2812b_frame_sending) || (frame == ws2812b_frame_ready))
+    {
+        return NULL;
+    }
+    return frame;
 }
 /**
- * @description: 将rgb颜色编码形式转换成对应的hsv编码格式
- *               若通过rgb的形式实现呼吸效果,需要同时改变R/G/B三个通道的数据,很难保证呼吸效果,因为RGB颜色的排列不是简单的递增形式
- *               hsv更适合实现呼吸效果,其中"H":色调/"S":饱和度/"V":亮度,只需要确保H/S不变,改变V的值即可实现呼吸效果
- *               函数说明:将当前颜色的rgb值转换成hsv格式,通过改变v后,再转换成对应的rgb值
- *               参考rgb转hsv的计算公式
- * @param {uint8_t} g
- * @param {uint8_t} r
- * @param {uint8_t} b
- * @param {float} *h
- * @param {float} *s
- * @param {float} *v
+ * @description: 提交渲染完成的帧:关中断期间只交换帧指针,DMA空闲时再启动发送
+ *               DMA2_Stream4的中断优先级为0,高于configMAX_SYSCALL_INTERRUPT_PRIORITY,taskENTER_CRITICAL无法屏蔽,因此直接设置PRIMASK
+ * @param {uint8_t} *frame
  * @return {*}
  */
-static void ws2812b_rgb_to_hsv(uint8_t g, uint8_t r, uint8_t b, float *h, float *s, float *v)
+static void ws2812b_frame_commit(uint8_t *frame)
 {
-    float red, green, blue;
-    float cmax, cmin, delta;
-
-    red = (float)r / 255;
-    green = (float)g / 255;
-    blue = (float)b / 255;
+    uint32_t primask;
+    uint32_t start_cycle;
+    uint32_t mask_cycle;
+    uint8_t dma_idle;
 
-    cmax = ws2812b_max(red, green, blue);
-    cmin = ws2812b_min(red, green, blue);
-    delta = cmax - cmin;
-
-    /* H */
-    if (delta == 0)
+    start_cycle = dwt_get_cycle();
+    primask = __get_PRIMASK();
+    __disable_irq();
+    dma_idle = (ws2812b_frame_sending == NULL);
+    if (dma_idle)
     {
-        *h = 0;
+        ws2812b_frame_sending = frame;
+        /* 启动失败而等待重试的旧帧不再需要:新帧已经包含它的变化 */
+        ws2812b_frame_ready = NULL;
     }
     else
     {
-        if (cmax == red)
-        {
-            if (green >= blue)
-            {
-                *h = 60 * ((green - blue) / delta);
-            }
-            else
-            {
-                *h = 60 * ((green - blue) / delta) + 360;
-            }
-        }
-        else if (cmax == green)
-        {
-            *h = 60 * ((blue - red) / delta + 2);
-        }
-        else if (cmax == blue)
-        {
-            *h = 60 * ((red - green) / delta + 4);
-        }
+        /* 正在发送上一帧,发送完成后由中断接着发送该帧 */
+        ws2812b_frame_ready = frame;
     }
-
-    /* S */
-    if (cmax == 0)
+    __set_PRIMASK(primask);
+    mask_cycle = dwt_get_cycle() - start_cycle;
+    if (mask_cycle > ws2812b_mask_cycle_max)
     {
-        *s = 0;
+        ws2812b_mask_cycle_max = mask_cycle;
     }
-    else
+
+    ws2812b_frame_back ^= 0x01;
+    if (dma_idle)
     {
-        *s = delta / cmax;
+        ws2812b_load_data(frame);
     }
-
-    /* V */
-    *v = cmax;
 }
 /**
- * @description: hsv编码转rgb编码,参考转换公式
- * @param {float} h
- * @param {float} s
- * @param {float} v
- * @param {uint8_t} *g
- * @param {uint8_t} *r
- * @param {uint8_t} *b
+ * @description: 重试启动失败的帧:DMA空闲且有等待发送的帧时启动发送,只由渲染方调用
  * @return {*}
  */
-static void ws2812b_hsv_to_rgb(float h, float s, float v, uint8_t *g, uint8_t *r, uint8_t *b)
+static void ws2812b_frame_retry(void)
 {
-    if (s == 0)
+    uint32_t primask;
+    uint8_t *frame = NULL;
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if ((ws2812b_frame_sending == NULL) && (ws2812b_frame_ready != NULL))
     {
-        *r = *g = *b = (int)(v * 255.0f);
+        frame = ws2812b_frame_ready;
+        ws2812b_frame_sending = frame;
+        ws2812b_frame_ready = NULL;
     }
-    else
+    __set_PRIMASK(primask);
+    if (frame != NULL)
     {
-        float H = h / 60;
-        int hi = (int)H;
-        float f = H - hi;
-        float p = v * (1 - s);
-        float q = v * (1 - f * s);
-        float t = v * (1 - (1 - f) * s);
-        switch (hi)
-        {
-        case 0:
-            *r = (int)(v * 255.0f + 0.5f);
-            *g = (int)(t * 255.0f + 0.5f);
-            *b = (int)(p * 255.0f + 0.5f);
-            break;
-        case 1:
-            *r = (int)(q * 255.0f + 0.5f);
-            *g = (int)(v * 255.0f + 0.5f);
-            *b = (int)(p * 255.0f + 0.5f);
-            break;
-        case 2:
-            *r = (int)(p * 255.0f + 0.5f);
-            *g = (int)(v * 255.0f + 0.5f);
-            *b = (int)(t * 255.0f + 0.5f);
-            break;
-        case 3:
-            *r = (int)(p * 255.0f + 0.5f);
-            *g = (int)(q * 255.0f + 0.5f);
-            *b = (int)(v * 255.0f + 0.5f);
-            break;
-        case 4:
-            *r = (int)(t * 255.0f + 0.5f);
-            *g = (int)(p * 255.0f + 0.5f);
-            *b = (int)(v * 255.0f + 0.5f);
-            break;
-        case 5:
-            *r = (int)(v * 255.0f + 0.5f);
-            *g = (int)(p * 255.0f + 0.5f);
-            *b = (int)(q * 255.0f + 0.5f);
-            break;
-        default:
-            break;
-        }
+        ws2812b_load_data(frame);
     }
 }
 /**
- * @description: 向config数组中写入一个rgb颜色数据
- * @param {uint32_t} color
+ * @description: 获取帧缓冲区,渲染后调用ws2812b_show显示,只能在调度器启动前或lamp任务中访问
  * @return {*}
  */
-static void ws2812b_write_config_array(uint8_t ws_R_channel, uint8_t ws_G_channel, uint8_t ws_B_channel)
+WS2812B_FramebufferDef *ws2812b_get_framebuffer(void)
 {
-    /* 解码G */
-    for (uint8_t i = 0; i < 8; i++)
-    {
-        WS2812B_COLOR_CONFIG[i] = ((ws_G_channel & 0x80) ? WS_1 : WS_0);
-        ws_G_channel <<= 1;
-    }
-    /* 解码R */
-    for (uint8_t i = 0; i < 8; i++)
-    {
-        WS2812B_COLOR_CONFIG[i + 8] = ((ws_R_channel & 0x80) ? WS_1 : WS_0);
-        ws_R_channel <<= 1;
-    }
-    /* 解码B */
-    for (uint8_t i = 0; i < 8; i++)
-    {
-        WS2812B_COLOR_CONFIG[i + 16] = ((ws_B_channel & 0x80) ? WS_1 : WS_0);
-        ws_B_channel <<= 1;
-    }
+    return &ws2812b_fb;
 }
 /**
- * @description: 向lamp数组中写入所有rgb颜色数据
+ * @description: 显示帧缓冲区:只把发生变化的灯珠拷贝到空闲的发送缓冲区再提交,没有变化时不发送
+ *               另一个发送缓冲区同样错过了这次变化,记录下来在它下一次使用时补上
+ *               需要在调度器启动前或lamp任务中调用
  * @return {*}
  */
-static void ws2812b_write_lamp_array(void)
+void ws2812b_show(void)
 {
-    /* 写入数组 */
-    for (uint16_t i = 0; i < LAMP_NUM; i++)
+    WS2812B_RangeDef range;
+    WS2812B_RangeDef *stale;
+    uint8_t *frame;
+    /* 先重试之前启动失败的帧 */
+    ws2812b_frame_retry();
+    frame = ws2812b_frame_back_buffer();
+    if (frame == NULL)
     {
-        for (uint8_t j = 0; j < 24; j++)
-        {
-            WS2812B_LAMP_DATA[24 * i + j] = WS2812B_COLOR_CONFIG[j];
-        }
+        /* 上一帧仍在发送,脏区间保留到下一次显示 */
+        return;
     }
-
-    /* 写入复位脉冲 */
-    for (uint16_t i = LAMP_NUM * 24; i < WS2812B_DATA_LENGTH; i++)
+    if (!ws2812b_fb_take_dirty(&ws2812b_fb, &range))
     {
-        WS2812B_LAMP_DATA[i] = 0;
+        return;
     }
+    ws2812b_range_merge(&ws2812b_frame_stale[ws2812b_frame_back ^ 0x01], range.begin, range.end);
+    stale = &ws2812b_frame_stale[ws2812b_frame_back];
+    ws2812b_range_merge(&range, stale->begin, stale->end);
+    stale->begin = 0;
+    stale->end = 0;
+    memcpy(frame + range.begin * WS2812B_GRB_SIZE, WS2812B_PIXEL + range.begin * WS2812B_GRB_SIZE, (range.end - range.begin) * WS2812B_GRB_SIZE);
+
+    /* 写入ws2812b */
+    ws2812b_frame_commit(frame);
 }
 /**
- * @description: 用于设置RGB灯带的颜色
- *               调用该函数的时候应该满足线程安全,即进入临界区
+ * @description: 关闭所有的灯珠,需要在调度器启动前或lamp任务中调用
+ * @return {*}
+ */
+void ws2812b_close_lamp(void)
+{
+    /* 写入#000000(黑色) */
+    ws2812b_fb_fill(&ws2812b_fb, 0, LAMP_NUM, 0x000000);
+    ws2812b_show();
+}
+/**
+ * @description: 用于设置RGB灯带的颜色,同时作为呼吸灯的基础颜色,呼吸从最亮处重新开始
+ *               需要在调度器启动前或lamp任务中调用,帧缓冲区只由lamp任务访问
  * @param {uint32_t} color
  * @return {*}
  */
 void ws2812b_config_color(uint32_t color)
 {
-    uint8_t r = color >> 16;
-    uint8_t g = color >> 8;
-    uint8_t b = color;
-    float h = 0.0;
-    float s = 0.0;
     /* 获取当前颜色 */
     WS2812B_COLOR = color;
-    /* 获取初始V值 */
-    ws2812b_rgb_to_hsv(g, r, b, &h, &s, &WS2812B_V_RAW_VALUE);
-    /* 写配置数组 */
-    ws2812b_write_config_array(r, g, b);
-    /* 写lamp数组 */
-    ws2812b_write_lamp_array();
+    ws2812b_breath_step = 0;
 
-    /* 写入一次WS2812B */
-    ws2812b_load_data();
+    /* 写入一次WS2812B,发送缓冲区忙时由下一次显示补上 */
+    ws2812b_fb_fill(&ws2812b_fb, 0, LAMP_NUM, color);
+    ws2812b_show();
 }
 /**
- * @description: 从配置数组中解码当前的rgb
- * @param {uint8_t} *r
- * @param {uint8_t} *g
- * @param {uint8_t} *b
+ * @description: 该函数由lamp任务每隔LAMP_PERIOD_MS(50ms)调用一次,每次更改一次色值
+ *               调用该函数之前需要使用ws2812b_config_color配置基础颜色
+ *               每一步按亮度曲线与gamma表对基础颜色做定点缩放(见ws2812b_color.h),渲染在任务中完成,只有提交帧时交换指针需要关中断
  * @return {*}
  */
-static void ws2812b_decode_from_array(uint8_t *r, uint8_t *g, uint8_t *b)
+void ws2812b_breath(void)
 {
-    uint8_t mask = 0x01;
-    uint8_t red = 0x00;
-    uint8_t green = 0x00;
-    uint8_t blue = 0x00;
-    /* 解码G */
-    for (uint8_t i = 8; i > 0; i--)
-    {
-        if (WS2812B_COLOR_CONFIG[i - 1] == WS_1)
-        {
-            green |= mask;
-        }
-        else
-        {
-            green &= ~mask;
-        }
-        mask <<= 1;
-    }
-    mask = 0x01; /* 复位解码值 */
-    /* 解码R */
-    for (uint8_t i = 8; i > 0; i--)
-    {
-        if (WS2812B_COLOR_CONFIG[i - 1 + 8] == WS_1)
-        {
-            red |= mask;
-        }
-        else
-        {
-            red &= ~mask;
-        }
-        mask <<= 1;
-    }
-    mask = 0x01; /* 复位解码值 */
-    /* 解码B */
-    for (uint8_t i = 8; i > 0; i--)
-    {
-        if (WS2812B_COLOR_CONFIG[i - 1 + 16] == WS_1)
-        {
-            blue |= mask;
-        }
-        else
-        {
-            blue &= ~mask;
-        }
-        mask <<= 1;
-    }
-    /* 赋值 */
-    *r = red;
-    *g = green;
-    *b = blue;
+    uint32_t color = ws2812b_color_scale(WS2812B_COLOR, ws2812b_breath_brightness(ws2812b_breath_step));
+    ws2812b_breath_step = (ws2812b_breath_step + 1) % (2 * WS2812B_BREATH_STEPS);
+    /* 写帧缓冲区并显示 */
+    ws2812b_fb_fill(&ws2812b_fb, 0, LAMP_NUM, color);
+    ws2812b_show();
 }
+#ifdef __WS2812B_BENCHMARK
 /**
- * @description: 该函数放到daemon守护进程中调用,daemon的调用周期是50ms,因此每隔50ms更改一次色值
- *               调用该函数之前需要配置好WS2812B的颜色配置数组
- *               该函数执行时应该确保进入临界区
- *               .........................多种颜色待测试.....................
+ * @description: 测试呼吸灯更新期间的关中断时间,在lamp任务中调用
+ *               渲染与DMA启动都在任务中完成,只有交换帧指针时关中断;渲染本身与原浮点HSV实现的耗时对比见ws2812b_color_benchmark
  * @return {*}
  */
-void ws2812b_breath(void)
+void ws2812b_benchmark(void)
 {
-    static float v_level = 0.01f;       /* 亮度每次递减1%,可配置 */
-    static uint8_t breate_state_up = 0; /* 0表示递减,1表示递增 */
-    static uint8_t r = 0;
-    static uint8_t g = 0;
-    static uint8_t b = 0;
-    static float h = 0.0f;
-    static float s = 0.0f;
-    static float v = 0.0f;
-
-    ws2812b_decode_from_array(&r, &g, &b);
-    ws2812b_rgb_to_hsv(g, r, b, &h, &s, &v);
-
-    /* 更新v值 */
-    if (breate_state_up) /* 递增 */
+    ws2812b_mask_cycle_max = 0;
+    for (uint8_t i = 0; i < WS2812B_BENCHMARK_ROUNDS; i++)
     {
-        v += v_level;
-        if (v >= WS2812B_V_RAW_VALUE)
-        {
-            v = WS2812B_V_RAW_VALUE;
-            breate_state_up = 0;
-        }
+        ws2812b_breath();
+        /* 等待DMA发送完成,保证每次都完整渲染一帧 */
+        vTaskDelay(pdMS_TO_TICKS(WS2812B_BENCHMARK_INTERVAL_MS));
     }
-    else /* 递减 */
-    {
-        v -= v_level;
-        if (v <= 0.0f)
-        {
-            v = 0.01f;
-            breate_state_up = 1;
-        }
-    }
-    ws2812b_hsv_to_rgb(h, s, v, &g, &r, &b);
-    /* 写配置数组 */
-    ws2812b_write_config_array(r, g, b);
-    /* 写lamp数组 */
-    ws2812b_write_lamp_array();
-    /* 写入ws2812b */
-    ws2812b_load_data();
+
+    LOGINFO("[ws2812b_benchmark]masked in swap:%d cycles(%d us),dma error:%d\r\n",
+            ws2812b_mask_cycle_max, dwt_cycle_to_us(ws2812b_mask_cycle_max),
+            ws2812b_dma_error_count);
 }
+#endif //__WS2812B_BENCHMARK
@@ -0,0 +1,411 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-08 10:16:30
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-08 15:47:09
+ * @Description: ws2812b_color.c
+ *               亮度曲线:brightness[k] = round(255 * (1 - cos(pi * k / 50)) / 2),首尾变化平缓,呼吸在最亮与最暗处自然转向
+ *               gamma表:gamma[i] = round(65535 * (i / 255) ^ 2.2),感知亮度到灯珠占空比的转换
+ *               输出:channel = (base * gamma[brightness] + 0x8000) >> 16,基础颜色不会因为反复换算而漂移
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include "ws2812b_color.h"
+#ifdef __WS2812B_COLOR_BENCHMARK
+#include "math.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "dwt.h"
+#include "rtt.h"
+#include "ws2812b_stream.h"
+#endif //__WS2812B_COLOR_BENCHMARK
+/* 亮度曲线:步数 -> 感知亮度(0 ~ 255) */
+static const uint8_t ws2812b_breath_curve[WS2812B_BREATH_STEPS + 1] = {
+    0, 0, 1, 2, 4, 6, 9, 12, 16, 20, 24, 29, 35, 40, 46, 53, 59,
+    66, 73, 81, 88, 96, 104, 112, 119, 127, 136, 143, 151, 159, 167, 174, 182, 189,
+    196, 202, 209, 215, 220, 226, 231, 235, 239, 243, 246, 249, 251, 253, 254, 255, 255};
+/* gamma表:感知亮度 -> Q16比例系数,const修饰,存放在flash中 */
+static const uint16_t ws2812b_gamma[256] = {
+    0, 0, 2, 4, 7, 11, 17, 24, 32, 42, 53, 65, 79, 94, 111, 129,
+    148, 169, 192, 216, 242, 270, 299, 330, 362, 396, 432, 469, 508, 549, 591, 635,
+    681, 729, 779, 830, 883, 938, 995, 1053, 1113, 1175, 1239, 1305, 1373, 1443, 1514, 1587,
+    1663, 1740, 1819, 1900, 1983, 2068, 2155, 2243, 2334, 2427, 2521, 2618, 2717, 2817, 2920, 3024,
+    3131, 3240, 3350, 3463, 3578, 3694, 3813, 3934, 4057, 4182, 4309, 4438, 4570, 4703, 4838, 4976,
+    5115, 5257, 5401, 5547, 5695, 5845, 5998, 6152, 6309, 6468, 6629, 6792, 6957, 7124, 7294, 7466,
+    7640, 7816, 7994, 8175, 8358, 8543, 8730, 8919, 9111, 9305, 9501, 9699, 9900, 10102, 10307, 10515,
+    10724, 10936, 11150, 11366, 11585, 11806, 12029, 12254, 12482, 12712, 12944, 13179, 13416, 13655, 13896, 14140,
+    14386, 14635, 14885, 15138, 15394, 15652, 15912, 16174, 16439, 16706, 16975, 17247, 17521, 17798, 18077, 18358,
+    18642, 18928, 19216, 19507, 19800, 20095, 20393, 20694, 20996, 21301, 21609, 21919, 22231, 22546, 22863, 23182,
+    23504, 23829, 24156, 24485, 24817, 25151, 25487, 25826, 26168, 26512, 26858, 27207, 27558, 27912, 28268, 28627,
+    28988, 29351, 29717, 30086, 30457, 30830, 31206, 31585, 31966, 32349, 32735, 33124, 33514, 33908, 34304, 34702,
+    35103, 35507, 35913, 36321, 36732, 37146, 37562, 37981, 38402, 38825, 39252, 39680, 40112, 40546, 40982, 41421,
+    41862, 42306, 42753, 43202, 43654, 44108, 44565, 45025, 45487, 45951, 46418, 46888, 47360, 47835, 48313, 48793,
+    49275, 49761, 50249, 50739, 51232, 51728, 52226, 52727, 53230, 53736, 54245, 54756, 55270, 55787, 56306, 56828,
+    57352, 57879, 58409, 58941, 59476, 60014, 60554, 61097, 61642, 62190, 62741, 63295, 63851, 64410, 64971, 65535};
+/**
+ * @description: 呼吸灯第step步的感知亮度:前半个周期由最亮变暗,后半个周期由最暗变亮
+ * @param {uint16_t} step 0 ~ 2 * WS2812B_BREATH_STEPS - 1
+ * @return {*}
+ */
+uint8_t ws2812b_breath_brightness(uint16_t step)
+{
+    step %= 2 * WS2812B_BREATH_STEPS;
+    return (step < WS2812B_BREATH_STEPS) ? ws2812b_breath_curve[WS2812B_BREATH_STEPS - step] : ws2812b_breath_curve[step - WS2812B_BREATH_STEPS];
+}
+/**
+ * @description: 按感知亮度调整颜色,亮度为255时返回原颜色
+ * @param {uint32_t} color 0xRRGGBB
+ * @param {uint8_t} brightness 感知亮度
+ * @return {*}
+ */
+uint32_t ws2812b_color_scale(uint32_t color, uint8_t brightness)
+{
+    uint32_t scale = ws2812b_gamma[brightness];
+    uint32_t r = ((color >> 16) & 0xFF) * scale;
+    uint32_t g = ((color >> 8) & 0xFF) * scale;
+    uint32_t b = (color & 0xFF) * scale;
+    return (((r + 0x8000) >> WS2812B_GAMMA_SHIFT) << 16) | (((g + 0x8000) >> WS2812B_GAMMA_SHIFT) << 8) | ((b + 0x8000) >> WS2812B_GAMMA_SHIFT);
+}
+#ifdef __WS2812B_COLOR_BENCHMARK
+/* 以下为原来的呼吸灯实现:从脉冲中解码当前颜色,经过浮点RGB与HSV往返后调整V值,再逐位编码,作为测试的参照 */
+static uint16_t ws2812b_reference_config[WS2812B_LAMP_PULSE] = {0};
+static float ws2812b_reference_v_raw = 0.0f;
+/**
+ * @description: 判断最小浮点值
+ * @param {float} a
+ * @param {float} b
+ * @param {float} c
+ * @return {*}
+ */
+static float ws2812b_reference_min(float a, float b, float c)
+{
+    float m;
+    m = a < b ? a : b;
+    return (m < c ? m : c);
+}
+/**
+ * @description: 判断最大浮点值
+ * @param {float} a
+ * @param {float} b
+ * @param {float} c
+ * @return {*}
+ */
+static float ws2812b_reference_max(float a, float b, float c)
+{
+    float m;
+    m = a > b ? a : b;
+    return (m > c ? m : c);
+}
+/**
+ * @description: 将rgb颜色编码形式转换成对应的hsv编码格式
+ *               若通过rgb的形式实现呼吸效果,需要同时改变R/G/B三个通道的数据,很难保证呼吸效果,因为RGB颜色的排列不是简单的递增形式
+ *               hsv更适合实现呼吸效果,其中"H":色调/"S":饱和度/"V":亮度,只需要确保H/S不变,改变V的值即可实现呼吸效果
+ *               函数说明:将当前颜色的rgb值转换成hsv格式,通过改变v后,再转换成对应的rgb值
+ *               参考rgb转hsv的计算公式
+ * @param {uint8_t} g
+ * @param {uint8_t} r
+ * @param {uint8_t} b
+ * @param {float} *h
+ * @param {float} *s
+ * @param {float} *v
+ * @return {*}
+ */
+static void ws2812b_reference_rgb_to_hsv(uint8_t g, uint8_t r, uint8_t b, float *h, float *s, float *v)
+{
+    float red, green, blue;
+    float cmax, cmin, delta;
+
+    red = (float)r / 255;
+    green = (float)g / 255;
+    blue = (float)b / 255;
+
+    cmax = ws2812b_reference_max(red, green, blue);
+    cmin = ws2812b_reference_min(red, green, blue);
+    delta = cmax - cmin;
+
+    /* H */
+    if (delta == 0)
+    {
+        *h = 0;
+    }
+    else
+    {
+        if (cmax == red)
+        {
+            if (green >= blue)
+            {
+                *h = 60 * ((green - blue) / delta);
+            }
+            else
+            {
+                *h = 60 * ((green - blue) / delta) + 360;
+            }
+        }
+        else if (cmax == green)
+        {
+            *h = 60 * ((blue - red) / delta + 2);
+        }
+        else if (cmax == blue)
+        {
+            *h = 60 * ((red - green) / delta + 4);
+        }
+    }
+
+    /* S */
+    if (cmax == 0)
+    {
+        *s = 0;
+    }
+    else
+    {
+        *s = delta / cmax;
+    }
+
+    /* V */
+    *v = cmax;
+}
+/**
+ * @description: hsv编码转rgb编码,参考转换公式
+ * @param {float} h
+ * @param {float} s
+ * @param {float} v
+ * @param {uint8_t} *g
+ * @param {uint8_t} *r
+ * @param {uint8_t} *b
+ * @return {*}
+ */
+static void ws2812b_reference_hsv_to_rgb(float h, float s, float v, uint8_t *g, uint8_t *r, uint8_t *b)
+{
+    if (s == 0)
+    {
+        *r = *g = *b = (int)(v * 255.0f);
+    }
+    else
+    {
+        float H = h / 60;
+        int hi = (int)H;
+        float f = H - hi;
+        float p = v * (1 - s);
+        float q = v * (1 - f * s);
+        float t = v * (1 - (1 - f) * s);
+        switch (hi)
+        {
+        case 0:
+            *r = (int)(v * 255.0f + 0.5f);
+            *g = (int)(t * 255.0f + 0.5f);
+            *b = (int)(p * 255.0f + 0.5f);
+            break;
+        case 1:
+            *r = (int)(q * 255.0f + 0.5f);
+            *g = (int)(v * 255.0f + 0.5f);
+            *b = (int)(p * 255.0f + 0.5f);
+            break;
+        case 2:
+            *r = (int)(p * 255.0f + 0.5f);
+            *g = (int)(v * 255.0f + 0.5f);
+            *b = (int)(t * 255.0f + 0.5f);
+            break;
+        case 3:
+            *r = (int)(p * 255.0f + 0.5f);
+            *g = (int)(q * 255.0f + 0.5f);
+            *b = (int)(v * 255.0f + 0.5f);
+            break;
+        case 4:
+            *r = (int)(t * 255.0f + 0.5f);
+            *g = (int)(p * 255.0f + 0.5f);
+            *b = (int)(v * 255.0f + 0.5f);
+            break;
+        case 5:
+            *r = (int)(v * 255.0f + 0.5f);
+            *g = (int)(p * 255.0f + 0.5f);
+            *b = (int)(q * 255.0f + 0.5f);
+            break;
+        default:
+            break;
+        }
+    }
+}
+/**
+ * @description: 逐位编码一颗灯珠(原实现)
+ * @param {uint8_t} ws_R_channel
+ * @param {uint8_t} ws_G_channel
+ * @param {uint8_t} ws_B_channel
+ * @return {*}
+ */
+static void ws2812b_reference_write_config_array(uint8_t ws_R_channel, uint8_t ws_G_channel, uint8_t ws_B_channel)
+{
+    /* 解码G */
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        ws2812b_reference_config[i] = ((ws_G_channel & 0x80) ? WS_1 : WS_0);
+        ws_G_channel <<= 1;
+    }
+    /* 解码R */
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        ws2812b_reference_config[i + 8] = ((ws_R_channel & 0x80) ? WS_1 : WS_0);
+        ws_R_channel <<= 1;
+    }
+    /* 解码B */
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        ws2812b_reference_config[i + 16] = ((ws_B_channel & 0x80) ? WS_1 : WS_0);
+        ws_B_channel <<= 1;
+    }
+}
+/**
+ * @description: 从配置数组中解码当前的rgb(原实现)
+ * @param {uint8_t} *r
+ * @param {uint8_t} *g
+ * @param {uint8_t} *b
+ * @return {*}
+ */
+static void ws2812b_reference_decode_from_array(uint8_t *r, uint8_t *g, uint8_t *b)
+{
+    uint8_t mask = 0x01;
+    uint8_t red = 0x00;
+    uint8_t green = 0x00;
+    uint8_t blue = 0x00;
+    /* 解码G */
+    for (uint8_t i = 8; i > 0; i--)
+    {
+        if (ws2812b_reference_config[i - 1] == WS_1)
+        {
+            green |= mask;
+        }
+        else
+        {
+            green &= ~mask;
+        }
+        mask <<= 1;
+    }
+    mask = 0x01; /* 复位解码值 */
+    /* 解码R */
+    for (uint8_t i = 8; i > 0; i--)
+    {
+        if (ws2812b_reference_config[i - 1 + 8] == WS_1)
+        {
+            red |= mask;
+        }
+        else
+        {
+            red &= ~mask;
+        }
+        mask <<= 1;
+    }
+    mask = 0x01; /* 复位解码值 */
+    /* 解码B */
+    for (uint8_t i = 8; i > 0; i--)
+    {
+        if (ws2812b_reference_config[i - 1 + 16] == WS_1)
+        {
+            blue |= mask;
+        }
+        else
+        {
+            blue &= ~mask;
+        }
+        mask <<= 1;
+    }
+    /* 赋值 */
+    *r = red;
+    *g = green;
+    *b = blue;
+}
+/**
+ * @description: 呼吸灯的一步(原实现)
+ * @return {*}
+ */
+static void ws2812b_reference_breath(void)
+{
+    static float v_level = 0.01f;       /* 亮度每次递减1%,可配置 */
+    static uint8_t breate_state_up = 0; /* 0表示递减,1表示递增 */
+    static uint8_t r = 0;
+    static uint8_t g = 0;
+    static uint8_t b = 0;
+    static float h = 0.0f;
+    static float s = 0.0f;
+    static float v = 0.0f;
+
+    ws2812b_reference_decode_from_array(&r, &g, &b);
+    ws2812b_reference_rgb_to_hsv(g, r, b, &h, &s, &v);
+
+    /* 更新v值 */
+    if (breate_state_up) /* 递增 */
+    {
+        v += v_level;
+        if (v >= ws2812b_reference_v_raw)
+        {
+            v = ws2812b_reference_v_raw;
+            breate_state_up = 0;
+        }
+    }
+    else /* 递减 */
+    {
+        v -= v_level;
+        if (v <= 0.0f)
+        {
+            v = 0.01f;
+            breate_state_up = 1;
+        }
+    }
+    ws2812b_reference_hsv_to_rgb(h, s, v, &g, &r, &b);
+    ws2812b_reference_write_config_array(r, g, b);
+}
+/**
+ * @description: 亮度测试:检验所有感知亮度与通道值的整数结果与浮点计算的误差,并与原来的浮点HSV往返比较每一步的耗时
+ *               每一步的耗时包含计算颜色与编码一颗灯珠的24个脉冲
+ * @return {*}
+ */
+void ws2812b_color_benchmark(void)
+{
+    static uint16_t pulse[WS2812B_LAMP_PULSE];
+    const uint32_t color = 0xFFB90F; /* DarkGoldenrod1 */
+    uint32_t start_cycle;
+    uint32_t reference_cycle;
+    uint32_t lut_cycle;
+    uint32_t scaled;
+    int32_t error;
+    int32_t error_max = 0;
+    float gain;
+    float h, s;
+
+    /* 误差:整数缩放与浮点计算round(value * (brightness / 255) ^ 2.2)比较 */
+    for (uint16_t brightness = 0; brightness < 256; brightness++)
+    {
+        gain = powf(brightness / 255.0f, 2.2f);
+        for (uint16_t value = 0; value < 256; value++)
+        {
+            error = (int32_t)ws2812b_color_scale(value, brightness) - (int32_t)(value * gain + 0.5f);
+            error = (error < 0) ? -error : error;
+            if (error > error_max)
+            {
+                error_max = error;
+            }
+        }
+    }
+
+    /* 耗时:原实现 */
+    ws2812b_reference_rgb_to_hsv(color >> 8, color >> 16, color, &h, &s, &ws2812b_reference_v_raw);
+    ws2812b_reference_write_config_array(color >> 16, color >> 8, color);
+    start_cycle = dwt_get_cycle();
+    for (uint16_t i = 0; i < WS2812B_COLOR_BENCHMARK_ROUNDS; i++)
+    {
+        ws2812b_reference_breath();
+    }
+    reference_cycle = dwt_get_cycle() - start_cycle;
+
+    /* 耗时:亮度曲线与gamma表 */
+    start_cycle = dwt_get_cycle();
+    for (uint16_t i = 0; i < WS2812B_COLOR_BENCHMARK_ROUNDS; i++)
+    {
+        scaled = ws2812b_color_scale(color, ws2812b_breath_brightness(i));
+        ws2812b_encode_lamp(pulse, scaled >> 8, scaled >> 16, scaled);
+    }
+    lut_cycle = dwt_get_cycle() - start_cycle;
+
+    LOGINFO("[ws2812b_color_benchmark]max error:%d LSB,float hsv:%d cycles/step,lut:%d cycles/step,pulse:0x%X/0x%X\r\n",
+            error_max, reference_cycle / WS2812B_COLOR_BENCHMARK_ROUNDS, lut_cycle / WS2812B_COLOR_BENCHMARK_ROUNDS,
+            ws2812b_reference_config[0], pulse[0]);
+}
+#endif //__WS2812B_COLOR_BENCHMARK
@@ -0,0 +1,112 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-06 09:51:20
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-06 16:24:08
+ * @Description: ws2812b_fb.c
+ *               颜色统一使用0xRRGGBB表示(与led.h中的颜色定义相同),写入帧缓冲区时转换成G/R/B顺序
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include "ws2812b_fb.h"
+/**
+ * @description: 将区间[begin, end)合并到range中,合并结果为包含两者的最小区间
+ * @param {WS2812B_RangeDef} *range
+ * @param {uint16_t} begin
+ * @param {uint16_t} end
+ * @return {*}
+ */
+void ws2812b_range_merge(WS2812B_RangeDef *range, uint16_t begin, uint16_t end)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+    if (range->begin >= range->end)
+    {
+        range->begin = begin;
+        range->end = end;
+        return;
+    }
+    if (begin < range->begin)
+    {
+        range->begin = begin;
+    }
+    if (end > range->end)
+    {
+        range->end = end;
+    }
+}
+/**
+ * @description: 初始化帧缓冲区:所有灯珠写入黑色,并全部计入脏区间,第一次显示时刷新整条灯带
+ * @param {WS2812B_FramebufferDef} *fb
+ * @param {uint8_t} *grb
+ * @param {uint16_t} lamp_num
+ * @return {*}
+ */
+void ws2812b_fb_init(WS2812B_FramebufferDef *fb, uint8_t *grb, uint16_t lamp_num)
+{
+    fb->grb = grb;
+    fb->lamp_num = lamp_num;
+    for (uint32_t i = 0; i < (uint32_t)lamp_num * WS2812B_GRB_SIZE; i++)
+    {
+        grb[i] = 0;
+    }
+    fb->dirty.begin = 0;
+    fb->dirty.end = lamp_num;
+}
+/**
+ * @description: 设置一颗灯珠的颜色,颜色发生变化时计入脏区间
+ * @param {WS2812B_FramebufferDef} *fb
+ * @param {uint16_t} idx
+ * @param {uint32_t} color 0xRRGGBB
+ * @return {*}
+ */
+void ws2812b_fb_set(WS2812B_FramebufferDef *fb, uint16_t idx, uint32_t color)
+{
+    uint8_t *grb;
+    uint8_t r = color >> 16;
+    uint8_t g = color >> 8;
+    uint8_t b = color;
+    if (idx >= fb->lamp_num)
+    {
+        return;
+    }
+    grb = fb->grb + (uint32_t)idx * WS2812B_GRB_SIZE;
+    if ((grb[0] == g) && (grb[1] == r) && (grb[2] == b))
+    {
+        return;
+    }
+    grb[0] = g;
+    grb[1] = r;
+    grb[2] = b;
+    ws2812b_range_merge(&fb->dirty, idx, idx + 1);
+}
+/**
+ * @description: 将连续的灯珠设置为同一颜色
+ * @param {WS2812B_FramebufferDef} *fb
+ * @param {uint16_t} begin
+ * @param {uint16_t} length
+ * @param {uint32_t} color 0xRRGGBB
+ * @return {*}
+ */
+void ws2812b_fb_fill(WS2812B_FramebufferDef *fb, uint16_t begin, uint16_t length, uint32_t color)
+{
+    for (uint16_t i = 0; i < length; i++)
+    {
+        ws2812b_fb_set(fb, begin + i, color);
+    }
+}
+/**
+ * @description: 取出脏区间并清空,用于显示
+ * @param {WS2812B_FramebufferDef} *fb
+ * @param {WS2812B_RangeDef} *range
+ * @return {*} 0:上一次显示后没有灯珠发生变化
+ */
+uint8_t ws2812b_fb_take_dirty(WS2812B_FramebufferDef *fb, WS2812B_RangeDef *range)
+{
+    *range = fb->dirty;
+    fb->dirty.begin = 0;
+    fb->dirty.end = 0;
+    return (range->begin < range->end);
+}
@@ -0,0 +1,103 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-04 14:08:37
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-08 15:47:09
+ * @Description: ws2812b_stream.c
+ *               时隙k由半缓冲区(k & 1)发送:启动时编码时隙0/1,此后每发送完一个半缓冲区,
+ *               就在中断中把时隙k+2编码到该半缓冲区,DMA此时正在发送另一半,有一个时隙(30us)的编码时间
+ *               灯珠全部发送后继续发送全0时隙,直到全0脉冲数不少于WS2812B_RESET_PULSE,一帧结束
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include "ws2812b_stream.h"
+#include "string.h"
+/* 字节 -> 8个脉冲(高位先发送),由宏在编译时展开,const修饰,存放在flash中(4KB) */
+#define WS2812B_PULSE_BIT(byte, bit) (((byte) & (0x80 >> (bit))) ? WS_1 : WS_0)
+#define WS2812B_PULSE_ROW(byte)                                                                  \
+    {                                                                                            \
+        WS2812B_PULSE_BIT(byte, 0), WS2812B_PULSE_BIT(byte, 1), WS2812B_PULSE_BIT(byte, 2),      \
+        WS2812B_PULSE_BIT(byte, 3), WS2812B_PULSE_BIT(byte, 4), WS2812B_PULSE_BIT(byte, 5),      \
+        WS2812B_PULSE_BIT(byte, 6), WS2812B_PULSE_BIT(byte, 7)                                   \
+    }
+#define WS2812B_PULSE_ROW4(byte) WS2812B_PULSE_ROW(byte), WS2812B_PULSE_ROW((byte) + 1), WS2812B_PULSE_ROW((byte) + 2), WS2812B_PULSE_ROW((byte) + 3)
+#define WS2812B_PULSE_ROW16(byte) WS2812B_PULSE_ROW4(byte), WS2812B_PULSE_ROW4((byte) + 4), WS2812B_PULSE_ROW4((byte) + 8), WS2812B_PULSE_ROW4((byte) + 12)
+#define WS2812B_PULSE_ROW64(byte) WS2812B_PULSE_ROW16(byte), WS2812B_PULSE_ROW16((byte) + 16), WS2812B_PULSE_ROW16((byte) + 32), WS2812B_PULSE_ROW16((byte) + 48)
+static const uint16_t ws2812b_pulse_table[256][8] = {WS2812B_PULSE_ROW64(0), WS2812B_PULSE_ROW64(64), WS2812B_PULSE_ROW64(128), WS2812B_PULSE_ROW64(192)};
+/**
+ * @description: 将一颗灯珠的颜色编码成24个脉冲,按照GRB的顺序发送(G7->G6->G5->......B0)
+ *               每个字节查表拷贝8个脉冲
+ * @param {uint16_t} *pulse
+ * @param {uint8_t} g
+ * @param {uint8_t} r
+ * @param {uint8_t} b
+ * @return {*}
+ */
+void ws2812b_encode_lamp(uint16_t *pulse, uint8_t g, uint8_t r, uint8_t b)
+{
+    memcpy(pulse, ws2812b_pulse_table[g], sizeof(ws2812b_pulse_table[0]));
+    memcpy(pulse + 8, ws2812b_pulse_table[r], sizeof(ws2812b_pulse_table[0]));
+    memcpy(pulse + 16, ws2812b_pulse_table[b], sizeof(ws2812b_pulse_table[0]));
+}
+/**
+ * @description: 将一个时隙编码到半缓冲区,灯珠之后的部分写入全0复位脉冲
+ * @param {WS2812B_StreamDef} *stream
+ * @param {uint16_t} *pulse 半缓冲区
+ * @param {uint16_t} slot
+ * @return {*}
+ */
+static void ws2812b_stream_fill(WS2812B_StreamDef *stream, uint16_t *pulse, uint16_t slot)
+{
+    const uint8_t *grb;
+    uint32_t lamp = (uint32_t)slot * WS2812B_STREAM_HALF_LAMP;
+    for (uint8_t i = 0; i < WS2812B_STREAM_HALF_LAMP; i++, lamp++, pulse += WS2812B_LAMP_PULSE)
+    {
+        if (lamp < stream->lamp_num)
+        {
+            grb = stream->grb + lamp * stream->grb_stride;
+            ws2812b_encode_lamp(pulse, grb[0], grb[1], grb[2]);
+        }
+        else
+        {
+            for (uint8_t j = 0; j < WS2812B_LAMP_PULSE; j++)
+            {
+                pulse[j] = 0; /* 全0复位脉冲 */
+            }
+        }
+    }
+}
+/**
+ * @description: 开始发送一帧:编码前两个时隙,之后由调用者以WS2812B_STREAM_BUFFER_SIZE为长度启动循环DMA
+ *               发送期间grb指向的数据不能改动
+ * @param {WS2812B_StreamDef} *stream
+ * @param {uint8_t} *grb
+ * @param {uint16_t} grb_stride
+ * @param {uint16_t} lamp_num
+ * @return {*}
+ */
+void ws2812b_stream_start(WS2812B_StreamDef *stream, const uint8_t *grb, uint16_t grb_stride, uint16_t lamp_num)
+{
+    stream->grb = grb;
+    stream->grb_stride = grb_stride;
+    stream->lamp_num = lamp_num;
+    /* 灯珠之后至少需要WS2812B_RESET_PULSE个全0脉冲 */
+    stream->slot_num = ((uint32_t)lamp_num * WS2812B_LAMP_PULSE + WS2812B_RESET_PULSE + WS2812B_STREAM_HALF_SIZE - 1) / WS2812B_STREAM_HALF_SIZE;
+    ws2812b_stream_fill(stream, stream->buffer, 0);
+    ws2812b_stream_fill(stream, stream->buffer + WS2812B_STREAM_HALF_SIZE, 1);
+    stream->next_slot = 2;
+}
+/**
+ * @description: 半缓冲区发送完成后调用(半传输中断:half为0;传输完成中断:half为1),将下一个时隙编码到该半缓冲区
+ * @param {WS2812B_StreamDef} *stream
+ * @param {uint8_t} half
+ * @return {*} 1:发送完成的是最后一个时隙,一帧结束,调用者应停止DMA
+ */
+uint8_t ws2812b_stream_next(WS2812B_StreamDef *stream, uint8_t half)
+{
+    /* 刚发送完成的时隙为next_slot - 2 */
+    uint8_t done = (stream->next_slot - 1 >= stream->slot_num);
+    /* 一帧结束时DMA已经开始发送另一半,继续填充全0脉冲,停止前输出保持低电平 */
+    ws2812b_stream_fill(stream, stream->buffer + half * WS2812B_STREAM_HALF_SIZE, stream->next_slot);
+    stream->next_slot++;
+    return done;
+}
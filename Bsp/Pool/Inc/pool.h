@@ -0,0 +1,86 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-09 10:05:12
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 11:20:48
+ * @Description: pool.h 静态对象池
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __POOL__H__
+#define __POOL__H__
+#include "FreeRTOS.h" /* 这里并不需要FreeRTOS.h这个文件,但是task.h必须在FreeRTOS后面 */
+#include "task.h"
+#include "stdint.h"
+/* 对象池的使用方式 */
+/**
+ * 每种驱动实例在自己的.c文件中用POOL_DEFINE定义一个对象池,容量在编译期确定,存储区是静态数组,不占用FreeRTOS堆
+ * 申请:空闲链表非空时取链表头,否则取下一个从未使用过的块,两种情况都是常数时间,不需要初始化
+ * 释放:块挂回空闲链表头,常数时间;块大小固定,不会产生碎片
+ * 大小不固定的缓冲区(如串口接收缓冲区)使用POOL_ARENA_DEFINE定义的静态区,按实例的实际大小依次切分,只申请不释放
+ * 静态内存报告:对象池与静态区都是所在驱动.o文件的ZI数据,链接器参数--info sizes,totals在编译输出中列出每个驱动的静态内存,
+ *             运行时可以调用pool_report打印已使用的对象池与静态区的容量、使用量与历史最大值
+ */
+#define POOL_ALIGN 8                                                          /* 块的对齐字节数,满足所有实例结构体的对齐要求 */
+#define POOL_BLOCK_SIZE(size) (((size) + POOL_ALIGN - 1) & ~(POOL_ALIGN - 1)) /* 块大小:按POOL_ALIGN向上对齐,同时能容纳空闲链表指针 */
+#define POOL_ARENA_ALIGN(size) (((size) + 3) & ~3)                            /* 静态区切分的缓冲区按4字节对齐,计算静态区大小时使用 */
+/* 编译期检查:条件不成立时数组大小为负,编译报错 */
+#define POOL_STATIC_ASSERT(expr, name) typedef char pool_static_assert_##name[(expr) ? 1 : -1]
+
+typedef struct Pool_BlockDef
+{
+    /* data */
+    struct Pool_BlockDef *next; /* 空闲块的链表指针,块被申请后该位置属于实例 */
+} Pool_BlockDef;
+
+typedef struct Pool_Def
+{
+    /* data */
+    const char *name;             /* 对象池名称,用于报告 */
+    uint8_t *storage;             /* 静态存储区 */
+    uint16_t block_size;          /* 块大小,已对齐 */
+    uint16_t block_num;           /* 块数量:编译期确定的容量 */
+    uint16_t next_unused;         /* 下一个从未使用过的块的下标 */
+    uint16_t used;                /* 当前已申请的块数 */
+    uint16_t used_high_water;     /* 已申请块数的历史最大值 */
+    uint16_t fail_count;          /* 对象池已满而申请失败的次数 */
+    Pool_BlockDef *free_list;     /* 空闲链表:释放后的块 */
+    uint8_t linked;               /* 已挂入报告链表 */
+    struct Pool_Def *report_next; /* 报告链表:第一次申请时挂入 */
+} Pool_Def;
+
+typedef struct Pool_ArenaDef
+{
+    /* data */
+    const char *name;                  /* 静态区名称,用于报告 */
+    uint8_t *storage;                  /* 静态存储区 */
+    uint16_t size;                     /* 静态区大小 */
+    uint16_t used;                     /* 已切分的字节数 */
+    uint16_t fail_count;               /* 剩余空间不足而申请失败的次数 */
+    uint8_t linked;                    /* 已挂入报告链表 */
+    struct Pool_ArenaDef *report_next; /* 报告链表:第一次申请时挂入 */
+} Pool_ArenaDef;
+
+/* 定义对象池:type为实例结构体类型,num为容量;存储区按POOL_ALIGN对齐 */
+#define POOL_DEFINE(pool, type, num)                                                            \
+    POOL_STATIC_ASSERT((num) > 0, pool##_not_empty);                                            \
+    static uint64_t pool##_storage[(POOL_BLOCK_SIZE(sizeof(type)) * (num)) / sizeof(uint64_t)]; \
+    static Pool_Def pool = {.name = #pool,                                                      \
+                            .storage = (uint8_t *)pool##_storage,                               \
+                            .block_size = POOL_BLOCK_SIZE(sizeof(type)),                        \
+                            .block_num = (num)}
+/* 定义容量为0的对象池:不占用静态内存,申请总是失败,用于编译时关闭的功能 */
+#define POOL_DEFINE_EMPTY(pool) static Pool_Def pool = {.name = #pool}
+/* 定义静态区:arena_size为所有实例缓冲区大小之和,每个缓冲区按4字节对齐切分 */
+#define POOL_ARENA_DEFINE(arena, arena_size)                             \
+    POOL_STATIC_ASSERT((arena_size) > 0, arena##_not_empty);             \
+    static uint32_t arena##_storage[POOL_ARENA_ALIGN(arena_size) / 4];   \
+    static Pool_ArenaDef arena = {.name = #arena,                        \
+                                  .storage = (uint8_t *)arena##_storage, \
+                                  .size = POOL_ARENA_ALIGN(arena_size)}
+
+void *pool_alloc(Pool_Def *pool);
+void pool_free(Pool_Def *pool, void *block);
+void *pool_arena_alloc(Pool_ArenaDef *arena, uint16_t size);
+void pool_report(void);
+#endif //!__POOL__H__
@@ -0,0 +1,134 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-09 10:05:12
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 11:20:48
+ * @Description: pool.c 静态对象池
+ *               替代驱动实例创建时的pvPortMalloc:申请与释放都是常数时间,只修改几个下标和指针,
+ *               可以在临界区内调用,不会在关中断期间执行堆分配算法
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include "pool.h"
+#include "rtt.h"
+static Pool_Def *pool_report_list = NULL;       /* 已使用的对象池 */
+static Pool_ArenaDef *arena_report_list = NULL; /* 已使用的静态区 */
+/**
+ * @description: 从对象池中申请一个块,常数时间,可以在临界区内调用,不能在中断中调用
+ * @param {Pool_Def} *pool
+ * @return {*} NULL:对象池已满
+ */
+void *pool_alloc(Pool_Def *pool)
+{
+    Pool_BlockDef *block = NULL;
+    taskENTER_CRITICAL();
+    /* 第一次申请时挂入报告链表 */
+    if (!pool->linked)
+    {
+        pool->linked = 1;
+        pool->report_next = pool_report_list;
+        pool_report_list = pool;
+    }
+    if (pool->free_list != NULL)
+    {
+        /* 优先复用释放过的块 */
+        block = pool->free_list;
+        pool->free_list = block->next;
+    }
+    else if (pool->next_unused < pool->block_num)
+    {
+        /* 取下一个从未使用过的块,存储区不需要预先初始化成链表 */
+        block = (Pool_BlockDef *)(pool->storage + (uint32_t)pool->next_unused * pool->block_size);
+        pool->next_unused++;
+    }
+    if (block == NULL)
+    {
+        pool->fail_count++;
+    }
+    else
+    {
+        pool->used++;
+        if (pool->used > pool->used_high_water)
+        {
+            pool->used_high_water = pool->used;
+        }
+    }
+    taskEXIT_CRITICAL();
+    return block;
+}
+/**
+ * @description: 将块释放回对象池,常数时间,可以在临界区内调用,不能在中断中调用
+ * @param {Pool_Def} *pool
+ * @param {void} *block 必须是由同一个对象池申请的块
+ * @return {*}
+ */
+void pool_free(Pool_Def *pool, void *block)
+{
+    if (block == NULL)
+    {
+        return;
+    }
+    taskENTER_CRITICAL();
+    ((Pool_BlockDef *)block)->next = pool->free_list;
+    pool->free_list = (Pool_BlockDef *)block;
+    pool->used--;
+    taskEXIT_CRITICAL();
+}
+/**
+ * @description: 从静态区中切分一个缓冲区,常数时间,切分出的缓冲区不能释放
+ * @param {Pool_ArenaDef} *arena
+ * @param {uint16_t} size 缓冲区大小,按4字节对齐切分
+ * @return {*} NULL:剩余空间不足
+ */
+void *pool_arena_alloc(Pool_ArenaDef *arena, uint16_t size)
+{
+    uint8_t *buffer = NULL;
+    uint16_t aligned = POOL_ARENA_ALIGN(size);
+    taskENTER_CRITICAL();
+    /* 第一次申请时挂入报告链表 */
+    if (!arena->linked)
+    {
+        arena->linked = 1;
+        arena->report_next = arena_report_list;
+        arena_report_list = arena;
+    }
+    if ((size != 0) && (aligned <= arena->size - arena->used))
+    {
+        buffer = arena->storage + arena->used;
+        arena->used += aligned;
+    }
+    else
+    {
+        arena->fail_count++;
+    }
+    taskEXIT_CRITICAL();
+    return buffer;
+}
+/**
+ * @description: 打印已使用的对象池与静态区:静态内存字节数、使用量与历史最大值、申请失败次数
+ *               未使用的对象池不在报告中,完整的静态内存见编译输出中每个.o文件的ZI数据
+ * @return {*}
+ */
+void pool_report(void)
+{
+    Pool_Def *pool;
+    Pool_ArenaDef *arena;
+    for (pool = pool_report_list; pool != NULL; pool = pool->report_next)
+    {
+        LOGINFO("[pool]%s Static [%d] bytes, Used [%d/%d] blocks, High Water [%d], Fail [%d].\r\n",
+                pool->name,
+                pool->block_size * pool->block_num,
+                pool->used,
+                pool->block_num,
+                pool->used_high_water,
+                pool->fail_count);
+    }
+    for (arena = arena_report_list; arena != NULL; arena = arena->report_next)
+    {
+        LOGINFO("[pool]%s Static [%d] bytes, Used [%d] bytes, Fail [%d].\r\n",
+                arena->name,
+                arena->size,
+                arena->used,
+                arena->fail_count);
+    }
+}
@@ -2,7 +2,7 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-12 15:54:18
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-13 17:00:14
+ * @LastEditTime: 2025-01-28 15:37:20
  * @Description:
  *
  * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
@@ -11,12 +11,73 @@
 #define __RTT__H__
 
 #include "SEGGER_RTT.h"
+#include "stdint.h"
 
 #define RTT_BUFFER_INDEX 0         // Buffer index 0表示输出到终端
+/* 延迟日志宏定义:LOGINFO/LOGWARNING/LOGERROR不在目标板上格式化,只写入二进制记录,由上位机还原文本 */
+// #define __RTT_LOG_DEFERRED
+#define RTT_LOG_BUFFER_INDEX 1           // 延迟日志使用的上行缓冲区编号,J-Link RTT Logger选择通道1保存
+#define RTT_LOG_BUFFER_SIZE 2048         // 延迟日志缓冲区字节数
+#define RTT_LOG_SECTION "rtt_log_fmt"    // 格式化字符串所在的段,链接后的axf文件中即为ID表
+#define RTT_LOG_RECORD_MAGIC 0xA5        // 记录的同步字节
+#define RTT_LOG_RECORD_HEAD_SIZE 10      // 记录头字节数
+#define RTT_LOG_ARGS_MAX 12              // 每条记录最多的参数个数
+#define RTT_LOG_LEVEL_INFO 0
+#define RTT_LOG_LEVEL_WARNING 1
+#define RTT_LOG_LEVEL_ERROR 2
+#define RTT_LOG_LEVEL_OFF 3             // 运行时关闭该模块的全部日志
+#define RTT_LOG_MODULE_ALL 0xFF         // rtt_log_set_level同时设置全部模块
+/* 日志模块列表:MODULE(NAME, name, build_level) */
+/**
+ * build_level为编译期等级阈值,低于该等级的日志调用不参与编译;运行时等级初始化为build_level,
+ * 可以通过上位机命令SCHEMA_LOG_LEVEL_CMD调整,被运行时等级过滤的调用只有一次比较与跳转
+ * 源文件在包含任何头文件之前定义LOG_MODULE选择所属模块,未定义时属于SYSTEM
+ */
+#define RTT_LOG_MODULES(MODULE)                               \
+        MODULE(SYSTEM, "system", RTT_LOG_LEVEL_INFO)           \
+        MODULE(UART, "uart", RTT_LOG_LEVEL_INFO)               \
+        MODULE(COMMUCATION, "commucation", RTT_LOG_LEVEL_INFO) \
+        MODULE(RC, "rc", RTT_LOG_LEVEL_INFO)                   \
+        MODULE(CHASSIS, "chassis", RTT_LOG_LEVEL_INFO)         \
+        MODULE(LED, "led", RTT_LOG_LEVEL_INFO)
+#ifndef LOG_MODULE
+#define LOG_MODULE SYSTEM
+#endif //!LOG_MODULE
+#define RTT_LOG_MODULE_ENUM(NAME, name, build_level) RTT_LOG_MODULE_##NAME,
+#define RTT_LOG_BUILD_LEVEL_ENUM(NAME, name, build_level) RTT_LOG_BUILD_LEVEL_##NAME = (build_level),
+enum
+{
+        RTT_LOG_MODULES(RTT_LOG_MODULE_ENUM)
+        RTT_LOG_MODULE_NUM
+};
+enum
+{
+        RTT_LOG_MODULES(RTT_LOG_BUILD_LEVEL_ENUM)
+        RTT_LOG_BUILD_LEVEL_END
+};
+
+typedef struct
+{
+    /* data */
+    uint8_t level;           /* 运行时等级阈值,低于该等级的日志被过滤 */
+    const char *name;        /* 模块名 */
+    uint32_t emit_count;     /* 输出的日志条数 */
+    uint32_t suppress_count; /* 被运行时等级过滤的日志条数 */
+} RTT_LogModuleDef;
+extern RTT_LogModuleDef rtt_log_module[RTT_LOG_MODULE_NUM];
+/* 日志耗时测试宏定义:比较文本日志与延迟日志每次调用的CPU节拍数,需要连接RTT Viewer读取缓冲区 */
+// #define __RTT_LOG_BENCHMARK
+#define RTT_LOG_BENCHMARK_ROUNDS 4 /* 调用次数,文本日志的输出不能超过终端缓冲区大小 */
 void rtt_log_init(void);
 int rtt_print_log(const char *sFormat, ...);
 void rtt_float_to_str(char *str, float va);
 void rtt_str_to_hex(const uint8_t* buf, int len);
+void rtt_log_write(uint8_t level, const char *format, const uint32_t *args, uint8_t arg_count);
+uint8_t rtt_log_set_level(uint8_t module, uint8_t level);
+void rtt_log_report(void);
+#ifdef __RTT_LOG_BENCHMARK
+void rtt_log_benchmark(void);
+#endif //__RTT_LOG_BENCHMARK
 /**
  * @description: 日志功能原型,供下面的LOGI,LOGW,LOGE等使用
  * @return {*}
@@ -27,12 +88,81 @@ void rtt_str_to_hex(const uint8_t* buf, int len);
                           type,                                   \
                           ##__VA_ARGS__,                          \
                           RTT_CTRL_RESET)
+/* 延迟日志的记录格式 */
+/**
+   | 数据      | 偏移位置 | 字节大小 | 内容                                                  |
+   | --------- | -------- | -------- | ----------------------------------------------------- |
+   | magic     | 0        | 1        | 同步字节,固定值为0xA5                                |
+   | info      | 1        | 1        | 高4位:日志等级;低4位:参数个数                         |
+   | format    | 2        | 4        | 格式化字符串的地址,即格式化字符串ID                   |
+   | timestamp | 6        | 4        | DWT节拍数                                             |
+   | args      | 10       | 4 * n    | 参数原始值,%s参数为字符串地址                         |
+*/
+/* 参数个数(0 ~ RTT_LOG_ARGS_MAX) */
+#define RTT_LOG_NARG(...) RTT_LOG_NARG_(0, ##__VA_ARGS__, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define RTT_LOG_NARG_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, n, ...) n
+/* 参数逐个转换为uint32_t,每个参数前带逗号 */
+#define RTT_LOG_CAT(a, b) RTT_LOG_CAT_(a, b)
+#define RTT_LOG_CAT_(a, b) a##b
+#define RTT_LOG_CAST(...) RTT_LOG_CAT(RTT_LOG_CAST_, RTT_LOG_NARG(__VA_ARGS__))(__VA_ARGS__)
+#define RTT_LOG_CAST_0()
+#define RTT_LOG_CAST_1(a) , (uint32_t)(a)
+#define RTT_LOG_CAST_2(a, ...) , (uint32_t)(a) RTT_LOG_CAST_1(__VA_ARGS__)
+#define RTT_LOG_CAST_3(a, ...) , (uint32_t)(a) RTT_LOG_CAST_2(__VA_ARGS__)
+#define RTT_LOG_CAST_4(a, ...) , (uint32_t)(a) RTT_LOG_CAST_3(__VA_ARGS__)
+#define RTT_LOG_CAST_5(a, ...) , (uint32_t)(a) RTT_LOG_CAST_4(__VA_ARGS__)
+#define RTT_LOG_CAST_6(a, ...) , (uint32_t)(a) RTT_LOG_CAST_5(__VA_ARGS__)
+#define RTT_LOG_CAST_7(a, ...) , (uint32_t)(a) RTT_LOG_CAST_6(__VA_ARGS__)
+#define RTT_LOG_CAST_8(a, ...) , (uint32_t)(a) RTT_LOG_CAST_7(__VA_ARGS__)
+#define RTT_LOG_CAST_9(a, ...) , (uint32_t)(a) RTT_LOG_CAST_8(__VA_ARGS__)
+#define RTT_LOG_CAST_10(a, ...) , (uint32_t)(a) RTT_LOG_CAST_9(__VA_ARGS__)
+#define RTT_LOG_CAST_11(a, ...) , (uint32_t)(a) RTT_LOG_CAST_10(__VA_ARGS__)
+#define RTT_LOG_CAST_12(a, ...) , (uint32_t)(a) RTT_LOG_CAST_11(__VA_ARGS__)
+/**
+ * @description: 延迟日志原型:格式化字符串放入RTT_LOG_SECTION段,以其地址作为ID,
+ *               参数按原始值写入记录,不在目标板上格式化;参数只支持整数、字符与字符串(%s需为常量字符串)
+ * @return {*}
+ */
+#define LOG_DEFERRED_PROTO(level, format, ...)                                                              \
+        do                                                                                                 \
+        {                                                                                                  \
+                static const char rtt_log_format[] __attribute__((section(RTT_LOG_SECTION))) = format;   \
+                const uint32_t rtt_log_args[] = {0 RTT_LOG_CAST(__VA_ARGS__)};                            \
+                rtt_log_write(level, rtt_log_format, rtt_log_args + 1, RTT_LOG_NARG(__VA_ARGS__));         \
+        } while (0)
+/**
+ * @description: 日志等级过滤:编译期阈值为常量比较,不满足时整个调用被优化掉;
+ *               运行时阈值只有一次比较与跳转,同时统计输出与被过滤的条数
+ * @return {*}
+ */
+#define LOG_FILTER_PROTO(log_level, proto)                                                                 \
+        do                                                                                                 \
+        {                                                                                                  \
+                if ((log_level) >= RTT_LOG_CAT(RTT_LOG_BUILD_LEVEL_, LOG_MODULE))                          \
+                {                                                                                          \
+                        if ((log_level) >= rtt_log_module[RTT_LOG_CAT(RTT_LOG_MODULE_, LOG_MODULE)].level) \
+                        {                                                                                  \
+                                rtt_log_module[RTT_LOG_CAT(RTT_LOG_MODULE_, LOG_MODULE)].emit_count++;     \
+                                proto;                                                                     \
+                        }                                                                                  \
+                        else                                                                               \
+                        {                                                                                  \
+                                rtt_log_module[RTT_LOG_CAT(RTT_LOG_MODULE_, LOG_MODULE)].suppress_count++; \
+                        }                                                                                  \
+                }                                                                                          \
+        } while (0)
 /* 输出LOG前可以使用SEGGER_RTT_SetTerminal选择终端编号 */
+#ifdef __RTT_LOG_DEFERRED
+#define LOGINFO(format, ...) LOG_FILTER_PROTO(RTT_LOG_LEVEL_INFO, LOG_DEFERRED_PROTO(RTT_LOG_LEVEL_INFO, format, ##__VA_ARGS__))
+#define LOGWARNING(format, ...) LOG_FILTER_PROTO(RTT_LOG_LEVEL_WARNING, LOG_DEFERRED_PROTO(RTT_LOG_LEVEL_WARNING, format, ##__VA_ARGS__))
+#define LOGERROR(format, ...) LOG_FILTER_PROTO(RTT_LOG_LEVEL_ERROR, LOG_DEFERRED_PROTO(RTT_LOG_LEVEL_ERROR, format, ##__VA_ARGS__))
+#else
 // information level
-#define LOGINFO(format, ...) LOG_PROTO("I:", RTT_CTRL_TEXT_BRIGHT_GREEN, format, ##__VA_ARGS__)
+#define LOGINFO(format, ...) LOG_FILTER_PROTO(RTT_LOG_LEVEL_INFO, LOG_PROTO("I:", RTT_CTRL_TEXT_BRIGHT_GREEN, format, ##__VA_ARGS__))
 // warning level
-#define LOGWARNING(format, ...) LOG_PROTO("W:", RTT_CTRL_TEXT_BRIGHT_YELLOW, format, ##__VA_ARGS__)
+#define LOGWARNING(format, ...) LOG_FILTER_PROTO(RTT_LOG_LEVEL_WARNING, LOG_PROTO("W:", RTT_CTRL_TEXT_BRIGHT_YELLOW, format, ##__VA_ARGS__))
 // error level
-#define LOGERROR(format, ...) LOG_PROTO("E:", RTT_CTRL_TEXT_BRIGHT_RED, format, ##__VA_ARGS__)
+#define LOGERROR(format, ...) LOG_FILTER_PROTO(RTT_LOG_LEVEL_ERROR, LOG_PROTO("E:", RTT_CTRL_TEXT_BRIGHT_RED, format, ##__VA_ARGS__))
+#endif //__RTT_LOG_DEFERRED
 
 #endif //!__RTT__H__
@@ -0,0 +1,45 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-29 09:52:06
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 17:58:13
+ * @Description: rtt_format.h 诊断信息格式化:十六进制转储与定点浮点数
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __RTT_FORMAT__H__
+#define __RTT_FORMAT__H__
+#include "stdint.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/* 该文件不依赖HAL与RTT,上位机可以直接复用 */
+/* 十六进制转储的行格式,与原rtt_str_to_hex一致 */
+/**
+   | 数据    | 偏移位置 | 字节大小 | 内容                                  |
+   | ------- | -------- | -------- | ------------------------------------- |
+   | address | 0        | 10       | 8位十六进制地址与": "                 |
+   | hex     | 10       | 48       | 16个"XX ",不足16字节时以空格补齐      |
+   | ascii   | 58       | 19       | " |" + 16个可打印字符 + "|"           |
+   | newline | 77       | 1        | "\n"                                  |
+*/
+#define RTT_FORMAT_HEX_BYTES_PER_LINE 16
+#define RTT_FORMAT_HEX_LINE_SIZE 78       /* 一行的字符数,不含结束符 */
+#define RTT_FORMAT_FLOAT_DECIMALS_MAX 6   /* 定点浮点数最多的小数位数 */
+#define RTT_FORMAT_FLOAT_SIZE_MAX 19      /* 定点浮点数最长的字符数(含结束符):符号 + 10位整数 + 小数点 + 6位小数 + 结束符 */
+/* 格式化测试宏定义:检验格式化结果,并与逐字节SEGGER_RTT_printf/sprintf比较耗时 */
+// #define __RTT_FORMAT_BENCHMARK
+#define RTT_FORMAT_BENCHMARK_BYTES 64 /* 十六进制转储的字节数 */
+#define RTT_FORMAT_BENCHMARK_ROUNDS 100 /* 浮点数格式化次数 */
+
+uint16_t rtt_format_hex_line(char *line, uint32_t address, const uint8_t *buf, uint8_t len);
+uint8_t rtt_format_float(char *str, float value, uint8_t decimals);
+#ifdef __RTT_FORMAT_BENCHMARK
+void rtt_format_benchmark(void);
+#endif //__RTT_FORMAT_BENCHMARK
+
+#ifdef __cplusplus
+}
+#endif
+#endif //!__RTT_FORMAT__H__
@@ -2,15 +2,21 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-12 15:54:05
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-17 09:57:54
+ * @LastEditTime: 2025-01-29 17:21:45
  * @Description:
  *
  * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
  */
 #include "rtt.h"
 #include "stdarg.h"
-#include "stdlib.h"
-#include "stdio.h"
+#include "rtt_format.h"
+#include "string.h"
+#include "dwt.h"
+#define RTT_LOG_MODULE_INIT(NAME, name, build_level) {(build_level), name, 0, 0},
+/* 各模块的运行时等级与统计信息,运行时等级初始化为编译期阈值 */
+RTT_LogModuleDef rtt_log_module[RTT_LOG_MODULE_NUM] = {RTT_LOG_MODULES(RTT_LOG_MODULE_INIT)};
+/* 延迟日志的上行缓冲区 */
+static uint8_t rtt_log_buffer[RTT_LOG_BUFFER_SIZE];
 /**
  * @description: 初始化rtt
  * @return {*}
@@ -20,8 +26,112 @@ void rtt_log_init(void)
     SEGGER_RTT_Init();
     /* 设置输出的Terminal编号恒定为0 */
     SEGGER_RTT_SetTerminal(0);
+    /* 延迟日志使用独立的上行缓冲区,缓冲区满时丢弃整条记录,保证记录完整 */
+    SEGGER_RTT_ConfigUpBuffer(RTT_LOG_BUFFER_INDEX, "DeferredLog", rtt_log_buffer, sizeof(rtt_log_buffer), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
     rtt_print_log("RTT Init Successfully!\r\n");
 }
+/**
+ * @description: 写入一条延迟日志记录,由LOG_DEFERRED_PROTO调用,可以在中断中调用
+ * @param {uint8_t} level 日志等级
+ * @param {char} *format 格式化字符串,地址即为格式化字符串ID
+ * @param {uint32_t} *args 参数原始值
+ * @param {uint8_t} arg_count 参数个数
+ * @return {*}
+ */
+void rtt_log_write(uint8_t level, const char *format, const uint32_t *args, uint8_t arg_count)
+{
+    uint8_t record[RTT_LOG_RECORD_HEAD_SIZE + RTT_LOG_ARGS_MAX * 4];
+    uint32_t word;
+    if (arg_count > RTT_LOG_ARGS_MAX)
+    {
+        arg_count = RTT_LOG_ARGS_MAX;
+    }
+    record[0] = RTT_LOG_RECORD_MAGIC;
+    record[1] = (uint8_t)((level << 4) | arg_count);
+    word = (uint32_t)format;
+    memcpy(record + 2, &word, 4);
+    word = dwt_get_cycle();
+    memcpy(record + 6, &word, 4);
+    memcpy(record + RTT_LOG_RECORD_HEAD_SIZE, args, arg_count * 4);
+    /* 一次写入整条记录:SEGGER_RTT_Write内部加锁,中断与任务的记录不会交错 */
+    SEGGER_RTT_Write(RTT_LOG_BUFFER_INDEX, record, RTT_LOG_RECORD_HEAD_SIZE + arg_count * 4);
+}
+/**
+ * @description: 设置模块的运行时日志等级,低于编译期阈值的日志不会因此恢复
+ * @param {uint8_t} module 模块编号,RTT_LOG_MODULE_ALL表示全部模块
+ * @param {uint8_t} level 日志等级,RTT_LOG_LEVEL_OFF表示关闭
+ * @return {*} 1:设置成功;0:参数错误
+ */
+uint8_t rtt_log_set_level(uint8_t module, uint8_t level)
+{
+    if ((level > RTT_LOG_LEVEL_OFF) || ((module >= RTT_LOG_MODULE_NUM) && (module != RTT_LOG_MODULE_ALL)))
+    {
+        return 0;
+    }
+    for (uint8_t i = 0; i < RTT_LOG_MODULE_NUM; i++)
+    {
+        if ((module == RTT_LOG_MODULE_ALL) || (module == i))
+        {
+            /* 单字节写入,不需要加锁 */
+            rtt_log_module[i].level = level;
+        }
+    }
+    return 1;
+}
+/**
+ * @description: 打印各模块的日志等级与统计信息,不受日志等级过滤
+ * @return {*}
+ */
+void rtt_log_report(void)
+{
+    for (uint8_t i = 0; i < RTT_LOG_MODULE_NUM; i++)
+    {
+        rtt_print_log("[rtt_log]%s level [%d], emit [%d], suppress [%d].\r\n",
+                      rtt_log_module[i].name,
+                      rtt_log_module[i].level,
+                      rtt_log_module[i].emit_count,
+                      rtt_log_module[i].suppress_count);
+    }
+}
+#ifdef __RTT_LOG_BENCHMARK
+/**
+ * @description: 日志耗时测试:以SBUS回调中10个整数的日志为例,比较文本日志、延迟日志与被过滤的日志每次调用的CPU节拍数
+ * @return {*}
+ */
+void rtt_log_benchmark(void)
+{
+    uint32_t cycle_start;
+    uint32_t cycle_text = 0;
+    uint32_t cycle_deferred = 0;
+    uint32_t cycle_filtered;
+    for (uint8_t i = 0; i < RTT_LOG_BENCHMARK_ROUNDS; i++)
+    {
+        cycle_start = dwt_get_cycle();
+        LOG_PROTO("I:", RTT_CTRL_TEXT_BRIGHT_GREEN, "CH1:[%d]---CH2:[%d]---CH3:[%d]---CH4:[%d]---CH5:[%d]---CH6:[%d]---CH7:[%d]---CH8:[%d]---CH9:[%d]---CH10:[%d]\r\n",
+                  1024 + i, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024);
+        cycle_text += dwt_get_cycle() - cycle_start;
+        cycle_start = dwt_get_cycle();
+        LOG_DEFERRED_PROTO(RTT_LOG_LEVEL_INFO, "CH1:[%d]---CH2:[%d]---CH3:[%d]---CH4:[%d]---CH5:[%d]---CH6:[%d]---CH7:[%d]---CH8:[%d]---CH9:[%d]---CH10:[%d]\r\n",
+                           1024 + i, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024);
+        cycle_deferred += dwt_get_cycle() - cycle_start;
+    }
+    /* 被运行时等级过滤的调用 */
+    uint8_t level = rtt_log_module[RTT_LOG_MODULE_SYSTEM].level;
+    rtt_log_set_level(RTT_LOG_MODULE_SYSTEM, RTT_LOG_LEVEL_OFF);
+    cycle_start = dwt_get_cycle();
+    for (uint8_t i = 0; i < RTT_LOG_BENCHMARK_ROUNDS; i++)
+    {
+        LOGINFO("CH1:[%d]---CH2:[%d]---CH3:[%d]---CH4:[%d]---CH5:[%d]---CH6:[%d]---CH7:[%d]---CH8:[%d]---CH9:[%d]---CH10:[%d]\r\n",
+                1024 + i, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024);
+    }
+    cycle_filtered = dwt_get_cycle() - cycle_start;
+    rtt_log_set_level(RTT_LOG_MODULE_SYSTEM, level);
+    rtt_print_log("[rtt_log]text [%d] cycles/call, deferred [%d] cycles/call, filtered [%d] cycles/call.\r\n",
+                  cycle_text / RTT_LOG_BENCHMARK_ROUNDS,
+                  cycle_deferred / RTT_LOG_BENCHMARK_ROUNDS,
+                  cycle_filtered / RTT_LOG_BENCHMARK_ROUNDS);
+}
+#endif //__RTT_LOG_BENCHMARK
 /**
  * @description: 通过SEGGER RTT打印日志,支持格式化输出,不支持浮点数格式化
  * @param {char *} sFormat
@@ -41,77 +151,32 @@ int rtt_print_log(const char *sFormat, ...)
     return r;
 }
 /**
- * @description: 将浮点值格式化成字符串
- * @param {char} *str:转换后的字符串
+ * @description: 将浮点值格式化成字符串,保留3位小数
+ * @param {char} *str:转换后的字符串,至少RTT_FORMAT_FLOAT_SIZE_MAX字节
  * @param {float} va:浮点值
  * @return {*}
  */
 void rtt_float_to_str(char *str, float va)
 {
-    int flag = va < 0;
-    int head = (int)va;
-    int point = (int)((va - head) * 1000);
-    head = abs(head);
-    point = abs(point);
-    if (flag)
-        sprintf(str, "-%d.%d", head, point);
-    else
-        sprintf(str, "%d.%d", head, point);
+    rtt_format_float(str, va, 3);
 }
 /**
  * @description: 将字符串转换成对应的十六进制进行打印:一行16字节数据
+ *               每行先渲染到栈上的缓冲区,再一次写入RTT
  * @param {uint8_t*} buf:字符串指针
  * @param {int} len:打印长度
  * @return {*}
  */
 void rtt_str_to_hex(const uint8_t* buf, int len)
 {
-    int i, c;
+    char line[RTT_FORMAT_HEX_LINE_SIZE];
+    uint16_t line_length;
 
-    while ((int)len > 0)
+    while (len > 0)
     {
-        SEGGER_RTT_printf(0, "%08X: ", buf);
-
-        for (i = 0; i < 16; i++)
-        {
-            if (i < (int)len)
-            {
-                SEGGER_RTT_printf(0, "%02X ", buf[i] & 0xFF);
-            }
-            else
-            {
-                SEGGER_RTT_printf(0, "   ");
-            }
-
-            // if (i == 7)
-            // {
-            //     SEGGER_RTT_printf(0, " ");
-            // }
-        }
-
-        SEGGER_RTT_printf(0, " |");
-
-        for (i = 0; i < 16; i++)
-        {
-            if (i < (int)len)
-            {
-                c = buf[i] & 0xFF;
-
-                if ((c < 0x20) || (c >= 0x7F))
-                {
-                    c = '.';
-                }
-            }
-            else
-            {
-                c = ' ';
-            }
-
-            SEGGER_RTT_printf(0, "%c", c);
-        }
-
-        SEGGER_RTT_printf(0, "|\n");
-        len -= 16;
-        buf += 16;
+        line_length = rtt_format_hex_line(line, (uint32_t)buf, buf, (len > RTT_FORMAT_HEX_BYTES_PER_LINE) ? RTT_FORMAT_HEX_BYTES_PER_LINE : (uint8_t)len);
+        SEGGER_RTT_Write(RTT_BUFFER_INDEX, line, line_length);
+        len -= RTT_FORMAT_HEX_BYTES_PER_LINE;
+        buf += RTT_FORMAT_HEX_BYTES_PER_LINE;
     }
 }
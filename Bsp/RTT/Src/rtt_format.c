@@ -0,0 +1,313 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-29 09:52:31
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-01-29 17:21:45
+ * @Description: rtt_format.c 诊断信息格式化:十六进制转储与定点浮点数
+ *               一行十六进制转储按查表渲染到调用者的缓冲区,由调用者一次写入RTT;
+ *               浮点数按整数部分与四舍五入后的小数部分分别转换,小数部分补齐前导0
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include "rtt_format.h"
+#include "string.h"
+#ifdef __RTT_FORMAT_BENCHMARK
+#include "stdio.h"
+#include "stdlib.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "dwt.h"
+#include "rtt.h"
+#endif //__RTT_FORMAT_BENCHMARK
+/* 半字节 -> 十六进制字符 */
+static const char rtt_format_hex_digit[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+/* 0 ~ 99 -> 两位十进制字符 */
+static const char rtt_format_decimal_pair[200] = {
+    '0', '0', '0', '1', '0', '2', '0', '3', '0', '4', '0', '5', '0', '6', '0', '7', '0', '8', '0', '9',
+    '1', '0', '1', '1', '1', '2', '1', '3', '1', '4', '1', '5', '1', '6', '1', '7', '1', '8', '1', '9',
+    '2', '0', '2', '1', '2', '2', '2', '3', '2', '4', '2', '5', '2', '6', '2', '7', '2', '8', '2', '9',
+    '3', '0', '3', '1', '3', '2', '3', '3', '3', '4', '3', '5', '3', '6', '3', '7', '3', '8', '3', '9',
+    '4', '0', '4', '1', '4', '2', '4', '3', '4', '4', '4', '5', '4', '6', '4', '7', '4', '8', '4', '9',
+    '5', '0', '5', '1', '5', '2', '5', '3', '5', '4', '5', '5', '5', '6', '5', '7', '5', '8', '5', '9',
+    '6', '0', '6', '1', '6', '2', '6', '3', '6', '4', '6', '5', '6', '6', '6', '7', '6', '8', '6', '9',
+    '7', '0', '7', '1', '7', '2', '7', '3', '7', '4', '7', '5', '7', '6', '7', '7', '7', '8', '7', '9',
+    '8', '0', '8', '1', '8', '2', '8', '3', '8', '4', '8', '5', '8', '6', '8', '7', '8', '8', '8', '9',
+    '9', '0', '9', '1', '9', '2', '9', '3', '9', '4', '9', '5', '9', '6', '9', '7', '9', '8', '9', '9'};
+/* 10的幂,下标为小数位数 */
+static const uint32_t rtt_format_pow10[RTT_FORMAT_FLOAT_DECIMALS_MAX + 1] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+/**
+ * @description: 渲染一行十六进制转储,格式与原rtt_str_to_hex一致
+ * @param {char} *line 输出缓冲区,至少RTT_FORMAT_HEX_LINE_SIZE字节,不写入结束符
+ * @param {uint32_t} address 行首显示的地址
+ * @param {uint8_t} *buf 数据
+ * @param {uint8_t} len 数据字节数,超过RTT_FORMAT_HEX_BYTES_PER_LINE时只渲染前16字节
+ * @return {*} 行的字符数,恒为RTT_FORMAT_HEX_LINE_SIZE
+ */
+uint16_t rtt_format_hex_line(char *line, uint32_t address, const uint8_t *buf, uint8_t len)
+{
+    char *hex = line + 10;
+    char *ascii = line + 10 + RTT_FORMAT_HEX_BYTES_PER_LINE * 3 + 2;
+    uint8_t c;
+    if (len > RTT_FORMAT_HEX_BYTES_PER_LINE)
+    {
+        len = RTT_FORMAT_HEX_BYTES_PER_LINE;
+    }
+    for (int8_t i = 7; i >= 0; i--)
+    {
+        line[i] = rtt_format_hex_digit[address & 0x0F];
+        address >>= 4;
+    }
+    line[8] = ':';
+    line[9] = ' ';
+    /* 不足一行的部分先整体填充空格 */
+    if (len < RTT_FORMAT_HEX_BYTES_PER_LINE)
+    {
+        memset(hex + len * 3, ' ', (RTT_FORMAT_HEX_BYTES_PER_LINE - len) * 3);
+        memset(ascii + len, ' ', RTT_FORMAT_HEX_BYTES_PER_LINE - len);
+    }
+    for (uint8_t i = 0; i < len; i++)
+    {
+        c = buf[i];
+        hex[0] = rtt_format_hex_digit[c >> 4];
+        hex[1] = rtt_format_hex_digit[c & 0x0F];
+        hex[2] = ' ';
+        hex += 3;
+        ascii[i] = ((c < 0x20) || (c >= 0x7F)) ? '.' : (char)c;
+    }
+    line[10 + RTT_FORMAT_HEX_BYTES_PER_LINE * 3] = ' ';
+    line[10 + RTT_FORMAT_HEX_BYTES_PER_LINE * 3 + 1] = '|';
+    line[RTT_FORMAT_HEX_LINE_SIZE - 2] = '|';
+    line[RTT_FORMAT_HEX_LINE_SIZE - 1] = '\n';
+    return RTT_FORMAT_HEX_LINE_SIZE;
+}
+/**
+ * @description: 无符号整数转十进制字符,每次查表转换两位
+ * @param {char} *end 输出的末尾(最后一位的下一个位置),字符从后向前写入
+ * @param {uint32_t} value 整数
+ * @param {uint8_t} width 最少位数,不足时补0
+ * @return {*} 第一位字符的位置
+ */
+static char *rtt_format_decimal(char *end, uint32_t value, uint8_t width)
+{
+    char *p = end;
+    uint32_t pair;
+    while (value >= 100)
+    {
+        pair = (value % 100) * 2;
+        value /= 100;
+        *--p = rtt_format_decimal_pair[pair + 1];
+        *--p = rtt_format_decimal_pair[pair];
+    }
+    if (value >= 10)
+    {
+        *--p = rtt_format_decimal_pair[value * 2 + 1];
+        *--p = rtt_format_decimal_pair[value * 2];
+    }
+    else
+    {
+        *--p = (char)('0' + value);
+    }
+    while (end - p < width)
+    {
+        *--p = '0';
+    }
+    return p;
+}
+/**
+ * @description: 浮点数格式化为定点字符串,小数部分四舍五入并补齐前导0(0.05 -> "0.050")
+ * @param {char} *str 输出字符串,至少RTT_FORMAT_FLOAT_SIZE_MAX字节
+ * @param {float} value 浮点值,绝对值不小于2^32时输出"inf",非数输出"nan"
+ * @param {uint8_t} decimals 小数位数,最多RTT_FORMAT_FLOAT_DECIMALS_MAX位,为0时不输出小数点
+ * @return {*} 字符数,不含结束符
+ */
+uint8_t rtt_format_float(char *str, float value, uint8_t decimals)
+{
+    char digits[RTT_FORMAT_FLOAT_SIZE_MAX];
+    char *end = digits + sizeof(digits);
+    char *p = end;
+    uint8_t negative = 0;
+    uint32_t integer;
+    uint32_t fraction;
+    uint8_t length;
+    if (decimals > RTT_FORMAT_FLOAT_DECIMALS_MAX)
+    {
+        decimals = RTT_FORMAT_FLOAT_DECIMALS_MAX;
+    }
+    if (value != value)
+    {
+        memcpy(str, "nan", 4);
+        return 3;
+    }
+    if (value < 0.0f)
+    {
+        negative = 1;
+        value = -value;
+    }
+    if (value >= 4294967296.0f)
+    {
+        p = digits + sizeof(digits) - 3;
+        memcpy(p, "inf", 3);
+    }
+    else
+    {
+        /* 整数部分直接截断,小数部分在float精度内精确,四舍五入后可能进位到整数部分 */
+        integer = (uint32_t)value;
+        fraction = (uint32_t)((value - (float)integer) * (float)rtt_format_pow10[decimals] + 0.5f);
+        if (fraction >= rtt_format_pow10[decimals])
+        {
+            fraction -= rtt_format_pow10[decimals];
+            if (integer == 0xFFFFFFFF)
+            {
+                /* 进位溢出时放弃进位,保持最大值 */
+                fraction = rtt_format_pow10[decimals] - 1;
+            }
+            else
+            {
+                integer++;
+            }
+        }
+        if (decimals != 0)
+        {
+            p = rtt_format_decimal(p, fraction, decimals);
+            *--p = '.';
+        }
+        p = rtt_format_decimal(p, integer, 1);
+    }
+    if (negative)
+    {
+        *--p = '-';
+    }
+    length = (uint8_t)(end - p);
+    memcpy(str, p, length);
+    str[length] = '\0';
+    return length;
+}
+#ifdef __RTT_FORMAT_BENCHMARK
+/**
+ * @description: 旧的十六进制转储:每个字节调用一次SEGGER_RTT_printf,作为测试的参照
+ * @param {uint8_t} *buf 数据
+ * @param {int} len 数据字节数
+ * @return {*}
+ */
+static void rtt_format_benchmark_hex_reference(const uint8_t *buf, int len)
+{
+    int i, c;
+    while (len > 0)
+    {
+        SEGGER_RTT_printf(0, "%08X: ", buf);
+        for (i = 0; i < 16; i++)
+        {
+            if (i < len)
+            {
+                SEGGER_RTT_printf(0, "%02X ", buf[i] & 0xFF);
+            }
+            else
+            {
+                SEGGER_RTT_printf(0, "   ");
+            }
+        }
+        SEGGER_RTT_printf(0, " |");
+        for (i = 0; i < 16; i++)
+        {
+            if (i < len)
+            {
+                c = buf[i] & 0xFF;
+                if ((c < 0x20) || (c >= 0x7F))
+                {
+                    c = '.';
+                }
+            }
+            else
+            {
+                c = ' ';
+            }
+            SEGGER_RTT_printf(0, "%c", c);
+        }
+        SEGGER_RTT_printf(0, "|\n");
+        len -= 16;
+        buf += 16;
+    }
+}
+/**
+ * @description: 旧的浮点数格式化:sprintf拼接整数部分与小数部分,作为测试的参照
+ * @param {char} *str 输出字符串
+ * @param {float} va 浮点值
+ * @return {*}
+ */
+static void rtt_format_benchmark_float_reference(char *str, float va)
+{
+    int flag = va < 0;
+    int head = (int)va;
+    int point = (int)((va - head) * 1000);
+    head = abs(head);
+    point = abs(point);
+    if (flag)
+        sprintf(str, "-%d.%d", head, point);
+    else
+        sprintf(str, "%d.%d", head, point);
+}
+/**
+ * @description: 格式化测试:检验浮点数与十六进制转储的格式化结果,并与旧的实现比较耗时
+ *               十六进制转储的耗时包含写入RTT,需要连接RTT Viewer读取终端缓冲区
+ * @return {*}
+ */
+void rtt_format_benchmark(void)
+{
+    static const float float_value[] = {0.05f, -0.05f, 1.5f, 231.43234f, -9.34f, 0.0f, 0.9996f, -1234567.0f};
+    static const char *const float_expect[] = {"0.050", "-0.050", "1.500", "231.432", "-9.340", "0.000", "1.000", "-1234567.000"};
+    static const char hex_expect[] = "00000010: 41 00 7F 20 7E FF                                |A.. ~.          |\n";
+    static const uint8_t hex_data[] = {0x41, 0x00, 0x7F, 0x20, 0x7E, 0xFF};
+    uint8_t data[RTT_FORMAT_BENCHMARK_BYTES];
+    char line[RTT_FORMAT_HEX_LINE_SIZE];
+    char str[32];
+    uint32_t cycle_start;
+    uint32_t cycle_hex_new;
+    uint32_t cycle_hex_old;
+    uint32_t cycle_float_new;
+    uint32_t cycle_float_old;
+    uint8_t pass = 1;
+    /* 正确性检验 */
+    for (uint8_t i = 0; i < sizeof(float_value) / sizeof(float_value[0]); i++)
+    {
+        rtt_format_float(str, float_value[i], 3);
+        pass &= (strcmp(str, float_expect[i]) == 0);
+    }
+    rtt_format_float(str, 2.5f, 0);
+    pass &= (strcmp(str, "3") == 0);
+    pass &= (rtt_format_hex_line(line, 0x10, hex_data, sizeof(hex_data)) == RTT_FORMAT_HEX_LINE_SIZE);
+    pass &= (memcmp(line, hex_expect, RTT_FORMAT_HEX_LINE_SIZE) == 0);
+    /* 十六进制转储耗时 */
+    for (uint8_t i = 0; i < RTT_FORMAT_BENCHMARK_BYTES; i++)
+    {
+        data[i] = i * 7;
+    }
+    cycle_start = dwt_get_cycle();
+    rtt_str_to_hex(data, RTT_FORMAT_BENCHMARK_BYTES);
+    cycle_hex_new = dwt_get_cycle() - cycle_start;
+    cycle_start = dwt_get_cycle();
+    rtt_format_benchmark_hex_reference(data, RTT_FORMAT_BENCHMARK_BYTES);
+    cycle_hex_old = dwt_get_cycle() - cycle_start;
+    /* 浮点数格式化耗时 */
+    taskENTER_CRITICAL();
+    cycle_start = dwt_get_cycle();
+    for (uint16_t i = 0; i < RTT_FORMAT_BENCHMARK_ROUNDS; i++)
+    {
+        rtt_format_float(str, float_value[i & 0x07], 3);
+    }
+    cycle_float_new = dwt_get_cycle() - cycle_start;
+    cycle_start = dwt_get_cycle();
+    for (uint16_t i = 0; i < RTT_FORMAT_BENCHMARK_ROUNDS; i++)
+    {
+        rtt_format_benchmark_float_reference(str, float_value[i & 0x07]);
+    }
+    cycle_float_old = dwt_get_cycle() - cycle_start;
+    taskEXIT_CRITICAL();
+    LOGINFO("[rtt_format]%s: hex dump [%d] bytes [%d] cycles, old [%d] cycles; float [%d] cycles, old [%d] cycles.\r\n",
+            pass ? "pass" : "FAIL",
+            RTT_FORMAT_BENCHMARK_BYTES,
+            cycle_hex_new,
+            cycle_hex_old,
+            cycle_float_new / RTT_FORMAT_BENCHMARK_ROUNDS,
+            cycle_float_old / RTT_FORMAT_BENCHMARK_ROUNDS);
+}
+#endif //__RTT_FORMAT_BENCHMARK
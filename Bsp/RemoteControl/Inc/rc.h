@@ -2,7 +2,7 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-20 12:22:31
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-20 18:16:02
+ * @LastEditTime: 2025-02-11 11:36:12
  * @Description: rc.h
  *
  * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
@@ -12,19 +12,22 @@
 #include "stdint.h"
 #include "uart.h"
 #include "daemon.h"
+#include "sbus.h"
+#include "snapshot.h"
 /* 遥控器通道解码图 */
 /**
  * 云卓T10的SBUS接收数据:
  *                     一帧SBUS协议共25字节,SBUS[0]表示帧头
  *                     SBUS[1] ~ SBUS[22]共22字节,对应16个通道,每个通道11bit
- *                     SBUS[23]表示遥控器的通讯状态:在线或离线
+ *                     SBUS[23]为标志字节:数字通道17/18、丢帧与失控保护,SBUS[24]表示帧尾
  * SBUS协议的数据值与通道的对应关系:
- *                               ch_1 = sbus[2]的低3bit + sbus[1]的高8bit(只有8bit)
+ *                               ch_1 = sbus[2]的低3bit + sbus[1]的8bit
  *                               ch_2 = sbus[3]的低6bit + sbus[2]的高5bit
  *                               ch_3 = sbus[5]的低1bit + sbus[4]的8bit + sbus[3]的高2bit
  *                               ch_4 = sbus[6]的低4bit + sbus[5]的高7bit
  *                               ch_5 = sbus[7]的低7bit + sbus[6]的高4bit
  *                               .................
+ *                               解码见sbus.c
  *
  *
  *           | |                                                                          | |
@@ -78,22 +81,24 @@ typedef struct
 {
     /* data */
     uint8_t enable_flag;                         /* 遥控器使能标志:0失能,1使能 */
-    uint8_t state_flag;                          /* 遥控器状态标志:在线或离线,0离线,1在线 */
-    uint16_t CH_1;                               /* 通道1 */
-    uint16_t CH_2;                               /* 通道2 */
-    uint16_t CH_3;                               /* 通道3 */
-    uint16_t CH_4;                               /* 通道4 */
-    uint16_t CH_5;                               /* 通道5 */
-    uint16_t CH_6;                               /* 通道6 */
-    uint16_t CH_7;                               /* 通道7 */
-    uint16_t CH_8;                               /* 通道8 */
-    uint16_t CH_9;                               /* 通道9 */
-    uint16_t CH_10;                              /* 通道10 */
+    uint8_t state_flag;                          /* 遥控器状态标志:在线或离线,0离线(失控保护),1在线 */
+    SBUS_FrameDef sbus;                          /* 最近一帧的解码结果:16个通道、数字通道与标志位,CH1对应channel[0];只由解码任务访问 */
+    Snapshot_InstanceHandle rc_snapshot;         /* 解码结果的快照:其他任务通过snapshot_read读取完整的SBUS_FrameDef与时间戳 */
+    SBUS_AssemblerDef assembler;                 /* 数据帧拼接:环形接收的切片拼成完整的数据帧;只由解码任务访问 */
+    /* 统计信息 */
+    uint32_t frame_count;                        /* 解码成功的数据帧数 */
+    uint32_t error_count;                        /* 格式错误被拒绝的数据帧数 */
+    uint32_t frame_lost_count;                   /* 接收机报告丢帧的次数 */
+    uint32_t failsafe_count;                     /* 接收机报告失控保护的次数 */
     UART_InstanceHandle rc_uart_instance_handle; /* 对应的串口实例 */
     Daemon_InstanceHandle rc_daemon_instance;    /* 对应的守护对象实例 */
     /* 应创建一个BEEP对象:当遥控器离线的时候产生蜂鸣声 */
 } RemoteCR_InstanceDef;
 typedef RemoteCR_InstanceDef *RemoteCR_InstanceHandle;
-#define REMOTECR_PROTOCOL_FRAME_SIZE 25 /* 遵循SBUS协议:一帧数据25字节;是否需要将缓冲区放大一点 */
+#define REMOTECR_PROTOCOL_FRAME_SIZE SBUS_FRAME_SIZE /* 遵循SBUS协议:一帧数据25字节;是否需要将缓冲区放大一点 */
+#define REMOTECR_RING_BUFFER_SIZE SBUS_RING_BUFFER_SIZE             /* 串口环形缓冲区大小:两帧,切片不要求落在帧边界 */
+#define REMOTECR_INSTANCE_POOL_SIZE 1 /* 遥控器实例对象池容量:最多支持一个遥控器实例 */
+/* 遥控器测试宏定义:每解码一帧打印CH1 ~ CH10,约70次/秒,默认关闭,避免占满日志缓冲区 */
+// #define __RC_CHANNEL_PRINT_TEST
 RemoteCR_InstanceHandle Y_rc_create_instance(void);
 #endif //!__RC__H__
@@ -0,0 +1,82 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-24 10:16:08
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-11 09:42:16
+ * @Description: sbus.h SBUS协议帧解码
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __SBUS__H__
+#define __SBUS__H__
+#include "stdint.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/* 该文件不依赖HAL与FreeRTOS,上位机可以直接复用 */
+/* SBUS协议帧格式 */
+/**
+   | 数据      | 偏移位置 | 字节大小 | 内容                                                  |
+   | --------- | -------- | -------- | ----------------------------------------------------- |
+   | header    | 0        | 1        | 帧头,固定值为0x0F                                    |
+   | channel   | 1        | 22       | 16个通道,每个通道11bit,低位在前依次排列               |
+   | flags     | 23       | 1        | bit0:数字通道17;bit1:数字通道18;bit2:丢帧;bit3:失控保护 |
+   | footer    | 24       | 1        | 帧尾:SBUS为0x00;SBUS2为0x04/0x14/0x24/0x34            |
+*/
+#define SBUS_FRAME_SIZE 25
+#define SBUS_RING_BUFFER_SIZE (SBUS_FRAME_SIZE * 2) /* 串口环形接收缓冲区大小:两帧;DMA可能从帧中间开始写入,切片由sbus_assembler重新拼成完整的数据帧 */
+#define SBUS_CHANNEL_NUM 16
+#define SBUS_CHANNEL_BITS 11
+#define SBUS_CHANNEL_MASK 0x07FF
+#define SBUS_HEADER 0x0F
+#define SBUS_FOOTER 0x00
+#define SBUS2_FOOTER_MASK 0x0F /* SBUS2帧尾的低4位固定为0x04,高4位为遥测时隙编号 */
+#define SBUS2_FOOTER 0x04
+#define SBUS_FLAG_CH17 0x01       /* 数字通道17 */
+#define SBUS_FLAG_CH18 0x02       /* 数字通道18 */
+#define SBUS_FLAG_FRAME_LOST 0x04 /* 接收机丢帧:该帧沿用上一帧的通道值 */
+#define SBUS_FLAG_FAILSAFE 0x08   /* 失控保护:接收机与遥控器断开 */
+#define SBUS_FLAG_RESERVED 0xF0   /* 保留位,必须为0 */
+/* SBUS测试宏定义:与逐通道手写移位的旧解码比较耗时 */
+// #define __SBUS_BENCHMARK
+#define SBUS_BENCHMARK_ROUNDS 1000 /* 解码次数 */
+
+typedef struct
+{
+    /* data */
+    uint16_t channel[SBUS_CHANNEL_NUM]; /* 16个比例通道,取值0 ~ 2047 */
+    uint8_t ch17;                       /* 数字通道17:0或1 */
+    uint8_t ch18;                       /* 数字通道18:0或1 */
+    uint8_t frame_lost;                 /* 接收机丢帧标志 */
+    uint8_t failsafe;                   /* 失控保护标志 */
+} SBUS_FrameDef;
+typedef SBUS_FrameDef *SBUS_FrameHandle;
+
+typedef void (*sbus_frame_callback)(uint8_t *frame, uint16_t frame_length); /* 拼出一帧完整的数据帧后调用 */
+
+/* SBUS数据帧拼接:环形接收模式下一帧可能被半传输/传输完成事件切成多段,按字节重新拼成25字节的数据帧 */
+/* 只在线路空闲(IDLE)之后或上一帧帧尾正确之后接受帧头0x0F,从帧中间开始接收或串口出错重启后,等到下一次空闲再同步 */
+typedef struct
+{
+    /* data */
+    uint8_t frame[SBUS_FRAME_SIZE]; /* 正在拼接的数据帧 */
+    uint8_t length;                 /* 已拼接的字节数 */
+    uint8_t sync;                   /* 1:下一个字节应为帧头;0:失步,丢弃数据直到线路空闲 */
+    uint32_t skip_bytes;            /* 失步期间丢弃的字节数 */
+    uint32_t break_count;           /* 数据帧未拼完就遇到线路空闲的次数 */
+    sbus_frame_callback callback;   /* 数据帧回调函数 */
+} SBUS_AssemblerDef;
+typedef SBUS_AssemblerDef *SBUS_AssemblerHandle;
+
+uint8_t sbus_decode(const uint8_t *frame, uint16_t frame_length, SBUS_FrameHandle sbus);
+void sbus_assembler_init(SBUS_AssemblerHandle assembler, sbus_frame_callback callback);
+void sbus_assembler_feed(SBUS_AssemblerHandle assembler, const uint8_t *data, uint16_t length);
+#ifdef __SBUS_BENCHMARK
+void sbus_benchmark(void);
+#endif //__SBUS_BENCHMARK
+
+#ifdef __cplusplus
+}
+#endif
+#endif //!__SBUS__H__
@@ -2,7 +2,7 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-20 12:22:17
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-20 18:17:25
+ * @LastEditTime: 2025-02-11 11:36:12
  * @Description: rc.c
  *               使用的遥控器是云卓T10,接收器协议是SBUS
  *               STM32配置如下:
@@ -16,61 +16,82 @@
  *
  * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
  */
+#define LOG_MODULE RC /* 日志模块,必须在包含头文件之前定义,见rtt.h */
 #include "FreeRTOS.h"
 #include "task.h"
-#include "portable.h"
 #include "rc.h"
+#include "pool.h"
 #include "stdlib.h"
+#include "string.h"
 #include "rtt.h"
 #include "usart.h"
 static uint8_t REMOTERC_INSTANCE_COUNT = 0; /* 用于对遥控器实例进行计数,最多支持一个遥控器实例 */
+POOL_DEFINE(remote_rc_instance_pool, RemoteCR_InstanceDef, REMOTECR_INSTANCE_POOL_SIZE); /* 遥控器实例对象池 */
 extern RemoteCR_InstanceHandle remote_control_instance_handle;
 /**
  * @description: 解码通道值
  * @param {uint8_t} *frame
- * @return {*}
+ * @param {uint16_t} frame_length
+ * @return {*} 1:解码成功;0:数据帧格式错误,保留上一帧的通道值
  */
-static void channel_decode(uint8_t *frame)
+static uint8_t channel_decode(uint8_t *frame, uint16_t frame_length)
 {
-    /* 帧大小要求25字节 */
     /* 该函数被调用的时候不会发生空指针的情况,遥控器实例内存在串口创建前被分配 */
-    /* 安全的操作 */
-    /* 获取通道值 */
-    remote_control_instance_handle->CH_1 = ((int16_t)frame[1] >> 0 | ((int16_t)frame[2] << 8)) & 0x07FF;
-    remote_control_instance_handle->CH_2 = ((int16_t)frame[2] >> 3 | ((int16_t)frame[3] << 5)) & 0x07FF;
-    remote_control_instance_handle->CH_3 = ((int16_t)frame[3] >> 6 | ((int16_t)frame[4] << 2) | (int16_t)frame[5] << 10) & 0x07FF;
-    remote_control_instance_handle->CH_4 = ((int16_t)frame[5] >> 1 | ((int16_t)frame[6] << 7)) & 0x07FF;
-    remote_control_instance_handle->CH_5 = ((int16_t)frame[6] >> 4 | ((int16_t)frame[7] << 4)) & 0x07FF;
-    remote_control_instance_handle->CH_6 = ((int16_t)frame[7] >> 7 | ((int16_t)frame[8] << 1) | (int16_t)frame[9] << 9) & 0x07FF;
-    remote_control_instance_handle->CH_7 = ((int16_t)frame[9] >> 2 | ((int16_t)frame[10] << 6)) & 0x07FF;
-    remote_control_instance_handle->CH_8 = ((int16_t)frame[10] >> 5 | ((int16_t)frame[11] << 3)) & 0x07FF;
-    remote_control_instance_handle->CH_9 = ((int16_t)frame[12] << 0 | ((int16_t)frame[13] << 8)) & 0x07FF;
-    remote_control_instance_handle->CH_10 = ((int16_t)frame[13] >> 3 | ((int16_t)frame[14] << 5)) & 0x07FF;
-    /* 获取遥控器状态 */
-    remote_control_instance_handle->state_flag = frame[23];
+    RemoteCR_InstanceHandle h_remote = remote_control_instance_handle;
+    /* 帧大小要求25字节,帧头、帧尾与保留位必须正确 */
+    if (!sbus_decode(frame, frame_length, &h_remote->sbus))
+    {
+        h_remote->error_count++;
+        return 0;
+    }
+    h_remote->frame_count++;
+    h_remote->frame_lost_count += h_remote->sbus.frame_lost;
+    h_remote->failsafe_count += h_remote->sbus.failsafe;
+    /* 获取遥控器状态:失控保护即视为离线 */
+    h_remote->state_flag = !h_remote->sbus.failsafe;
+    /* 收到正确的数据帧,推迟离线检测 */
+    daemon_feed(h_remote->rc_daemon_instance);
+    /* 发布快照,底盘任务读取时不会读到写了一半的通道值 */
+    snapshot_publish(h_remote->rc_snapshot, &h_remote->sbus);
+    return 1;
 }
 /**
- * @description: 遥控器解码回调函数
- * @param {uint8_t} *rx_buffer
+ * @description: 数据帧回调函数,拼出一帧完整的SBUS数据帧后调用
+ * @param {uint8_t} *frame
  * @param {uint16_t} frame_length
  * @return {*}
  */
-static void remote_control_sbus_decode_callback(uint8_t *rx_buffer, uint16_t frame_length)
+static void remote_control_sbus_frame_callback(uint8_t *frame, uint16_t frame_length)
 {
     /* 解码通道值 */
-    channel_decode(rx_buffer);
+    if (!channel_decode(frame, frame_length))
+    {
+        return;
+    }
+#ifdef __RC_CHANNEL_PRINT_TEST
     /* 打印通道值:测试 */
     LOGINFO("CH1:[%d]---CH2:[%d]---CH3:[%d]---CH4:[%d]---CH5:[%d]---CH6:[%d]---CH7:[%d]---CH8:[%d]---CH9:[%d]---CH10:[%d]\r\n",
-            remote_control_instance_handle->CH_1, 
-            remote_control_instance_handle->CH_2, 
-            remote_control_instance_handle->CH_3, 
-            remote_control_instance_handle->CH_4,
-            remote_control_instance_handle->CH_5, 
-            remote_control_instance_handle->CH_6, 
-            remote_control_instance_handle->CH_7, 
-            remote_control_instance_handle->CH_8, 
-            remote_control_instance_handle->CH_9, 
-            remote_control_instance_handle->CH_10);
+            remote_control_instance_handle->sbus.channel[0],
+            remote_control_instance_handle->sbus.channel[1],
+            remote_control_instance_handle->sbus.channel[2],
+            remote_control_instance_handle->sbus.channel[3],
+            remote_control_instance_handle->sbus.channel[4],
+            remote_control_instance_handle->sbus.channel[5],
+            remote_control_instance_handle->sbus.channel[6],
+            remote_control_instance_handle->sbus.channel[7],
+            remote_control_instance_handle->sbus.channel[8],
+            remote_control_instance_handle->sbus.channel[9]);
+#endif //__RC_CHANNEL_PRINT_TEST
+}
+/**
+ * @description: 遥控器解码回调函数,环形接收模式下收到的是切片,不一定是完整的数据帧
+ * @param {uint8_t} *rx_buffer
+ * @param {uint16_t} length 切片长度,0表示线路空闲
+ * @return {*}
+ */
+static void remote_control_sbus_decode_callback(uint8_t *rx_buffer, uint16_t length)
+{
+    sbus_assembler_feed(&remote_control_instance_handle->assembler, rx_buffer, length);
 }
 /**
  * @description: 遥控器离线回调函数
@@ -83,22 +104,18 @@ static void remote_control_lost_callback(void *daemon_instance_handle)
     Daemon_InstanceHandle h_daemon = (Daemon_InstanceHandle)daemon_instance_handle;
     /* 拿取对应的遥控器实例句柄 */
     RemoteCR_InstanceHandle h_remote = (RemoteCR_InstanceHandle)(h_daemon->owner_instance_handle);
-    /* 先执行喂狗操作 */
-    h_daemon->count = h_daemon->reload_count; /* 重新从重载值向下计数 */
     /* 遥控器失能,直接返回就好 */
     if (h_remote->enable_flag == 0)
     {
         return;
     }
-    /* 遥控器实例使能状态,离线 */
-    if (h_remote->state_flag == 0)
-    {
-        /* 蜂鸣器操作 */
-        //......发声三次
-        /* 离线操作 */
-        //......清空接收区数据/重启串口服务/打印LOG
-        // LOGWARNING("[daemon_remote]RemoteControl Lost Service.\r\n");
-    }
+    /* 超过DAEMON_TIMEOUT_RC_MS没有收到正确的数据帧,离线 */
+    h_remote->state_flag = 0;
+    /* 蜂鸣器操作 */
+    //......发声三次
+    /* 离线操作 */
+    //......清空接收区数据/重启串口服务/打印LOG
+    // LOGWARNING("[daemon_remote]RemoteControl Lost Service.\r\n");
     return;
 }
 /**
@@ -115,20 +132,33 @@ RemoteCR_InstanceHandle Y_rc_create_instance(void)
             LOGERROR("[remoterc_create]RemoteControl Instance Already Created!");
         }
     }
-    /* 进入临界区进行创建操作:注意,由于是在临界区中创建,因此需要确保串口的编号正确,否则会使系统卡死 */
-    taskENTER_CRITICAL();
-    RemoteCR_InstanceHandle remote_rc_instance_handle = (RemoteCR_InstanceHandle)pvPortMalloc(sizeof(RemoteCR_InstanceDef));
+    /* 从对象池中申请遥控器实例,常数时间,不使用FreeRTOS堆 */
+    /* 快照、串口与守护实例各自保证创建过程线程安全,不在临界区中创建:串口实例需要创建解析任务 */
+    RemoteCR_InstanceHandle remote_rc_instance_handle = (RemoteCR_InstanceHandle)pool_alloc(&remote_rc_instance_pool);
     if (remote_rc_instance_handle == NULL)
     {
-        LOGERROR("[remoterc_create]RemoteControl Instance Create Failed,Stack Overflow!\r\n");
-        /* 退出临界区 */
-        taskEXIT_CRITICAL();
+        LOGERROR("[remoterc_create]RemoteControl Instance Pool Is Full!\r\n");
         return NULL;
     }
+    memset(remote_rc_instance_handle, 0, sizeof(RemoteCR_InstanceDef));
     remote_rc_instance_handle->enable_flag = 0; /* 初始为失能 */
     remote_rc_instance_handle->state_flag = 0;  /* 初始为离线 */
+    remote_rc_instance_handle->rc_snapshot = Y_snapshot_create_instance(sizeof(SBUS_FrameDef));
+    /* 快照创建失败时解码任务发布快照会访问空指针,与其他创建错误一样停在这里 */
+    if (remote_rc_instance_handle->rc_snapshot == NULL)
+    {
+        while (1)
+        {
+            LOGERROR("[remoterc_create]RemoteControl Snapshot Create Failed!");
+        }
+    }
+    /* 数据帧拼接在串口创建前初始化:串口创建后可能立即收到数据 */
+    sbus_assembler_init(&remote_rc_instance_handle->assembler, remote_control_sbus_frame_callback);
+    /* 使用环形模式:DMA可能从帧中间开始写入(上电时接收机已经在发送、串口出错后从缓冲区起点重启), */
+    /* 切片与帧边界无关,由数据帧拼接在线路空闲后按帧头重新同步 */
     remote_rc_instance_handle->rc_uart_instance_handle = Y_uart_create_instance(IDX_OF_UART_DEVICE_5,
-                                                                                REMOTECR_PROTOCOL_FRAME_SIZE,
+                                                                                REMOTECR_RING_BUFFER_SIZE,
+                                                                                UART_RECV_MODE_RING,
                                                                                 &huart5, /* 使用串口5 */
                                                                                 remote_control_sbus_decode_callback);
 
@@ -136,9 +166,13 @@ RemoteCR_InstanceHandle Y_rc_create_instance(void)
     remote_rc_instance_handle->rc_daemon_instance = Y_daemon_create_instance((void *)remote_rc_instance_handle,
                                                                              DAEMON_OWNER_TYPE_RC,
                                                                              0,
-                                                                             DAEMON_RELOD_RC,
+                                                                             DAEMON_PERIOD_RC_MS,
+                                                                             DAEMON_TIMEOUT_RC_MS,
                                                                              remote_control_lost_callback);
 
+    /* 进入临界区,记录实例数量 */
+    taskENTER_CRITICAL();
+    REMOTERC_INSTANCE_COUNT++;
     /* 退出临界区 */
     taskEXIT_CRITICAL();
 
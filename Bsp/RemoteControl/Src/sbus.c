@@ -0,0 +1,197 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-24 10:16:31
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-11 09:42:16
+ * @Description: sbus.c SBUS协议帧解码
+ *               16个11bit通道按查找表给出的字节偏移与位偏移逐个读取32位字后移位截取,
+ *               每个通道最多跨越3个字节,一次32位读取即可覆盖,不需要逐通道手写移位表达式
+ *               环形接收模式下的切片由sbus_assembler_feed拼成完整的数据帧,线路空闲作为帧间隔重新同步
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#define LOG_MODULE RC /* 日志模块,必须在包含头文件之前定义,见rtt.h */
+#include "sbus.h"
+#include "string.h"
+#ifdef __SBUS_BENCHMARK
+#include "FreeRTOS.h"
+#include "task.h"
+#include "dwt.h"
+#include "rtt.h"
+#endif //__SBUS_BENCHMARK
+/* 第i个通道起始于第11 * i个bit:字节偏移为1 + 11 * i / 8,位偏移为11 * i % 8 */
+static const uint8_t sbus_channel_byte[SBUS_CHANNEL_NUM] = {1, 2, 3, 5, 6, 7, 9, 10, 12, 13, 14, 16, 17, 18, 20, 21};
+static const uint8_t sbus_channel_shift[SBUS_CHANNEL_NUM] = {0, 3, 6, 1, 4, 7, 2, 5, 0, 3, 6, 1, 4, 7, 2, 5};
+/* 帧尾:SBUS为0x00,SBUS2的低4位为0x04 */
+#define SBUS_FOOTER_VALID(footer) (((footer) == SBUS_FOOTER) || (((footer) & SBUS2_FOOTER_MASK) == SBUS2_FOOTER))
+/**
+ * @description: 解码一帧SBUS数据,帧头、帧尾与保留位不正确的数据帧被拒绝
+ * @param {uint8_t} *frame SBUS数据帧
+ * @param {uint16_t} frame_length 数据帧字节数,必须为SBUS_FRAME_SIZE
+ * @param {SBUS_FrameHandle} sbus 解码结果,数据帧被拒绝时不修改
+ * @return {*} 1:解码成功;0:数据帧格式错误
+ */
+uint8_t sbus_decode(const uint8_t *frame, uint16_t frame_length, SBUS_FrameHandle sbus)
+{
+    uint32_t word;
+    uint8_t flags;
+    if ((frame == NULL) || (frame_length != SBUS_FRAME_SIZE) || (frame[0] != SBUS_HEADER))
+    {
+        return 0;
+    }
+    flags = frame[23];
+    if (!SBUS_FOOTER_VALID(frame[24]) || (flags & SBUS_FLAG_RESERVED))
+    {
+        return 0;
+    }
+    for (uint8_t i = 0; i < SBUS_CHANNEL_NUM; i++)
+    {
+        /* 小端平台:32位读取后第一个字节位于低8位,最后一个通道读取到帧尾为止,不会越界 */
+        memcpy(&word, frame + sbus_channel_byte[i], sizeof(word));
+        sbus->channel[i] = (word >> sbus_channel_shift[i]) & SBUS_CHANNEL_MASK;
+    }
+    sbus->ch17 = (flags & SBUS_FLAG_CH17) ? 1 : 0;
+    sbus->ch18 = (flags & SBUS_FLAG_CH18) ? 1 : 0;
+    sbus->frame_lost = (flags & SBUS_FLAG_FRAME_LOST) ? 1 : 0;
+    sbus->failsafe = (flags & SBUS_FLAG_FAILSAFE) ? 1 : 0;
+    return 1;
+}
+/**
+ * @description: 初始化数据帧拼接,初始为失步:上电时接收机可能已经在发送,DMA从帧中间开始写入
+ * @param {SBUS_AssemblerHandle} assembler
+ * @param {sbus_frame_callback} callback 数据帧回调函数
+ * @return {*}
+ */
+void sbus_assembler_init(SBUS_AssemblerHandle assembler, sbus_frame_callback callback)
+{
+    memset(assembler, 0, sizeof(SBUS_AssemblerDef));
+    assembler->callback = callback;
+}
+/**
+ * @description: 送入一段接收数据,每拼出25字节就调用一次回调函数,格式检查由sbus_decode完成
+ *               SBUS帧与帧之间有数毫秒的空闲,帧内字节连续:空闲之后的第一个字节就是帧头,
+ *               帧尾正确时下一个字节也是帧头;其余情况下数据帧中的0x0F不能作为帧头,丢弃数据直到线路空闲
+ * @param {SBUS_AssemblerHandle} assembler
+ * @param {uint8_t} *data 接收数据
+ * @param {uint16_t} length 数据长度,0表示线路空闲(串口IDLE事件)
+ * @return {*}
+ */
+void sbus_assembler_feed(SBUS_AssemblerHandle assembler, const uint8_t *data, uint16_t length)
+{
+    uint16_t copy;
+    if (length == 0)
+    {
+        /* 线路空闲:未拼完的数据帧已经不完整,丢弃后重新同步 */
+        assembler->break_count += (assembler->length != 0);
+        assembler->length = 0;
+        assembler->sync = 1;
+        return;
+    }
+    while (length > 0)
+    {
+        if (assembler->length == 0)
+        {
+            if (!assembler->sync || (*data != SBUS_HEADER))
+            {
+                assembler->sync = 0;
+                assembler->skip_bytes++;
+                data++;
+                length--;
+                continue;
+            }
+        }
+        copy = SBUS_FRAME_SIZE - assembler->length;
+        copy = (copy > length) ? length : copy;
+        memcpy(assembler->frame + assembler->length, data, copy);
+        assembler->length += copy;
+        data += copy;
+        length -= copy;
+        if (assembler->length == SBUS_FRAME_SIZE)
+        {
+            assembler->length = 0;
+            /* 帧尾不正确说明同步位置是错的,后续数据需要等到线路空闲 */
+            assembler->sync = SBUS_FOOTER_VALID(assembler->frame[SBUS_FRAME_SIZE - 1]);
+            assembler->callback(assembler->frame, SBUS_FRAME_SIZE);
+        }
+    }
+}
+#ifdef __SBUS_BENCHMARK
+/**
+ * @description: 旧的解码方式:逐通道手写移位表达式,只解码前10个通道,作为测试的参照
+ * @param {uint8_t} *frame SBUS数据帧
+ * @param {uint16_t} *channel 通道值
+ * @return {*}
+ */
+static void sbus_benchmark_reference(const uint8_t *frame, uint16_t *channel)
+{
+    channel[0] = ((int16_t)frame[1] >> 0 | ((int16_t)frame[2] << 8)) & 0x07FF;
+    channel[1] = ((int16_t)frame[2] >> 3 | ((int16_t)frame[3] << 5)) & 0x07FF;
+    channel[2] = ((int16_t)frame[3] >> 6 | ((int16_t)frame[4] << 2) | (int16_t)frame[5] << 10) & 0x07FF;
+    channel[3] = ((int16_t)frame[5] >> 1 | ((int16_t)frame[6] << 7)) & 0x07FF;
+    channel[4] = ((int16_t)frame[6] >> 4 | ((int16_t)frame[7] << 4)) & 0x07FF;
+    channel[5] = ((int16_t)frame[7] >> 7 | ((int16_t)frame[8] << 1) | (int16_t)frame[9] << 9) & 0x07FF;
+    channel[6] = ((int16_t)frame[9] >> 2 | ((int16_t)frame[10] << 6)) & 0x07FF;
+    channel[7] = ((int16_t)frame[10] >> 5 | ((int16_t)frame[11] << 3)) & 0x07FF;
+    channel[8] = ((int16_t)frame[12] << 0 | ((int16_t)frame[13] << 8)) & 0x07FF;
+    channel[9] = ((int16_t)frame[13] >> 3 | ((int16_t)frame[14] << 5)) & 0x07FF;
+}
+/**
+ * @description: SBUS解码测试:用逐bit打包的随机通道值生成数据帧,检验16个通道与标志位,
+ *               并与旧解码方式比较前10个通道的结果与耗时
+ * @return {*}
+ */
+void sbus_benchmark(void)
+{
+    uint8_t frame[SBUS_FRAME_SIZE];
+    uint16_t expect[SBUS_CHANNEL_NUM];
+    uint16_t reference[10];
+    SBUS_FrameDef sbus;
+    uint32_t seed = 0x1234567;
+    uint32_t cycle_start;
+    uint32_t cycle_new;
+    uint32_t cycle_old;
+    uint16_t bit;
+    uint8_t pass = 1;
+    /* 逐bit打包,与查找表无关 */
+    memset(frame, 0, sizeof(frame));
+    frame[0] = SBUS_HEADER;
+    for (uint8_t i = 0; i < SBUS_CHANNEL_NUM; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        expect[i] = (seed >> 16) & SBUS_CHANNEL_MASK;
+        for (uint8_t j = 0; j < SBUS_CHANNEL_BITS; j++)
+        {
+            bit = i * SBUS_CHANNEL_BITS + j;
+            frame[1 + bit / 8] |= ((expect[i] >> j) & 0x01) << (bit % 8);
+        }
+    }
+    frame[23] = SBUS_FLAG_CH18 | SBUS_FLAG_FRAME_LOST;
+    taskENTER_CRITICAL();
+    cycle_start = dwt_get_cycle();
+    for (uint16_t i = 0; i < SBUS_BENCHMARK_ROUNDS; i++)
+    {
+        pass &= sbus_decode(frame, SBUS_FRAME_SIZE, &sbus);
+    }
+    cycle_new = dwt_get_cycle() - cycle_start;
+    cycle_start = dwt_get_cycle();
+    for (uint16_t i = 0; i < SBUS_BENCHMARK_ROUNDS; i++)
+    {
+        sbus_benchmark_reference(frame, reference);
+    }
+    cycle_old = dwt_get_cycle() - cycle_start;
+    taskEXIT_CRITICAL();
+    for (uint8_t i = 0; i < SBUS_CHANNEL_NUM; i++)
+    {
+        pass &= (sbus.channel[i] == expect[i]);
+        pass &= (i >= 10) || (reference[i] == expect[i]);
+    }
+    pass &= (sbus.ch17 == 0) && (sbus.ch18 == 1) && (sbus.frame_lost == 1) && (sbus.failsafe == 0);
+    /* 格式错误的数据帧必须被拒绝 */
+    frame[24] = 0xFF;
+    pass &= !sbus_decode(frame, SBUS_FRAME_SIZE, &sbus);
+    LOGINFO("[sbus]%s: 16 channels [%d] cycles/frame, old 10 channels [%d] cycles/frame.\r\n",
+            pass ? "pass" : "FAIL",
+            cycle_new / SBUS_BENCHMARK_ROUNDS,
+            cycle_old / SBUS_BENCHMARK_ROUNDS);
+}
+#endif //__SBUS_BENCHMARK
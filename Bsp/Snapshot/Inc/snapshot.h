@@ -0,0 +1,47 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-26 09:41:18
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-11 10:48:55
+ * @Description: snapshot.h 最新值快照(顺序锁)
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __SNAPSHOT__H__
+#define __SNAPSHOT__H__
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stdint.h"
+#include "pool.h"
+#include "sbus.h"
+/* 快照的使用方式 */
+/**
+ * 一个发布者(中断或高优先级任务)不断发布最新值,任意个读者随时读取一份完整的副本
+ * 发布:序号加1(奇数,正在写入) -> 写入数据与DWT时间戳 -> 序号加1(偶数,写入完成),不等待、不关中断
+ * 读取:读序号 -> 拷贝数据 -> 再读序号,两次序号相同且为偶数则副本完整,否则重试
+ * 发布者优先级高于读者时,读者只会被完整的发布过程打断,重试次数由发布频率决定,最多重试SNAPSHOT_READ_RETRY_MAX次
+ */
+#define SNAPSHOT_READ_RETRY_MAX 4 /* 读取的最大重试次数,超过后读取失败,保证读取时间有上限 */
+/* 对象池配置宏:快照实例从静态对象池中申请,数据区按实例的实际大小从静态区中切分 */
+#define SNAPSHOT_POOL_SIZE 1 /* 快照实例数量:遥控器解码结果 */
+#define SNAPSHOT_DATA_ARENA_SIZE POOL_ARENA_ALIGN(sizeof(SBUS_FrameDef)) /* 数据区静态区:遥控器的SBUS_FrameDef,与pool_arena_alloc相同按4字节对齐 */
+
+typedef struct
+{
+    /* data */
+    volatile uint32_t sequence; /* 序号:奇数表示正在写入 */
+    uint32_t timestamp;         /* 发布时的DWT节拍数 */
+    uint16_t size;              /* 数据字节数 */
+    uint8_t *data;              /* 数据区 */
+    /* 统计信息 */
+    uint32_t publish_count; /* 发布次数 */
+    uint32_t retry_count;   /* 读取重试次数 */
+    uint32_t fail_count;    /* 超过最大重试次数而读取失败的次数 */
+} Snapshot_InstanceDef;
+typedef Snapshot_InstanceDef *Snapshot_InstanceHandle;
+
+Snapshot_InstanceHandle Y_snapshot_create_instance(uint16_t size);
+void snapshot_publish(Snapshot_InstanceHandle snapshot, const void *data);
+uint8_t snapshot_read(Snapshot_InstanceHandle snapshot, void *data, uint32_t *timestamp);
+uint32_t snapshot_age_us(uint32_t timestamp);
+#endif //!__SNAPSHOT__H__
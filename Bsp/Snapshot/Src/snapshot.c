@@ -0,0 +1,115 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-26 09:41:40
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-09 16:40:27
+ * @Description: snapshot.c 最新值快照(顺序锁)
+ *               发布者不等待,读者在有限次重试内得到一份完整的副本,副本带有发布时的DWT时间戳
+ *               单核下DMB同时作为编译器屏障,保证序号与数据的读写顺序
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include "snapshot.h"
+#include "string.h"
+#include "rtt.h"
+#include "dwt.h"
+POOL_DEFINE(snapshot_instance_pool, Snapshot_InstanceDef, SNAPSHOT_POOL_SIZE); /* 快照实例对象池 */
+POOL_ARENA_DEFINE(snapshot_data_arena, SNAPSHOT_DATA_ARENA_SIZE);               /* 数据区静态区 */
+/**
+ * @description: 创建快照实例
+ * @param {uint16_t} size 数据字节数
+ * @return {*}
+ */
+Snapshot_InstanceHandle Y_snapshot_create_instance(uint16_t size)
+{
+    /* 检测参数是否合法 */
+    if (size == 0)
+    {
+        while (1)
+        {
+            LOGERROR("[snapshot_create]Snapshot Size Error!");
+        }
+    }
+    /* 从对象池中申请实例,数据区从静态区中切分,都是常数时间,不使用FreeRTOS堆 */
+    Snapshot_InstanceHandle snapshot = (Snapshot_InstanceHandle)pool_alloc(&snapshot_instance_pool);
+    if (snapshot == NULL)
+    {
+        LOGERROR("[snapshot_create]Snapshot Instance Pool Is Full!\r\n");
+        return NULL;
+    }
+    memset(snapshot, 0, sizeof(Snapshot_InstanceDef));
+    snapshot->data = (uint8_t *)pool_arena_alloc(&snapshot_data_arena, size);
+    if (snapshot->data == NULL)
+    {
+        LOGERROR("[snapshot_create]Snapshot Data Arena Is Full!\r\n");
+        pool_free(&snapshot_instance_pool, snapshot);
+        return NULL;
+    }
+    memset(snapshot->data, 0, size);
+    snapshot->size = size;
+    return snapshot;
+}
+/**
+ * @description: 发布最新值,只允许一个发布者,可以在中断中调用
+ * @param {Snapshot_InstanceHandle} snapshot 快照句柄
+ * @param {void} *data 最新值,大小为创建时的size
+ * @return {*}
+ */
+void snapshot_publish(Snapshot_InstanceHandle snapshot, const void *data)
+{
+    snapshot->sequence++; /* 奇数:正在写入 */
+    __DMB();
+    snapshot->timestamp = dwt_get_cycle();
+    memcpy(snapshot->data, data, snapshot->size);
+    __DMB();
+    snapshot->sequence++; /* 偶数:写入完成 */
+    snapshot->publish_count++;
+}
+/**
+ * @description: 读取一份完整的副本,不能在中断中调用
+ * @param {Snapshot_InstanceHandle} snapshot 快照句柄
+ * @param {void} *data 副本,大小为创建时的size
+ * @param {uint32_t} *timestamp 副本发布时的DWT节拍数,可以为NULL
+ * @return {*} 1:读取成功;0:尚未发布过,或超过最大重试次数(发布者优先级低于读者时可能发生)
+ */
+uint8_t snapshot_read(Snapshot_InstanceHandle snapshot, void *data, uint32_t *timestamp)
+{
+    uint32_t sequence;
+    uint32_t stamp;
+    for (uint8_t retry = 0; retry <= SNAPSHOT_READ_RETRY_MAX; retry++)
+    {
+        sequence = snapshot->sequence;
+        if (sequence == 0)
+        {
+            /* 尚未发布过 */
+            return 0;
+        }
+        if ((sequence & 0x01) == 0)
+        {
+            __DMB();
+            stamp = snapshot->timestamp;
+            memcpy(data, snapshot->data, snapshot->size);
+            __DMB();
+            if (snapshot->sequence == sequence)
+            {
+                if (timestamp != NULL)
+                {
+                    *timestamp = stamp;
+                }
+                return 1;
+            }
+        }
+        snapshot->retry_count++;
+    }
+    snapshot->fail_count++;
+    return 0;
+}
+/**
+ * @description: 计算副本的年龄,要求年龄小于CYCCNT的溢出周期(168MHz下约25s)
+ * @param {uint32_t} timestamp 副本发布时的DWT节拍数
+ * @return {*} 年龄,单位us
+ */
+uint32_t snapshot_age_us(uint32_t timestamp)
+{
+    return dwt_cycle_to_us(dwt_get_cycle() - timestamp);
+}
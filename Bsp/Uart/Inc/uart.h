@@ -2,36 +2,111 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-12 21:34:06
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-20 13:20:39
+ * @LastEditTime: 2025-02-11 09:42:16
  * @Description: uart.h
  *
  * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
  */
 #ifndef __UART__H__
 #define __UART__H__
+#include "FreeRTOS.h" /* 这里并不需要FreeRTOS.h这个文件,但是task.h必须在FreeRTOS后面 */
+#include "task.h"
+#include "semphr.h"
 #include "stdint.h"
 #include "usart.h"
+#include "pool.h"
+#include "sbus.h"
 /* 创建串口实例结构体,把每个串口都当成一个实例对象,即一个串口设备对应一个串口对象 */
 /* 串口是独占的点对点通信,不存在多个设备同时占用一个串口的情况 */
-#define DEVICE_UART_NUM 3            /* 表示3个可用串口: */
-#define UART_RECEIVE_BUFFER_SIZE 256 /* 接受缓冲区的大小 */
-#define IDX_OF_UART_DEVICE_1 0       /* 串口0对应的编号:可以配置成vofa的串口 */
-#define IDX_OF_UART_DEVICE_3 1       /* 串口3对应的编号:用于和上位机通信 */
-#define IDX_OF_UART_DEVICE_5 2       /* 串口5对应的编号:用于SBUS接口,和遥控器通信 */
+#define DEVICE_UART_NUM 6            /* 表示6个可用串口:STM32F407的USART1/2/3/6和UART4/5 */
+#define UART_RECEIVE_BUFFER_SIZE 256 /* 接受缓冲区大小的上限 */
+/* 对象池配置宏:串口实例与发送队列从编译期确定容量的静态对象池中申请,接收缓冲区按实例的实际大小从静态区中切分 */
+#define UART_INSTANCE_POOL_SIZE 2                           /* 串口实例数量:上位机串口与SBUS串口 */
+#define UART_TX_QUEUE_POOL_SIZE 1                           /* 发送队列数量:只有上位机串口发送数据 */
+#define UART_RECV_ARENA_SIZE (POOL_ARENA_ALIGN(UART_RECEIVE_BUFFER_SIZE) + POOL_ARENA_ALIGN(SBUS_RING_BUFFER_SIZE)) /* 接收缓冲区静态区:上位机串口与SBUS串口,与pool_arena_alloc相同按4字节对齐 */
+#define IDX_OF_UART_DEVICE_1 0       /* 串口1对应的编号:可以配置成vofa的串口 */
+#define IDX_OF_UART_DEVICE_2 1       /* 串口2对应的编号:未使用 */
+#define IDX_OF_UART_DEVICE_3 2       /* 串口3对应的编号:用于和上位机通信 */
+#define IDX_OF_UART_DEVICE_4 3       /* 串口4对应的编号:未使用 */
+#define IDX_OF_UART_DEVICE_5 4       /* 串口5对应的编号:用于SBUS接口,和遥控器通信 */
+#define IDX_OF_UART_DEVICE_6 5       /* 串口6对应的编号:未使用 */
+/* 中断分发表:由串口外设基地址直接计算表下标,中断中查找串口实例的时间与已注册的串口数量无关 */
+/* USART2/3和UART4/5位于APB1(0x4000_4400 ~ 0x4000_5000),USART1/6位于APB2(0x4001_1000/0x4001_1400) */
+/* 地址的bit[12:10]区分同一总线上的串口,bit16区分APB1/APB2,组合成4bit下标,6个串口互不冲突 */
+#define UART_DISPATCH_TABLE_SIZE 16
+#define UART_DISPATCH_KEY(instance) (((((uint32_t)(instance)) >> 10) & 0x07) | ((((uint32_t)(instance)) >> 13) & 0x08))
+/* 中断分发测试宏定义:测量每个串口查找实例的节拍数 */
+// #define __UART_DISPATCH_BENCHMARK
+/* 串口接收模式 */
+#define UART_RECV_MODE_IDLE 0 /* 普通模式:DMA_NORMAL,每次IDLE事件后清空缓冲区并重新注册DMA接收 */
+#define UART_RECV_MODE_RING 1 /* 环形模式:DMA_CIRCULAR,只注册一次,由NDTR跟踪写指针,将环形缓冲区切片交给解析函数;IDLE事件时解析函数收到长度为0的切片 */
+/* 串口解析任务配置宏:中断只负责投递数据描述符,解析函数在每个串口独立的解析任务中执行 */
+#define UART_DECODE_TASK_STACK (configMINIMAL_STACK_SIZE * 2)
+#define UART_DECODE_TASK_PRIORITY (configMAX_PRIORITIES - 1) /* 当前优先级为4,高于所有应用任务,保证及时取走数据 */
+#define UART_DECODE_QUEUE_LENGTH 8                            /* 描述符队列长度,必须是2的幂 */
+/* 串口发送队列配置宏:任务把数据帧写入帧槽后提交,发送完成中断自动启动下一帧的DMA发送,不需要CPU拷贝和忙等 */
+#define UART_TX_QUEUE_LENGTH 8        /* 发送队列帧槽数量,必须是2的幂 */
+#define UART_TRANSMIT_BUFFER_SIZE 256 /* 每个帧槽的大小:一帧数据的最大字节数 */
 
 typedef void (*uart_recv_decode_callback)(uint8_t *buffer, uint16_t Size); /* 解析接受串口数据的函数指针,做结构体的回调函数*/
 
+/* 接收数据描述符:描述接收缓冲区中的一段待解析数据,由中断写入,解析任务读出 */
 typedef struct
 {
     /* data */
-    uint8_t idx;                                         /* 串口实例的编号,对于该开发板来讲,编号只有1和3 */
-    uint8_t recv_buffer[UART_RECEIVE_BUFFER_SIZE];       /* 接收缓冲区 */
-    uint16_t recv_buffer_size;                           /* 接收一包数据的大小:数据帧大小 */
-    UART_HandleTypeDef *uartHandle;                      /* 每个UART实例对应的设备句柄 */
-    uart_recv_decode_callback uart_recv_decode_callback; /* 解析协议回调函数 */
+    uint16_t offset; /* 数据在接收缓冲区中的起始位置 */
+    uint16_t length; /* 数据长度 */
+} UART_RecvDescDef;
+
+/* 串口发送队列结构体:帧槽按分配顺序发送,帧槽内的数据直接作为DMA的源地址 */
+typedef struct
+{
+    /* data */
+    uint8_t frame[UART_TX_QUEUE_LENGTH][UART_TRANSMIT_BUFFER_SIZE]; /* 帧槽 */
+    uint16_t frame_length[UART_TX_QUEUE_LENGTH];                    /* 每个帧槽中数据帧的长度 */
+    volatile uint8_t frame_ready[UART_TX_QUEUE_LENGTH];             /* 帧槽已提交,可以发送 */
+    volatile uint8_t alloc_pos;                                     /* 分配位置:任务分配帧槽时递增 */
+    volatile uint8_t send_pos;                                      /* 发送位置:发送完成中断中递增 */
+    volatile uint8_t busy;                                          /* DMA正在发送 */
+    SemaphoreHandle_t free_semaphore;                               /* 计数信号量:空闲帧槽数量,用于阻塞等待 */
+    uint32_t tx_bytes;                                              /* 累计发送字节数 */
+    uint32_t tx_frames;                                             /* 累计发送帧数 */
+    uint32_t drop_count;                                            /* 队列满且等待超时而丢弃的帧数 */
+    uint32_t kick_error_count;                                      /* 启动DMA发送失败的次数,失败的帧在下一次启动时重试 */
+    uint8_t depth_high_water;                                       /* 队列深度的历史最大值 */
+    uint32_t report_bytes;                                          /* 上一次统计时的累计发送字节数 */
+    TickType_t report_tick;                                         /* 上一次统计时的tick */
+} UART_TxQueueDef;
+typedef UART_TxQueueDef *UART_TxQueueHandle;
+
+typedef struct
+{
+    /* data */
+    uint8_t idx;                                                /* 串口实例的编号,范围0 ~ 5,对应IDX_OF_UART_DEVICE_x */
+    uint8_t *recv_buffer;                                       /* 接收缓冲区:从静态区中按recv_buffer_size切分 */
+    uint16_t recv_buffer_size;                                  /* 接收一包数据的大小:数据帧大小;环形模式下表示环形缓冲区的大小 */
+    uint8_t recv_mode;                                          /* 接收模式:UART_RECV_MODE_IDLE或UART_RECV_MODE_RING */
+    uint16_t recv_tail;                                         /* 环形模式下的读指针:上一次交给解析函数的数据末尾 */
+    UART_HandleTypeDef *uartHandle;                             /* 每个UART实例对应的设备句柄 */
+    uart_recv_decode_callback uart_recv_decode_callback;        /* 解析协议回调函数 */
+    UART_RecvDescDef recv_desc_queue[UART_DECODE_QUEUE_LENGTH]; /* 无锁单生产者单消费者描述符队列 */
+    volatile uint8_t recv_desc_head;                            /* 队列写位置:只由中断修改 */
+    volatile uint8_t recv_desc_tail;                            /* 队列读位置:只由解析任务修改 */
+    uint16_t recv_desc_drop_count;                              /* 队列满时丢弃的描述符数量 */
+    uint32_t isr_cycle_max;                                     /* 接收中断回调的最坏执行节拍数(DWT测量) */
+    TaskHandle_t decode_task_handle;                            /* 解析任务句柄 */
+    UART_TxQueueHandle tx_queue;                                /* 发送队列:为NULL表示该串口不使用发送队列 */
 } UART_InstanceDef;
 typedef UART_InstanceDef *UART_InstanceHandle;
 
-UART_InstanceHandle Y_uart_create_instance(uint8_t, uint16_t, UART_HandleTypeDef *, uart_recv_decode_callback);
+UART_InstanceHandle Y_uart_create_instance(uint8_t, uint16_t, uint8_t, UART_HandleTypeDef *, uart_recv_decode_callback);
+void uart_isr_report(void);
+UART_TxQueueHandle Y_uart_create_tx_queue(UART_InstanceHandle uart_instance_handle);
+uint8_t *uart_tx_frame_alloc(UART_InstanceHandle uart_instance_handle, TickType_t timeout);
+void uart_tx_frame_commit(UART_InstanceHandle uart_instance_handle, uint8_t *frame, uint16_t length);
+void uart_tx_report(UART_InstanceHandle uart_instance_handle);
+#ifdef __UART_DISPATCH_BENCHMARK
+void uart_dispatch_benchmark(void);
+#endif //__UART_DISPATCH_BENCHMARK
 
 #endif //!__UART__H__
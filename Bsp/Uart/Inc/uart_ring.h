@@ -0,0 +1,36 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-10 16:45:12
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 16:45:12
+ * @Description: uart_ring.h
+ *               环形接收模式的读写指针计算:由DMA剩余计数(NDTR)得到写指针,
+ *               将读指针到写指针之间的数据切成不超过两段连续的切片;该文件不依赖HAL,可以在上位机测试
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __UART_RING__H__
+#define __UART_RING__H__
+#include "stdint.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define UART_RING_SLICE_MAX 2 /* 写指针回绕时数据被切成两段:[tail, size)和[0, head) */
+
+/* 环形缓冲区中的一段连续数据 */
+typedef struct
+{
+    /* data */
+    uint16_t offset; /* 数据在环形缓冲区中的起始位置 */
+    uint16_t length; /* 数据长度 */
+} UART_RingSliceDef;
+
+uint16_t uart_ring_head(uint16_t size, uint16_t ndtr);
+uint8_t uart_ring_slice(uint16_t tail, uint16_t head, uint16_t size, UART_RingSliceDef *slice);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //!__UART_RING__H__
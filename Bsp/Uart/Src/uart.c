@@ -2,18 +2,34 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-12 21:33:51
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-20 13:27:33
+ * @LastEditTime: 2025-02-11 09:42:16
  * @Description: uart.c
  *
  * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
  */
+#define LOG_MODULE UART /* 日志模块,必须在包含头文件之前定义,见rtt.h */
 #include "FreeRTOS.h" /* 这里并不需要FreeRTOS.h这个文件,但是task.h必须在FreeRTOS后面 */
 #include "task.h"
 #include "rtt.h"
 #include "uart.h"
+#include "uart_ring.h"
+#include "dwt.h"
 #include "string.h"
-#include "portable.h"
-static UART_InstanceHandle uart_instance_array[DEVICE_UART_NUM] = {NULL}; /* 挂载串口实例句柄 */
+#include "pool.h"
+static UART_InstanceHandle uart_instance_array[DEVICE_UART_NUM] = {NULL};            /* 挂载串口实例句柄 */
+static UART_InstanceHandle uart_dispatch_table[UART_DISPATCH_TABLE_SIZE] = {NULL}; /* 中断分发表:由外设基地址索引串口实例 */
+POOL_DEFINE(uart_instance_pool, UART_InstanceDef, UART_INSTANCE_POOL_SIZE);        /* 串口实例对象池 */
+POOL_DEFINE(uart_tx_queue_pool, UART_TxQueueDef, UART_TX_QUEUE_POOL_SIZE);         /* 发送队列对象池 */
+POOL_ARENA_DEFINE(uart_recv_arena, UART_RECV_ARENA_SIZE);                          /* 接收缓冲区静态区 */
+/**
+ * @description: 由HAL串口句柄查找对应的串口实例,常数时间,未注册的串口返回NULL
+ * @param {UART_HandleTypeDef} *huart
+ * @return {*}
+ */
+static UART_InstanceHandle uart_dispatch_lookup(UART_HandleTypeDef *huart)
+{
+    return uart_dispatch_table[UART_DISPATCH_KEY(huart->Instance)];
+}
 /**
  * @description: 成功创建串口实例后,会启动串口服务,主要用于DMA接受
  * @param {UART_InstanceHandle} uart_instance_handle
@@ -21,7 +37,14 @@ static UART_InstanceHandle uart_instance_array[DEVICE_UART_NUM] = {NULL}; /* 挂
  */
 static void uart_service_start(UART_InstanceHandle uart_instance_handle)
 {
-
+    /* 环形模式:将DMA切换为循环模式,DMA只注册一次,写到缓冲区末尾后自动回到起点,不存在重新注册的空窗期 */
+    if (uart_instance_handle->recv_mode == UART_RECV_MODE_RING)
+    {
+        uart_instance_handle->uartHandle->hdmarx->Init.Mode = DMA_CIRCULAR;
+        HAL_DMA_Init(uart_instance_handle->uartHandle->hdmarx);
+        /* DMA从缓冲区起点重新开始写入,读指针同步复位 */
+        uart_instance_handle->recv_tail = 0;
+    }
     /* 注意,虽然使用DMA进行数据传输,但是串口空闲中断依赖UART全局中断,注意开启UART全局中断 */
     HAL_UARTEx_ReceiveToIdle_DMA(uart_instance_handle->uartHandle, uart_instance_handle->recv_buffer, uart_instance_handle->recv_buffer_size);
     /* 该函数会调用UART_Start_Receive_DMA开启串口的DMA接收,该函数会配置三种回调函数,同时开启DMA中断 */
@@ -30,41 +53,160 @@ static void uart_service_start(UART_InstanceHandle uart_instance_handle)
     /* 由于设置了标志HAL_UART_RECEPTION_TOIDLE */
     /* 因此传输完成中断和IDLE中断都作为Rx Event,即调用HAL_UARTEx_RxEventCallback函数 */
     /* 实际上半传输中断也会调用HAL_UARTEx_RxEventCallback,因此需要关闭半传输中断(当然也可以进行标志位判断,但关闭中断能提高系统实时性) */
-    __HAL_DMA_DISABLE_IT(uart_instance_handle->uartHandle->hdmarx, DMA_IT_HT);
+    /* 环形模式需要保留半传输中断:半满时及时交出前半区的数据,避免写指针追上读指针 */
+    if (uart_instance_handle->recv_mode == UART_RECV_MODE_IDLE)
+    {
+        __HAL_DMA_DISABLE_IT(uart_instance_handle->uartHandle->hdmarx, DMA_IT_HT);
+    }
+}
+/**
+ * @description: 中断中调用,向描述符队列投递一段待解析数据,队列满时丢弃并计数
+ *               单生产者(中断)单消费者(解析任务)队列,读写位置各自只由一方修改,不需要加锁
+ * @param {UART_InstanceHandle} uart_instance_handle
+ * @param {uint16_t} offset
+ * @param {uint16_t} length
+ * @return {*}
+ */
+static void uart_recv_desc_push(UART_InstanceHandle uart_instance_handle, uint16_t offset, uint16_t length)
+{
+    uint8_t head = uart_instance_handle->recv_desc_head;
+    /* 读写位置为自由递增的8位计数,差值即队列中的描述符数量 */
+    if ((uint8_t)(head - uart_instance_handle->recv_desc_tail) >= UART_DECODE_QUEUE_LENGTH)
+    {
+        uart_instance_handle->recv_desc_drop_count++;
+        return;
+    }
+    uart_instance_handle->recv_desc_queue[head & (UART_DECODE_QUEUE_LENGTH - 1)].offset = offset;
+    uart_instance_handle->recv_desc_queue[head & (UART_DECODE_QUEUE_LENGTH - 1)].length = length;
+    /* 先写描述符,再发布写位置 */
+    uart_instance_handle->recv_desc_head = head + 1;
+}
+/**
+ * @description: 环形模式下,将读指针到写指针之间的数据切片投递给解析任务,不拷贝、不清空
+ *               写指针回绕时数据被切成两段,解析函数会被调用两次,切片计算见uart_ring.c
+ *               要求解析任务在下一次DMA覆盖这段数据之前处理完毕,即环形缓冲区应大于解析延迟内可能到达的字节数
+ * @param {UART_InstanceHandle} uart_instance_handle
+ * @param {uint16_t} head 写指针:DMA下一个要写入的位置
+ * @return {*}
+ */
+static void uart_ring_dispatch(UART_InstanceHandle uart_instance_handle, uint16_t head)
+{
+    UART_RingSliceDef slice[UART_RING_SLICE_MAX];
+    uint8_t slice_num = uart_ring_slice(uart_instance_handle->recv_tail, head, uart_instance_handle->recv_buffer_size, slice);
+    for (uint8_t i = 0; i < slice_num; i++)
+    {
+        uart_recv_desc_push(uart_instance_handle, slice[i].offset, slice[i].length);
+    }
+    uart_instance_handle->recv_tail = head;
 }
 /**
  * @description: 发生DMA传输完成中断和IDLE中断后,会调用该回调函数,注意每个串口设备都会调用该函数,因此内部要做区分
+ *               环形模式下,DMA半传输中断也会调用该回调函数
+ *               中断中只投递数据描述符并通知解析任务,解析函数(CRC校验/拷贝/打印)全部在解析任务中执行,缩短中断占用时间
  * @param {UART_HandleTypeDef} *huart
  * @param {uint16_t} Size 本次接收到的数据包数量:接收到的一帧数据的大小
  * @return {*}
  */
 void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
 {
-    /* 寻找发生中断的串口 */
-    uint8_t idx = 0;
-    for (; idx < DEVICE_UART_NUM; idx++)
+    uint32_t cycle_start = dwt_get_cycle(); /* 记录进入中断回调时的节拍数 */
+    uint32_t cycle = 0;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    /* 查找发生中断的串口对应的串口实例 */
+    UART_InstanceHandle uart_instance_handle = uart_dispatch_lookup(huart);
+    /* 未注册的串口,不做处理 */
+    if (uart_instance_handle == NULL)
     {
-        /* 找到发生中断的串口对应的串口实例 */
-        if (huart == uart_instance_array[idx]->uartHandle)
+        return;
+    }
+    if (uart_instance_handle->recv_mode == UART_RECV_MODE_RING)
+    {
+        /* 环形模式:直接读取NDTR得到写指针,比HAL传入的Size更及时(半传输/传输完成事件时Size是固定值) */
+        uint16_t head = uart_ring_head(uart_instance_handle->recv_buffer_size, (uint16_t)__HAL_DMA_GET_COUNTER(huart->hdmarx));
+        /* DMA处于循环模式,不需要重新注册 */
+        uart_ring_dispatch(uart_instance_handle, head);
+        /* IDLE事件额外投递一个长度为0的描述符,告诉解析函数线路空闲:帧间隔,SBUS等定长协议据此重新同步 */
+        if (HAL_UARTEx_GetRxEventType(huart) == HAL_UART_RXEVENT_IDLE)
         {
-            break;
+            uart_recv_desc_push(uart_instance_handle, head, 0);
         }
     }
-    /* 调用内部解析函数,不同的串口实例有不同的解析回调函数 */
-    if (uart_instance_array[idx]->uart_recv_decode_callback != NULL)
+    else
     {
-        /* 可以考虑将size作为解析函数的参数 */
-        uart_instance_array[idx]->uart_recv_decode_callback(uart_instance_array[idx]->recv_buffer, Size);
-        /* 清除接收缓冲区中的数据 */
-        memset(uart_instance_array[idx]->recv_buffer, 0, Size);
+        /* 普通模式:DMA已经停止,解析任务处理完这一帧后负责清空缓冲区并重新注册DMA接收 */
+        uart_recv_desc_push(uart_instance_handle, 0, Size);
     }
-    /* 串口没有解析回调函数,但这并不影响系统 */
-    else
+    /* 通过任务通知唤醒解析任务,比信号量更轻量 */
+    vTaskNotifyGiveFromISR(uart_instance_handle->decode_task_handle, &xHigherPriorityTaskWoken);
+    /* 统计最坏执行节拍数 */
+    cycle = dwt_get_cycle() - cycle_start;
+    if (cycle > uart_instance_handle->isr_cycle_max)
+    {
+        uart_instance_handle->isr_cycle_max = cycle;
+    }
+    /* 解析任务优先级更高时,退出中断后立即切换到解析任务 */
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+/**
+ * @description: 串口解析任务,每个串口实例一个,等待中断的任务通知,依次取出描述符并调用解析函数
+ *               解析函数的原型保持不变,仍然接收(数据指针,数据长度),只是运行在任务上下文中
+ * @param {void} *pvParameters 串口实例句柄
+ * @return {*}
+ */
+static void uart_decode_task(void *pvParameters)
+{
+    UART_InstanceHandle uart_instance_handle = (UART_InstanceHandle)pvParameters;
+    UART_RecvDescDef *desc;
+    while (1)
     {
-        LOGERROR("[uart_deocde]UART %d Has No Callback!", idx);
+        /* 阻塞等待中断通知,取走所有累计的通知 */
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        /* 一次通知可能对应多个描述符,全部处理完再继续等待 */
+        while (uart_instance_handle->recv_desc_tail != uart_instance_handle->recv_desc_head)
+        {
+            desc = &uart_instance_handle->recv_desc_queue[uart_instance_handle->recv_desc_tail & (UART_DECODE_QUEUE_LENGTH - 1)];
+            /* 串口没有解析回调函数,但这并不影响系统 */
+            if (uart_instance_handle->uart_recv_decode_callback != NULL)
+            {
+                uart_instance_handle->uart_recv_decode_callback(uart_instance_handle->recv_buffer + desc->offset, desc->length);
+            }
+            else
+            {
+                LOGERROR("[uart_deocde]UART %d Has No Callback!", uart_instance_handle->idx);
+            }
+            if (uart_instance_handle->recv_mode == UART_RECV_MODE_IDLE)
+            {
+                /* 清除接收缓冲区中的数据 */
+                memset(uart_instance_handle->recv_buffer, 0, desc->length);
+            }
+            /* 解析完成后再释放描述符 */
+            uart_instance_handle->recv_desc_tail++;
+            if (uart_instance_handle->recv_mode == UART_RECV_MODE_IDLE)
+            {
+                /* 完成一次接收后,需要重新注册串口的DMA接收服务 */
+                uart_service_start(uart_instance_handle);
+            }
+        }
+    }
+}
+/**
+ * @description: 打印所有串口实例的接收中断最坏执行时间以及描述符丢弃数量
+ * @return {*}
+ */
+void uart_isr_report(void)
+{
+    for (uint8_t idx = 0; idx < DEVICE_UART_NUM; idx++)
+    {
+        if (uart_instance_array[idx] == NULL)
+        {
+            continue;
+        }
+        LOGINFO("[uart_isr]UART %d ISR Max [%d] cycles ([%d] us), Drop [%d] descs.\r\n",
+                idx,
+                uart_instance_array[idx]->isr_cycle_max,
+                dwt_cycle_to_us(uart_instance_array[idx]->isr_cycle_max),
+                uart_instance_array[idx]->recv_desc_drop_count);
     }
-    /* 完成一次接收后,需要重新注册串口的DMA接收服务 */
-    uart_service_start(uart_instance_array[idx]);
 }
 /**
  * @description: 串口传输错误回调函数,常见错误:奇偶校验错误/溢出/栈异常,重启串口DMA服务或执行其他操作
@@ -73,63 +215,92 @@ void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
  */
 void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
 {
-    /* 找到出错误的串口 */
-    uint8_t idx = 0;
-    for (; idx < DEVICE_UART_NUM; idx++)
+    /* 找到发生错误的串口实例 */
+    UART_InstanceHandle uart_instance_handle = uart_dispatch_lookup(huart);
+    if (uart_instance_handle == NULL)
     {
-        /* 找到发生错误的串口实例 */
-        if (huart == uart_instance_array[idx]->uartHandle)
-        {
-            break;
-        }
+        return;
     }
-    LOGERROR("[uart_rx]UART %d Has an Error!", idx);
-    uart_service_start(uart_instance_array[idx]);
+    LOGERROR("[uart_rx]UART %d Has an Error!", uart_instance_handle->idx);
+    uart_service_start(uart_instance_handle);
 }
 /**
  * @description: 应用层函数,创建串口实例
  * @return {*}
  */
-UART_InstanceHandle Y_uart_create_instance(uint8_t instance_num,                                /* 串口实例编号,支持0 ~ 2 */
-                                           uint16_t recv_buffer_size,                           /* 串口接受一帧数据大小 */
+UART_InstanceHandle Y_uart_create_instance(uint8_t instance_num,                                /* 串口实例编号,支持0 ~ 5 */
+                                           uint16_t recv_buffer_size,                           /* 串口接受一帧数据大小,环形模式下为环形缓冲区大小 */
+                                           uint8_t recv_mode,                                   /* 接收模式:UART_RECV_MODE_IDLE/UART_RECV_MODE_RING */
                                            UART_HandleTypeDef *uartHandle,                      /* 串口实例对应的设备句柄 */
                                            uart_recv_decode_callback uart_recv_decode_callback) /* 解析回调函数 */
 {
     /* 检测串口编号是否非法 */
-    if (instance_num > DEVICE_UART_NUM)
+    if (instance_num >= DEVICE_UART_NUM)
     {
         while (1)
         {
             LOGERROR("[uart_create]The UART Number Is Illegal!");
         }
     }
-    /* 检测是否已经注册过 */
-    if (uart_instance_array[instance_num] != NULL)
+    /* 检测缓冲区大小是否非法 */
+    if ((recv_buffer_size == 0) || (recv_buffer_size > UART_RECEIVE_BUFFER_SIZE))
+    {
+        while (1)
+        {
+            LOGERROR("[uart_create]The UART Buffer Size Is Illegal!");
+        }
+    }
+    /* 检测是否已经注册过:同一个编号或同一个串口外设只能注册一次 */
+    if ((uart_instance_array[instance_num] != NULL) || (uart_dispatch_table[UART_DISPATCH_KEY(uartHandle->Instance)] != NULL))
     {
         while (1)
         {
             LOGERROR("[uart_create]UART Instance Already Created!");
         }
     }
-    /* 进入临界区,确保创建串口实例的过程是线程安全的,不要在检测串口是否合法之前进入临界区,这样会影响其他任务的调度,使整个系统卡死 */
-    taskENTER_CRITICAL();
-    /* 使用线程安全的内存分配函数 */
-    UART_InstanceHandle uart_instance_handle = (UART_InstanceHandle)pvPortMalloc(sizeof(UART_InstanceDef));
+    /* 从对象池中申请串口实例,常数时间,不使用FreeRTOS堆 */
+    UART_InstanceHandle uart_instance_handle = (UART_InstanceHandle)pool_alloc(&uart_instance_pool);
     if (uart_instance_handle == NULL)
     {
-        LOGERROR("[uart_create]UART Instance Create Failed,Stack Overflow!\r\n");
-        /* 退出临界区 */
-        taskEXIT_CRITICAL();
+        LOGERROR("[uart_create]UART Instance Pool Is Full!\r\n");
         return NULL;
     }
     uart_instance_handle->uartHandle = uartHandle;
     uart_instance_handle->idx = instance_num;
     uart_instance_handle->recv_buffer_size = recv_buffer_size;
-    /* 不需要分配BUFFER,每个结构体在创建的时候自带BUFFER */
+    uart_instance_handle->recv_mode = recv_mode;
+    uart_instance_handle->recv_tail = 0;
+    uart_instance_handle->recv_desc_head = 0;
+    uart_instance_handle->recv_desc_tail = 0;
+    uart_instance_handle->recv_desc_drop_count = 0;
+    uart_instance_handle->isr_cycle_max = 0;
+    uart_instance_handle->tx_queue = NULL; /* 发送队列按需创建 */
     uart_instance_handle->uart_recv_decode_callback = uart_recv_decode_callback;
 
+    /* 创建解析任务:任务栈由FreeRTOS堆分配,在临界区之外创建;实例挂载之前中断不会通知该任务 */
+    if (xTaskCreate(uart_decode_task, "uart_decode", UART_DECODE_TASK_STACK, (void *)uart_instance_handle, UART_DECODE_TASK_PRIORITY, &uart_instance_handle->decode_task_handle) != pdPASS)
+    {
+        LOGERROR("[uart_create]UART Decode Task Create Failed!\r\n");
+        pool_free(&uart_instance_pool, uart_instance_handle);
+        return NULL;
+    }
+    /* 接收缓冲区按实例的实际大小切分,切分后不能归还,因此放在最后一步 */
+    uart_instance_handle->recv_buffer = (uint8_t *)pool_arena_alloc(&uart_recv_arena, recv_buffer_size);
+    if (uart_instance_handle->recv_buffer == NULL)
+    {
+        LOGERROR("[uart_create]UART Receive Arena Is Full!\r\n");
+        vTaskDelete(uart_instance_handle->decode_task_handle);
+        pool_free(&uart_instance_pool, uart_instance_handle);
+        return NULL;
+    }
+    memset(uart_instance_handle->recv_buffer, 0, recv_buffer_size);
+
+    /* 进入临界区,挂载实例并注册串口服务,临界区内只有常数时间的操作 */
+    taskENTER_CRITICAL();
     /* 将创建好的串口实例挂载到串口实例队列中 */
     uart_instance_array[instance_num] = uart_instance_handle;
+    /* 挂载到中断分发表,必须在注册串口服务之前完成 */
+    uart_dispatch_table[UART_DISPATCH_KEY(uartHandle->Instance)] = uart_instance_handle;
 
     /* 注册串口服务 */
     uart_service_start(uart_instance_handle);
@@ -138,3 +309,209 @@ UART_InstanceHandle Y_uart_create_instance(uint8_t instance_num,
 
     return uart_instance_handle;
 }
+/**
+ * @description: 启动下一帧的DMA发送,要求调用者已经屏蔽串口中断(任务中进入临界区,或在发送完成中断中调用)
+ *               只有发送位置上的帧槽已提交才会发送,保证按分配顺序发送;启动失败时不丢帧,等待下一次启动
+ * @param {UART_InstanceHandle} uart_instance_handle
+ * @return {*}
+ */
+static void uart_tx_kick(UART_InstanceHandle uart_instance_handle)
+{
+    UART_TxQueueHandle tx_queue = uart_instance_handle->tx_queue;
+    uint8_t slot = tx_queue->send_pos & (UART_TX_QUEUE_LENGTH - 1);
+    if ((tx_queue->busy) || (tx_queue->send_pos == tx_queue->alloc_pos) || (!tx_queue->frame_ready[slot]))
+    {
+        return;
+    }
+    tx_queue->busy = 1;
+    /* 帧槽直接作为DMA的源地址,不需要拷贝 */
+    if (HAL_UART_Transmit_DMA(uart_instance_handle->uartHandle, tx_queue->frame[slot], tx_queue->frame_length[slot]) != HAL_OK)
+    {
+        /* 串口忙或出错时发送完成中断不会到来,清除busy,帧槽保持已提交,由下一次提交或uart_tx_report重试 */
+        tx_queue->busy = 0;
+        tx_queue->kick_error_count++;
+    }
+}
+/**
+ * @description: 串口发送完成回调函数,在串口TC中断中调用:释放已发送的帧槽,并启动下一帧的DMA发送
+ * @param {UART_HandleTypeDef} *huart
+ * @return {*}
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    UART_InstanceHandle uart_instance_handle = uart_dispatch_lookup(huart);
+    UART_TxQueueHandle tx_queue;
+    uint8_t slot;
+    if ((uart_instance_handle == NULL) || (uart_instance_handle->tx_queue == NULL))
+    {
+        return;
+    }
+    tx_queue = uart_instance_handle->tx_queue;
+    slot = tx_queue->send_pos & (UART_TX_QUEUE_LENGTH - 1);
+    /* 统计 */
+    tx_queue->tx_bytes += tx_queue->frame_length[slot];
+    tx_queue->tx_frames++;
+    /* 释放帧槽 */
+    tx_queue->frame_ready[slot] = 0;
+    tx_queue->send_pos++;
+    tx_queue->busy = 0;
+    xSemaphoreGiveFromISR(tx_queue->free_semaphore, &xHigherPriorityTaskWoken);
+    /* 链式启动下一帧 */
+    uart_tx_kick(uart_instance_handle);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+/**
+ * @description: 为串口实例创建发送队列,使用发送队列的串口需要在创建实例后调用一次
+ * @param {UART_InstanceHandle} uart_instance_handle
+ * @return {*}
+ */
+UART_TxQueueHandle Y_uart_create_tx_queue(UART_InstanceHandle uart_instance_handle)
+{
+    /* 检测是否已经创建过 */
+    if (uart_instance_handle->tx_queue != NULL)
+    {
+        while (1)
+        {
+            LOGERROR("[uart_tx_create]UART TX Queue Already Created!");
+        }
+    }
+    /* 从对象池中申请发送队列,常数时间,不使用FreeRTOS堆 */
+    UART_TxQueueHandle tx_queue = (UART_TxQueueHandle)pool_alloc(&uart_tx_queue_pool);
+    if (tx_queue == NULL)
+    {
+        LOGERROR("[uart_tx_create]UART TX Queue Pool Is Full!\r\n");
+        return NULL;
+    }
+    /* 信号量由FreeRTOS堆分配,在临界区之外创建 */
+    tx_queue->free_semaphore = xSemaphoreCreateCounting(UART_TX_QUEUE_LENGTH, UART_TX_QUEUE_LENGTH);
+    if (tx_queue->free_semaphore == NULL)
+    {
+        LOGERROR("[uart_tx_create]UART TX Semaphore Create Failed!\r\n");
+        pool_free(&uart_tx_queue_pool, tx_queue);
+        return NULL;
+    }
+    for (uint8_t i = 0; i < UART_TX_QUEUE_LENGTH; i++)
+    {
+        tx_queue->frame_ready[i] = 0;
+    }
+    tx_queue->alloc_pos = 0;
+    tx_queue->send_pos = 0;
+    tx_queue->busy = 0;
+    tx_queue->tx_bytes = 0;
+    tx_queue->tx_frames = 0;
+    tx_queue->drop_count = 0;
+    tx_queue->kick_error_count = 0;
+    tx_queue->depth_high_water = 0;
+    tx_queue->report_bytes = 0;
+    tx_queue->report_tick = xTaskGetTickCount();
+    /* 进入临界区,挂载发送队列 */
+    taskENTER_CRITICAL();
+    uart_instance_handle->tx_queue = tx_queue;
+    /* 退出临界区 */
+    taskEXIT_CRITICAL();
+
+    return tx_queue;
+}
+/**
+ * @description: 从发送队列中分配一个帧槽,调用者直接在帧槽中组帧,随后调用uart_tx_frame_commit提交
+ *               队列满时最多阻塞timeout个tick,timeout为0表示队列满时直接丢弃
+ * @param {UART_InstanceHandle} uart_instance_handle
+ * @param {TickType_t} timeout
+ * @return {*} 帧槽地址,大小为UART_TRANSMIT_BUFFER_SIZE;分配失败返回NULL
+ */
+uint8_t *uart_tx_frame_alloc(UART_InstanceHandle uart_instance_handle, TickType_t timeout)
+{
+    UART_TxQueueHandle tx_queue = uart_instance_handle->tx_queue;
+    uint8_t slot;
+    uint8_t depth;
+    if (xSemaphoreTake(tx_queue->free_semaphore, timeout) != pdTRUE)
+    {
+        tx_queue->drop_count++;
+        return NULL;
+    }
+    /* 多个任务可能同时分配帧槽,分配位置的修改需要进入临界区 */
+    taskENTER_CRITICAL();
+    slot = tx_queue->alloc_pos & (UART_TX_QUEUE_LENGTH - 1);
+    tx_queue->alloc_pos++;
+    depth = tx_queue->alloc_pos - tx_queue->send_pos;
+    if (depth > tx_queue->depth_high_water)
+    {
+        tx_queue->depth_high_water = depth;
+    }
+    taskEXIT_CRITICAL();
+    return tx_queue->frame[slot];
+}
+/**
+ * @description: 提交一个已经组好帧的帧槽,若DMA空闲则立即开始发送,否则由发送完成中断链式发送
+ * @param {UART_InstanceHandle} uart_instance_handle
+ * @param {uint8_t} *frame uart_tx_frame_alloc返回的帧槽地址
+ * @param {uint16_t} length 数据帧长度,不超过UART_TRANSMIT_BUFFER_SIZE
+ * @return {*}
+ */
+void uart_tx_frame_commit(UART_InstanceHandle uart_instance_handle, uint8_t *frame, uint16_t length)
+{
+    UART_TxQueueHandle tx_queue = uart_instance_handle->tx_queue;
+    /* 由帧槽地址反推帧槽编号 */
+    uint8_t slot = (frame - tx_queue->frame[0]) / UART_TRANSMIT_BUFFER_SIZE;
+    taskENTER_CRITICAL();
+    tx_queue->frame_length[slot] = length;
+    tx_queue->frame_ready[slot] = 1;
+    uart_tx_kick(uart_instance_handle);
+    taskEXIT_CRITICAL();
+}
+/**
+ * @description: 打印发送队列的统计信息:发送速率/队列深度最大值/丢弃帧数/启动失败次数,速率按两次调用之间的平均值计算
+ * @param {UART_InstanceHandle} uart_instance_handle
+ * @return {*}
+ */
+void uart_tx_report(UART_InstanceHandle uart_instance_handle)
+{
+    UART_TxQueueHandle tx_queue = uart_instance_handle->tx_queue;
+    TickType_t tick = xTaskGetTickCount();
+    uint32_t bytes = tx_queue->tx_bytes;
+    uint32_t bytes_per_second = 0;
+    if (tick != tx_queue->report_tick)
+    {
+        bytes_per_second = (bytes - tx_queue->report_bytes) * configTICK_RATE_HZ / (tick - tx_queue->report_tick);
+    }
+    tx_queue->report_bytes = bytes;
+    tx_queue->report_tick = tick;
+    /* 启动失败且之后没有新的提交时,由周期性的统计重试发送,避免队列停滞 */
+    taskENTER_CRITICAL();
+    uart_tx_kick(uart_instance_handle);
+    taskEXIT_CRITICAL();
+    LOGINFO("[uart_tx]UART %d TX [%d] B/s, [%d] frames, Depth Max [%d], Drop [%d] frames, Kick Error [%d].\r\n",
+            uart_instance_handle->idx,
+            bytes_per_second,
+            tx_queue->tx_frames,
+            tx_queue->depth_high_water,
+            tx_queue->drop_count,
+            tx_queue->kick_error_count);
+}
+#ifdef __UART_DISPATCH_BENCHMARK
+/**
+ * @description: 中断分发测试函数:依次测量6个串口外设查找实例的节拍数,包括未注册的串口
+ *               所有串口的节拍数应当一致,且不随已注册串口数量的增加而增加
+ *               在任务中调用,测量时关闭中断避免被打断
+ * @return {*}
+ */
+void uart_dispatch_benchmark(void)
+{
+    static USART_TypeDef *const uart_base[DEVICE_UART_NUM] = {USART1, USART2, USART3, UART4, UART5, USART6};
+    UART_HandleTypeDef uart_handle;
+    volatile UART_InstanceHandle uart_instance_handle;
+    uint32_t cycle_start = 0;
+    uint32_t cycle = 0;
+    for (uint8_t idx = 0; idx < DEVICE_UART_NUM; idx++)
+    {
+        uart_handle.Instance = uart_base[idx];
+        taskENTER_CRITICAL();
+        cycle_start = dwt_get_cycle();
+        uart_instance_handle = uart_dispatch_lookup(&uart_handle);
+        cycle = dwt_get_cycle() - cycle_start;
+        taskEXIT_CRITICAL();
+        LOGINFO("[uart_dispatch]UART %d Lookup [%d] cycles, %s.\r\n", idx, cycle, (uart_instance_handle != NULL) ? "Registered" : "Unregistered");
+    }
+}
+#endif //__UART_DISPATCH_BENCHMARK
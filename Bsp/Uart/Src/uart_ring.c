@@ -0,0 +1,57 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-10 16:45:12
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 16:45:12
+ * @Description: uart_ring.c 环形接收模式的读写指针计算,在接收中断中调用
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include "uart_ring.h"
+/**
+ * @description: 由DMA剩余计数得到写指针:DMA下一个要写入的位置
+ * @param {uint16_t} size 环形缓冲区大小
+ * @param {uint16_t} ndtr DMA剩余计数,循环模式下从size递减到1后重载
+ * @return {*} 写指针,范围0 ~ size - 1
+ */
+uint16_t uart_ring_head(uint16_t size, uint16_t ndtr)
+{
+    uint16_t head = size - ndtr;
+    if (head >= size)
+    {
+        head = 0; /* NDTR重载瞬间读到0,此时写指针位于缓冲区起点 */
+    }
+    return head;
+}
+/**
+ * @description: 将读指针到写指针之间的数据切片,不拷贝、不清空
+ *               写指针回绕时数据被切成两段:[tail, size)和[0, head)
+ * @param {uint16_t} tail 读指针:上一次交给解析函数的数据末尾
+ * @param {uint16_t} head 写指针
+ * @param {uint16_t} size 环形缓冲区大小
+ * @param {UART_RingSliceDef} *slice 输出的切片,大小不小于UART_RING_SLICE_MAX
+ * @return {*} 切片数量:0表示没有新数据,例如半传输中断之后紧跟着的IDLE中断
+ */
+uint8_t uart_ring_slice(uint16_t tail, uint16_t head, uint16_t size, UART_RingSliceDef *slice)
+{
+    if (head == tail)
+    {
+        return 0;
+    }
+    slice[0].offset = tail;
+    if (head > tail)
+    {
+        /* 未回绕,一段连续数据 */
+        slice[0].length = head - tail;
+        return 1;
+    }
+    /* 写指针已回绕,先交出缓冲区尾部的数据,再交出缓冲区头部的数据 */
+    slice[0].length = size - tail;
+    if (head == 0)
+    {
+        return 1;
+    }
+    slice[1].offset = 0;
+    slice[1].length = head;
+    return 2;
+}
@@ -0,0 +1,33 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-10 15:52:26
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 18:12:40
+ * @Description: FreeRTOS.h 上位机测试桩:在上位机上编译依赖FreeRTOS的驱动文件,单线程仿真,临界区为空操作
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __STUB_FREERTOS__H__
+#define __STUB_FREERTOS__H__
+#include "stdint.h"
+#include "stddef.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFUL)
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+/* 单线程仿真:测试在固定的位置调用中断/其他任务的处理函数,临界区不需要关中断 */
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+#ifdef __cplusplus
+}
+#endif
+#endif //!__STUB_FREERTOS__H__
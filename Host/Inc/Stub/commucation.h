@@ -0,0 +1,22 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-10 15:52:26
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 15:52:26
+ * @Description: commucation.h 上位机测试桩:只保留命令码注册接口,处理函数由测试程序保存
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __STUB_COMMUCATION__H__
+#define __STUB_COMMUCATION__H__
+#include "commucation_parser.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+typedef void (*commucation_cmd_handler)(const Commucation_FrameViewDef *view);
+uint8_t register_cmd_handler(uint16_t cmd_id, commucation_cmd_handler handler, uint16_t max_len);
+#ifdef __cplusplus
+}
+#endif
+#endif //!__STUB_COMMUCATION__H__
@@ -0,0 +1,16 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-10 15:52:26
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 15:52:26
+ * @Description: rtt.h 上位机测试桩:日志输出到标准输出
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __STUB_RTT__H__
+#define __STUB_RTT__H__
+#include "stdio.h"
+#define LOGINFO(...) printf(__VA_ARGS__)
+#define LOGWARNING(...) printf(__VA_ARGS__)
+#define LOGERROR(...) printf(__VA_ARGS__)
+#endif //!__STUB_RTT__H__
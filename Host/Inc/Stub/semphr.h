@@ -0,0 +1,24 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-10 15:52:26
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 15:52:26
+ * @Description: semphr.h 上位机测试桩:计数信号量,获取不阻塞
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __STUB_SEMPHR__H__
+#define __STUB_SEMPHR__H__
+#include "FreeRTOS.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+typedef struct StubSemaphoreDef *SemaphoreHandle_t;
+SemaphoreHandle_t xSemaphoreCreateCounting(uint32_t max_count, uint32_t initial_count);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+#ifdef __cplusplus
+}
+#endif
+#endif //!__STUB_SEMPHR__H__
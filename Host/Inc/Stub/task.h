@@ -0,0 +1,21 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-10 15:52:26
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 15:52:26
+ * @Description: task.h 上位机测试桩:tick由测试程序推进
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __STUB_TASK__H__
+#define __STUB_TASK__H__
+#include "FreeRTOS.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+TickType_t xTaskGetTickCount(void);
+#ifdef __cplusplus
+}
+#endif
+#endif //!__STUB_TASK__H__
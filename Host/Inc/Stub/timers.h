@@ -0,0 +1,28 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-10 15:52:26
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 18:12:40
+ * @Description: timers.h 上位机测试桩:软件定时器,回调由测试程序调用
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __STUB_TIMERS__H__
+#define __STUB_TIMERS__H__
+#include "FreeRTOS.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+typedef struct StubTimerDef *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t xTimer);
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, BaseType_t auto_reload, void *timer_id, TimerCallbackFunction_t callback);
+void *pvTimerGetTimerID(TimerHandle_t xTimer);
+BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t timeout);
+BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t timeout);
+BaseType_t xTimerReset(TimerHandle_t xTimer, TickType_t timeout);
+BaseType_t xTimerChangePeriod(TimerHandle_t xTimer, TickType_t period, TickType_t timeout);
+#ifdef __cplusplus
+}
+#endif
+#endif //!__STUB_TIMERS__H__
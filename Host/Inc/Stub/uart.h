@@ -0,0 +1,29 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-10 15:52:26
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 15:52:26
+ * @Description: uart.h 上位机测试桩:只保留发送队列接口,帧槽由测试程序提供
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __STUB_UART__H__
+#define __STUB_UART__H__
+#include "FreeRTOS.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+#define UART_TRANSMIT_BUFFER_SIZE 256 /* 与Bsp/Uart/Inc/uart.h相同 */
+typedef struct
+{
+    /* data */
+    void *tx_queue; /* 发送队列:非NULL表示该串口可以发送 */
+} UART_InstanceDef;
+typedef UART_InstanceDef *UART_InstanceHandle;
+uint8_t *uart_tx_frame_alloc(UART_InstanceHandle uart_instance_handle, TickType_t timeout);
+void uart_tx_frame_commit(UART_InstanceHandle uart_instance_handle, uint8_t *frame, uint16_t length);
+#ifdef __cplusplus
+}
+#endif
+#endif //!__STUB_UART__H__
@@ -0,0 +1,81 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-22 09:12:35
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-01-22 18:20:14
+ * @Description: telemetry_receiver.h Linux上位机遥测数据接收库
+ *               直接复用下位机的流式解析器(commucation_parser.c)与crc8/crc16/cobs,协议定义与下位机完全一致
+ *               数据来源可以是串口(tty/pty)、抓包文件或内存,数据帧以只读视图的形式交给回调,不拷贝数据段
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#ifndef __TELEMETRY_RECEIVER__H__
+#define __TELEMETRY_RECEIVER__H__
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "commucation_parser.h"
+
+namespace host
+{
+    /* 数据帧回调:view与frame指向解析器内部缓存(或抓包文件映射),只在回调期间有效 */
+    using FrameHandler = std::function<void(const Commucation_FrameViewDef &view, const uint8_t *frame, uint16_t frame_length)>;
+
+    /* 接收统计信息 */
+    struct ReceiverStats
+    {
+        uint64_t bytes;           /* 输入解析器的字节数 */
+        uint64_t frames;          /* 通过校验的数据帧数 */
+        uint64_t head_errors;     /* 帧头校验失败次数 */
+        uint64_t crc_errors;      /* 整包crc16校验失败次数 */
+        uint64_t skip_bytes;      /* 同步过程中丢弃的字节数 */
+        uint64_t reliable_frames; /* 交付的可靠数据帧数 */
+        uint64_t duplicates;      /* 重复收到的可靠数据帧数 */
+    };
+
+    class TelemetryReceiver
+    {
+    public:
+        /* framing:PARSER_FRAMING_SOF或PARSER_FRAMING_COBS,与下位机COMMUCATION_FRAMING一致 */
+        explicit TelemetryReceiver(uint8_t framing = PARSER_FRAMING_SOF);
+        ~TelemetryReceiver();
+        TelemetryReceiver(const TelemetryReceiver &) = delete;
+        TelemetryReceiver &operator=(const TelemetryReceiver &) = delete;
+
+        void set_frame_handler(FrameHandler handler);
+        /* 开启后可靠数据帧去掉序号后按原始cmd_id交付,并通过串口回复确认帧,见commucation_reliable.h */
+        void set_reliable(bool enable);
+
+        /* 数据来源:串口(raw模式,8N1)或抓包文件(只读映射) */
+        bool open_tty(const char *path, uint32_t baud_rate);
+        bool open_file(const char *path);
+        void close();
+
+        /* 串口:等待最多timeout_ms后读取已到达的数据,返回读取的字节数,出错返回-1 */
+        long poll(int timeout_ms);
+        /* 抓包文件:一次性解析整个文件,返回解析的字节数 */
+        size_t run_file();
+        /* 内存:解析任意长度的数据块,可以只包含半帧 */
+        void feed(const uint8_t *data, size_t length);
+
+        ReceiverStats stats() const;
+
+    private:
+        static void parser_callback(uint8_t *frame, uint16_t frame_length);
+        void dispatch(const uint8_t *frame, uint16_t frame_length);
+        void reliable_dispatch(const Commucation_FrameViewDef &view, const uint8_t *frame, uint16_t frame_length);
+
+        Commucation_ParserDef parser_;
+        Commucation_ReliableRxDef reliable_rx_;
+        FrameHandler handler_;
+        bool reliable_;
+        int fd_;                       /* 串口文件描述符,-1表示未打开 */
+        const uint8_t *file_data_;     /* 抓包文件映射地址 */
+        size_t file_length_;           /* 抓包文件字节数 */
+        uint8_t read_buffer_[1 << 16]; /* 串口读取缓存 */
+        uint64_t bytes_;
+        uint64_t reliable_frames_;
+    };
+} // namespace host
+
+#endif //!__TELEMETRY_RECEIVER__H__
@@ -0,0 +1,226 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-10 17:20:04
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 17:20:04
+ * @Description: commucation_parser_chunk_test.cpp 上位机测试流式解析器对任意分块的处理
+ *               生成混合字节流:合法数据帧(长度随机,数据段中包含0xA5与0x00)、整包校验错误的数据帧、
+ *               被截断的数据帧与随机噪声;按多种随机分块方式送入解析器,检查:
+ *               1. 每种分块方式解析出的数据帧序列与统计信息,与整块解析的结果逐字节相同;
+ *               2. 输入的每个合法数据帧都被解析出来,顺序不变(零丢帧);
+ *               3. 解析耗时与1Mbaud(8N1,100000字节/秒)线路时间的比值
+ *
+ *               编译(在仓库根目录执行):
+ *               gcc -O2 -c -IApplication/commucation/Inc -IBsp/Algorithm/Inc Application/commucation/Src/commucation_parser.c Bsp/Algorithm/Src/crc8.c Bsp/Algorithm/Src/crc16.c Bsp/Algorithm/Src/cobs.c
+ *               g++ -std=c++17 -O2 -IApplication/commucation/Inc -IBsp/Algorithm/Inc Host/Src/commucation_parser_chunk_test.cpp commucation_parser.o crc8.o crc16.o cobs.o -o commucation_parser_chunk_test
+ *
+ *               用法:
+ *               commucation_parser_chunk_test [bytes]    每种分帧方式的字节流长度,默认4000000字节(1Mbaud下40秒)
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "commucation_parser.h"
+
+#define LINE_BYTES_PER_SECOND 100000.0 /* 1Mbaud,8N1每字节10位 */
+
+/* 解析器输出的数据帧:拼接存放,offsets记录每帧的起始位置 */
+struct FrameLog
+{
+    std::vector<uint8_t> bytes;
+    std::vector<size_t> offsets;
+};
+
+static FrameLog *frame_log = nullptr;
+
+static void log_frame_callback(uint8_t *frame, uint16_t frame_length)
+{
+    frame_log->offsets.push_back(frame_log->bytes.size());
+    frame_log->bytes.insert(frame_log->bytes.end(), frame, frame + frame_length);
+}
+
+/* 一次解析的结果 */
+struct ParseResult
+{
+    FrameLog log;
+    uint32_t head_error;
+    uint32_t crc_error;
+    uint32_t skip_bytes;
+    double seconds;
+};
+
+/**
+ * @description: 按分块把字节流送入解析器,分块长度在1 ~ chunk_max之间均匀随机
+ * @param {uint32_t} chunk_max 最大分块长度,0表示整块(按解析器单次输入上限0x8000分块)
+ * @return {*}
+ */
+static ParseResult parse(const std::vector<uint8_t> &stream, uint8_t framing, uint32_t chunk_max, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<uint32_t> chunks;
+    Commucation_ParserDef parser;
+    ParseResult result;
+    size_t pos = 0;
+    /* 分块长度预先生成,不计入解析耗时 */
+    while (pos < stream.size())
+    {
+        uint32_t chunk = (chunk_max == 0) ? 0x8000 : 1 + rng() % chunk_max;
+        chunk = (chunk > stream.size() - pos) ? static_cast<uint32_t>(stream.size() - pos) : chunk;
+        chunks.push_back(chunk);
+        pos += chunk;
+    }
+    frame_log = &result.log;
+    commucation_parser_init(&parser, framing, log_frame_callback);
+    pos = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t chunk : chunks)
+    {
+        commucation_parser_feed(&parser, stream.data() + pos, static_cast<uint16_t>(chunk));
+        pos += chunk;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.head_error = parser.head_error_count;
+    result.crc_error = parser.crc_error_count;
+    result.skip_bytes = parser.skip_bytes;
+    frame_log = nullptr;
+    return result;
+}
+
+/**
+ * @description: 生成混合字节流
+ * @param {FrameLog} &expected 输出:流中的合法数据帧(未编码的原始数据帧)
+ * @return {*}
+ */
+static void build_stream(std::vector<uint8_t> &stream, FrameLog &expected, uint8_t framing, size_t bytes, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    uint8_t slot[PROTOCOL_COBS_OFFSET + PROTOCOL_FRAME_LENGTH_MAX + 1];
+    uint8_t *frame = slot + PROTOCOL_COBS_OFFSET;
+    while (stream.size() < bytes)
+    {
+        uint32_t kind = rng() % 100;
+        if (kind >= 85)
+        {
+            /* 随机噪声,0xA5与0x00出现的概率较高;COBS分帧时噪声以分隔符结束,模拟线路干扰 */
+            uint32_t noise = 1 + rng() % 24;
+            for (uint32_t i = 0; i < noise; i++)
+            {
+                uint32_t r = rng();
+                stream.push_back(((r & 0x0F) == 0) ? PROTOCOL_HEAD_CMD : (((r & 0x0F) == 1) ? 0x00 : static_cast<uint8_t>(r >> 8)));
+            }
+            if (framing == PARSER_FRAMING_COBS)
+            {
+                stream.push_back(COBS_DELIMITER);
+            }
+            continue;
+        }
+        /* 数据段至少包含16位标志位寄存器,不超过PROTOCOL_DATA_LENGTH_MAX + 2 */
+        uint16_t data_length = 2 + rng() % (PROTOCOL_DATA_LENGTH_MAX + 1);
+        for (uint16_t i = 0; i < data_length; i++)
+        {
+            uint32_t r = rng();
+            frame[6 + i] = ((r & 0x07) == 0) ? PROTOCOL_HEAD_CMD : (((r & 0x07) == 1) ? 0x00 : static_cast<uint8_t>(r >> 8));
+        }
+        uint16_t frame_length = commucation_frame_seal(frame, 1 + rng() % 0x0F, data_length);
+        if (kind < 75)
+        {
+            expected.offsets.push_back(expected.bytes.size());
+            expected.bytes.insert(expected.bytes.end(), frame, frame + frame_length);
+        }
+        else if (kind < 80)
+        {
+            /* 整包校验错误:帧头正确,数据段中的一个字节出错 */
+            frame[6 + rng() % data_length] ^= static_cast<uint8_t>(1 + rng() % 0xFF);
+        }
+        else
+        {
+            /* 被截断的数据帧:SOF分帧时后面的数据帧会被当作它的剩余部分,校验失败后需要重新同步;COBS分帧时在分隔符处结束 */
+            frame_length = 1 + rng() % (frame_length - 1);
+        }
+        if (framing == PARSER_FRAMING_COBS)
+        {
+            frame_length = commucation_frame_cobs_wrap(slot, frame_length);
+            stream.insert(stream.end(), slot, slot + frame_length);
+        }
+        else
+        {
+            stream.insert(stream.end(), frame, frame + frame_length);
+        }
+    }
+}
+
+/**
+ * @description: 检查expected中的每个数据帧按顺序出现在output中
+ * @return {*} 丢失的数据帧数
+ */
+static uint64_t count_lost(const FrameLog &expected, const FrameLog &output, uint64_t &extra)
+{
+    uint64_t lost = 0;
+    size_t j = 0;
+    for (size_t i = 0; i < expected.offsets.size(); i++)
+    {
+        size_t begin = expected.offsets[i];
+        size_t length = ((i + 1 < expected.offsets.size()) ? expected.offsets[i + 1] : expected.bytes.size()) - begin;
+        size_t k = j;
+        for (; k < output.offsets.size(); k++)
+        {
+            size_t out_begin = output.offsets[k];
+            size_t out_length = ((k + 1 < output.offsets.size()) ? output.offsets[k + 1] : output.bytes.size()) - out_begin;
+            if ((out_length == length) && (memcmp(&expected.bytes[begin], &output.bytes[out_begin], length) == 0))
+            {
+                break;
+            }
+        }
+        if (k == output.offsets.size())
+        {
+            lost++;
+            continue;
+        }
+        j = k + 1;
+    }
+    extra = output.offsets.size() - (expected.offsets.size() - lost);
+    return lost;
+}
+
+int main(int argc, char **argv)
+{
+    size_t bytes = (argc >= 2) ? static_cast<size_t>(atol(argv[1])) : 4000000;
+    /* 最大分块长度:逐字节、小分块、上位机/下位机环形缓冲区的半区(IDLE/HT/TC事件)、大块读取 */
+    const uint32_t chunk_max[] = {1, 7, 128, 512, 4096};
+    const char *framing_name[] = {"sof", "cobs"};
+    int fail = 0;
+    for (uint8_t framing = PARSER_FRAMING_SOF; framing <= PARSER_FRAMING_COBS; framing++)
+    {
+        std::vector<uint8_t> stream;
+        FrameLog expected;
+        build_stream(stream, expected, framing, bytes, 0x5EED + framing);
+        ParseResult whole = parse(stream, framing, 0, 0);
+        uint64_t extra = 0;
+        uint64_t lost = count_lost(expected, whole.log, extra);
+        printf("[%s]stream [%zu] bytes, frames [%zu], whole: frames [%zu], lost [%llu], extra [%llu], head error [%u], crc error [%u], skip [%u]: %s\n",
+               framing_name[framing], stream.size(), expected.offsets.size(), whole.log.offsets.size(),
+               static_cast<unsigned long long>(lost), static_cast<unsigned long long>(extra),
+               whole.head_error, whole.crc_error, whole.skip_bytes, (lost == 0) ? "PASS" : "FAIL");
+        fail += (lost != 0);
+        for (uint32_t max : chunk_max)
+        {
+            ParseResult chunked = parse(stream, framing, max, max);
+            bool same = (chunked.log.bytes == whole.log.bytes) && (chunked.log.offsets == whole.log.offsets) &&
+                        (chunked.head_error == whole.head_error) && (chunked.crc_error == whole.crc_error) &&
+                        (chunked.skip_bytes == whole.skip_bytes);
+            double line_seconds = stream.size() / LINE_BYTES_PER_SECOND;
+            printf("[%s]chunk [1 ~ %4u]: frames [%zu], head error [%u], crc error [%u], %.1f MB/s, %.3f%% of 1Mbaud line time, %s: %s\n",
+                   framing_name[framing], max, chunked.log.offsets.size(), chunked.head_error, chunked.crc_error,
+                   stream.size() / chunked.seconds / 1e6, 100.0 * chunked.seconds / line_seconds,
+                   same ? "same as whole" : "DIFFERENT", same ? "PASS" : "FAIL");
+            fail += !same;
+        }
+    }
+    return fail;
+}
@@ -0,0 +1,238 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-10 17:31:26
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 17:31:26
+ * @Description: crc_benchmark.cpp 上位机测试slice-by-4 CRC16/CRC8的正确性与吞吐量
+ *               正确性:与逐字节查表/逐位计算的参考实现比较,覆盖随机长度、随机起始地址(未对齐)、
+ *               crc_16/crc_modbus/crc_8/update_crc_*以及流式接口按随机分块累加的结果;
+ *               吞吐量:数据帧长度8 ~ 256字节,起始地址轮流错开0 ~ 3字节,
+ *               报告每帧耗时、bytes/cycle(x86上为TSC周期)与bytes/ns,并与逐字节实现对比
+ *
+ *               编译(在仓库根目录执行):
+ *               gcc -O2 -c -IBsp/Algorithm/Inc Bsp/Algorithm/Src/crc8.c Bsp/Algorithm/Src/crc16.c
+ *               g++ -std=c++17 -O2 -IBsp/Algorithm/Inc Host/Src/crc_benchmark.cpp crc8.o crc16.o -o crc_benchmark
+ *
+ *               用法:
+ *               crc_benchmark [rounds]    每种帧长的计算次数,默认2000000
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCHMARK_HAVE_TSC 1
+#else
+#define BENCHMARK_HAVE_TSC 0
+#endif
+#include "crc8.h"
+#include "crc16.h"
+
+#define CRC8_POLY 0x31 /* sht75_crc_table对应的多项式x^8 + x^5 + x^4 + 1,高位先行 */
+#define POOL_SIZE 4096 /* 测试数据池大小,数据帧从池中轮流取出,避免只测同一段缓存 */
+
+static uint16_t reference_tab16[256];
+static uint8_t reference_tab8[256];
+
+static uint8_t reference_crc8(uint8_t crc, const uint8_t *ptr, uint16_t num_bytes);
+
+/**
+ * @description: 参考实现的查找表:CRC16与修改前的init_crc16_tab相同,CRC8由逐位计算得出
+ * @return {*}
+ */
+static void reference_init(void)
+{
+    for (uint16_t i = 0; i < 256; i++)
+    {
+        uint16_t crc = 0;
+        uint16_t c = i;
+        for (uint8_t j = 0; j < 8; j++)
+        {
+            crc = ((crc ^ c) & 0x0001) ? (crc >> 1) ^ CRC_POLY_16 : crc >> 1;
+            c = c >> 1;
+        }
+        reference_tab16[i] = crc;
+        uint8_t byte = static_cast<uint8_t>(i);
+        reference_tab8[i] = reference_crc8(0, &byte, 1);
+    }
+}
+
+static uint16_t reference_crc16(uint16_t crc, const uint8_t *ptr, uint16_t num_bytes)
+{
+    for (uint16_t a = 0; a < num_bytes; a++)
+    {
+        crc = (crc >> 8) ^ reference_tab16[(crc ^ ptr[a]) & 0x00FF];
+    }
+    return crc;
+}
+
+/**
+ * @description: 参考实现:逐位计算,与sht75_crc_table无关,用于核对查找表本身
+ * @return {*}
+ */
+static uint8_t reference_crc8(uint8_t crc, const uint8_t *ptr, uint16_t num_bytes)
+{
+    for (uint16_t a = 0; a < num_bytes; a++)
+    {
+        crc ^= ptr[a];
+        for (uint8_t j = 0; j < 8; j++)
+        {
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ CRC8_POLY) : static_cast<uint8_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/* 逐字节实现:与修改前的crc_16/crc_8相同,每字节一次查表,作为吞吐量的对照 */
+static uint16_t bytewise_crc16(const uint8_t *ptr, uint16_t num_bytes)
+{
+    return reference_crc16(CRC_START_16, ptr, num_bytes);
+}
+
+static uint8_t bytewise_crc8(const uint8_t *ptr, uint16_t num_bytes)
+{
+    uint8_t crc = CRC_START_8;
+    for (uint16_t a = 0; a < num_bytes; a++)
+    {
+        crc = reference_tab8[ptr[a] ^ crc];
+    }
+    return crc;
+}
+
+static uint16_t slice_crc16(const uint8_t *ptr, uint16_t num_bytes)
+{
+    return crc_16(ptr, num_bytes);
+}
+
+static uint8_t slice_crc8(const uint8_t *ptr, uint16_t num_bytes)
+{
+    return crc_8(ptr, num_bytes);
+}
+
+/**
+ * @description: 随机长度、随机起始地址与随机分块,核对所有接口与参考实现逐位相同
+ * @return {*} 不一致的次数
+ */
+static uint64_t verify(const std::vector<uint8_t> &pool, uint32_t cases)
+{
+    std::mt19937 rng(0xC12C);
+    uint64_t mismatch = 0;
+    for (uint32_t i = 0; i < cases; i++)
+    {
+        uint16_t length = rng() % 600;
+        const uint8_t *ptr = pool.data() + rng() % (pool.size() - length);
+        uint16_t crc16 = reference_crc16(CRC_START_16, ptr, length);
+        uint8_t crc8 = reference_crc8(CRC_START_8, ptr, length);
+        mismatch += (crc_16(ptr, length) != crc16);
+        mismatch += (crc_modbus(ptr, length) != reference_crc16(CRC_START_MODBUS, ptr, length));
+        mismatch += (crc_8(ptr, length) != crc8);
+        mismatch += (bytewise_crc8(ptr, length) != crc8);
+        /* 单字节接口 */
+        uint16_t update16 = CRC_START_16;
+        uint8_t update8 = CRC_START_8;
+        for (uint16_t a = 0; a < length; a++)
+        {
+            update16 = update_crc_16(update16, ptr[a]);
+            update8 = update_crc_8(update8, ptr[a]);
+        }
+        mismatch += (update16 != crc16);
+        mismatch += (update8 != crc8);
+        /* 流式接口:按随机分块累加,结果与一次计算相同 */
+        CRC16_ContextDef ctx16;
+        CRC8_ContextDef ctx8;
+        crc16_init(&ctx16);
+        crc8_init(&ctx8);
+        for (uint16_t pos = 0; pos < length;)
+        {
+            uint16_t chunk = 1 + rng() % 37;
+            chunk = (chunk > length - pos) ? length - pos : chunk;
+            crc16_update(&ctx16, ptr + pos, chunk);
+            crc8_update(&ctx8, ptr + pos, chunk);
+            pos += chunk;
+        }
+        mismatch += (crc16_final(&ctx16) != crc16);
+        mismatch += (crc8_final(&ctx8) != crc8);
+    }
+    return mismatch;
+}
+
+static inline uint64_t benchmark_cycles(void)
+{
+#if BENCHMARK_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/* 一次吞吐量测量的结果 */
+struct Throughput
+{
+    double ns_per_frame;
+    double cycles_per_frame;
+};
+
+/**
+ * @description: 测量一种实现在给定帧长下的耗时,起始地址轮流错开0 ~ 3字节
+ * @return {*}
+ */
+template <typename Result>
+static Throughput measure(Result (*crc)(const uint8_t *, uint16_t), const std::vector<uint8_t> &pool, uint16_t length, uint32_t rounds)
+{
+    volatile Result sink = 0;
+    Result acc = 0;
+    size_t offset = 0;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t cycles = benchmark_cycles();
+    for (uint32_t i = 0; i < rounds; i++)
+    {
+        acc ^= crc(pool.data() + offset + (i & 0x03), length);
+        offset = (offset + length + 4 > pool.size() - length - 4) ? 0 : offset + length + 4;
+    }
+    cycles = benchmark_cycles() - cycles;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    sink = acc;
+    (void)sink;
+    return {seconds * 1e9 / rounds, static_cast<double>(cycles) / rounds};
+}
+
+template <typename Result>
+static void report(const char *name, Result (*bytewise)(const uint8_t *, uint16_t), Result (*slice)(const uint8_t *, uint16_t),
+                   const std::vector<uint8_t> &pool, uint32_t rounds)
+{
+    for (uint16_t length = 8; length <= CRC_BENCHMARK_SIZE_MAX; length <<= 1)
+    {
+        Throughput base = measure(bytewise, pool, length, rounds);
+        Throughput fast = measure(slice, pool, length, rounds);
+        printf("[%s]frame [%3d] bytes: bytewise %7.1f ns %6.3f B/cycle %6.3f B/ns, slice-by-4 %7.1f ns %6.3f B/cycle %6.3f B/ns, speedup %.2fx\n",
+               name, length,
+               base.ns_per_frame, length / base.cycles_per_frame, length / base.ns_per_frame,
+               fast.ns_per_frame, length / fast.cycles_per_frame, length / fast.ns_per_frame,
+               base.ns_per_frame / fast.ns_per_frame);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t rounds = (argc >= 2) ? static_cast<uint32_t>(atol(argv[1])) : 2000000;
+    std::vector<uint8_t> pool(POOL_SIZE);
+    std::mt19937 rng(0x5EED);
+    for (uint8_t &byte : pool)
+    {
+        byte = static_cast<uint8_t>(rng());
+    }
+    reference_init();
+    uint64_t mismatch = verify(pool, 200000);
+    printf("bit-exact check: 200000 cases, mismatch [%llu]: %s\n", static_cast<unsigned long long>(mismatch), (mismatch == 0) ? "PASS" : "FAIL");
+#if !BENCHMARK_HAVE_TSC
+    printf("no cycle counter on this host, B/cycle is not valid\n");
+#endif
+    report("crc16", bytewise_crc16, slice_crc16, pool, rounds);
+    report("crc8 ", bytewise_crc8, slice_crc8, pool, rounds);
+    return (mismatch == 0) ? 0 : 1;
+}
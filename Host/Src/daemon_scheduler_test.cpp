@@ -0,0 +1,339 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-10 18:12:40
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 18:12:40
+ * @Description: daemon_scheduler_test.cpp 上位机测试守护进程的最小堆调度
+ *               下位机的daemon.c在Host/Inc/Stub的FreeRTOS测试桩上运行,tick由测试程序推进,
+ *               单次软件定时器在设置的时刻调用deamon_timer_callback;
+ *               每个守护实例有一个参考模型记录期望的到期时刻:到期后每隔period再次到期,喂狗推迟到timeout之后;
+ *               任务中随机创建、删除、喂狗,回调函数中随机删除自身、删除其他实例、喂狗与创建新实例;
+ *               一部分实例按固定间隔喂狗(间隔小于timeout时不应到期,大于timeout时按timeout到期);
+ *               tick从接近0xFFFFFFFF处开始,运行过程中回绕
+ *               检查每次回调恰好发生在期望的时刻、删除后不再回调、daemon_next_expiry与参考模型一致、
+ *               实例数量达到上限时创建失败;统计定时器唤醒次数,以及堆顶实例被喂狗或删除后没有实例到期的唤醒次数
+ *
+ *               编译(在仓库根目录执行):
+ *               gcc -O2 -c -IHost/Inc/Stub -IBsp/Daemon/Inc -IBsp/Pool/Inc Bsp/Daemon/Src/daemon.c Bsp/Pool/Src/pool.c
+ *               g++ -std=c++17 -O2 -IHost/Inc/Stub -IBsp/Daemon/Inc -IBsp/Pool/Inc Host/Src/daemon_scheduler_test.cpp daemon.o pool.o -o daemon_scheduler_test
+ *
+ *               用法:
+ *               daemon_scheduler_test [ticks] [seed]    仿真的tick数,默认5000000;随机数种子,默认1
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+#include "daemon.h"
+
+#define MODEL_NUM (INSTANCE_DAEMON_CNT + 4) /* 参考模型数量:多于实例上限,用于测试创建失败 */
+#define PERIOD_MS_MAX 500                    /* 随机周期与超时的上限 */
+#define TICK_START (0xFFFFFFFFu - 1000000u)  /* 起始tick:运行1000000个tick后回绕 */
+
+/* 测试桩的状态 */
+struct StubTimerDef
+{
+    TickType_t fire_at;
+    void *timer_id;
+    TimerCallbackFunction_t callback;
+    bool active;
+};
+
+/* 守护实例的参考模型 */
+struct DaemonModel
+{
+    Daemon_InstanceHandle handle;
+    bool alive;
+    TickType_t period;
+    TickType_t timeout;
+    TickType_t expected;   /* 期望的下一次到期时刻 */
+    TickType_t feed_every; /* 任务按固定间隔喂狗,0表示不喂狗 */
+    TickType_t last_feed;
+    uint64_t expire_count;
+};
+
+static TickType_t sim_tick = TICK_START;
+static std::mt19937 rng(1);
+static StubTimerDef *daemon_timer = nullptr;
+static DaemonModel model[MODEL_NUM];
+static DaemonModel *running = nullptr; /* 正在执行回调函数的实例 */
+static bool running_deleted = false;   /* 回调函数中删除了自身:实例在回调结束后才释放 */
+/* 统计信息 */
+static uint64_t expire_total = 0;       /* 到期回调次数 */
+static uint64_t wrong_time = 0;         /* 回调时刻与期望不同的次数 */
+static uint64_t after_delete = 0;       /* 删除后仍然回调的次数 */
+static uint64_t wrong_next_expiry = 0;  /* daemon_next_expiry与参考模型不同的次数 */
+static uint64_t create_ok = 0;          /* 创建成功次数 */
+static uint64_t create_full = 0;        /* 实例数量达到上限而创建失败的次数 */
+static uint64_t create_wrong = 0;       /* 创建结果与实例数量不符的次数 */
+static uint64_t delete_count = 0;       /* 删除次数 */
+static uint64_t feed_count = 0;         /* 喂狗次数 */
+static uint64_t timer_wakeups = 0;      /* 定时器唤醒次数 */
+static uint64_t idle_wakeups = 0;       /* 唤醒时没有实例到期的次数 */
+static uint64_t fed_expired = 0;        /* 喂狗间隔小于timeout的实例到期的次数 */
+
+extern "C"
+{
+    TickType_t xTaskGetTickCount(void)
+    {
+        return sim_tick;
+    }
+    TimerHandle_t xTimerCreate(const char *, TickType_t period, BaseType_t, void *timer_id, TimerCallbackFunction_t callback)
+    {
+        daemon_timer = new StubTimerDef{sim_tick + period, timer_id, callback, false};
+        return daemon_timer;
+    }
+    void *pvTimerGetTimerID(TimerHandle_t xTimer)
+    {
+        return xTimer->timer_id;
+    }
+    BaseType_t xTimerChangePeriod(TimerHandle_t xTimer, TickType_t period, TickType_t)
+    {
+        /* 修改周期同时启动定时器,从命令处理的时刻开始计时;测试桩中命令立即处理 */
+        xTimer->fire_at = sim_tick + period;
+        xTimer->active = true;
+        return pdPASS;
+    }
+}
+
+static uint32_t live_count(void)
+{
+    uint32_t count = 0;
+    for (const DaemonModel &m : model)
+    {
+        count += m.alive;
+    }
+    return count;
+}
+
+static void model_callback(void *daemon);
+
+/**
+ * @description: 按参考模型创建实例,检查创建结果与实例数量一致
+ * @return {*}
+ */
+static void model_create(void)
+{
+    DaemonModel *m = nullptr;
+    for (DaemonModel &slot : model)
+    {
+        if (!slot.alive && (slot.handle == nullptr))
+        {
+            m = &slot;
+            break;
+        }
+    }
+    if (m == nullptr)
+    {
+        return;
+    }
+    uint16_t period_ms = 1 + rng() % PERIOD_MS_MAX;
+    uint16_t timeout_ms = (rng() % 4 == 0) ? 0 : 1 + rng() % PERIOD_MS_MAX;
+    uint32_t live = live_count();
+    /* 回调函数中删除自身后,实例在回调结束后才归还对象池,此时对象池可能仍然是满的 */
+    bool may_fail = (live >= INSTANCE_DAEMON_CNT) || (running_deleted && (live + 1 >= INSTANCE_DAEMON_CNT));
+    Daemon_InstanceHandle handle = Y_daemon_create_instance(m, 0, static_cast<uint8_t>(m - model), period_ms, timeout_ms, model_callback);
+    if (handle == nullptr)
+    {
+        create_full++;
+        create_wrong += !may_fail;
+        return;
+    }
+    create_ok++;
+    create_wrong += (live >= INSTANCE_DAEMON_CNT);
+    m->handle = handle;
+    m->alive = true;
+    m->period = pdMS_TO_TICKS(period_ms);
+    m->timeout = timeout_ms ? pdMS_TO_TICKS(timeout_ms) : m->period;
+    m->expected = sim_tick + m->timeout;
+    m->feed_every = 0;
+    if (rng() % 3 == 0)
+    {
+        /* 按固定间隔喂狗:一半实例的喂狗间隔小于timeout,不应到期 */
+        m->feed_every = (rng() & 0x01) ? 1 + rng() % m->timeout : m->timeout + 1 + rng() % PERIOD_MS_MAX;
+    }
+    m->last_feed = sim_tick;
+    m->expire_count = 0;
+}
+
+/**
+ * @description: 实例数量达到上限时只偶尔尝试创建,检查创建失败(每次失败打印一行错误日志)
+ * @return {*}
+ */
+static void model_try_create(void)
+{
+    if ((live_count() < INSTANCE_DAEMON_CNT) || (rng() % 50 == 0))
+    {
+        model_create();
+    }
+}
+
+static void model_delete(DaemonModel *m)
+{
+    daemon_delete_instance(m->handle);
+    m->alive = false;
+    m->handle = nullptr;
+    delete_count++;
+    if (m == running)
+    {
+        running_deleted = true;
+    }
+}
+
+static void model_feed(DaemonModel *m)
+{
+    daemon_feed(m->handle);
+    m->expected = sim_tick + m->timeout;
+    m->last_feed = sim_tick;
+    feed_count++;
+}
+
+static DaemonModel *random_live(void)
+{
+    uint32_t live = live_count();
+    if (live == 0)
+    {
+        return nullptr;
+    }
+    uint32_t pick = rng() % live;
+    for (DaemonModel &m : model)
+    {
+        if (m.alive && (pick-- == 0))
+        {
+            return &m;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @description: 守护实例的回调函数:检查回调时刻,随机删除、喂狗、创建
+ * @param {void} *daemon 守护实例句柄
+ * @return {*}
+ */
+static void model_callback(void *daemon)
+{
+    DaemonModel *m = static_cast<DaemonModel *>(static_cast<Daemon_InstanceHandle>(daemon)->owner_instance_handle);
+    expire_total++;
+    if (!m->alive || (m->handle != daemon))
+    {
+        after_delete++;
+        return;
+    }
+    wrong_time += (m->expected != sim_tick);
+    fed_expired += (m->feed_every != 0) && (m->feed_every < m->timeout);
+    m->expected = sim_tick + m->period;
+    m->expire_count++;
+    running = m;
+    running_deleted = false;
+    uint32_t action = rng() % 100;
+    if (action < 4)
+    {
+        model_delete(m);
+    }
+    else if (action < 8)
+    {
+        model_feed(m);
+    }
+    if ((action % 10 == 9) && (random_live() != nullptr))
+    {
+        DaemonModel *other = random_live();
+        if (other != m)
+        {
+            model_delete(other);
+        }
+    }
+    if (action % 16 == 15)
+    {
+        model_try_create();
+    }
+    running = nullptr;
+    running_deleted = false;
+}
+
+/**
+ * @description: 检查daemon_next_expiry与参考模型一致
+ * @return {*}
+ */
+static void check_next_expiry(void)
+{
+    TickType_t expect = portMAX_DELAY;
+    for (const DaemonModel &m : model)
+    {
+        if (m.alive)
+        {
+            int32_t delay = static_cast<int32_t>(m.expected - sim_tick);
+            TickType_t value = (delay > 0) ? static_cast<TickType_t>(delay) : 0;
+            expect = (value < expect) ? value : expect;
+        }
+    }
+    wrong_next_expiry += (daemon_next_expiry() != expect);
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t ticks = (argc >= 2) ? strtoull(argv[1], nullptr, 10) : 5000000;
+    rng.seed((argc >= 3) ? static_cast<uint32_t>(atol(argv[2])) : 1);
+    daemon_scheduler_start();
+    for (uint32_t i = 0; i < INSTANCE_DAEMON_CNT / 2; i++)
+    {
+        model_create();
+    }
+    for (uint64_t n = 0; n < ticks; n++)
+    {
+        sim_tick++;
+        /* 定时器任务:到达设置的时刻时调用回调函数 */
+        if (daemon_timer->active && (daemon_timer->fire_at == sim_tick))
+        {
+            uint64_t before = expire_total;
+            daemon_timer->active = false;
+            timer_wakeups++;
+            daemon_timer->callback(daemon_timer);
+            idle_wakeups += (expire_total == before);
+        }
+        /* 其他任务:按固定间隔喂狗,随机创建、删除、喂狗 */
+        for (DaemonModel &m : model)
+        {
+            if (m.alive && (m.feed_every != 0) && (sim_tick - m.last_feed >= m.feed_every))
+            {
+                model_feed(&m);
+            }
+        }
+        uint32_t action = rng() % 1000;
+        if (action < 3)
+        {
+            model_try_create();
+        }
+        else if ((action < 5) && (random_live() != nullptr))
+        {
+            model_delete(random_live());
+        }
+        else if ((action < 15) && (random_live() != nullptr))
+        {
+            model_feed(random_live());
+        }
+        check_next_expiry();
+        if (!daemon_timer->active)
+        {
+            printf("daemon timer stopped at tick [%u]\n", sim_tick);
+            return 1;
+        }
+    }
+    bool pass = (wrong_time == 0) && (after_delete == 0) && (wrong_next_expiry == 0) && (create_wrong == 0) && (fed_expired == 0);
+    printf("ticks [%llu], expired [%llu], timer wakeups [%llu], idle wakeups [%llu]\n",
+           static_cast<unsigned long long>(ticks), static_cast<unsigned long long>(expire_total),
+           static_cast<unsigned long long>(timer_wakeups), static_cast<unsigned long long>(idle_wakeups));
+    printf("created [%llu], create failed at capacity [%llu], deleted [%llu], fed [%llu]\n",
+           static_cast<unsigned long long>(create_ok), static_cast<unsigned long long>(create_full),
+           static_cast<unsigned long long>(delete_count), static_cast<unsigned long long>(feed_count));
+    printf("wrong time [%llu], after delete [%llu], wrong next expiry [%llu], wrong create result [%llu], fed instance expired [%llu]: %s\n",
+           static_cast<unsigned long long>(wrong_time), static_cast<unsigned long long>(after_delete),
+           static_cast<unsigned long long>(wrong_next_expiry), static_cast<unsigned long long>(create_wrong),
+           static_cast<unsigned long long>(fed_expired), pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
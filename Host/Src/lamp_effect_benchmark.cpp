@@ -0,0 +1,198 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-06 14:12:26
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 10:12:40
+ * @Description: lamp_effect_benchmark.cpp 上位机测试分段灯效的每帧渲染耗时
+ *               按lamp任务的方式逐帧渲染所有分段,统计每帧的渲染耗时、脏区间灯珠数、需要发送的帧数,
+ *               以及发送一帧时流式编码(ws2812b_stream_next)的总耗时;
+ *               同时检查灯效的边界:电平表满量程、渐变首尾颜色、静止画面不产生脏区间
+ *
+ *               编译(在仓库根目录执行):
+ *               gcc -O2 -c -IBsp/Led/Inc -IApplication/Lamp/Inc Bsp/Led/Src/ws2812b_fb.c Bsp/Led/Src/ws2812b_stream.c Application/Lamp/Src/lamp_effect.c
+ *               g++ -std=c++17 -O2 -IBsp/Led/Inc -IApplication/Lamp/Inc Host/Src/lamp_effect_benchmark.cpp ws2812b_fb.o ws2812b_stream.o lamp_effect.o -o lamp_effect_benchmark
+ *
+ *               用法:
+ *               lamp_effect_benchmark [frames]    每个场景渲染的帧数,默认200000
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "ws2812b_fb.h"
+#include "ws2812b_stream.h"
+#include "lamp_effect.h"
+
+#define SEGMENT_NUM 4 /* 与lamp.h中的LAMP_SEGMENT_NUM相同 */
+
+/* 一个测试场景:灯珠数与分段布局 */
+struct Scene
+{
+    const char *name;
+    uint16_t lamp_num;
+    Lamp_SegmentDef segment[SEGMENT_NUM];
+    uint8_t level_moving; /* 每帧改变电平表的值 */
+};
+
+/* 每个场景的统计结果 */
+struct SceneResult
+{
+    double render_ns;  /* 每帧渲染耗时 */
+    double dirty_lamp; /* 每帧脏区间的平均灯珠数 */
+    double sent_ratio; /* 需要发送的帧的比例 */
+    double encode_ns;  /* 发送一帧的流式编码总耗时 */
+    uint64_t checksum; /* 编码结果的校验和,打印出来防止编码循环被优化掉 */
+};
+
+/**
+ * @description: 按lamp任务的方式渲染frames帧
+ * @return {*}
+ */
+static SceneResult run_scene(Scene &scene, uint32_t frames)
+{
+    std::vector<uint8_t> pixel(scene.lamp_num * WS2812B_GRB_SIZE);
+    std::vector<uint8_t> send(scene.lamp_num * WS2812B_GRB_SIZE);
+    WS2812B_FramebufferDef fb;
+    WS2812B_RangeDef range;
+    static WS2812B_StreamDef stream;
+    uint64_t dirty_lamp = 0;
+    uint64_t sent = 0;
+    uint64_t checksum = 0;
+    ws2812b_fb_init(&fb, pixel.data(), scene.lamp_num);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < frames; frame++)
+    {
+        if (scene.level_moving)
+        {
+            /* 剂量率缓慢上升后回落 */
+            scene.segment[1].level = (frame * 7) % (2 * LAMP_METER_FULL);
+            if (scene.segment[1].level > LAMP_METER_FULL)
+            {
+                scene.segment[1].level = 2 * LAMP_METER_FULL - scene.segment[1].level;
+            }
+        }
+        for (uint8_t i = 0; i < SEGMENT_NUM; i++)
+        {
+            lamp_effect_render(&fb, &scene.segment[i], frame);
+        }
+        if (ws2812b_fb_take_dirty(&fb, &range))
+        {
+            dirty_lamp += range.end - range.begin;
+            sent++;
+            memcpy(send.data() + range.begin * WS2812B_GRB_SIZE, pixel.data() + range.begin * WS2812B_GRB_SIZE, (range.end - range.begin) * WS2812B_GRB_SIZE);
+        }
+    }
+    auto render = std::chrono::steady_clock::now() - start;
+
+    /* 流式编码:发送一帧时中断中编码所有时隙的总耗时 */
+    uint32_t encode_rounds = frames / 10 + 1;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < encode_rounds; round++)
+    {
+        uint8_t half = 0;
+        send[0] = (uint8_t)round;
+        ws2812b_stream_start(&stream, send.data(), WS2812B_GRB_SIZE, scene.lamp_num);
+        while (!ws2812b_stream_next(&stream, half))
+        {
+            /* 累加刚编码的半区中的一个脉冲,使编码结果参与输出 */
+            checksum += stream.buffer[half * WS2812B_STREAM_HALF_SIZE + (round % WS2812B_STREAM_HALF_SIZE)];
+            half ^= 1;
+        }
+    }
+    auto encode = std::chrono::steady_clock::now() - start;
+
+    SceneResult result;
+    result.render_ns = std::chrono::duration<double, std::nano>(render).count() / frames;
+    result.dirty_lamp = sent ? (double)dirty_lamp / frames : 0;
+    result.sent_ratio = (double)sent / frames;
+    result.encode_ns = std::chrono::duration<double, std::nano>(encode).count() / encode_rounds;
+    result.checksum = checksum;
+    return result;
+}
+/**
+ * @description: 读取帧缓冲区中一颗灯珠的颜色0xRRGGBB
+ * @return {*}
+ */
+static uint32_t pixel_color(const WS2812B_FramebufferDef &fb, uint16_t idx)
+{
+    const uint8_t *grb = fb.grb + idx * WS2812B_GRB_SIZE;
+    return ((uint32_t)grb[1] << 16) | ((uint32_t)grb[0] << 8) | grb[2];
+}
+/**
+ * @description: 灯效边界检查
+ * @return {*} 失败的检查项数
+ */
+static int check_effects(void)
+{
+    uint8_t pixel[20 * WS2812B_GRB_SIZE];
+    WS2812B_FramebufferDef fb;
+    WS2812B_RangeDef range;
+    int fail = 0;
+    ws2812b_fb_init(&fb, pixel, 20);
+
+    Lamp_SegmentDef meter = {LAMP_EFFECT_METER, 0, 10, 0x006400, 0xB22222, 0, LAMP_METER_FULL};
+    lamp_effect_render(&fb, &meter, 0);
+    fail += (pixel_color(fb, 0) != 0x006400) || (pixel_color(fb, 9) != 0xB22222);
+    meter.level = LAMP_METER_FULL / 2; /* 点亮5颗灯珠 */
+    lamp_effect_render(&fb, &meter, 0);
+    fail += (pixel_color(fb, 4) == 0) || (pixel_color(fb, 5) != 0);
+    meter.level = 0;
+    lamp_effect_render(&fb, &meter, 0);
+    fail += (pixel_color(fb, 0) != 0);
+
+    Lamp_SegmentDef gradient = {LAMP_EFFECT_GRADIENT, 10, 10, 0x00F5FF, 0xAB82FF, 0, 0};
+    lamp_effect_render(&fb, &gradient, 0);
+    fail += (pixel_color(fb, 10) != 0x00F5FF) || (pixel_color(fb, 19) != 0xAB82FF);
+
+    /* 静止画面:第二次渲染不产生脏区间 */
+    ws2812b_fb_take_dirty(&fb, &range);
+    lamp_effect_render(&fb, &gradient, 1);
+    fail += ws2812b_fb_take_dirty(&fb, &range);
+
+    /* 超出灯带的分段被截掉 */
+    Lamp_SegmentDef solid = {LAMP_EFFECT_SOLID, 15, 100, 0xFFB90F, 0, 0, 0};
+    lamp_effect_render(&fb, &solid, 0);
+    fail += !ws2812b_fb_take_dirty(&fb, &range) || (range.begin != 15) || (range.end != 20);
+    return fail;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t frames = (argc > 1) ? (uint32_t)atoi(argv[1]) : 200000;
+    int fail = check_effects();
+    printf("effect checks: %s\n", fail ? "FAIL" : "PASS");
+
+    Scene scenes[] = {
+        {"58 lamps, dose meter moving", 58,
+         {{LAMP_EFFECT_SOLID, 0, 8, 0x006400, 0, 0, 0},
+          {LAMP_EFFECT_METER, 8, 36, 0x006400, 0xB22222, 0, 0},
+          {LAMP_EFFECT_GRADIENT, 44, 8, 0x00F5FF, 0xAB82FF, 40, 0},
+          {LAMP_EFFECT_BLINK, 52, 6, 0xFFB90F, 0, 10, 0}},
+         1},
+        {"58 lamps, static status", 58,
+         {{LAMP_EFFECT_SOLID, 0, 8, 0x006400, 0, 0, 0},
+          {LAMP_EFFECT_METER, 8, 36, 0x006400, 0xB22222, 0, 500},
+          {LAMP_EFFECT_GRADIENT, 44, 8, 0x00F5FF, 0xAB82FF, 0, 0},
+          {LAMP_EFFECT_OFF, 52, 6, 0, 0, 0, 0}},
+         0},
+        {"300 lamps, dose meter moving", 300,
+         {{LAMP_EFFECT_SOLID, 0, 20, 0x006400, 0, 0, 0},
+          {LAMP_EFFECT_METER, 20, 200, 0x006400, 0xB22222, 0, 0},
+          {LAMP_EFFECT_GRADIENT, 220, 50, 0x00F5FF, 0xAB82FF, 40, 0},
+          {LAMP_EFFECT_BLINK, 270, 30, 0xFFB90F, 0, 10, 0}},
+         1},
+    };
+    for (auto &scene : scenes)
+    {
+        SceneResult result = run_scene(scene, frames);
+        printf("%-30s render %8.1f ns/frame, dirty %6.1f lamps/frame, sent %5.1f%% of frames, stream encode %8.1f ns/frame, checksum [%llx]\n",
+               scene.name, result.render_ns, result.dirty_lamp, result.sent_ratio * 100, result.encode_ns,
+               static_cast<unsigned long long>(result.checksum));
+    }
+    return fail;
+}
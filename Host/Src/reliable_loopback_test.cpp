@@ -0,0 +1,405 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-10 15:52:26
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 16:27:43
+ * @Description: reliable_loopback_test.cpp 上位机回环测试滑动窗口可靠传输
+ *               下位机的commucation_reliable.c在Host/Inc/Stub的FreeRTOS测试桩上运行,tick由测试程序推进:
+ *               发送端 -> 发送队列(帧槽数有限) -> 链路(带宽、时延、丢包) -> 解析器 + 接收端 -> 确认帧 -> 链路 -> 发送端
+ *               丢包模型为Gilbert-Elliott两状态模型,数据帧与确认帧独立丢包;
+ *               确认帧偶尔延迟LOOPBACK_SPIKE个tick(超过重传超时,引起不必要的重传),时延有抖动:
+ *               发送端申请帧槽时提前交付链路上的确认帧,模拟解析任务在发送端拷贝数据帧期间抢占
+ *               检查每条消息恰好交付一次且内容正确、每个tick窗口守恒、窗口全部释放、没有残留锁定的帧、接收端没有校验错误
+ *
+ *               编译(在仓库根目录执行):
+ *               gcc -O2 -c -D__COMMUCATION_RELIABLE -IHost/Inc/Stub -IApplication/commucation/Inc -IBsp/Algorithm/Inc -IBsp/Pool/Inc Application/commucation/Src/commucation_reliable.c Application/commucation/Src/commucation_parser.c Bsp/Pool/Src/pool.c Bsp/Algorithm/Src/crc8.c Bsp/Algorithm/Src/crc16.c Bsp/Algorithm/Src/cobs.c
+ *               g++ -std=c++17 -O2 -IHost/Inc/Stub -IApplication/commucation/Inc -IBsp/Algorithm/Inc -IBsp/Pool/Inc Host/Src/reliable_loopback_test.cpp commucation_reliable.o commucation_parser.o pool.o crc8.o crc16.o cobs.o -o reliable_loopback_test
+ *
+ *               用法(发送端只能创建一次,每次运行测试一种场景):
+ *               reliable_loopback_test [loss%] [burst] [window] [sof|cobs] [messages]
+ *               loss%:平均丢包率,默认10;burst:坏状态平均持续的帧数,1表示独立丢包,默认4;
+ *               window:窗口大小,默认8;messages:发送的消息数,默认100000
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+#include "timers.h"
+#include "uart.h"
+#include "commucation.h"
+extern "C"
+{
+#include "commucation_reliable.h"
+}
+
+#define LOOPBACK_TX_SLOTS 4       /* 发送队列帧槽数:小于UART_TX_QUEUE_LENGTH,更容易出现发送队列满 */
+#define LOOPBACK_LINK_FRAMES 2    /* 链路带宽:每个tick发送的帧数 */
+#define LOOPBACK_LATENCY 3        /* 单向时延,单位tick */
+#define LOOPBACK_SPIKE 25         /* 确认帧时延尖峰,大于重传超时 */
+#define LOOPBACK_SPIKE_RATE 0.002 /* 每个确认帧出现时延尖峰的概率 */
+#define LOOPBACK_SEND_PER_TICK 3  /* 应用每个tick尝试发送的消息数,大于链路带宽,窗口会被填满 */
+#define LOOPBACK_FLOATS 4         /* 每条消息的float个数 */
+#define LOOPBACK_CMD 0x0001       /* 消息的原始命令码 */
+#define LOOPBACK_TICK_LIMIT 50000000u
+
+/* 测试桩的状态 */
+struct StubSemaphoreDef
+{
+    uint32_t count;
+    uint32_t max_count;
+    uint32_t over_give; /* 超过上限的释放次数:窗口被重复释放 */
+};
+struct StubTimerDef
+{
+    TickType_t period;
+    void *timer_id;
+    TimerCallbackFunction_t callback;
+    bool active;
+};
+
+/* 链路上的一帧 */
+struct WireFrame
+{
+    TickType_t arrive;
+    std::vector<uint8_t> bytes;
+};
+
+/* Gilbert-Elliott丢包模型:好状态不丢包,坏状态全部丢包 */
+struct LossModel
+{
+    double enter_bad; /* 好状态 -> 坏状态的概率 */
+    double leave_bad; /* 坏状态 -> 好状态的概率 */
+    bool bad;
+    uint64_t lost;
+
+    bool drop(std::mt19937 &rng)
+    {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        bad = bad ? (uniform(rng) >= leave_bad) : (uniform(rng) < enter_bad);
+        lost += bad;
+        return bad;
+    }
+};
+
+static TickType_t sim_tick = 0;
+static std::mt19937 rng(20250210);
+static StubSemaphoreDef *window_semaphore = nullptr;
+static StubTimerDef *retransmit_timer = nullptr;
+static commucation_cmd_handler ack_handler = nullptr;
+static UART_InstanceDef uart_instance = {&uart_instance};
+static uint8_t framing = PARSER_FRAMING_COBS;
+
+static uint8_t tx_slot[LOOPBACK_TX_SLOTS][UART_TRANSMIT_BUFFER_SIZE];
+static bool tx_slot_used[LOOPBACK_TX_SLOTS];
+static std::deque<std::vector<uint8_t>> tx_queue; /* 已提交、等待链路发送的帧 */
+static std::deque<uint8_t> tx_queue_slot;         /* 与tx_queue对应的帧槽 */
+static std::deque<WireFrame> uplink;              /* 数据帧:下位机 -> 上位机 */
+static std::deque<WireFrame> downlink;            /* 确认帧:上位机 -> 下位机 */
+static LossModel uplink_loss;
+static LossModel downlink_loss;
+
+static Commucation_ParserDef host_parser;   /* 上位机解析器 */
+static Commucation_ReliableRxDef host_rx;   /* 上位机接收端 */
+static Commucation_ParserDef device_parser; /* 下位机解析器:只接收确认帧 */
+static std::vector<uint8_t> delivered;      /* 每条消息的交付次数 */
+static uint64_t corrupt_payload = 0;        /* 内容与发送时不一致的消息数 */
+static uint64_t preempted_acks = 0;         /* 在发送端拷贝期间交付的确认帧数 */
+static uint64_t pinned_release = 0;         /* 拷贝期间被累计确认的帧数:窗口延迟到解锁时释放 */
+static Commucation_ReliableHandle reliable = nullptr;
+
+extern "C"
+{
+    TickType_t xTaskGetTickCount(void)
+    {
+        return sim_tick;
+    }
+    SemaphoreHandle_t xSemaphoreCreateCounting(uint32_t max_count, uint32_t initial_count)
+    {
+        window_semaphore = new StubSemaphoreDef{initial_count, max_count, 0};
+        return window_semaphore;
+    }
+    BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t)
+    {
+        if (semaphore->count == 0)
+        {
+            return pdFALSE;
+        }
+        semaphore->count--;
+        return pdTRUE;
+    }
+    BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+    {
+        if (semaphore->count >= semaphore->max_count)
+        {
+            semaphore->over_give++;
+            return pdFALSE;
+        }
+        semaphore->count++;
+        return pdTRUE;
+    }
+    TimerHandle_t xTimerCreate(const char *, TickType_t period, BaseType_t, void *timer_id, TimerCallbackFunction_t callback)
+    {
+        retransmit_timer = new StubTimerDef{period, timer_id, callback, false};
+        return retransmit_timer;
+    }
+    void *pvTimerGetTimerID(TimerHandle_t xTimer)
+    {
+        return xTimer->timer_id;
+    }
+    BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t)
+    {
+        xTimer->active = true;
+        return pdPASS;
+    }
+    BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t)
+    {
+        xTimer->active = false;
+        return pdPASS;
+    }
+    BaseType_t xTimerReset(TimerHandle_t xTimer, TickType_t)
+    {
+        xTimer->active = true;
+        return pdPASS;
+    }
+    uint8_t register_cmd_handler(uint16_t cmd_id, commucation_cmd_handler handler, uint16_t)
+    {
+        if (cmd_id == PROTOCOL_CMD_RELIABLE_ACK)
+        {
+            ack_handler = handler;
+        }
+        return TRUE;
+    }
+}
+
+/**
+ * @description: 下位机解析器回调:确认帧交给发送端注册的处理函数
+ * @return {*}
+ */
+static void device_frame_callback(uint8_t *frame, uint16_t frame_length)
+{
+    Commucation_FrameViewDef view;
+    if (commucation_frame_view(frame, frame_length, &view) && (view.cmd_id == PROTOCOL_CMD_RELIABLE_ACK) && (ack_handler != nullptr))
+    {
+        ack_handler(&view);
+    }
+}
+/**
+ * @description: 交付已到达的确认帧,模拟下位机解析任务运行
+ * @param {TickType_t} early 提前交付的tick数:模拟时延抖动
+ * @return {*}
+ */
+static void deliver_acks(TickType_t early)
+{
+    while (!downlink.empty() && (downlink.front().arrive <= sim_tick + early))
+    {
+        commucation_parser_feed(&device_parser, downlink.front().bytes.data(), downlink.front().bytes.size());
+        downlink.pop_front();
+    }
+}
+extern "C"
+{
+    uint8_t *uart_tx_frame_alloc(UART_InstanceHandle, TickType_t)
+    {
+        /* 发送端此时已锁定数据帧,在这里交付确认帧相当于解析任务在拷贝期间抢占 */
+        if (!downlink.empty() && (downlink.front().arrive <= sim_tick + LOOPBACK_LATENCY))
+        {
+            preempted_acks++;
+            deliver_acks(LOOPBACK_LATENCY);
+            for (uint8_t i = 0; i < COMMUCATION_RELIABLE_POOL_SIZE; i++)
+            {
+                pinned_release += (reliable->pool[i].pin == RELIABLE_PIN_RELEASE);
+            }
+        }
+        for (uint8_t i = 0; i < LOOPBACK_TX_SLOTS; i++)
+        {
+            if (!tx_slot_used[i])
+            {
+                tx_slot_used[i] = true;
+                return tx_slot[i];
+            }
+        }
+        return nullptr;
+    }
+    void uart_tx_frame_commit(UART_InstanceHandle, uint8_t *frame, uint16_t length)
+    {
+        tx_queue.emplace_back(frame, frame + length);
+        tx_queue_slot.push_back((frame - tx_slot[0]) / UART_TRANSMIT_BUFFER_SIZE);
+    }
+}
+
+/**
+ * @description: 上位机解析器回调:可靠数据帧去重、检查内容并回复确认帧
+ * @return {*}
+ */
+static void host_frame_callback(uint8_t *frame, uint16_t frame_length)
+{
+    Commucation_FrameViewDef view;
+    uint8_t ack[PROTOCOL_COBS_OFFSET + OFFSET_BYTE + 6 + 1];
+    uint16_t ack_length;
+    uint32_t message[LOOPBACK_FLOATS];
+    if (!commucation_frame_view(frame, frame_length, &view) || (view.cmd_id != PROTOCOL_CMD_RELIABLE_DATA) ||
+        (view.payload_length != RELIABLE_DATA_HEAD_SIZE - 2 + 4 * LOOPBACK_FLOATS))
+    {
+        corrupt_payload++;
+        return;
+    }
+    if (commucation_reliable_rx_accept(&host_rx, view.flags_register & 0xFF))
+    {
+        /* 原始cmd_id、原始flags_register与float数据:消息编号及其变换 */
+        memcpy(message, view.payload + RELIABLE_DATA_HEAD_SIZE - 2, sizeof(message));
+        if ((message[0] >= delivered.size()) || ((view.payload[0] | (view.payload[1] << 8)) != LOOPBACK_CMD) ||
+            ((uint32_t)(view.payload[2] | (view.payload[3] << 8)) != (message[0] & 0xFFFF)) ||
+            (message[1] != ~message[0]) || (message[2] != message[0] * 2654435761u) || (message[3] != 0xA5A500A5u))
+        {
+            corrupt_payload++;
+        }
+        else
+        {
+            delivered[message[0]]++;
+        }
+    }
+    ack_length = commucation_reliable_ack_pack(&host_rx, ack + PROTOCOL_COBS_OFFSET);
+    if (downlink_loss.drop(rng))
+    {
+        return;
+    }
+    /* 链路先进先出:时延尖峰之后的确认帧不会先到达 */
+    TickType_t arrive = sim_tick + LOOPBACK_LATENCY + ((std::uniform_real_distribution<double>(0.0, 1.0)(rng) < LOOPBACK_SPIKE_RATE) ? LOOPBACK_SPIKE : 0);
+    if (!downlink.empty() && (downlink.back().arrive > arrive))
+    {
+        arrive = downlink.back().arrive;
+    }
+    if (framing == PARSER_FRAMING_COBS)
+    {
+        ack_length = commucation_frame_cobs_wrap(ack, ack_length);
+        downlink.push_back({arrive, std::vector<uint8_t>(ack, ack + ack_length)});
+    }
+    else
+    {
+        downlink.push_back({arrive, std::vector<uint8_t>(ack + PROTOCOL_COBS_OFFSET, ack + PROTOCOL_COBS_OFFSET + ack_length)});
+    }
+}
+/**
+ * @description: 窗口守恒:信号量剩余数 + 未确认的帧数 + 等待解锁释放的帧数 = 窗口大小
+ *               窗口被重复释放时信号量会多出,未释放时会少,发送端的每个调用返回后都应当成立
+ * @param {uint8_t} window 窗口大小
+ * @return {*} true:守恒
+ */
+static bool window_conserved(uint8_t window)
+{
+    uint32_t pending = 0;
+    for (uint8_t i = 0; i < COMMUCATION_RELIABLE_POOL_SIZE; i++)
+    {
+        pending += (reliable->pool[i].pin == RELIABLE_PIN_RELEASE);
+    }
+    return window_semaphore->count + (uint8_t)(reliable->next_seq - reliable->base_seq) + pending == window;
+}
+/**
+ * @description: 链路前进一个tick:发送队列按带宽发出数据帧并释放帧槽,到达的数据帧交给上位机解析器
+ * @return {*}
+ */
+static void link_step(void)
+{
+    for (uint8_t i = 0; (i < LOOPBACK_LINK_FRAMES) && !tx_queue.empty(); i++)
+    {
+        if (!uplink_loss.drop(rng))
+        {
+            uplink.push_back({sim_tick + LOOPBACK_LATENCY, std::move(tx_queue.front())});
+        }
+        tx_slot_used[tx_queue_slot.front()] = false;
+        tx_queue.pop_front();
+        tx_queue_slot.pop_front();
+    }
+    while (!uplink.empty() && (uplink.front().arrive <= sim_tick))
+    {
+        commucation_parser_feed(&host_parser, uplink.front().bytes.data(), uplink.front().bytes.size());
+        uplink.pop_front();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    double loss = ((argc > 1) ? atof(argv[1]) : 10.0) / 100.0;
+    double burst = (argc > 2) ? atof(argv[2]) : 4.0;
+    uint8_t window = (argc > 3) ? (uint8_t)atoi(argv[3]) : 8;
+    framing = ((argc > 4) && (strcmp(argv[4], "sof") == 0)) ? PARSER_FRAMING_SOF : PARSER_FRAMING_COBS;
+    uint32_t messages = (argc > 5) ? (uint32_t)atoi(argv[5]) : 100000;
+    uint32_t next_message = 0;
+    uint64_t duplicate = 0;
+    uint64_t missing = 0;
+    uint8_t pinned = 0;
+    uint64_t window_error = 0;
+    int fail = 0;
+
+    /* 平均丢包率loss,坏状态平均持续burst帧:leave_bad = 1 / burst,enter_bad = loss * leave_bad / (1 - loss) */
+    uplink_loss = {(loss < 1.0) ? loss / (burst * (1.0 - loss)) : 1.0, 1.0 / burst, false, 0};
+    downlink_loss = uplink_loss;
+    delivered.assign(messages, 0);
+    commucation_parser_init(&host_parser, framing, host_frame_callback);
+    commucation_parser_init(&device_parser, framing, device_frame_callback);
+    commucation_reliable_rx_init(&host_rx);
+    reliable = Y_commucation_create_reliable(&uart_instance, framing, window);
+    if (reliable == nullptr)
+    {
+        return 1;
+    }
+
+    while (((next_message < messages) || (reliable->base_seq != reliable->next_seq)) && (sim_tick < LOOPBACK_TICK_LIMIT))
+    {
+        sim_tick++;
+        for (uint8_t i = 0; (i < LOOPBACK_SEND_PER_TICK) && (next_message < messages); i++)
+        {
+            uint32_t message[LOOPBACK_FLOATS] = {next_message, ~next_message, next_message * 2654435761u, 0xA5A500A5u};
+            float tx_data[LOOPBACK_FLOATS];
+            memcpy(tx_data, message, sizeof(tx_data));
+            if (!commucation_reliable_send(reliable, LOOPBACK_CMD, next_message & 0xFFFF, tx_data, LOOPBACK_FLOATS, 0))
+            {
+                break;
+            }
+            next_message++;
+        }
+        if (retransmit_timer->active && (sim_tick % retransmit_timer->period == 0))
+        {
+            retransmit_timer->callback(retransmit_timer);
+        }
+        link_step();
+        deliver_acks(0);
+        window_error += !window_conserved(window);
+    }
+
+    for (uint32_t i = 0; i < messages; i++)
+    {
+        missing += (delivered[i] == 0);
+        duplicate += (delivered[i] > 1);
+    }
+    for (uint8_t i = 0; i < COMMUCATION_RELIABLE_POOL_SIZE; i++)
+    {
+        pinned += (reliable->pool[i].pin != RELIABLE_PIN_NONE);
+    }
+    printf("%s framing, window [%d], loss [%.1f%%], burst [%.1f] frames, [%u] messages in [%u] ticks: %.3f messages/tick (link %d frames/tick)\n",
+           (framing == PARSER_FRAMING_COBS) ? "COBS" : "SOF", window, loss * 100, burst, messages, sim_tick,
+           (double)messages / sim_tick, LOOPBACK_LINK_FRAMES);
+    printf("sent [%u], retransmit [%u], acked [%u], lost data [%llu], lost ack [%llu], preempted ack [%llu], acked while pinned [%llu], srtt [%u] ticks, rto [%u] ticks\n",
+           reliable->tx_frames, reliable->retransmit_count, reliable->acked_frames,
+           static_cast<unsigned long long>(uplink_loss.lost), static_cast<unsigned long long>(downlink_loss.lost),
+           static_cast<unsigned long long>(preempted_acks), static_cast<unsigned long long>(pinned_release),
+           reliable->srtt, reliable->rto);
+    fail += (missing != 0) || (duplicate != 0) || (corrupt_payload != 0);
+    fail += (reliable->acked_frames != messages) || (reliable->base_seq != reliable->next_seq);
+    fail += (window_semaphore->count != window) || (window_semaphore->over_give != 0) || (pinned != 0) || (window_error != 0);
+    fail += (host_parser.crc_error_count != 0) || (host_parser.head_error_count != 0);
+    printf("missing [%llu], duplicate [%llu], corrupt [%llu], window [%u/%u], over give [%u], window error [%llu] ticks, pinned [%d], crc error [%u]: %s\n",
+           static_cast<unsigned long long>(missing), static_cast<unsigned long long>(duplicate),
+           static_cast<unsigned long long>(corrupt_payload), window_semaphore->count, window_semaphore->max_count,
+           window_semaphore->over_give, static_cast<unsigned long long>(window_error), pinned,
+           host_parser.crc_error_count, fail ? "FAIL" : "PASS");
+    return fail;
+}
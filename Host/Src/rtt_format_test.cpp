@@ -0,0 +1,282 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-10 17:58:13
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 17:58:13
+ * @Description: rtt_format_test.cpp 上位机测试诊断信息格式化
+ *               1. 十六进制转储:0 ~ 16字节(以及超过16字节时截断)的随机数据与全部256个字节值,
+ *                  与按原rtt_str_to_hex逐字节printf拼接的参考行逐字符比较,检查不越界写入;
+ *               2. 定点浮点数:固定用例(0.05 -> "0.050"等)、nan/inf、各数量级的随机值与0 ~ 6位小数,
+ *                  与snprintf("%.*f")比较;float乘法与四舍五入(snprintf为四舍六入五成双)只允许在
+ *                  舍入边界附近差最后一位,其余必须逐字符相同;检查返回长度与最长字符数;
+ *               3. 与原实现(逐字节printf、sprintf拼接整数与小数部分)比较耗时
+ *
+ *               编译(在仓库根目录执行):
+ *               gcc -O2 -c -IBsp/RTT/Inc Bsp/RTT/Src/rtt_format.c
+ *               g++ -std=c++17 -O2 -IBsp/RTT/Inc Host/Src/rtt_format_test.cpp rtt_format.o -o rtt_format_test
+ *
+ *               用法:
+ *               rtt_format_test [cases]    随机用例数,默认1000000
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include "rtt_format.h"
+
+#define CANARY 0x5A /* 输出缓冲区末尾的哨兵字节,检查越界写入 */
+
+/**
+ * @description: 参考实现:按原rtt_str_to_hex的格式逐字节printf拼接一行
+ * @return {*}
+ */
+static std::string reference_hex_line(uint32_t address, const uint8_t *buf, int len)
+{
+    char item[16];
+    std::string line;
+    snprintf(item, sizeof(item), "%08X: ", address);
+    line += item;
+    for (int i = 0; i < 16; i++)
+    {
+        if (i < len)
+        {
+            snprintf(item, sizeof(item), "%02X ", buf[i] & 0xFF);
+            line += item;
+        }
+        else
+        {
+            line += "   ";
+        }
+    }
+    line += " |";
+    for (int i = 0; i < 16; i++)
+    {
+        int c = (i < len) ? (buf[i] & 0xFF) : ' ';
+        line += ((i < len) && ((c < 0x20) || (c >= 0x7F))) ? '.' : static_cast<char>(c);
+    }
+    line += "|\n";
+    return line;
+}
+
+/* 原浮点数格式化:sprintf拼接整数部分与小数部分,小数部分不补前导0 */
+static void reference_float_old(char *str, float va)
+{
+    int flag = va < 0;
+    int head = (int)va;
+    int point = (int)((va - head) * 1000);
+    head = abs(head);
+    point = abs(point);
+    if (flag)
+        sprintf(str, "-%d.%d", head, point);
+    else
+        sprintf(str, "%d.%d", head, point);
+}
+
+/**
+ * @description: 十六进制转储的正确性
+ * @return {*} 失败的用例数
+ */
+static uint64_t check_hex(uint32_t cases)
+{
+    std::mt19937 rng(0x4E7);
+    uint8_t data[RTT_FORMAT_HEX_BYTES_PER_LINE + 4];
+    char line[RTT_FORMAT_HEX_LINE_SIZE + 1];
+    uint64_t fail = 0;
+    auto check = [&](uint32_t address, uint8_t len) {
+        memset(line, CANARY, sizeof(line));
+        uint16_t length = rtt_format_hex_line(line, address, data, len);
+        std::string expect = reference_hex_line(address, data, (len > RTT_FORMAT_HEX_BYTES_PER_LINE) ? RTT_FORMAT_HEX_BYTES_PER_LINE : len);
+        bool pass = (length == RTT_FORMAT_HEX_LINE_SIZE) && (expect.size() == RTT_FORMAT_HEX_LINE_SIZE) &&
+                    (memcmp(line, expect.data(), RTT_FORMAT_HEX_LINE_SIZE) == 0) && (line[RTT_FORMAT_HEX_LINE_SIZE] == (char)CANARY);
+        if (!pass && (fail < 4))
+        {
+            printf("[hex]expect: %s[hex]got:    %.*s\n", expect.c_str(), RTT_FORMAT_HEX_LINE_SIZE, line);
+        }
+        fail += !pass;
+    };
+    /* 全部256个字节值:16行,每行16个连续的字节值 */
+    for (uint16_t row = 0; row < 16; row++)
+    {
+        for (uint8_t i = 0; i < RTT_FORMAT_HEX_BYTES_PER_LINE; i++)
+        {
+            data[i] = static_cast<uint8_t>(row * 16 + i);
+        }
+        check(row * 16, RTT_FORMAT_HEX_BYTES_PER_LINE);
+    }
+    for (uint32_t n = 0; n < cases; n++)
+    {
+        for (uint8_t &byte : data)
+        {
+            byte = static_cast<uint8_t>(rng());
+        }
+        check(rng(), rng() % (RTT_FORMAT_HEX_BYTES_PER_LINE + 4));
+    }
+    return fail;
+}
+
+/**
+ * @description: 检查一个浮点值的格式化结果
+ * @param {uint64_t} &near_tie 在舍入边界附近与snprintf差最后一位的次数
+ * @return {*} 1:结果错误
+ */
+static bool check_float_value(float value, uint8_t decimals, uint64_t &near_tie)
+{
+    char str[RTT_FORMAT_FLOAT_SIZE_MAX + 1];
+    char expect[64];
+    memset(str, CANARY, sizeof(str));
+    uint8_t length = rtt_format_float(str, value, decimals);
+    if ((length >= RTT_FORMAT_FLOAT_SIZE_MAX) || (strlen(str) != length) || (str[RTT_FORMAT_FLOAT_SIZE_MAX] != (char)CANARY))
+    {
+        return true;
+    }
+    snprintf(expect, sizeof(expect), "%.*f", decimals, static_cast<double>(value));
+    if (strcmp(str, expect) == 0)
+    {
+        return false;
+    }
+    /* 只允许舍入边界附近差最后一位:小数部分乘以10^decimals与加0.5各有一次float舍入,
+       误差不超过2 * 2^-24 * 10^decimals个最小单位,即与小数位数无关的约1.2e-7 */
+    double exact = static_cast<double>(value);
+    double got = strtod(str, nullptr);
+    double step = 1.0 / pow(10.0, decimals);
+    double tolerance = 1.2e-7 + fabs(exact) * 1e-15;
+    if ((fabs(got - strtod(expect, nullptr)) <= step * 1.001) && (fabs(fabs(got - exact) - step / 2) <= tolerance))
+    {
+        near_tie++;
+        return false;
+    }
+    printf("[float]%.9g with %d decimals: expect \"%s\", got \"%s\"\n", value, decimals, expect, str);
+    return true;
+}
+
+/**
+ * @description: 定点浮点数的正确性
+ * @return {*} 失败的用例数
+ */
+static uint64_t check_float(uint32_t cases, uint64_t &near_tie)
+{
+    static const float value[] = {0.05f, -0.05f, 1.5f, 231.43234f, -9.34f, 0.0f, 0.9996f, -1234567.0f};
+    static const char *const expect[] = {"0.050", "-0.050", "1.500", "231.432", "-9.340", "0.000", "1.000", "-1234567.000"};
+    char str[RTT_FORMAT_FLOAT_SIZE_MAX];
+    uint64_t fail = 0;
+    std::mt19937 rng(0xF10A7);
+    /* 固定用例,与片上测试相同 */
+    for (uint8_t i = 0; i < sizeof(value) / sizeof(value[0]); i++)
+    {
+        rtt_format_float(str, value[i], 3);
+        fail += (strcmp(str, expect[i]) != 0);
+    }
+    rtt_format_float(str, 0.05f, 2);
+    fail += (strcmp(str, "0.05") != 0);
+    rtt_format_float(str, 0.001f, 6);
+    fail += (strcmp(str, "0.001000") != 0);
+    rtt_format_float(str, 2.5f, 0);
+    fail += (strcmp(str, "3") != 0);
+    rtt_format_float(str, 9.9999f, 2);
+    fail += (strcmp(str, "10.00") != 0);
+    rtt_format_float(str, 1.0f, 9);
+    fail += (strcmp(str, "1.000000") != 0);
+    rtt_format_float(str, NAN, 3);
+    fail += (strcmp(str, "nan") != 0);
+    rtt_format_float(str, INFINITY, 3);
+    fail += (strcmp(str, "inf") != 0);
+    rtt_format_float(str, -INFINITY, 3);
+    fail += (strcmp(str, "-inf") != 0);
+    rtt_format_float(str, 4294967296.0f, 3);
+    fail += (strcmp(str, "inf") != 0);
+    /* 最长的字符串:2^32以下最大的float,负数,6位小数 */
+    fail += (rtt_format_float(str, -4294967040.0f, RTT_FORMAT_FLOAT_DECIMALS_MAX) != RTT_FORMAT_FLOAT_SIZE_MAX - 1);
+    fail += (strcmp(str, "-4294967040.000000") != 0);
+    if (fail != 0)
+    {
+        printf("[float]fixed cases: [%llu] failed\n", static_cast<unsigned long long>(fail));
+    }
+    /* 随机值:数量级1e-7 ~ 4e9均匀分布,符号随机 */
+    std::uniform_real_distribution<double> exponent(-7.0, 9.6);
+    for (uint32_t n = 0; n < cases; n++)
+    {
+        float v = static_cast<float>(pow(10.0, exponent(rng)));
+        v = (rng() & 0x01) ? -v : v;
+        if (fabsf(v) >= 4294967296.0f)
+        {
+            continue;
+        }
+        fail += check_float_value(v, rng() % (RTT_FORMAT_FLOAT_DECIMALS_MAX + 1), near_tie);
+    }
+    /* 小数部分恰好落在舍入边界上的值:k / 2^m */
+    for (uint32_t k = 1; k < 4096; k++)
+    {
+        for (uint8_t decimals = 0; decimals <= RTT_FORMAT_FLOAT_DECIMALS_MAX; decimals++)
+        {
+            fail += check_float_value(static_cast<float>(k) / 64.0f, decimals, near_tie);
+        }
+    }
+    return fail;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t cases = (argc >= 2) ? static_cast<uint32_t>(atol(argv[1])) : 1000000;
+    int fail = 0;
+    char old_str[32];
+    char str[RTT_FORMAT_FLOAT_SIZE_MAX];
+
+    uint64_t hex_fail = check_hex(cases);
+    printf("[hex]lines [%u], failed [%llu]: %s\n", cases + 16, static_cast<unsigned long long>(hex_fail), (hex_fail == 0) ? "PASS" : "FAIL");
+    fail += (hex_fail != 0);
+
+    uint64_t near_tie = 0;
+    uint64_t float_fail = check_float(cases, near_tie);
+    printf("[float]values [%u], failed [%llu], last digit differs from snprintf at a rounding tie [%llu]: %s\n", cases,
+           static_cast<unsigned long long>(float_fail), static_cast<unsigned long long>(near_tie), (float_fail == 0) ? "PASS" : "FAIL");
+    fail += (float_fail != 0);
+    reference_float_old(old_str, 0.05f);
+    rtt_format_float(str, 0.05f, 3);
+    printf("[float]0.05: old \"%s\", new \"%s\"\n", old_str, str);
+
+    /* 耗时:十六进制转储按行,浮点数按次,结果累加到volatile变量避免被优化掉 */
+    volatile uint32_t sink = 0;
+    uint32_t acc = 0;
+    uint8_t data[RTT_FORMAT_HEX_BYTES_PER_LINE];
+    char line[RTT_FORMAT_HEX_LINE_SIZE];
+    for (uint8_t i = 0; i < RTT_FORMAT_HEX_BYTES_PER_LINE; i++)
+    {
+        data[i] = i * 7;
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < cases; n++)
+    {
+        acc += rtt_format_hex_line(line, n, data, RTT_FORMAT_HEX_BYTES_PER_LINE) + line[n & 0x3F];
+    }
+    double hex_new = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / cases;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < cases; n++)
+    {
+        acc += reference_hex_line(n, data, RTT_FORMAT_HEX_BYTES_PER_LINE)[n & 0x3F];
+    }
+    double hex_old = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / cases;
+    const float values[] = {0.05f, -0.05f, 1.5f, 231.43234f, -9.34f, 0.0f, 0.9996f, -1234567.0f};
+    start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < cases; n++)
+    {
+        acc += rtt_format_float(str, values[n & 0x07], 3);
+    }
+    double float_new = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / cases;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < cases; n++)
+    {
+        reference_float_old(old_str, values[n & 0x07]);
+        acc += old_str[1];
+    }
+    double float_old = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / cases;
+    sink = acc;
+    (void)sink;
+    printf("[time]hex line [%.1f] ns, per-byte printf [%.1f] ns; float [%.1f] ns, sprintf [%.1f] ns\n", hex_new, hex_old, float_new, float_old);
+    return fail;
+}
@@ -0,0 +1,404 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-27 10:25:17
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-01-27 16:08:42
+ * @Description: rtt_log_decoder.cpp 上位机延迟日志解码
+ *               下位机开启__RTT_LOG_DEFERRED后,日志以二进制记录写入RTT通道1(记录格式见rtt.h),
+ *               本工具从链接生成的axf文件中读取格式化字符串ID表,还原带时间戳的文本日志
+ *               ID表:axf符号表中名为rtt_log_format的静态数组(GCC为rtt_log_format.N),地址即为ID,
+ *               因此ID表随每次编译自动生成,不需要额外的构建步骤;%s参数为常量字符串的地址,同样从axf中读取
+ *
+ *               编译(在仓库根目录执行):
+ *               g++ -std=c++17 -O2 Host/Src/rtt_log_decoder.cpp -o rtt_log_decoder
+ *
+ *               用法:
+ *               rtt_log_decoder <axf> table                  打印ID表
+ *               rtt_log_decoder <axf> <log|-> [cpu_mhz]      解码RTT通道1的数据(文件或标准输入),默认168MHz
+ *               例如:JLinkRTTLogger -Device STM32F407IG -If SWD -Speed 4000 -RTTChannel 1 rtt_log.bin
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+/* 与下位机rtt.h保持一致;rtt.h依赖SEGGER_RTT.h,这里不直接包含 */
+#define RTT_LOG_RECORD_MAGIC 0xA5
+#define RTT_LOG_RECORD_HEAD_SIZE 10
+#define RTT_LOG_ARGS_MAX 12
+#define RTT_LOG_SYMBOL "rtt_log_format"
+
+/* ELF32小端文件中与地址对应的数据 */
+struct ElfSection
+{
+    uint32_t address;
+    uint32_t size;
+    const uint8_t *data;
+};
+
+class ElfImage
+{
+public:
+    bool load(const char *path)
+    {
+        FILE *file = fopen(path, "rb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+        uint8_t chunk[0x10000];
+        size_t length;
+        while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        {
+            image_.insert(image_.end(), chunk, chunk + length);
+        }
+        fclose(file);
+        /* 只支持32位小端ELF(ARM Cortex-M) */
+        if ((image_.size() < 0x34) || (memcmp(image_.data(), "\x7F" "ELF", 4) != 0) || (image_[4] != 1) || (image_[5] != 1))
+        {
+            return false;
+        }
+        uint32_t section_offset = read32(0x20);
+        uint16_t section_entry = read16(0x2E);
+        uint16_t section_count = read16(0x30);
+        if ((section_entry < 0x28) || (section_offset + static_cast<uint64_t>(section_entry) * section_count > image_.size()))
+        {
+            return false;
+        }
+        std::vector<uint32_t> symtab;
+        for (uint16_t i = 0; i < section_count; i++)
+        {
+            uint32_t header = section_offset + i * section_entry;
+            uint32_t type = read32(header + 0x04);
+            uint32_t flags = read32(header + 0x08);
+            uint32_t offset = read32(header + 0x10);
+            uint32_t size = read32(header + 0x14);
+            if (static_cast<uint64_t>(offset) + size > image_.size())
+            {
+                continue;
+            }
+            /* SHT_PROGBITS且SHF_ALLOC:下载到Flash/RAM中的数据 */
+            if ((type == 1) && (flags & 0x02))
+            {
+                sections_.push_back({read32(header + 0x0C), size, image_.data() + offset});
+            }
+            /* SHT_SYMTAB */
+            if (type == 2)
+            {
+                symtab.push_back(header);
+            }
+        }
+        for (uint32_t header : symtab)
+        {
+            load_symbols(section_offset, section_entry, section_count, header);
+        }
+        return true;
+    }
+
+    /* 读取地址处的常量字符串,地址不在镜像中时返回false */
+    bool read_string(uint32_t address, std::string &text) const
+    {
+        for (const ElfSection &section : sections_)
+        {
+            if ((address >= section.address) && (address - section.address < section.size))
+            {
+                const char *begin = reinterpret_cast<const char *>(section.data) + (address - section.address);
+                size_t length = strnlen(begin, section.size - (address - section.address));
+                text.assign(begin, length);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /* ID表:格式化字符串地址 -> 格式化字符串 */
+    const std::map<uint32_t, std::string> &formats() const { return formats_; }
+
+private:
+    uint16_t read16(size_t offset) const { return static_cast<uint16_t>(image_[offset] | (image_[offset + 1] << 8)); }
+    uint32_t read32(size_t offset) const
+    {
+        return static_cast<uint32_t>(image_[offset]) | (static_cast<uint32_t>(image_[offset + 1]) << 8) |
+               (static_cast<uint32_t>(image_[offset + 2]) << 16) | (static_cast<uint32_t>(image_[offset + 3]) << 24);
+    }
+
+    void load_symbols(uint32_t section_offset, uint16_t section_entry, uint16_t section_count, uint32_t header)
+    {
+        uint32_t offset = read32(header + 0x10);
+        uint32_t size = read32(header + 0x14);
+        uint32_t link = read32(header + 0x18);
+        uint32_t entry = read32(header + 0x24);
+        if ((entry < 0x10) || (link >= section_count))
+        {
+            return;
+        }
+        uint32_t strtab = section_offset + link * section_entry;
+        uint32_t strtab_offset = read32(strtab + 0x10);
+        uint32_t strtab_size = read32(strtab + 0x14);
+        if (static_cast<uint64_t>(strtab_offset) + strtab_size > image_.size())
+        {
+            return;
+        }
+        const char *names = reinterpret_cast<const char *>(image_.data() + strtab_offset);
+        for (uint32_t symbol = offset; symbol + entry <= offset + size; symbol += entry)
+        {
+            uint32_t name = read32(symbol);
+            if (name >= strtab_size)
+            {
+                continue;
+            }
+            /* armcc保留静态变量的原名,GCC在静态局部变量名后追加.N */
+            size_t prefix = strlen(RTT_LOG_SYMBOL);
+            const char *symbol_name = names + name;
+            if ((strncmp(symbol_name, RTT_LOG_SYMBOL, prefix) != 0) || ((symbol_name[prefix] != '\0') && (symbol_name[prefix] != '.')))
+            {
+                continue;
+            }
+            std::string text;
+            uint32_t address = read32(symbol + 0x04);
+            if (read_string(address, text))
+            {
+                formats_[address] = text;
+            }
+        }
+    }
+
+    std::vector<uint8_t> image_;
+    std::vector<ElfSection> sections_;
+    std::map<uint32_t, std::string> formats_;
+};
+
+/**
+ * @description: 按SEGGER_RTT_printf支持的格式还原文本:%d %u %x %X %c %s %p %%,支持标志、宽度与精度
+ * @param {ElfImage} &elf axf镜像,用于读取%s参数
+ * @param {std::string} &format 格式化字符串
+ * @param {uint32_t} *args 参数原始值
+ * @param {uint8_t} arg_count 参数个数
+ * @return {*} 还原后的文本
+ */
+static std::string decoder_format(const ElfImage &elf, const std::string &format, const uint32_t *args, uint8_t arg_count)
+{
+    std::string text;
+    char spec[32];
+    char field[256];
+    uint8_t arg = 0;
+    for (size_t i = 0; i < format.size(); i++)
+    {
+        if (format[i] != '%')
+        {
+            text += format[i];
+            continue;
+        }
+        /* 截取一个转换说明,去掉长度修饰符,SEGGER_RTT_printf的参数都是32位 */
+        size_t spec_length = 0;
+        spec[spec_length++] = '%';
+        for (i++; (i < format.size()) && (spec_length < sizeof(spec) - 2); i++)
+        {
+            char c = format[i];
+            if ((c == 'l') || (c == 'h') || (c == 'z'))
+            {
+                continue;
+            }
+            spec[spec_length++] = c;
+            if (strchr("-+ #0123456789.", c) == nullptr)
+            {
+                break;
+            }
+        }
+        spec[spec_length] = '\0';
+        char conversion = spec[spec_length - 1];
+        if (conversion == '%')
+        {
+            text += '%';
+            continue;
+        }
+        if (arg >= arg_count)
+        {
+            text += "<missing>";
+            continue;
+        }
+        uint32_t value = args[arg++];
+        switch (conversion)
+        {
+        case 'd':
+        case 'i':
+            snprintf(field, sizeof(field), spec, static_cast<int>(static_cast<int32_t>(value)));
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+            snprintf(field, sizeof(field), spec, static_cast<unsigned>(value));
+            break;
+        case 'c':
+            snprintf(field, sizeof(field), spec, static_cast<int>(static_cast<char>(value)));
+            break;
+        case 'p':
+            snprintf(field, sizeof(field), "%08X", static_cast<unsigned>(value));
+            break;
+        case 's':
+        {
+            std::string string;
+            if (!elf.read_string(value, string))
+            {
+                /* RAM中的字符串在记录写入后可能已经改变,只能给出地址 */
+                snprintf(field, sizeof(field), "<str 0x%08X>", static_cast<unsigned>(value));
+                break;
+            }
+            snprintf(field, sizeof(field), spec, string.c_str());
+            break;
+        }
+        default:
+            snprintf(field, sizeof(field), "<%s>", spec);
+            break;
+        }
+        text += field;
+    }
+    /* 行尾由解码器统一添加 */
+    while (!text.empty() && ((text.back() == '\n') || (text.back() == '\r')))
+    {
+        text.pop_back();
+    }
+    return text;
+}
+
+/* 流式记录解析:数据可以分块到达,不完整的记录留到下一次 */
+class RecordDecoder
+{
+public:
+    RecordDecoder(const ElfImage &elf, double cpu_mhz) : elf_(elf), cpu_mhz_(cpu_mhz), color_(isatty(STDOUT_FILENO) != 0) {}
+
+    void feed(const uint8_t *data, size_t length)
+    {
+        pending_.insert(pending_.end(), data, data + length);
+        size_t position = 0;
+        while (pending_.size() - position >= RTT_LOG_RECORD_HEAD_SIZE)
+        {
+            const uint8_t *record = pending_.data() + position;
+            uint8_t arg_count = record[1] & 0x0F;
+            uint32_t format = read32(record + 2);
+            auto it = elf_.formats().find(format);
+            /* 同步字节、参数个数与格式化字符串ID均有效才认为是一条记录,否则逐字节重新同步 */
+            if ((record[0] != RTT_LOG_RECORD_MAGIC) || (arg_count > RTT_LOG_ARGS_MAX) || (it == elf_.formats().end()))
+            {
+                position++;
+                skip_bytes_++;
+                continue;
+            }
+            size_t record_length = RTT_LOG_RECORD_HEAD_SIZE + arg_count * 4u;
+            if (pending_.size() - position < record_length)
+            {
+                break;
+            }
+            uint32_t args[RTT_LOG_ARGS_MAX];
+            for (uint8_t i = 0; i < arg_count; i++)
+            {
+                args[i] = read32(record + RTT_LOG_RECORD_HEAD_SIZE + i * 4);
+            }
+            print(record[1] >> 4, read32(record + 6), decoder_format(elf_, it->second, args, arg_count));
+            position += record_length;
+            records_++;
+        }
+        pending_.erase(pending_.begin(), pending_.begin() + position);
+    }
+
+    uint64_t records() const { return records_; }
+    uint64_t skip_bytes() const { return skip_bytes_; }
+
+private:
+    static uint32_t read32(const uint8_t *data)
+    {
+        return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+               (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+    }
+
+    void print(uint8_t level, uint32_t timestamp, const std::string &text)
+    {
+        static const char *const level_name[] = {"I:", "W:", "E:"};
+        static const char *const level_color[] = {"\x1B[1;32m", "\x1B[1;33m", "\x1B[1;31m"};
+        /* DWT节拍数为32位,168MHz下约25.6s溢出一次,按相邻记录的差值累加 */
+        if (records_ == 0)
+        {
+            last_timestamp_ = timestamp;
+        }
+        cycles_ += static_cast<uint32_t>(timestamp - last_timestamp_);
+        last_timestamp_ = timestamp;
+        const char *name = (level < 3) ? level_name[level] : "?:";
+        printf("[%12.6f] %s%s%s%s\n",
+               cycles_ / (cpu_mhz_ * 1e6),
+               (color_ && (level < 3)) ? level_color[level] : "",
+               name,
+               text.c_str(),
+               color_ ? "\x1B[0m" : "");
+    }
+
+    const ElfImage &elf_;
+    double cpu_mhz_;
+    bool color_;
+    std::vector<uint8_t> pending_;
+    uint64_t records_ = 0;
+    uint64_t skip_bytes_ = 0;
+    uint64_t cycles_ = 0;
+    uint32_t last_timestamp_ = 0;
+};
+
+int main(int argc, char **argv)
+{
+    ElfImage elf;
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <axf> table | <log|-> [cpu_mhz]\n", argv[0]);
+        return 1;
+    }
+    if (!elf.load(argv[1]))
+    {
+        fprintf(stderr, "load %s failed: 32-bit little-endian ELF expected\n", argv[1]);
+        return 1;
+    }
+    if (elf.formats().empty())
+    {
+        fprintf(stderr, "no %s symbols in %s, was it built with __RTT_LOG_DEFERRED?\n", RTT_LOG_SYMBOL, argv[1]);
+        return 1;
+    }
+    if (strcmp(argv[2], "table") == 0)
+    {
+        for (const auto &entry : elf.formats())
+        {
+            std::string text = entry.second;
+            while (!text.empty() && ((text.back() == '\n') || (text.back() == '\r')))
+            {
+                text.pop_back();
+            }
+            printf("0x%08X %s\n", entry.first, text.c_str());
+        }
+        return 0;
+    }
+    FILE *input = (strcmp(argv[2], "-") == 0) ? stdin : fopen(argv[2], "rb");
+    if (input == nullptr)
+    {
+        fprintf(stderr, "open %s failed\n", argv[2]);
+        return 1;
+    }
+    RecordDecoder decoder(elf, (argc >= 4) ? atof(argv[3]) : 168.0);
+    uint8_t chunk[0x1000];
+    ssize_t length;
+    /* read在数据到达后立即返回,标准输入的日志随到随打印 */
+    while ((length = read(fileno(input), chunk, sizeof(chunk))) > 0)
+    {
+        decoder.feed(chunk, static_cast<size_t>(length));
+        fflush(stdout);
+    }
+    if (input != stdin)
+    {
+        fclose(input);
+    }
+    fprintf(stderr, "[rtt_log][%llu] records, skip [%llu] bytes\n",
+            static_cast<unsigned long long>(decoder.records()),
+            static_cast<unsigned long long>(decoder.skip_bytes()));
+    return 0;
+}
@@ -0,0 +1,309 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-10 17:44:51
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 17:44:51
+ * @Description: sbus_decode_test.cpp 上位机测试SBUS解码
+ *               1. 固定数据帧:接收机输出的典型数据帧(通道居中992、最小172、最大1811、失控保护、丢帧、
+ *                  数字通道、SBUS2帧尾),逐字节写出,检查16个通道与标志位;
+ *               2. 随机数据帧:逐bit打包的随机通道值与标志位,与查找表无关的逐bit参考解码比较;
+ *               3. 格式错误的数据帧:帧头、帧尾、保留位、帧长度错误必须被拒绝,且不修改解码结果;
+ *               4. 与旧的逐通道手写移位解码(只解码前10个通道)比较耗时
+ *
+ *               编译(在仓库根目录执行):
+ *               gcc -O2 -c -IBsp/RemoteControl/Inc Bsp/RemoteControl/Src/sbus.c
+ *               g++ -std=c++17 -O2 -IBsp/RemoteControl/Inc Host/Src/sbus_decode_test.cpp sbus.o -o sbus_decode_test
+ *
+ *               用法:
+ *               sbus_decode_test [frames]         随机数据帧数,默认1000000
+ *               sbus_decode_test file <capture>   解码抓包文件(串口原始字节流,100000baud 8E2),按帧头与帧尾同步,
+ *                                                 每帧与参考解码比较,打印通道范围与标志位统计
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "sbus.h"
+
+/* 接收机输出的典型数据帧与期望的通道值、标志位 */
+struct SBUSSample
+{
+    const char *name;
+    uint8_t frame[SBUS_FRAME_SIZE];
+    uint16_t channel[SBUS_CHANNEL_NUM];
+    uint8_t flags;
+};
+
+static const SBUSSample sbus_samples[] = {
+    {"center",
+     {0x0F, 0xE0, 0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C, 0xE0,
+      0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C, 0x00, 0x00},
+     {992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992},
+     0x00},
+    {"min",
+     {0x0F, 0xAC, 0x60, 0x05, 0x2B, 0x58, 0xC1, 0x0A, 0x56, 0xB0, 0x82, 0x15, 0xAC,
+      0x60, 0x05, 0x2B, 0x58, 0xC1, 0x0A, 0x56, 0xB0, 0x82, 0x15, 0x00, 0x00},
+     {172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172},
+     0x00},
+    {"max + ch17/ch18",
+     {0x0F, 0x13, 0x9F, 0xF8, 0xC4, 0x27, 0x3E, 0xF1, 0x89, 0x4F, 0x7C, 0xE2, 0x13,
+      0x9F, 0xF8, 0xC4, 0x27, 0x3E, 0xF1, 0x89, 0x4F, 0x7C, 0xE2, 0x03, 0x00},
+     {1811, 1811, 1811, 1811, 1811, 1811, 1811, 1811, 1811, 1811, 1811, 1811, 1811, 1811, 1811, 1811},
+     SBUS_FLAG_CH17 | SBUS_FLAG_CH18},
+    {"sticks + frame lost",
+     {0x0F, 0xAC, 0xF0, 0x30, 0xF8, 0x26, 0x0E, 0x3E, 0xF0, 0x81, 0x0F, 0x7C, 0xE0,
+      0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C, 0x04, 0x00},
+     {172, 1566, 992, 1811, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992},
+     SBUS_FLAG_FRAME_LOST},
+    {"failsafe",
+     {0x0F, 0xE0, 0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C, 0xE0,
+      0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C, 0x0C, 0x00},
+     {992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992},
+     SBUS_FLAG_FRAME_LOST | SBUS_FLAG_FAILSAFE},
+    {"sbus2 slot 2",
+     {0x0F, 0xE0, 0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C, 0xE0,
+      0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C, 0x00, 0x24},
+     {992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992, 992},
+     0x00},
+};
+
+/**
+ * @description: 参考实现:逐bit打包,与sbus.c中的查找表无关
+ * @return {*}
+ */
+static void reference_pack(uint8_t *frame, const uint16_t *channel, uint8_t flags, uint8_t footer)
+{
+    memset(frame, 0, SBUS_FRAME_SIZE);
+    frame[0] = SBUS_HEADER;
+    for (uint16_t bit = 0; bit < SBUS_CHANNEL_NUM * SBUS_CHANNEL_BITS; bit++)
+    {
+        frame[1 + bit / 8] |= ((channel[bit / SBUS_CHANNEL_BITS] >> (bit % SBUS_CHANNEL_BITS)) & 0x01) << (bit % 8);
+    }
+    frame[23] = flags;
+    frame[24] = footer;
+}
+
+/**
+ * @description: 参考实现:逐bit解包
+ * @return {*}
+ */
+static void reference_unpack(const uint8_t *frame, uint16_t *channel)
+{
+    memset(channel, 0, SBUS_CHANNEL_NUM * sizeof(uint16_t));
+    for (uint16_t bit = 0; bit < SBUS_CHANNEL_NUM * SBUS_CHANNEL_BITS; bit++)
+    {
+        channel[bit / SBUS_CHANNEL_BITS] |= ((frame[1 + bit / 8] >> (bit % 8)) & 0x01) << (bit % SBUS_CHANNEL_BITS);
+    }
+}
+
+/* 旧的解码方式:逐通道手写移位表达式,只解码前10个通道,与sbus.c中的sbus_benchmark_reference相同 */
+static void reference_old(const uint8_t *frame, uint16_t *channel)
+{
+    channel[0] = ((int16_t)frame[1] >> 0 | ((int16_t)frame[2] << 8)) & 0x07FF;
+    channel[1] = ((int16_t)frame[2] >> 3 | ((int16_t)frame[3] << 5)) & 0x07FF;
+    channel[2] = ((int16_t)frame[3] >> 6 | ((int16_t)frame[4] << 2) | (int16_t)frame[5] << 10) & 0x07FF;
+    channel[3] = ((int16_t)frame[5] >> 1 | ((int16_t)frame[6] << 7)) & 0x07FF;
+    channel[4] = ((int16_t)frame[6] >> 4 | ((int16_t)frame[7] << 4)) & 0x07FF;
+    channel[5] = ((int16_t)frame[7] >> 7 | ((int16_t)frame[8] << 1) | (int16_t)frame[9] << 9) & 0x07FF;
+    channel[6] = ((int16_t)frame[9] >> 2 | ((int16_t)frame[10] << 6)) & 0x07FF;
+    channel[7] = ((int16_t)frame[10] >> 5 | ((int16_t)frame[11] << 3)) & 0x07FF;
+    channel[8] = ((int16_t)frame[12] << 0 | ((int16_t)frame[13] << 8)) & 0x07FF;
+    channel[9] = ((int16_t)frame[13] >> 3 | ((int16_t)frame[14] << 5)) & 0x07FF;
+}
+
+/**
+ * @description: 检查解码结果与期望的通道值、标志位一致
+ * @return {*}
+ */
+static bool check_frame(const SBUS_FrameDef &sbus, const uint16_t *channel, uint8_t flags)
+{
+    bool pass = (memcmp(sbus.channel, channel, sizeof(sbus.channel)) == 0);
+    pass &= (sbus.ch17 == ((flags & SBUS_FLAG_CH17) ? 1 : 0));
+    pass &= (sbus.ch18 == ((flags & SBUS_FLAG_CH18) ? 1 : 0));
+    pass &= (sbus.frame_lost == ((flags & SBUS_FLAG_FRAME_LOST) ? 1 : 0));
+    pass &= (sbus.failsafe == ((flags & SBUS_FLAG_FAILSAFE) ? 1 : 0));
+    return pass;
+}
+
+/**
+ * @description: 格式错误的数据帧必须被拒绝,且解码结果保持不变
+ * @return {*} 失败的用例数
+ */
+static int check_reject(const uint8_t *valid)
+{
+    uint8_t frame[SBUS_FRAME_SIZE + 1];
+    SBUS_FrameDef sbus;
+    SBUS_FrameDef untouched;
+    int fail = 0;
+    memset(&untouched, 0x5A, sizeof(untouched));
+    auto expect = [&](const char *name, const uint8_t *data, uint16_t length, bool accept) {
+        sbus = untouched;
+        bool result = sbus_decode(data, length, &sbus) != 0;
+        bool pass = (result == accept) && (accept || (memcmp(&sbus, &untouched, sizeof(sbus)) == 0));
+        if (!pass)
+        {
+            printf("[reject]%s: FAIL\n", name);
+        }
+        fail += !pass;
+    };
+    expect("null frame", nullptr, SBUS_FRAME_SIZE, false);
+    expect("short frame", valid, SBUS_FRAME_SIZE - 1, false);
+    memcpy(frame, valid, SBUS_FRAME_SIZE);
+    frame[SBUS_FRAME_SIZE] = SBUS_HEADER;
+    expect("long frame", frame, SBUS_FRAME_SIZE + 1, false);
+    /* 帧头:只接受0x0F */
+    for (uint16_t value = 0; value < 256; value++)
+    {
+        memcpy(frame, valid, SBUS_FRAME_SIZE);
+        frame[0] = static_cast<uint8_t>(value);
+        expect("header", frame, SBUS_FRAME_SIZE, value == SBUS_HEADER);
+    }
+    /* 帧尾:只接受SBUS的0x00与SBUS2的0x04/0x14/0x24/0x34...,低4位为0x04 */
+    for (uint16_t value = 0; value < 256; value++)
+    {
+        memcpy(frame, valid, SBUS_FRAME_SIZE);
+        frame[24] = static_cast<uint8_t>(value);
+        expect("footer", frame, SBUS_FRAME_SIZE, (value == SBUS_FOOTER) || ((value & SBUS2_FOOTER_MASK) == SBUS2_FOOTER));
+    }
+    /* 标志位:保留位必须为0 */
+    for (uint16_t value = 0; value < 256; value++)
+    {
+        memcpy(frame, valid, SBUS_FRAME_SIZE);
+        frame[23] = static_cast<uint8_t>(value);
+        expect("flags", frame, SBUS_FRAME_SIZE, (value & SBUS_FLAG_RESERVED) == 0);
+    }
+    return fail;
+}
+
+/**
+ * @description: 解码抓包文件:按帧头与帧尾同步,每帧与参考解码比较
+ * @return {*}
+ */
+static int decode_capture(const char *path)
+{
+    std::vector<uint8_t> capture;
+    uint8_t buffer[4096];
+    size_t length;
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "open %s failed\n", path);
+        return 1;
+    }
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        capture.insert(capture.end(), buffer, buffer + length);
+    }
+    fclose(file);
+    uint64_t frames = 0, mismatch = 0, skip = 0, frame_lost = 0, failsafe = 0;
+    uint16_t low[SBUS_CHANNEL_NUM], high[SBUS_CHANNEL_NUM], channel[SBUS_CHANNEL_NUM];
+    SBUS_FrameDef sbus;
+    for (uint8_t i = 0; i < SBUS_CHANNEL_NUM; i++)
+    {
+        low[i] = SBUS_CHANNEL_MASK;
+        high[i] = 0;
+    }
+    for (size_t pos = 0; pos + SBUS_FRAME_SIZE <= capture.size();)
+    {
+        if (!sbus_decode(capture.data() + pos, SBUS_FRAME_SIZE, &sbus))
+        {
+            pos++;
+            skip++;
+            continue;
+        }
+        reference_unpack(capture.data() + pos, channel);
+        mismatch += !check_frame(sbus, channel, capture[pos + 23]);
+        for (uint8_t i = 0; i < SBUS_CHANNEL_NUM; i++)
+        {
+            low[i] = (sbus.channel[i] < low[i]) ? sbus.channel[i] : low[i];
+            high[i] = (sbus.channel[i] > high[i]) ? sbus.channel[i] : high[i];
+        }
+        frames++;
+        frame_lost += sbus.frame_lost;
+        failsafe += sbus.failsafe;
+        pos += SBUS_FRAME_SIZE;
+    }
+    printf("[file]bytes [%zu], frames [%llu], skipped bytes [%llu], frame lost [%llu], failsafe [%llu], mismatch [%llu]\n",
+           capture.size(), static_cast<unsigned long long>(frames), static_cast<unsigned long long>(skip),
+           static_cast<unsigned long long>(frame_lost), static_cast<unsigned long long>(failsafe),
+           static_cast<unsigned long long>(mismatch));
+    for (uint8_t i = 0; (i < SBUS_CHANNEL_NUM) && (frames > 0); i++)
+    {
+        printf("[file]CH%d: [%4d ~ %4d]\n", i + 1, low[i], high[i]);
+    }
+    return (mismatch == 0) ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    if ((argc >= 3) && (strcmp(argv[1], "file") == 0))
+    {
+        return decode_capture(argv[2]);
+    }
+    uint32_t rounds = (argc >= 2) ? static_cast<uint32_t>(atol(argv[1])) : 1000000;
+    int fail = 0;
+    SBUS_FrameDef sbus;
+    uint8_t frame[SBUS_FRAME_SIZE];
+
+    /* 固定数据帧:同时核对参考打包与逐字节写出的数据帧相同 */
+    for (const SBUSSample &sample : sbus_samples)
+    {
+        reference_pack(frame, sample.channel, sample.flags, sample.frame[24]);
+        bool pass = (memcmp(frame, sample.frame, SBUS_FRAME_SIZE) == 0);
+        pass &= sbus_decode(sample.frame, SBUS_FRAME_SIZE, &sbus) && check_frame(sbus, sample.channel, sample.flags);
+        printf("[sample]%s: %s\n", sample.name, pass ? "PASS" : "FAIL");
+        fail += !pass;
+    }
+
+    /* 随机数据帧 */
+    std::mt19937 rng(0x5B05);
+    uint16_t channel[SBUS_CHANNEL_NUM];
+    uint16_t old_channel[10];
+    uint64_t mismatch = 0;
+    for (uint32_t n = 0; n < rounds; n++)
+    {
+        for (uint16_t &value : channel)
+        {
+            value = rng() & SBUS_CHANNEL_MASK;
+        }
+        uint8_t flags = rng() & ~SBUS_FLAG_RESERVED;
+        reference_pack(frame, channel, flags, (rng() & 0x01) ? SBUS_FOOTER : static_cast<uint8_t>(SBUS2_FOOTER | ((rng() & 0x03) << 4)));
+        mismatch += !(sbus_decode(frame, SBUS_FRAME_SIZE, &sbus) && check_frame(sbus, channel, flags));
+        reference_old(frame, old_channel);
+        mismatch += (memcmp(old_channel, channel, sizeof(old_channel)) != 0);
+    }
+    printf("[random]frames [%u], mismatch [%llu]: %s\n", rounds, static_cast<unsigned long long>(mismatch), (mismatch == 0) ? "PASS" : "FAIL");
+    fail += (mismatch != 0);
+
+    int reject_fail = check_reject(sbus_samples[0].frame);
+    printf("[reject]header/footer/flags/length: %s\n", (reject_fail == 0) ? "PASS" : "FAIL");
+    fail += reject_fail;
+
+    /* 耗时:解码结果累加到volatile变量,避免被优化掉 */
+    volatile uint32_t sink = 0;
+    uint32_t acc = 0;
+    const uint8_t *sample = sbus_samples[3].frame;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < rounds; n++)
+    {
+        sbus_decode(sample, SBUS_FRAME_SIZE, &sbus);
+        acc += sbus.channel[n & 0x0F];
+    }
+    double new_ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / rounds;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t n = 0; n < rounds; n++)
+    {
+        reference_old(sample, old_channel);
+        acc += old_channel[n % 10];
+    }
+    double old_ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / rounds;
+    sink = acc;
+    (void)sink;
+    printf("[time]16 channels + flags [%.1f] ns/frame, old 10 channels [%.1f] ns/frame\n", new_ns, old_ns);
+    return fail;
+}
@@ -0,0 +1,292 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-22 14:36:51
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-10 14:32:18
+ * @Description: telemetry_benchmark.cpp 上位机解码吞吐量测试
+ *               用commucation_codec.h生成多种消息组成的合成抓包数据(包括写满的批量数据帧),重复输入接收库直到达到指定数据量,
+ *               回调中完成消息解码,统计frames/s、ns/frame与MB/s,并检查丢帧与校验错误
+ *               也可以解码真实的抓包文件,或者直接接收串口数据
+ *
+ *               编译(在仓库根目录执行):
+ *               gcc -O2 -c -IApplication/commucation/Inc -IBsp/Algorithm/Inc Application/commucation/Src/commucation_parser.c Bsp/Algorithm/Src/crc8.c Bsp/Algorithm/Src/crc16.c Bsp/Algorithm/Src/cobs.c
+ *               g++ -std=c++17 -O2 -IHost/Inc -IApplication/commucation/Inc -IBsp/Algorithm/Inc Host/Src/telemetry_receiver.cpp Host/Src/telemetry_benchmark.cpp commucation_parser.o crc8.o crc16.o cobs.o -o telemetry_benchmark
+ *
+ *               用法:
+ *               telemetry_benchmark [GB] [sof|cobs]           合成数据测试,默认4GB,SOF分帧
+ *               telemetry_benchmark file <capture> [sof|cobs] 解码抓包文件
+ *               telemetry_benchmark tty <device> <baud> [sof|cobs] [reliable] 接收串口数据,每秒打印一次统计
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "telemetry_receiver.h"
+#include "commucation_codec.h"
+
+#define BENCHMARK_CAPTURE_SIZE (64u << 20) /* 合成抓包数据大小:64MB,重复输入直到达到指定数据量 */
+#define BENCHMARK_BATCH_FIELDS 4           /* 批量数据帧每条记录的float个数 */
+#define BENCHMARK_BATCH_RECORD_SIZE (4 + 4 * BENCHMARK_BATCH_FIELDS)
+#define BENCHMARK_BATCH_RECORDS (PROTOCOL_DATA_LENGTH_MAX / BENCHMARK_BATCH_RECORD_SIZE) /* 与commucation_batch.c相同:写满一帧的记录条数 */
+
+/* 回调中解码得到的消息数,按消息类型统计,同时防止解码被编译器优化掉 */
+struct DecodeCount
+{
+    uint64_t decoded;
+    uint64_t unknown;
+    uint64_t records; /* 批量数据帧中的记录条数 */
+    uint64_t checksum;
+};
+
+/**
+ * @description: 生成批量数据帧,布局与下位机commucation_batch.c相同:flags_register低8位为记录条数,高8位为float个数,
+ *               每条记录为timestamp + float字段
+ * @param {uint8_t} *frame 数据帧缓存
+ * @param {uint32_t} timestamp 第一条记录的时间戳
+ * @return {*} 数据帧长度
+ */
+static uint16_t benchmark_batch_encode(uint8_t *frame, uint32_t timestamp)
+{
+    uint8_t *record = frame + OFFSET_BYTE;
+    frame[6] = BENCHMARK_BATCH_RECORDS;
+    frame[7] = BENCHMARK_BATCH_FIELDS;
+    for (uint32_t i = 0; i < BENCHMARK_BATCH_RECORDS; i++, timestamp++, record += BENCHMARK_BATCH_RECORD_SIZE)
+    {
+        float fields[BENCHMARK_BATCH_FIELDS] = {0.5f * timestamp, -1.0f, 0.0f, static_cast<float>(i)};
+        memcpy(record, &timestamp, 4);
+        memcpy(record + 4, fields, sizeof(fields));
+    }
+    return commucation_frame_seal(frame, PROTOCOL_CMD_BATCH, 2 + BENCHMARK_BATCH_RECORDS * BENCHMARK_BATCH_RECORD_SIZE);
+}
+
+/**
+ * @description: 生成合成抓包数据:五种消息轮流出现,字段为伪随机数,数据中包含0xA5与0x00
+ * @param {uint8_t} framing 分帧方式
+ * @param {std::vector<uint8_t>} &capture 输出的抓包数据
+ * @return {*} 抓包数据中的数据帧数
+ */
+static uint64_t benchmark_build_capture(uint8_t framing, std::vector<uint8_t> &capture)
+{
+    uint8_t slot[PROTOCOL_COBS_OFFSET + PROTOCOL_FRAME_LENGTH_MAX + 1];
+    uint8_t *frame = slot + PROTOCOL_COBS_OFFSET;
+    uint32_t seed = 0x1234567;
+    uint64_t frames = 0;
+    uint16_t frame_length = 0;
+    capture.clear();
+    capture.reserve(BENCHMARK_CAPTURE_SIZE);
+    while (capture.size() + sizeof(slot) < BENCHMARK_CAPTURE_SIZE)
+    {
+        seed = seed * 1103515245 + 12345;
+        switch (frames % 5)
+        {
+        case 0:
+        {
+            Schema_visionDef msg = {static_cast<uint16_t>(seed), 0.01f * (seed >> 20), -0.5f, 1234.5f};
+            frame_length = schema_vision_encode(frame, &msg);
+            break;
+        }
+        case 1:
+        {
+            Schema_chassis_speedDef msg = {0, 1.5f, -0.25f, static_cast<float>(seed >> 24)};
+            frame_length = schema_chassis_speed_encode(frame, &msg);
+            break;
+        }
+        case 2:
+        {
+            Schema_radiationDef msg = {0x00A5, static_cast<uint8_t>(seed), 0xA5, static_cast<uint32_t>(frames), seed, 0.125f};
+            frame_length = schema_radiation_encode(frame, &msg);
+            break;
+        }
+        case 3:
+        {
+            Schema_test_dataDef msg = {0xFE55, 1.43234f, 231.43234f, 9.34f, static_cast<float>(seed)};
+            frame_length = schema_test_data_encode(frame, &msg);
+            break;
+        }
+        default:
+            frame_length = benchmark_batch_encode(frame, static_cast<uint32_t>(frames));
+            break;
+        }
+        if (framing == PARSER_FRAMING_COBS)
+        {
+            frame_length = commucation_frame_cobs_wrap(slot, frame_length);
+            capture.insert(capture.end(), slot, slot + frame_length);
+        }
+        else
+        {
+            capture.insert(capture.end(), frame, frame + frame_length);
+        }
+        frames++;
+    }
+    return frames;
+}
+
+/**
+ * @description: 回调中按cmd_id解码消息
+ * @param {Commucation_FrameViewDef} &view 数据帧视图
+ * @param {DecodeCount} &count 解码统计
+ * @return {*}
+ */
+static void benchmark_decode(const Commucation_FrameViewDef &view, DecodeCount &count)
+{
+    switch (view.cmd_id)
+    {
+    case SCHEMA_VISION_CMD:
+    {
+        Schema_visionDef msg;
+        if (schema_vision_decode(&view, &msg))
+        {
+            count.decoded++;
+            count.checksum += msg.flags_register;
+        }
+        break;
+    }
+    case SCHEMA_CHASSIS_SPEED_CMD:
+    {
+        Schema_chassis_speedDef msg;
+        if (schema_chassis_speed_decode(&view, &msg))
+        {
+            count.decoded++;
+            count.checksum += msg.flags_register;
+        }
+        break;
+    }
+    case SCHEMA_RADIATION_CMD:
+    {
+        Schema_radiationDef msg;
+        if (schema_radiation_decode(&view, &msg))
+        {
+            count.decoded++;
+            count.checksum += msg.counts;
+        }
+        break;
+    }
+    case SCHEMA_TEST_DATA_CMD:
+    {
+        Schema_test_dataDef msg;
+        if (schema_test_data_decode(&view, &msg))
+        {
+            count.decoded++;
+            count.checksum += msg.flags_register;
+        }
+        break;
+    }
+    case PROTOCOL_CMD_BATCH:
+    {
+        /* 批量数据帧:记录条数与float个数决定数据段长度 */
+        uint8_t record_num = view.flags_register & 0xFF;
+        uint8_t field_num = view.flags_register >> 8;
+        uint32_t timestamp;
+        if ((record_num != 0) && (view.payload_length == record_num * (4 + 4 * field_num)))
+        {
+            memcpy(&timestamp, view.payload + (record_num - 1) * (4 + 4 * field_num), 4);
+            count.decoded++;
+            count.records += record_num;
+            count.checksum += timestamp;
+        }
+        break;
+    }
+    default:
+        count.unknown++;
+        break;
+    }
+}
+
+static void benchmark_report(const char *name, const host::ReceiverStats &stats, const DecodeCount &count, double seconds)
+{
+    printf("[%s]%.2f GB in %.3f s: %.2f Mframes/s, %.2f ns/frame, %.1f MB/s\n",
+           name,
+           stats.bytes / 1e9,
+           seconds,
+           stats.frames / seconds / 1e6,
+           (stats.frames != 0) ? seconds * 1e9 / stats.frames : 0.0,
+           stats.bytes / seconds / 1e6);
+    printf("[%s]frames [%llu], decoded [%llu], batch records [%llu], unknown [%llu], head error [%llu], crc error [%llu], skip [%llu] bytes\n",
+           name,
+           static_cast<unsigned long long>(stats.frames),
+           static_cast<unsigned long long>(count.decoded),
+           static_cast<unsigned long long>(count.records),
+           static_cast<unsigned long long>(count.unknown),
+           static_cast<unsigned long long>(stats.head_errors),
+           static_cast<unsigned long long>(stats.crc_errors),
+           static_cast<unsigned long long>(stats.skip_bytes));
+}
+
+static uint8_t benchmark_framing(const char *arg)
+{
+    return ((arg != nullptr) && (strcmp(arg, "cobs") == 0)) ? PARSER_FRAMING_COBS : PARSER_FRAMING_SOF;
+}
+
+int main(int argc, char **argv)
+{
+    DecodeCount count = {0, 0, 0, 0};
+    auto handler = [&count](const Commucation_FrameViewDef &view, const uint8_t *, uint16_t) { benchmark_decode(view, count); };
+
+    if ((argc >= 3) && (strcmp(argv[1], "file") == 0))
+    {
+        host::TelemetryReceiver receiver(benchmark_framing(argc >= 4 ? argv[3] : nullptr));
+        receiver.set_frame_handler(handler);
+        if (!receiver.open_file(argv[2]))
+        {
+            fprintf(stderr, "open %s failed\n", argv[2]);
+            return 1;
+        }
+        auto start = std::chrono::steady_clock::now();
+        receiver.run_file();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        benchmark_report("file", receiver.stats(), count, elapsed.count());
+        return 0;
+    }
+    if ((argc >= 4) && (strcmp(argv[1], "tty") == 0))
+    {
+        host::TelemetryReceiver receiver(benchmark_framing(argc >= 5 ? argv[4] : nullptr));
+        receiver.set_frame_handler(handler);
+        receiver.set_reliable((argc >= 6) && (strcmp(argv[5], "reliable") == 0));
+        if (!receiver.open_tty(argv[2], strtoul(argv[3], nullptr, 10)))
+        {
+            fprintf(stderr, "open %s failed\n", argv[2]);
+            return 1;
+        }
+        auto start = std::chrono::steady_clock::now();
+        auto last = start;
+        while (receiver.poll(100) >= 0)
+        {
+            auto now = std::chrono::steady_clock::now();
+            if (now - last >= std::chrono::seconds(1))
+            {
+                last = now;
+                benchmark_report("tty", receiver.stats(), count, std::chrono::duration<double>(now - start).count());
+            }
+        }
+        return 0;
+    }
+
+    /* 合成数据测试 */
+    double gigabytes = (argc >= 2) ? atof(argv[1]) : 4.0;
+    uint8_t framing = benchmark_framing(argc >= 3 ? argv[2] : nullptr);
+    std::vector<uint8_t> capture;
+    uint64_t capture_frames = benchmark_build_capture(framing, capture);
+    uint64_t rounds = static_cast<uint64_t>(gigabytes * 1e9 / capture.size()) + 1;
+    host::TelemetryReceiver receiver(framing);
+    receiver.set_frame_handler(handler);
+    printf("[synthetic]%s framing, capture [%zu] bytes with [%llu] frames, [%llu] rounds\n",
+           (framing == PARSER_FRAMING_COBS) ? "COBS" : "SOF",
+           capture.size(),
+           static_cast<unsigned long long>(capture_frames),
+           static_cast<unsigned long long>(rounds));
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < rounds; i++)
+    {
+        receiver.feed(capture.data(), capture.size());
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    host::ReceiverStats stats = receiver.stats();
+    benchmark_report("synthetic", stats, count, elapsed.count());
+    printf("[synthetic]lost [%lld] frames, checksum [%llx]\n",
+           static_cast<long long>(capture_frames * rounds - count.decoded),
+           static_cast<unsigned long long>(count.checksum));
+    return (count.decoded == capture_frames * rounds) ? 0 : 1;
+}
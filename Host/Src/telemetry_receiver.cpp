@@ -0,0 +1,306 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-01-22 09:13:02
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-01-22 18:20:14
+ * @Description: telemetry_receiver.cpp Linux上位机遥测数据接收库
+ *               解析器回调没有上下文参数,解析期间通过线程局部变量找到当前的接收实例
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include "telemetry_receiver.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace host
+{
+    static thread_local TelemetryReceiver *active_receiver = nullptr; /* 正在解析数据的接收实例 */
+
+    /**
+     * @description: 波特率转换为termios速率常量
+     * @param {uint32_t} baud_rate 波特率
+     * @return {*} 速率常量,不支持的波特率返回B0
+     */
+    static speed_t baud_to_speed(uint32_t baud_rate)
+    {
+        switch (baud_rate)
+        {
+        case 115200:
+            return B115200;
+        case 230400:
+            return B230400;
+        case 460800:
+            return B460800;
+        case 921600:
+            return B921600;
+        case 1000000:
+            return B1000000;
+        case 2000000:
+            return B2000000;
+        case 3000000:
+            return B3000000;
+        case 4000000:
+            return B4000000;
+        default:
+            return B0;
+        }
+    }
+
+    TelemetryReceiver::TelemetryReceiver(uint8_t framing)
+        : reliable_(false), fd_(-1), file_data_(nullptr), file_length_(0), bytes_(0), reliable_frames_(0)
+    {
+        commucation_parser_init(&parser_, framing, parser_callback);
+        commucation_reliable_rx_init(&reliable_rx_);
+    }
+
+    TelemetryReceiver::~TelemetryReceiver()
+    {
+        close();
+    }
+
+    void TelemetryReceiver::set_frame_handler(FrameHandler handler)
+    {
+        handler_ = std::move(handler);
+    }
+
+    void TelemetryReceiver::set_reliable(bool enable)
+    {
+        reliable_ = enable;
+        commucation_reliable_rx_init(&reliable_rx_);
+    }
+
+    /**
+     * @description: 以raw模式打开串口
+     * @param {char} *path 设备路径,例如/dev/ttyUSB0或pty从设备
+     * @param {uint32_t} baud_rate 波特率,pty忽略该参数
+     * @return {*} true:打开成功
+     */
+    bool TelemetryReceiver::open_tty(const char *path, uint32_t baud_rate)
+    {
+        struct termios tio;
+        speed_t speed = baud_to_speed(baud_rate);
+        close();
+        if (speed == B0)
+        {
+            return false;
+        }
+        fd_ = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (fd_ < 0)
+        {
+            return false;
+        }
+        if (tcgetattr(fd_, &tio) == 0)
+        {
+            cfmakeraw(&tio);
+            tio.c_cflag |= CLOCAL | CREAD;
+            tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+            cfsetispeed(&tio, speed);
+            cfsetospeed(&tio, speed);
+            tcsetattr(fd_, TCSANOW, &tio);
+        }
+        return true;
+    }
+
+    /**
+     * @description: 以只读方式映射抓包文件,解析时直接读取映射内存,不经过read拷贝
+     * @param {char} *path 抓包文件路径,内容为串口原始字节流
+     * @return {*} true:映射成功
+     */
+    bool TelemetryReceiver::open_file(const char *path)
+    {
+        struct stat st;
+        int fd;
+        void *data;
+        close();
+        fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        if ((fstat(fd, &st) != 0) || (st.st_size == 0))
+        {
+            ::close(fd);
+            return false;
+        }
+        data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            return false;
+        }
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+        file_data_ = static_cast<const uint8_t *>(data);
+        file_length_ = st.st_size;
+        return true;
+    }
+
+    void TelemetryReceiver::close()
+    {
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        if (file_data_ != nullptr)
+        {
+            munmap(const_cast<uint8_t *>(file_data_), file_length_);
+            file_data_ = nullptr;
+            file_length_ = 0;
+        }
+    }
+
+    long TelemetryReceiver::poll(int timeout_ms)
+    {
+        struct pollfd pfd;
+        ssize_t length;
+        if (fd_ < 0)
+        {
+            return -1;
+        }
+        pfd.fd = fd_;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (::poll(&pfd, 1, timeout_ms) <= 0)
+        {
+            return 0;
+        }
+        length = ::read(fd_, read_buffer_, sizeof(read_buffer_));
+        if (length < 0)
+        {
+            return ((errno == EAGAIN) || (errno == EINTR)) ? 0 : -1;
+        }
+        feed(read_buffer_, length);
+        return length;
+    }
+
+    size_t TelemetryReceiver::run_file()
+    {
+        if (file_data_ == nullptr)
+        {
+            return 0;
+        }
+        feed(file_data_, file_length_);
+        return file_length_;
+    }
+
+    /**
+     * @description: 将数据块交给解析器,解析器单次输入长度为uint16_t,超长数据块分段输入
+     * @param {uint8_t} *data 数据块
+     * @param {size_t} length 数据块字节数
+     * @return {*}
+     */
+    void TelemetryReceiver::feed(const uint8_t *data, size_t length)
+    {
+        const size_t chunk_max = 0x8000;
+        TelemetryReceiver *previous = active_receiver;
+        active_receiver = this;
+        while (length > 0)
+        {
+            uint16_t chunk = (length > chunk_max) ? chunk_max : static_cast<uint16_t>(length);
+            commucation_parser_feed(&parser_, data, chunk);
+            data += chunk;
+            length -= chunk;
+            bytes_ += chunk;
+        }
+        active_receiver = previous;
+    }
+
+    ReceiverStats TelemetryReceiver::stats() const
+    {
+        ReceiverStats stats;
+        stats.bytes = bytes_;
+        stats.frames = parser_.frame_count;
+        stats.head_errors = parser_.head_error_count;
+        stats.crc_errors = parser_.crc_error_count;
+        stats.skip_bytes = parser_.skip_bytes;
+        stats.reliable_frames = reliable_frames_;
+        stats.duplicates = reliable_rx_.duplicate_count;
+        return stats;
+    }
+
+    void TelemetryReceiver::parser_callback(uint8_t *frame, uint16_t frame_length)
+    {
+        if (active_receiver != nullptr)
+        {
+            active_receiver->dispatch(frame, frame_length);
+        }
+    }
+
+    /**
+     * @description: 数据帧已通过crc校验,建立只读视图后交给回调
+     * @param {uint8_t} *frame 数据帧
+     * @param {uint16_t} frame_length 数据帧字节数
+     * @return {*}
+     */
+    void TelemetryReceiver::dispatch(const uint8_t *frame, uint16_t frame_length)
+    {
+        Commucation_FrameViewDef view;
+        if (!commucation_frame_view(frame, frame_length, &view))
+        {
+            return;
+        }
+        if (reliable_ && (view.cmd_id == PROTOCOL_CMD_RELIABLE_DATA))
+        {
+            reliable_dispatch(view, frame, frame_length);
+            return;
+        }
+        if (handler_)
+        {
+            handler_(view, frame, frame_length);
+        }
+    }
+
+    /**
+     * @description: 可靠数据帧:更新接收状态并回复确认帧,新的数据帧去掉序号后按原始cmd_id交付
+     *               乱序到达的数据帧立即交付,交付顺序可能与发送顺序不同
+     * @param {Commucation_FrameViewDef} &view 可靠数据帧视图
+     * @param {uint8_t} *frame 数据帧
+     * @param {uint16_t} frame_length 数据帧字节数
+     * @return {*}
+     */
+    void TelemetryReceiver::reliable_dispatch(const Commucation_FrameViewDef &view, const uint8_t *frame, uint16_t frame_length)
+    {
+        uint8_t ack[PROTOCOL_COBS_OFFSET + OFFSET_BYTE + 6 + 1]; /* 确认帧:编码开销 + 帧头帧尾 + 6字节数据段 + 分隔符 */
+        uint16_t ack_length;
+        Commucation_FrameViewDef inner;
+        uint8_t fresh;
+        /* flags_register之后还有原始cmd_id与原始flags_register */
+        if (view.payload_length < RELIABLE_DATA_HEAD_SIZE - 2)
+        {
+            return;
+        }
+        fresh = commucation_reliable_rx_accept(&reliable_rx_, view.flags_register & 0xFF);
+        /* 重复的数据帧同样需要确认,上一次的确认帧可能已丢失 */
+        if (fd_ >= 0)
+        {
+            ack_length = commucation_reliable_ack_pack(&reliable_rx_, ack + PROTOCOL_COBS_OFFSET);
+            if (parser_.framing == PARSER_FRAMING_COBS)
+            {
+                ack_length = commucation_frame_cobs_wrap(ack, ack_length);
+                (void)::write(fd_, ack, ack_length);
+            }
+            else
+            {
+                (void)::write(fd_, ack + PROTOCOL_COBS_OFFSET, ack_length);
+            }
+        }
+        if (!fresh)
+        {
+            return;
+        }
+        reliable_frames_++;
+        inner.cmd_id = view.payload[0] | (view.payload[1] << 8);
+        inner.flags_register = view.payload[2] | (view.payload[3] << 8);
+        inner.payload = view.payload + RELIABLE_DATA_HEAD_SIZE - 2;
+        inner.payload_length = view.payload_length - (RELIABLE_DATA_HEAD_SIZE - 2);
+        if (handler_)
+        {
+            handler_(inner, frame, frame_length);
+        }
+    }
+} // namespace host
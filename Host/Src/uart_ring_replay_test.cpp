@@ -0,0 +1,378 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-10 16:45:12
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-11 09:42:16
+ * @Description: uart_ring_replay_test.cpp 上位机回放测试串口环形接收模式
+ *               模拟循环DMA逐字节写入环形缓冲区:数据按随机长度的突发到达,突发结束产生IDLE事件,
+ *               写过半区与缓冲区末尾产生半传输/传输完成事件,中断延迟随机0~3字节,传输完成时随机读到NDTR为0的重载瞬间;
+ *               每个事件按中断的方式用uart_ring_head/uart_ring_slice切片,切片依次交给解析器,
+ *               检查切片拼接后的数据与输入逐字节相同、解析出的数据帧数与输入相同、没有校验错误;
+ *               SBUS回放:每帧一次突发,DMA从帧中间开始写入,并随机在帧内模拟串口出错后从缓冲区起点重启,
+ *               IDLE事件与uart.c相同额外交出长度为0的切片,切片经sbus_assembler_feed拼帧,
+ *               检查除了第一帧与出错的数据帧,其余数据帧按顺序逐字节相同、全部解码成功
+ *
+ *               编译(在仓库根目录执行):
+ *               gcc -O2 -c -IBsp/Uart/Inc -IBsp/RemoteControl/Inc -IApplication/commucation/Inc -IBsp/Algorithm/Inc Bsp/Uart/Src/uart_ring.c Bsp/RemoteControl/Src/sbus.c Application/commucation/Src/commucation_parser.c Bsp/Algorithm/Src/crc8.c Bsp/Algorithm/Src/crc16.c Bsp/Algorithm/Src/cobs.c
+ *               g++ -std=c++17 -O2 -IBsp/Uart/Inc -IBsp/RemoteControl/Inc -IApplication/commucation/Inc -IBsp/Algorithm/Inc Host/Src/uart_ring_replay_test.cpp uart_ring.o sbus.o commucation_parser.o crc8.o crc16.o cobs.o -o uart_ring_replay_test
+ *
+ *               用法:
+ *               uart_ring_replay_test [bytes]                 合成数据,依次测试多种环形缓冲区大小,默认1000000字节
+ *               uart_ring_replay_test file <capture> [ring]   回放抓包文件(串口原始字节流,SOF分帧),环形缓冲区默认256字节
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "uart_ring.h"
+#include "sbus.h"
+#include "commucation_codec.h"
+
+#define REPLAY_IRQ_LATENCY_MAX 3   /* 中断延迟:事件发生后DMA最多继续写入的字节数 */
+#define REPLAY_SBUS_RESTART_RATE 8 /* SBUS回放:平均每多少帧模拟一次串口出错重启 */
+
+typedef void (*replay_feed_function)(const uint8_t *data, uint16_t length); /* 解析函数:切片长度为0表示线路空闲 */
+
+static uint64_t replay_frames = 0;                /* 解析器输出的数据帧数 */
+static Commucation_ParserDef replay_parser;       /* 上位机协议解析器 */
+static SBUS_AssemblerDef replay_assembler;        /* SBUS数据帧拼接 */
+static std::vector<uint8_t> replay_sbus_output;   /* 拼出的SBUS数据帧,依次拼接存放 */
+static uint64_t replay_sbus_decode_error = 0;     /* 拼出但解码失败的SBUS数据帧数 */
+
+static void replay_frame_callback(uint8_t *, uint16_t)
+{
+    replay_frames++;
+}
+
+static void replay_parser_feed(const uint8_t *data, uint16_t length)
+{
+    commucation_parser_feed(&replay_parser, data, length);
+}
+
+static void replay_sbus_frame_callback(uint8_t *frame, uint16_t frame_length)
+{
+    SBUS_FrameDef sbus;
+    replay_frames++;
+    replay_sbus_decode_error += !sbus_decode(frame, frame_length, &sbus);
+    replay_sbus_output.insert(replay_sbus_output.end(), frame, frame + frame_length);
+}
+
+static void replay_sbus_feed(const uint8_t *data, uint16_t length)
+{
+    sbus_assembler_feed(&replay_assembler, data, length);
+}
+
+/* 回放结果 */
+struct ReplayResult
+{
+    uint64_t events;    /* IDLE/HT/TC事件数 */
+    uint64_t slices;    /* 交给解析函数的切片数 */
+    uint64_t wraps;     /* 回绕成两段的事件数 */
+    uint64_t frames;    /* 解析出的数据帧数 */
+    uint64_t crc_error; /* 帧头与整包校验错误数 */
+    bool identical;     /* 切片拼接后的数据与输入相同 */
+};
+
+/**
+ * @description: 按中断的方式处理一次接收事件:由NDTR得到写指针,切片后交给解析函数并拼接;IDLE事件再交出长度为0的切片
+ * @return {*}
+ */
+static void replay_event(const std::vector<uint8_t> &ring, uint16_t ndtr, bool idle, uint16_t &tail, replay_feed_function feed,
+                         std::vector<uint8_t> &output, ReplayResult &result)
+{
+    UART_RingSliceDef slice[UART_RING_SLICE_MAX];
+    uint16_t size = ring.size();
+    uint16_t head = uart_ring_head(size, ndtr);
+    uint8_t slice_num = uart_ring_slice(tail, head, size, slice);
+    result.events++;
+    result.slices += slice_num;
+    result.wraps += (slice_num == 2);
+    for (uint8_t i = 0; i < slice_num; i++)
+    {
+        if ((slice[i].length == 0) || (slice[i].offset + slice[i].length > size))
+        {
+            result.identical = false;
+            continue;
+        }
+        output.insert(output.end(), ring.begin() + slice[i].offset, ring.begin() + slice[i].offset + slice[i].length);
+        feed(ring.data() + slice[i].offset, slice[i].length);
+    }
+    if (idle)
+    {
+        feed(ring.data() + head, 0);
+    }
+    tail = head;
+}
+
+/**
+ * @description: 回放字节流:循环DMA逐字节写入环形缓冲区,突发之间为IDLE事件
+ * @param {std::vector<uint8_t>} &input 串口字节流
+ * @param {uint16_t} size 环形缓冲区大小
+ * @return {*}
+ */
+static ReplayResult replay(const std::vector<uint8_t> &input, uint16_t size, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> ring(size, 0);
+    std::vector<uint8_t> output;
+    ReplayResult result = {0, 0, 0, 0, 0, true};
+    uint16_t pos = 0;  /* DMA写指针 */
+    uint16_t tail = 0; /* 读指针 */
+    int pending = -1;  /* 等待处理的半传输/传输完成事件:剩余的中断延迟字节数,-1表示没有 */
+    bool reload = false;
+    size_t idx = 0;
+    replay_frames = 0;
+    output.reserve(input.size());
+    commucation_parser_init(&replay_parser, PARSER_FRAMING_SOF, replay_frame_callback);
+    while (idx < input.size())
+    {
+        /* 一次突发:长度不超过半个缓冲区,解析任务在两次事件之间取走数据,不会被DMA覆盖 */
+        size_t burst = 1 + rng() % (size / 2);
+        for (size_t i = 0; (i < burst) && (idx < input.size()); i++)
+        {
+            ring[pos] = input[idx++];
+            pos = (pos + 1 == size) ? 0 : pos + 1;
+            if ((pos == size / 2) || (pos == 0))
+            {
+                /* 中断延迟期间再次触发的事件与前一次合并 */
+                if (pending < 0)
+                {
+                    pending = rng() % (REPLAY_IRQ_LATENCY_MAX + 1);
+                }
+                reload = (pos == 0) && (rng() & 0x01);
+            }
+            if ((pending >= 0) && (pending-- == 0))
+            {
+                /* 传输完成后NDTR重载为size,偶尔在重载瞬间读到0 */
+                replay_event(ring, (reload && (pos == 0)) ? 0 : size - pos, false, tail, replay_parser_feed, output, result);
+                pending = -1;
+                reload = false;
+            }
+        }
+        /* 突发结束:IDLE事件 */
+        replay_event(ring, size - pos, true, tail, replay_parser_feed, output, result);
+        pending = -1;
+    }
+    result.frames = replay_frames;
+    result.crc_error = replay_parser.head_error_count + replay_parser.crc_error_count;
+    result.identical = result.identical && (output == input);
+    return result;
+}
+
+/**
+ * @description: 回放SBUS数据:每帧一次突发,帧间为IDLE事件;DMA从第一帧的start字节开始写入,
+ *               并随机在帧内模拟串口出错:未交出的数据与出错的字节丢失,DMA与读指针从缓冲区起点重启
+ * @param {std::vector<uint8_t>} &input SBUS数据帧,依次拼接存放
+ * @param {std::vector<uint8_t>} &expected 输出:应完整拼出的数据帧(第一帧与出错的数据帧除外)
+ * @param {uint16_t} start 第一帧中开始接收的位置,大于0表示从帧中间开始
+ * @return {*}
+ */
+static ReplayResult replay_sbus(const std::vector<uint8_t> &input, std::vector<uint8_t> &expected, uint16_t size, uint16_t start, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> ring(size, 0);
+    std::vector<uint8_t> output;
+    ReplayResult result = {0, 0, 0, 0, 0, true};
+    uint16_t pos = 0;  /* DMA写指针 */
+    uint16_t tail = 0; /* 读指针 */
+    int pending = -1;  /* 等待处理的半传输/传输完成事件:剩余的中断延迟字节数,-1表示没有 */
+    replay_frames = 0;
+    replay_sbus_decode_error = 0;
+    replay_sbus_output.clear();
+    expected.clear();
+    sbus_assembler_init(&replay_assembler, replay_sbus_frame_callback);
+    for (size_t frame = 0; frame * SBUS_FRAME_SIZE < input.size(); frame++)
+    {
+        const uint8_t *bytes = input.data() + frame * SBUS_FRAME_SIZE;
+        uint16_t first = (frame == 0) ? start : 0;
+        /* 出错位置:0表示在帧间隔中出错,不影响数据帧;SBUS_FRAME_SIZE表示本帧不出错 */
+        uint16_t error = (rng() % REPLAY_SBUS_RESTART_RATE == 0) ? rng() % SBUS_FRAME_SIZE : SBUS_FRAME_SIZE;
+        /* 第一帧之前没有线路空闲,无法确认帧头,即使从帧起点开始接收也被丢弃 */
+        bool damaged = (frame == 0) || ((error > first) && (error < SBUS_FRAME_SIZE));
+        for (uint16_t i = first; i < SBUS_FRAME_SIZE; i++)
+        {
+            if (i == error)
+            {
+                /* HAL_UART_ErrorCallback:出错的字节丢失,uart_service_start从缓冲区起点重启,读指针复位 */
+                pos = 0;
+                tail = 0;
+                pending = -1;
+                if (error > first)
+                {
+                    continue;
+                }
+            }
+            ring[pos] = bytes[i];
+            pos = (pos + 1 == size) ? 0 : pos + 1;
+            if (((pos == size / 2) || (pos == 0)) && (pending < 0))
+            {
+                pending = rng() % (REPLAY_IRQ_LATENCY_MAX + 1);
+            }
+            if ((pending >= 0) && (pending-- == 0))
+            {
+                replay_event(ring, size - pos, false, tail, replay_sbus_feed, output, result);
+                pending = -1;
+            }
+        }
+        /* 帧间隔:IDLE事件 */
+        replay_event(ring, size - pos, true, tail, replay_sbus_feed, output, result);
+        pending = -1;
+        if (!damaged)
+        {
+            expected.insert(expected.end(), bytes, bytes + SBUS_FRAME_SIZE);
+        }
+    }
+    result.frames = replay_frames;
+    result.crc_error = replay_sbus_decode_error;
+    result.identical = (replay_sbus_output == expected);
+    return result;
+}
+
+/**
+ * @description: 生成SBUS数据帧:通道值随机,数据段中经常出现0x0F与0x00,帧尾在SBUS与SBUS2之间变化
+ * @return {*}
+ */
+static void build_sbus_capture(std::vector<uint8_t> &capture, size_t frames, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    uint8_t frame[SBUS_FRAME_SIZE];
+    for (size_t n = 0; n < frames; n++)
+    {
+        frame[0] = SBUS_HEADER;
+        for (uint8_t i = 1; i < SBUS_FRAME_SIZE - 2; i++)
+        {
+            uint32_t r = rng();
+            frame[i] = ((r & 0x03) == 0) ? SBUS_HEADER : (((r & 0x07) == 1) ? 0x00 : static_cast<uint8_t>(r >> 8));
+        }
+        frame[23] = static_cast<uint8_t>(rng() & ~SBUS_FLAG_RESERVED);
+        frame[24] = (rng() & 0x01) ? SBUS_FOOTER : static_cast<uint8_t>(SBUS2_FOOTER | ((rng() & 0x03) << 4));
+        capture.insert(capture.end(), frame, frame + SBUS_FRAME_SIZE);
+    }
+}
+
+/**
+ * @description: 生成合成数据:四种消息轮流出现,字段为伪随机数,数据中包含0xA5与0x00
+ * @return {*} 数据帧数
+ */
+static uint64_t build_capture(std::vector<uint8_t> &capture, size_t bytes)
+{
+    uint8_t frame[PROTOCOL_FRAME_LENGTH_MAX];
+    uint32_t seed = 0x1234567;
+    uint64_t frames = 0;
+    uint16_t frame_length = 0;
+    while (capture.size() + sizeof(frame) < bytes)
+    {
+        seed = seed * 1103515245 + 12345;
+        switch (frames & 0x03)
+        {
+        case 0:
+        {
+            Schema_visionDef msg = {static_cast<uint16_t>(seed), 0.01f * (seed >> 20), -0.5f, 1234.5f};
+            frame_length = schema_vision_encode(frame, &msg);
+            break;
+        }
+        case 1:
+        {
+            Schema_chassis_speedDef msg = {0, 1.5f, -0.25f, static_cast<float>(seed >> 24)};
+            frame_length = schema_chassis_speed_encode(frame, &msg);
+            break;
+        }
+        case 2:
+        {
+            Schema_radiationDef msg = {0x00A5, static_cast<uint8_t>(seed), 0xA5, static_cast<uint32_t>(frames), seed, 0.125f};
+            frame_length = schema_radiation_encode(frame, &msg);
+            break;
+        }
+        default:
+        {
+            Schema_test_dataDef msg = {0xFE55, 1.43234f, 231.43234f, 9.34f, static_cast<float>(seed)};
+            frame_length = schema_test_data_encode(frame, &msg);
+            break;
+        }
+        }
+        capture.insert(capture.end(), frame, frame + frame_length);
+        frames++;
+    }
+    return frames;
+}
+
+static bool report(const char *name, uint16_t size, const ReplayResult &result, uint64_t expected_frames)
+{
+    bool pass = result.identical && (result.crc_error == 0) && (result.frames == expected_frames);
+    printf("[%s]ring [%3d] bytes: events [%llu], slices [%llu], wrapped [%llu], frames [%llu/%llu], crc error [%llu], data %s: %s\n",
+           name, size,
+           static_cast<unsigned long long>(result.events),
+           static_cast<unsigned long long>(result.slices),
+           static_cast<unsigned long long>(result.wraps),
+           static_cast<unsigned long long>(result.frames),
+           static_cast<unsigned long long>(expected_frames),
+           static_cast<unsigned long long>(result.crc_error),
+           result.identical ? "identical" : "MISMATCH",
+           pass ? "PASS" : "FAIL");
+    return pass;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<uint8_t> capture;
+    int fail = 0;
+    if ((argc >= 3) && (strcmp(argv[1], "file") == 0))
+    {
+        FILE *file = fopen(argv[2], "rb");
+        uint16_t size = (argc >= 4) ? (uint16_t)atoi(argv[3]) : 256;
+        uint8_t buffer[4096];
+        size_t length;
+        if ((file == nullptr) || (size < 2))
+        {
+            fprintf(stderr, "open %s failed\n", argv[2]);
+            return 1;
+        }
+        while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            capture.insert(capture.end(), buffer, buffer + length);
+        }
+        fclose(file);
+        /* 抓包文件的数据帧数未知:先按大块解析一次作为参考,解析器单次输入长度为uint16_t */
+        Commucation_ParserDef parser;
+        replay_frames = 0;
+        commucation_parser_init(&parser, PARSER_FRAMING_SOF, replay_frame_callback);
+        for (size_t pos = 0; pos < capture.size(); pos += 0x8000)
+        {
+            commucation_parser_feed(&parser, capture.data() + pos, (capture.size() - pos > 0x8000) ? 0x8000 : (uint16_t)(capture.size() - pos));
+        }
+        uint64_t expected = replay_frames;
+        ReplayResult result = replay(capture, size, 1);
+        /* 抓包文件本身可能包含错误帧,只要求与整块解析的结果一致 */
+        result.crc_error -= parser.head_error_count + parser.crc_error_count;
+        return report("file", size, result, expected) ? 0 : 1;
+    }
+
+    size_t bytes = (argc >= 2) ? (size_t)atol(argv[1]) : 1000000;
+    uint64_t frames = build_capture(capture, bytes);
+    /* 上位机串口的环形缓冲区、SBUS的环形缓冲区、奇数大小与小于一帧的缓冲区 */
+    const uint16_t sizes[] = {256, 50, 37, 16, 1024};
+    for (uint16_t size : sizes)
+    {
+        fail += !report("synthetic", size, replay(capture, size, size), frames);
+    }
+    /* SBUS:固件使用两帧大小的环形缓冲区,DMA从帧起点、帧中间与帧尾开始写入,并在帧内随机出错重启 */
+    std::vector<uint8_t> sbus_capture;
+    std::vector<uint8_t> expected;
+    build_sbus_capture(sbus_capture, bytes / SBUS_FRAME_SIZE, 0x5B05);
+    const uint16_t sbus_sizes[] = {SBUS_RING_BUFFER_SIZE, 37, 16, 256};
+    const uint16_t sbus_starts[] = {0, 1, 12, SBUS_FRAME_SIZE - 1};
+    for (uint16_t size : sbus_sizes)
+    {
+        for (uint16_t start : sbus_starts)
+        {
+            ReplayResult result = replay_sbus(sbus_capture, expected, size, start, size + start);
+            printf("[sbus]start [%2d], skip [%u] bytes, break [%u] frames: ", start, replay_assembler.skip_bytes, replay_assembler.break_count);
+            fail += !report("sbus", size, result, expected.size() / SBUS_FRAME_SIZE);
+        }
+    }
+    return fail;
+}
@@ -0,0 +1,131 @@
+/*
+ * @Author: Hengyang Jiang
+ * @Date: 2025-02-04 15:42:10
+ * @LastEditors: Hengyang Jiang
+ * @LastEditTime: 2025-02-04 17:36:20
+ * @Description: ws2812b_stream_test.cpp 上位机测试WS2812B流式编码
+ *               模拟循环DMA:依次发送前后两个半缓冲区,每发送完一半就调用ws2812b_stream_next,
+ *               将实际发送的脉冲序列与原来的整帧编码(灯珠数*24个脉冲+50个复位脉冲)逐个比较,
+ *               同色(间隔0)与逐灯珠(间隔3)两种帧格式,灯珠数0~300,颜色随机
+ *
+ *               编译(在仓库根目录执行):
+ *               gcc -O2 -c -IBsp/Led/Inc Bsp/Led/Src/ws2812b_stream.c
+ *               g++ -std=c++17 -O2 -IBsp/Led/Inc Host/Src/ws2812b_stream_test.cpp ws2812b_stream.o -o ws2812b_stream_test
+ *
+ *               用法:
+ *               ws2812b_stream_test [rounds]    每种灯珠数测试的随机帧数,默认100
+ *
+ * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "ws2812b_stream.h"
+
+#define TEST_LAMP_NUM_MAX 300 /* 测试的最大灯珠数 */
+
+/**
+ * @description: 原来的整帧编码:逐灯珠写入24个脉冲,最后写入50个全0复位脉冲
+ * @param {vector<uint8_t>} &grb 每颗灯珠的G/R/B
+ * @param {uint16_t} lamp_num
+ * @return {*}
+ */
+static std::vector<uint16_t> reference_encode(const std::vector<uint8_t> &grb, uint16_t lamp_num)
+{
+    std::vector<uint16_t> data(lamp_num * 24 + 50, 0);
+    for (uint16_t i = 0; i < lamp_num; i++)
+    {
+        uint8_t channel[3] = {grb[i * 3], grb[i * 3 + 1], grb[i * 3 + 2]};
+        for (uint8_t c = 0; c < 3; c++)
+        {
+            for (uint8_t j = 0; j < 8; j++)
+            {
+                data[24 * i + 8 * c + j] = ((channel[c] & 0x80) ? WS_1 : WS_0);
+                channel[c] <<= 1;
+            }
+        }
+    }
+    return data;
+}
+/**
+ * @description: 模拟循环DMA发送一帧,返回实际发送的脉冲序列
+ *               一帧结束时DMA刚开始发送另一半就被停止,这一半不计入序列
+ * @param {uint8_t} *grb
+ * @param {uint16_t} grb_stride
+ * @param {uint16_t} lamp_num
+ * @return {*}
+ */
+static std::vector<uint16_t> stream_encode(const uint8_t *grb, uint16_t grb_stride, uint16_t lamp_num)
+{
+    static WS2812B_StreamDef stream;
+    std::vector<uint16_t> data;
+    uint8_t half = 0;
+    uint8_t done = 0;
+    ws2812b_stream_start(&stream, grb, grb_stride, lamp_num);
+    while (!done)
+    {
+        data.insert(data.end(), stream.buffer + half * WS2812B_STREAM_HALF_SIZE, stream.buffer + (half + 1) * WS2812B_STREAM_HALF_SIZE);
+        done = ws2812b_stream_next(&stream, half);
+        half ^= 1;
+    }
+    return data;
+}
+/**
+ * @description: 比较流式编码与原来的编码:前缀逐个相同,多出的部分必须全0(复位脉冲)
+ * @return {*} 0:相同
+ */
+static int compare(const std::vector<uint16_t> &reference, const std::vector<uint16_t> &stream, uint16_t lamp_num, const char *mode)
+{
+    if (stream.size() < reference.size())
+    {
+        printf("FAIL %s lamp_num=%u: %zu pulses sent, %zu expected\n", mode, lamp_num, stream.size(), reference.size());
+        return 1;
+    }
+    for (size_t i = 0; i < stream.size(); i++)
+    {
+        uint16_t expect = (i < reference.size()) ? reference[i] : 0;
+        if (stream[i] != expect)
+        {
+            printf("FAIL %s lamp_num=%u: pulse %zu is 0x%02X, expected 0x%02X\n", mode, lamp_num, i, stream[i], expect);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = (argc > 1) ? atoi(argv[1]) : 100;
+    std::mt19937 rng(20250204);
+    uint64_t frames = 0;
+    int fail = 0;
+    for (uint16_t lamp_num = 0; (lamp_num <= TEST_LAMP_NUM_MAX) && !fail; lamp_num++)
+    {
+        for (int round = 0; (round < rounds) && !fail; round++)
+        {
+            /* 逐灯珠颜色 */
+            std::vector<uint8_t> grb(lamp_num * 3 + 3);
+            for (auto &c : grb)
+            {
+                c = (uint8_t)rng();
+            }
+            fail |= compare(reference_encode(grb, lamp_num), stream_encode(grb.data(), 3, lamp_num), lamp_num, "per-lamp");
+            /* 同色 */
+            std::vector<uint8_t> same(lamp_num * 3 + 3);
+            for (uint16_t i = 0; i < lamp_num; i++)
+            {
+                same[i * 3] = grb[0];
+                same[i * 3 + 1] = grb[1];
+                same[i * 3 + 2] = grb[2];
+            }
+            fail |= compare(reference_encode(same, lamp_num), stream_encode(grb.data(), 0, lamp_num), lamp_num, "uniform");
+            frames += 2;
+        }
+    }
+    printf("%s: %llu frames, lamp_num 0..%u\n", fail ? "FAIL" : "PASS", (unsigned long long)frames, TEST_LAMP_NUM_MAX);
+    printf("DMA buffer %u bytes, stream state %zu bytes (full frame for 58 lamps: %u bytes)\n",
+           (unsigned)(WS2812B_STREAM_BUFFER_SIZE * sizeof(uint16_t)), sizeof(WS2812B_StreamDef), (unsigned)((58 * 24 + 50) * sizeof(uint16_t)));
+    return fail;
+}
@@ -2,7 +2,7 @@
  * @Author: Hengyang Jiang
  * @Date: 2024-12-13 13:38:48
  * @LastEditors: Hengyang Jiang
- * @LastEditTime: 2024-12-20 14:19:03
+ * @LastEditTime: 2025-02-03 10:12:36
  * @Description: freertos_start.c
  *
  * Copyright (c) 2024 by https://github.com/Nolan-Jon, All Rights Reserved.
@@ -10,12 +10,13 @@
 #include "freertos_start.h"
 #include "commucation.h"
 #include "chassis.h"
+#include "lamp.h"
 #include "rtt.h"
 #include "daemon.h"
 TaskHandle_t start_task_handle;
 extern TaskHandle_t commucation_task_handle;
 extern TaskHandle_t chassis_task_handle;
-TimerHandle_t daemon_timer_handle;
+extern TaskHandle_t lamp_task_handle;
 void start_task(void *pvParameters)
 {
     /* 启动任务运行的时候调度器已经启动,由于需要创建其他任务,为了避免错误,需要设置临界区 */
@@ -25,10 +26,9 @@ void start_task(void *pvParameters)
     /* 创建应用级任务 */
     xTaskCreate(commucation_task, "com", COMMUCATION_TASK_STACK, NULL, COMMUCATION_TASK_PRIORITY, &commucation_task_handle);
     xTaskCreate(chassis_task, "chassis", CHASSIS_TASK_STACK, NULL, CHASSIS_TASK_PRIORITY, &chassis_task_handle);
-    /* 创建软件定时器Daemon */
-    daemon_timer_handle = xTimerCreate("Daemon", DAEMON_TIMER_PERIOD_TICKS, pdTRUE, (void *)1, deamon_timer_callback); /* pdTRUE循环执行,pdFALSE单次执行*/
-    /* 由于在调度器启动之前开启Timer,函数第二个参数将被忽略 */
-    xTimerStart(daemon_timer_handle, 0);
+    xTaskCreate(lamp_task, "lamp", LAMP_TASK_STACK, NULL, LAMP_TASK_PRIORITY, &lamp_task_handle);
+    /* 创建并启动守护进程(单次软件定时器,每次唤醒后设置到下一个到期时刻) */
+    daemon_scheduler_start();
     /* 删除启动任务自身 */
     vTaskDelete(NULL);
     taskEXIT_CRITICAL();
@@ -30,6 +30,7 @@
 #include "led.h"
 #include "commucation.h"
 #include "freertos_start.h"
+#include "dwt.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -101,11 +102,12 @@ int main(void)
   /* USER CODE BEGIN 2 */
   beep_init();
   rtt_log_init();
+  dwt_init(168); /* CPU频率168MHz,用于中断耗时等节拍数测量 */
 #ifdef TEST_LED_RGB
   led_init();
 #endif // TEST_LED_RGB
+  ws2812b_init(); /* 灯带由lamp任务渲染,未定义TEST_WS2812B_LAMP时显示分段灯效 */
 #ifdef TEST_WS2812B_LAMP
-  ws2812b_init();
   ws2812b_config_color(DarkGreen);
 #endif // TEST_WS2812B_LAMP
 #ifndef __EASY_PRINT_TEST